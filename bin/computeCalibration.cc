@@ -47,6 +47,7 @@
 #include <fstream>
 #include <map>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -231,6 +232,102 @@ void showGraphs(double canvasSizeX, double canvasSizeY,
 
 
 
+//--- contents of TH2 histogram, copied once into contiguous array with one y-slice per x-bin
+//   (including underflow and overflow bins),
+//    so that the statistics of all slices can be computed without creating ProjectionY histograms
+struct histogramSlicesType
+{
+  histogramSlicesType(const TH2* h2)
+    : numBinsX_(h2->GetNbinsX()),
+      numBinsY_(h2->GetNbinsY()),
+      hasSumw2_(h2->GetSumw2N() > 0)
+  {
+    int numSlices = numBinsX_ + 2;
+    int sliceSize = numBinsY_ + 2;
+    contents_.resize(numSlices*sliceSize);
+    if ( hasSumw2_ ) sumw2_.resize(numSlices*sliceSize);
+    for ( int binX = 0; binX < numSlices; ++binX ) {
+      for ( int binY = 0; binY < sliceSize; ++binY ) {
+	int idx = binX*sliceSize + binY;
+	contents_[idx] = h2->GetBinContent(binX, binY);
+	if ( hasSumw2_ ) sumw2_[idx] = square(h2->GetBinError(binX, binY));
+      }
+    }
+    yBinCenters_.resize(sliceSize);
+    for ( int binY = 0; binY < sliceSize; ++binY ) {
+      yBinCenters_[binY] = h2->GetYaxis()->GetBinCenter(binY);
+    }
+  }
+  ~histogramSlicesType() {}
+
+  static double square(double x) { return x*x; }
+
+  const double* slice(int binX) const { return &contents_[binX*(numBinsY_ + 2)]; }
+
+//--- compute mean and uncertainty on mean of y-slice,
+//    identical to TH1::GetMean and TH1::GetMeanError of the projection on the y-axis
+  void compMean(int binX, double& mean, double& meanErr) const
+  {
+    const double* contents = slice(binX);
+    const double* sumw2 = ( hasSumw2_ ) ? &sumw2_[binX*(numBinsY_ + 2)] : 0;
+    double sumw   = 0.;
+    double sumw2_total = 0.;
+    double sumwy  = 0.;
+    double sumwy2 = 0.;
+    for ( int binY = 1; binY <= numBinsY_; ++binY ) {
+      double w = contents[binY];
+      double y = yBinCenters_[binY];
+      sumw   += w;
+      sumw2_total += ( sumw2 ) ? sumw2[binY] : TMath::Abs(w);
+      sumwy  += w*y;
+      sumwy2 += w*y*y;
+    }
+    mean = 0.;
+    meanErr = 0.;
+    if ( sumw == 0. ) return;
+    mean = sumwy/sumw;
+    double rms = TMath::Sqrt(TMath::Abs(sumwy2/sumw - mean*mean));
+    double neff = ( sumw2_total > 0. ) ? sumw*sumw/sumw2_total : 0.;
+    if ( neff > 0. ) meanErr = rms/TMath::Sqrt(neff);
+  }
+
+  int numBinsX_;
+  int numBinsY_;
+  bool hasSumw2_;
+  std::vector<double> contents_;
+  std::vector<double> sumw2_;
+  std::vector<double> yBinCenters_;
+};
+
+//--- calibration function
+//     ((slope_a*y + intercept_a) + (slope_b*y + intercept_b)*TMath::Erf((slope_c*y + intercept_c)*x + (slope_d*y + intercept_d)) - y,
+//    evaluated in compiled form.
+//    The parameters are rounded to the precision with which they are written into the formula string,
+//    so that the result is the same as for the formula written to the output file.
+struct calibrationFunctionType
+{
+  calibrationFunctionType(double slope_a, double intercept_a, double slope_b, double intercept_b,
+			  double slope_c, double intercept_c, double slope_d, double intercept_d)
+    : slope_a_(round(slope_a)), intercept_a_(round(intercept_a)),
+      slope_b_(round(slope_b)), intercept_b_(round(intercept_b)),
+      slope_c_(round(slope_c)), intercept_c_(round(intercept_c)),
+      slope_d_(round(slope_d)), intercept_d_(round(intercept_d))
+  {}
+  ~calibrationFunctionType() {}
+
+  static double round(double x) { return atof(Form("%f", x)); }
+
+  double operator()(double x, double y) const
+  {
+    return (slope_a_*y + intercept_a_) + (slope_b_*y + intercept_b_)*TMath::Erf((slope_c_*y + intercept_c_)*x + (slope_d_*y + intercept_d_)) - y;
+  }
+
+  double slope_a_, intercept_a_;
+  double slope_b_, intercept_b_;
+  double slope_c_, intercept_c_;
+  double slope_d_, intercept_d_;
+};
+
 
 int main(int argc, const char* argv[])
 {
@@ -346,11 +443,10 @@ int main(int argc, const char* argv[])
 				h2->GetNbinsX(),h2->GetXaxis()->GetXmin(),h2->GetXaxis()->GetXmax());
       
       
-      TH1F* h2_py = 0;
+      histogramSlicesType h2_slices(h2);
       for(int k = 1 ; k <= h2->GetNbinsX() ; k++){
-	h2_py = (TH1F*)h2->ProjectionY((directoryName+"_"+histogramName+"_py").c_str(),k+1,k+1,"");
-	Double_t M = h2_py->GetMean();
-	Double_t E = h2_py->GetMeanError();
+	Double_t M, E;
+	h2_slices.compMean(k+1, M, E);
 	h1->SetBinContent(k+1, M);
 	h1->SetBinError(k+1, E );
       }
@@ -399,15 +495,14 @@ int main(int argc, const char* argv[])
       for(int k = 1 ; k <= h2->GetNbinsX() ; k++){
 
 	double sigma_bin_k = (k-0.5)*(h2->GetXaxis()->GetBinWidth(1));
-	TH1F* h2v2_py = (TH1F*)h2->ProjectionY((directoryName+"_"+histogramName+"_v2py").c_str(),k+1,k+1,"");
-
-	//cout << "Profile plot with name " << string(h2v2_py->GetName()) << endl;
-
-	for(int m = 1 ; m <= h2v2_py->GetNbinsX() ; m++){
-	  double mass_bin_m = (m-0.5)*h2v2_py->GetBinWidth(1);
-	  double rescaled_mass_bin_m = mass_bin_m - absDiff->Eval(sigma_bin_k);
-	  h1_raw->Fill(mass_bin_m,          h2v2_py->GetBinContent(m));
-	  h1_cal0->Fill(rescaled_mass_bin_m, h2v2_py->GetBinContent(m));
+	const double* h2_slice = h2_slices.slice(k+1);
+	double massShift = absDiff->Eval(sigma_bin_k);
+
+	for(int m = 1 ; m <= h2->GetNbinsY() ; m++){
+	  double mass_bin_m = (m-0.5)*h2->GetYaxis()->GetBinWidth(1);
+	  double rescaled_mass_bin_m = mass_bin_m - massShift;
+	  h1_raw->Fill(mass_bin_m,          h2_slice[m]);
+	  h1_cal0->Fill(rescaled_mass_bin_m, h2_slice[m]);
 	}
       }
 
@@ -624,8 +719,7 @@ int main(int argc, const char* argv[])
 
 
 
-  TF2* calibration = new TF2("calibration",Form("((%f)*y+(%f))+((%f)*y+(%f))*TMath::Erf(((%f)*y+(%f))*x+((%f)*y+(%f))) - y", 
-						slope_a, intercept_a, slope_b, intercept_b,slope_c, intercept_c,slope_d, intercept_d), 0,200,0,1000);
+  calibrationFunctionType calibration(slope_a, intercept_a, slope_b, intercept_b, slope_c, intercept_c, slope_d, intercept_d);
   for(unsigned int j = 0 ; j < histograms.size() ; j++){
 
     string histogramName = histograms[j];
@@ -668,23 +762,25 @@ int main(int argc, const char* argv[])
 					     h2->GetNbinsY(),h2->GetYaxis()->GetXmin(),h2->GetYaxis()->GetXmax());
       
       
+      histogramSlicesType h2_slices(h2);
       for(int k = 1 ; k <= h2->GetNbinsX() ; k++){
 	
 	double sigma_bin_k = (k-0.5)*(h2->GetXaxis()->GetBinWidth(1));
-	TH1F* h2v3_py = (TH1F*)h2->ProjectionY((directoryName+"_"+histogramName+"_v3py").c_str(),k+1,k+1,"");
+	const double* h2_slice = h2_slices.slice(k+1);
+	double massShift = calibration(sigma_bin_k, 120.);
 	
-	for(int m = 1 ; m <= h2v3_py->GetNbinsX() ; m++){
-	  double mass_bin_m = (m-0.5)*h2v3_py->GetBinWidth(1);
-	  double rescaled_mass_bin_m = mass_bin_m - calibration->Eval(sigma_bin_k, 120.);
+	for(int m = 1 ; m <= h2->GetNbinsY() ; m++){
+	  double mass_bin_m = (m-0.5)*h2->GetYaxis()->GetBinWidth(1);
+	  double rescaled_mass_bin_m = mass_bin_m - massShift;
 
-	  double bias    = calibration->Eval(sigma_bin_k,mass_bin_m);
+	  double bias    = calibration(sigma_bin_k,mass_bin_m);
 	  double massNew = mass_bin_m;
 	  double diff    = 999.;
 	  int nMax       = 100;
 	  bool exit      = false;
 
 	  for(int it=0; it< nMax && !exit; it++){
-	    double bias_it = calibration->Eval(sigma_bin_k,massNew);
+	    double bias_it = calibration(sigma_bin_k,massNew);
 	    massNew        = mass_bin_m - bias_it;
 	    diff           = TMath::Abs(bias - bias_it);
 	    bias           = bias_it;
@@ -695,9 +791,9 @@ int main(int argc, const char* argv[])
 	    }
 	  }
 
-	  h1_raw_formula->Fill(mass_bin_m,           h2v3_py->GetBinContent(m));
-	  h1_cal0_formula->Fill(rescaled_mass_bin_m, h2v3_py->GetBinContent(m));
-	  h1_cal1_formula->Fill(mass_bin_m-bias,     h2v3_py->GetBinContent(m));
+	  h1_raw_formula->Fill(mass_bin_m,           h2_slice[m]);
+	  h1_cal0_formula->Fill(rescaled_mass_bin_m, h2_slice[m]);
+	  h1_cal1_formula->Fill(mass_bin_m-bias,     h2_slice[m]);
 	}
       }
 
@@ -0,0 +1,117 @@
+
+/** \executable evaluateNeuralMtautau
+ *
+ * Evaluate performance of MLP neural network trained by trainNeuralMtautau
+ * on the test sample prepared by prepareNeuralMtautauTrainingData.
+ *
+ * The network output is computed for all events of the test sample in batches,
+ * using the compact NeuralMtautauMLP representation of the network.
+ * Histograms of the reconstructed vs. generated tau+ tau- invariant mass
+ * and of the relative resolution are written to the output file.
+ *
+ * Usage: evaluateNeuralMtautau trainNeuralMtautau_MLP.weights.xml trainNeuralMtautau_prepared.root [output.root]
+ *
+ */
+
+#include "TauAnalysis/CandidateTools/interface/NeuralMtautauMLP.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneColumnarReader.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1D.h>
+#include <TH2D.h>
+#include <TString.h>
+#include <TBenchmark.h>
+#include <TMath.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+int main(int argc, char* argv[])
+{
+//--- parse command-line arguments
+  if ( argc < 3 ) {
+    std::cout << "Usage: " << argv[0] << " [input.weights.xml|input.txt] [prepared.root] [output.root]" << std::endl;
+    return 0;
+  }
+
+  std::cout << "<evaluateNeuralMtautau>:" << std::endl;
+
+  std::string weightsFileName = argv[1];
+  std::string preparedInputFileName = argv[2];
+  std::string outputFileName = ( argc >= 4 ) ? argv[3] : "evaluateNeuralMtautau.root";
+
+  TBenchmark clock;
+  clock.Start("evaluateNeuralMtautau");
+
+//--- read network either from TMVA weights file or from file written by exportNeuralMtautau
+  NeuralMtautauMLP mlp;
+  if ( weightsFileName.find(".xml") != std::string::npos ) mlp.readTMVAWeightsFile(weightsFileName);
+  else mlp.readFile(weightsFileName);
+  unsigned numInputs = mlp.numInputs();
+
+  TFile* preparedInputFile = new TFile(preparedInputFileName.data());
+  TTree* testTree = dynamic_cast<TTree*>(preparedInputFile->Get("test"));
+  if ( !testTree )
+    throw cms::Exception("evaluateNeuralMtautau")
+      << "Failed to find test sample in file = " << preparedInputFileName << " !!\n";
+
+  std::vector<std::string> columnNames;
+  for ( unsigned iInput = 0; iInput < numInputs; ++iInput ) {
+    columnNames.push_back(Form("var%u", iInput));
+  }
+  columnNames.push_back("target");
+  NSVfitStandaloneColumnarReader columns(columnNames);
+  columns.readTree(testTree);
+  size_t numEvents = columns.numEntries();
+  std::cout << " read " << numEvents << " events from test sample." << std::endl;
+  const Float_t* genMtautau = columns.column(numInputs);
+
+//--- compute network output in batches;
+//    input variables need to be rearranged from one column per variable to one row per event
+  const size_t batchSize = 4096;
+  std::vector<Float_t> inputs(batchSize*numInputs);
+  std::vector<Float_t> recMtautau(numEvents);
+  for ( size_t iFirstEvent = 0; iFirstEvent < numEvents; iFirstEvent += batchSize ) {
+    size_t numEvents_batch = std::min(batchSize, numEvents - iFirstEvent);
+    for ( unsigned iInput = 0; iInput < numInputs; ++iInput ) {
+      const Float_t* column = columns.column(iInput) + iFirstEvent;
+      for ( size_t iEvent = 0; iEvent < numEvents_batch; ++iEvent ) {
+	inputs[iEvent*numInputs + iInput] = column[iEvent];
+      }
+    }
+    mlp.evaluate(&inputs[0], numEvents_batch, &recMtautau[iFirstEvent]);
+  }
+
+  TFile* outputFile = new TFile(outputFileName.data(), "RECREATE");
+  TH2D* histogramRecVsGenMtautau = new TH2D("histogramRecVsGenMtautau", "histogramRecVsGenMtautau", 100, 0., 500., 100, 0., 500.);
+  TH1D* histogramMtautauResolution = new TH1D("histogramMtautauResolution", "histogramMtautauResolution", 200, -1., +1.);
+  double sumRes = 0.;
+  double sumRes2 = 0.;
+  size_t numEvents_valid = 0;
+  for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+    histogramRecVsGenMtautau->Fill(genMtautau[iEvent], recMtautau[iEvent]);
+    if ( !(genMtautau[iEvent] > 0.) ) continue;
+    double res = (recMtautau[iEvent] - genMtautau[iEvent])/genMtautau[iEvent];
+    histogramMtautauResolution->Fill(res);
+    sumRes += res;
+    sumRes2 += res*res;
+    ++numEvents_valid;
+  }
+  if ( numEvents_valid > 0 ) {
+    double mean = sumRes/numEvents_valid;
+    double rms = TMath::Sqrt(TMath::Max(0., sumRes2/numEvents_valid - mean*mean));
+    std::cout << " (rec - gen)/gen: mean = " << mean << ", RMS = " << rms << std::endl;
+  }
+  outputFile->Write();
+  delete outputFile;
+  delete preparedInputFile;
+
+  clock.Show("evaluateNeuralMtautau");
+
+  return 0;
+}
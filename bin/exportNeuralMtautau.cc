@@ -0,0 +1,146 @@
+/** \executable exportNeuralMtautau
+ *
+ * Convert weights of MLP neural network trained by trainNeuralMtautau
+ * (TMVA weights file in XML format) into the compact dense-layer format
+ * read by NeuralMtautauMLP, and check that NeuralMtautauMLP reproduces the output of TMVA::Reader
+ *
+ * The outputs are compared for random inputs and, in case a training ntuple is given,
+ * for the input variables of the events contained in the ntuple.
+ *
+ * Usage: exportNeuralMtautau trainNeuralMtautau_MLP.weights.xml neuralMtautau_MLP.txt [trainingNtuple.root [treeName]]
+ *
+ */
+
+#include "TauAnalysis/CandidateTools/interface/NeuralMtautauMLP.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TMVA/Reader.h"
+#include "TMVA/Tools.h"
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+#include <TRandom3.h>
+#include <TMath.h>
+#include <TString.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // maximum relative difference between outputs of TMVA::Reader and NeuralMtautauMLP;
+  // the two differ by the rounding of single precision input and output values only
+  const double maxRelDiff = 1.e-5;
+
+  const size_t numEvents_random = 1000;
+  const int maxEvents_ntuple = 10000;
+
+//--- compare output of NeuralMtautauMLP to TMVA::Reader for one set of input variables
+  void compare(const NeuralMtautauMLP& mlp, TMVA::Reader& reader, std::vector<Float_t>& readerInputs,
+	       const std::vector<Float_t>& inputs, const std::string& label)
+  {
+    for ( unsigned idx = 0; idx < inputs.size(); ++idx ) {
+      readerInputs[idx] = inputs[idx];
+    }
+    double output_reader = reader.EvaluateRegression("MLP")[0];
+    double output_mlp = mlp.evaluate(&inputs[0]);
+    if ( TMath::Abs(output_mlp - output_reader) > maxRelDiff*TMath::Max(1., TMath::Abs(output_reader)) ) {
+      cms::Exception exception("exportNeuralMtautau");
+      exception << "Output of NeuralMtautauMLP = " << output_mlp << " differs from TMVA::Reader = " << output_reader
+		<< " for " << label << ", inputs = {";
+      for ( unsigned idx = 0; idx < inputs.size(); ++idx ) {
+	exception << " " << inputs[idx];
+      }
+      exception << " } !!\n";
+      throw exception;
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+//--- parse command-line arguments
+  if ( argc < 3 ) {
+    std::cout << "Usage: " << argv[0] << " [input.weights.xml] [output.txt] [trainingNtuple.root [treeName]]" << std::endl;
+    return 0;
+  }
+
+  std::cout << "<exportNeuralMtautau>:" << std::endl;
+
+  std::string inputFileName = argv[1];
+  std::string outputFileName = argv[2];
+  std::string ntupleFileName = ( argc >= 4 ) ? argv[3] : "";
+  std::string treeName = ( argc >= 5 ) ? argv[4] : "train";
+
+  NeuralMtautauMLP mlp;
+  mlp.readTMVAWeightsFile(inputFileName);
+  mlp.writeFile(outputFileName);
+  std::cout << " written neural net with " << mlp.numInputs() << " inputs to file = " << outputFileName << std::endl;
+
+  NeuralMtautauMLP mlp_exported;
+  mlp_exported.readFile(outputFileName);
+
+//--- book TMVA::Reader for the same weights file,
+//    using the input variable expressions stored in the weights file
+  TMVA::Tools::Instance();
+  TMVA::Reader reader("!Color:Silent");
+  const std::vector<std::string>& inputExpressions = mlp.inputExpressions();
+  std::vector<Float_t> readerInputs(mlp.numInputs());
+  for ( unsigned idx = 0; idx < mlp.numInputs(); ++idx ) {
+    reader.AddVariable(inputExpressions[idx].data(), &readerInputs[idx]);
+  }
+  reader.BookMVA("MLP", inputFileName.data());
+
+//--- check that network read back from output file gives identical results,
+//    and that results agree with TMVA::Reader, for random inputs
+  std::vector<Float_t> inputs(numEvents_random*mlp.numInputs());
+  TRandom3 rnd;
+  for ( std::vector<Float_t>::iterator input = inputs.begin();
+	input != inputs.end(); ++input ) {
+    (*input) = rnd.Gaus(0., 50.);
+  }
+  std::vector<Float_t> outputs(numEvents_random);
+  mlp_exported.evaluate(&inputs[0], numEvents_random, &outputs[0]);
+  for ( size_t iEvent = 0; iEvent < numEvents_random; ++iEvent ) {
+    Float_t output = mlp.evaluate(&inputs[iEvent*mlp.numInputs()]);
+    if ( output != outputs[iEvent] )
+      throw cms::Exception("exportNeuralMtautau")
+	<< "Output of exported neural net = " << outputs[iEvent] << " differs from original = " << output << " !!\n";
+    std::vector<Float_t> inputs_event(inputs.begin() + iEvent*mlp.numInputs(), inputs.begin() + (iEvent + 1)*mlp.numInputs());
+    compare(mlp_exported, reader, readerInputs, inputs_event, Form("random event #%i", (int)iEvent));
+  }
+  std::cout << " checked output of exported neural net for " << numEvents_random << " random inputs." << std::endl;
+
+//--- compare results with TMVA::Reader for events in training ntuple
+  if ( ntupleFileName != "" ) {
+    TFile* ntupleFile = new TFile(ntupleFileName.data());
+    TTree* tree = dynamic_cast<TTree*>(ntupleFile->Get(treeName.data()));
+    if ( !tree )
+      throw cms::Exception("exportNeuralMtautau")
+	<< "Failed to find tree = " << treeName << " in file = " << ntupleFileName << " !!\n";
+    std::vector<TTreeFormula*> treeFormulas;
+    for ( unsigned idx = 0; idx < mlp.numInputs(); ++idx ) {
+      treeFormulas.push_back(new TTreeFormula(Form("treeFormula%i", idx), inputExpressions[idx].data(), tree));
+    }
+    int numEntries = TMath::Min((int)tree->GetEntries(), maxEvents_ntuple);
+    std::vector<Float_t> inputs_event(mlp.numInputs());
+    for ( int iEntry = 0; iEntry < numEntries; ++iEntry ) {
+      tree->GetEntry(iEntry);
+      for ( unsigned idx = 0; idx < mlp.numInputs(); ++idx ) {
+	inputs_event[idx] = treeFormulas[idx]->EvalInstance();
+      }
+      compare(mlp_exported, reader, readerInputs, inputs_event, Form("entry #%i of tree = %s", iEntry, treeName.data()));
+    }
+    std::cout << " checked output of exported neural net for " << numEntries << " events of tree = " << treeName << "." << std::endl;
+    for ( std::vector<TTreeFormula*>::iterator treeFormula = treeFormulas.begin();
+	  treeFormula != treeFormulas.end(); ++treeFormula ) {
+      delete (*treeFormula);
+    }
+    delete ntupleFile;
+  }
+
+  return 0;
+}
@@ -2,6 +2,7 @@
 #include "TFile.h"
 
 #include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneAlgorithm.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneColumnarReader.h"
 
 /**
    \class nsvfitStandalone nsvfitStandalone.cc "TauAnalysis/CandidateTools/bin/nsvfitStandalone.cc"
@@ -63,51 +64,67 @@ void eventsFromTree(int argc, char* argv[])
 {
   // parse arguments
   if ( argc < 3 ) {
-    std::cout << "Usage : " << argv[0] << " [inputfile.root] [tree_name]" << std::endl;
+    std::cout << "Usage : " << argv[0] << " [inputfile.root] [tree_name] ([cachefile])" << std::endl;
     return;
   }
-  // get intput directory up to one before mass points
-  TFile* file = new TFile(argv[1]); 
-  // access tree in file
-  TTree* tree = (TTree*) file->Get(argv[2]);
-  // input variables
-  float met, metPhi;
-  float covMet11, covMet12; 
-  float covMet21, covMet22;
-  float l1M, l1Px, l1Py, l1Pz;
-  float l2M, l2Px, l2Py, l2Pz;
-  float mTrue;
-  // branch adresses
-  tree->SetBranchAddress("met"          , &met        );
-  tree->SetBranchAddress("mphi"         , &metPhi     );
-  tree->SetBranchAddress("mcov_11"      , &covMet11   );
-  tree->SetBranchAddress("mcov_12"      , &covMet12   );
-  tree->SetBranchAddress("mcov_21"      , &covMet21   );
-  tree->SetBranchAddress("mcov_22"      , &covMet22   );
-  tree->SetBranchAddress("l1_M"         , &l1M        );
-  tree->SetBranchAddress("l1_Px"        , &l1Px       );
-  tree->SetBranchAddress("l1_Py"        , &l1Py       );
-  tree->SetBranchAddress("l1_Pz"        , &l1Pz       );
-  tree->SetBranchAddress("l2_M"         , &l2M        );
-  tree->SetBranchAddress("l2_Px"        , &l2Px       );
-  tree->SetBranchAddress("l2_Py"        , &l2Py       );
-  tree->SetBranchAddress("l2_Pz"        , &l2Pz       );
-  tree->SetBranchAddress("m_true"       , &mTrue      );
-  int nevent = tree->GetEntries();
+  // input variables (read as contiguous columns; only the branches listed here are read from the tree)
+  std::vector<std::string> columnNames;
+  columnNames.push_back("met"    );
+  columnNames.push_back("mphi"   );
+  columnNames.push_back("mcov_11");
+  columnNames.push_back("mcov_12");
+  columnNames.push_back("mcov_21");
+  columnNames.push_back("mcov_22");
+  columnNames.push_back("l1_M"   );
+  columnNames.push_back("l1_Px"  );
+  columnNames.push_back("l1_Py"  );
+  columnNames.push_back("l1_Pz"  );
+  columnNames.push_back("l2_M"   );
+  columnNames.push_back("l2_Px"  );
+  columnNames.push_back("l2_Py"  );
+  columnNames.push_back("l2_Pz"  );
+  columnNames.push_back("m_true" );
+  NSVfitStandaloneColumnarReader columns(columnNames);
+  // optionally use memory-mapped cache file given as third argument (created if it does not yet exist)
+  std::string cacheFileName = ( argc >= 4 ) ? argv[3] : "";
+  if ( cacheFileName == "" || !columns.openCache(cacheFileName, argv[1]) ) {
+    // get intput directory up to one before mass points
+    TFile* file = new TFile(argv[1]); 
+    // access tree in file
+    TTree* tree = (TTree*) file->Get(argv[2]);
+    columns.readTree(tree);
+    if ( cacheFileName != "" ) columns.writeCache(cacheFileName, argv[1]);
+    delete file;
+  }
+  const Float_t* met      = columns.column("met"    );
+  const Float_t* metPhi   = columns.column("mphi"   );
+  const Float_t* covMet11 = columns.column("mcov_11");
+  const Float_t* covMet12 = columns.column("mcov_12");
+  const Float_t* covMet21 = columns.column("mcov_21");
+  const Float_t* covMet22 = columns.column("mcov_22");
+  const Float_t* l1M      = columns.column("l1_M"   );
+  const Float_t* l1Px     = columns.column("l1_Px"  );
+  const Float_t* l1Py     = columns.column("l1_Py"  );
+  const Float_t* l1Pz     = columns.column("l1_Pz"  );
+  const Float_t* l2M      = columns.column("l2_M"   );
+  const Float_t* l2Px     = columns.column("l2_Px"  );
+  const Float_t* l2Py     = columns.column("l2_Py"  );
+  const Float_t* l2Pz     = columns.column("l2_Pz"  );
+  const Float_t* mTrue    = columns.column("m_true" );
+  int nevent = columns.numEntries();
   for(int i=0; i<nevent; ++i){
-    tree->GetEvent(i);
     std::cout << "event " << i+1 << std::endl;
     // setup MET input vector
-    NSVfitStandalone::Vector measuredMET(met *TMath::Sin(metPhi), met *TMath::Cos(metPhi), 0); 
+    NSVfitStandalone::Vector measuredMET(met[i] *TMath::Sin(metPhi[i]), met[i] *TMath::Cos(metPhi[i]), 0); 
     // setup the MET significance
     TMatrixD covMET(2,2);
-    covMET[0][0] = covMet11;
-    covMET[0][1] = covMet12;
-    covMET[1][0] = covMet21;
-    covMET[1][1] = covMet22;
+    covMET[0][0] = covMet11[i];
+    covMET[0][1] = covMet12[i];
+    covMET[1][0] = covMet21[i];
+    covMET[1][1] = covMet22[i];
     // setup measure tau lepton vectors 
-    NSVfitStandalone::LorentzVector l1(l1Px, l1Py, l1Pz, TMath::Sqrt(l1M*l1M+l1Px*l1Px+l1Py*l1Py+l1Pz*l1Pz));
-    NSVfitStandalone::LorentzVector l2(l2Px, l2Py, l2Pz, TMath::Sqrt(l2M*l2M+l2Px*l2Px+l2Py*l2Py+l2Pz*l2Pz));
+    NSVfitStandalone::LorentzVector l1(l1Px[i], l1Py[i], l1Pz[i], TMath::Sqrt(l1M[i]*l1M[i]+l1Px[i]*l1Px[i]+l1Py[i]*l1Py[i]+l1Pz[i]*l1Pz[i]));
+    NSVfitStandalone::LorentzVector l2(l2Px[i], l2Py[i], l2Pz[i], TMath::Sqrt(l2M[i]*l2M[i]+l2Px[i]*l2Px[i]+l2Py[i]*l2Py[i]+l2Pz[i]*l2Pz[i]));
     std::vector<NSVfitStandalone::MeasuredTauLepton> measuredTauLeptons;
     measuredTauLeptons.push_back(NSVfitStandalone::MeasuredTauLepton(std::string(argv[2])==std::string("EMu") ? NSVfitStandalone::kLepDecay : NSVfitStandalone::kLepDecay, l1));
     measuredTauLeptons.push_back(NSVfitStandalone::MeasuredTauLepton(std::string(argv[2])==std::string("EMu") ? NSVfitStandalone::kLepDecay : NSVfitStandalone::kHadDecay, l2));
@@ -120,7 +137,7 @@ void eventsFromTree(int argc, char* argv[])
     // run the fit
     algo.fit();
     // retrieve the results upon success
-    std::cout << "... m truth : " << mTrue  << std::endl;
+    std::cout << "... m truth : " << mTrue[i]  << std::endl;
     if(algo.isValidSolution()){
       std::cout << "... m svfit : " << algo.mass() << "+/-" << algo.massUncert() << std::endl;
     }
@@ -0,0 +1,276 @@
+
+/** \executable prepareNeuralMtautauTrainingData
+ *
+ * Prepare compact training and test samples for training the neural network
+ * for reconstruction of tau+ tau- invariant mass (bin/trainNeuralMtautau.cc)
+ * from the n-tuples produced by NeuralMtautauNtupleProducer.
+ *
+ * The input files are processed by several worker processes in parallel.
+ * For each event the input variable expressions and the target are evaluated
+ * and stored as columns 'var0', 'var1',..., 'target', on which the network is trained
+ * (trainNeuralMtautau maps the columns back to the original expressions in the TMVA weights file).
+ * The branches referenced by the expressions are kept as well, with their original types,
+ * so that the expressions can still be evaluated on the prepared samples (cf. exportNeuralMtautau).
+ * All other branches are dropped.
+ *
+ * Each worker processes a contiguous block of input files and the outputs of the workers
+ * are merged in order of the worker index, so that the events in the prepared samples
+ * are in the same order as in the input files, independent of the number of workers.
+ *
+ * Events are assigned to the training or test sample according to their event number,
+ * so that the split is reproducible when the n-tuples are reprocessed.
+ *
+ */
+
+#include "FWCore/FWLite/interface/AutoLibraryLoader.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/PythonParameterSet/interface/MakeParameterSets.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/FWLite/interface/InputSource.h"
+
+#include <TSystem.h>
+#include <TFile.h>
+#include <TChain.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+#include <TLeaf.h>
+#include <TString.h>
+#include <TBenchmark.h>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+
+typedef std::vector<std::string> vstring;
+
+struct preparationConfigType
+{
+  std::string treeName_;
+  vstring inputExpressions_;
+  std::string targetExpression_;
+  std::string selection_;
+  std::string eventBranchName_;
+  unsigned testFractionPerMille_;
+};
+
+//--- process subset of input files, write training and test samples to output file given as function argument
+void prepareTrainingData(const preparationConfigType& cfg, const vstring& inputFileNames, const std::string& outputFileName)
+{
+  TChain* inputTree = new TChain(cfg.treeName_.data());
+  for ( vstring::const_iterator inputFileName = inputFileNames.begin();
+	inputFileName != inputFileNames.end(); ++inputFileName ) {
+    inputTree->AddFile(inputFileName->data());
+  }
+
+  std::vector<TTreeFormula*> inputFormulas;
+  for ( vstring::const_iterator inputExpression = cfg.inputExpressions_.begin();
+	inputExpression != cfg.inputExpressions_.end(); ++inputExpression ) {
+    inputFormulas.push_back(new TTreeFormula(Form("var%i", (int)inputFormulas.size()), inputExpression->data(), inputTree));
+  }
+  TTreeFormula* targetFormula = new TTreeFormula("target", cfg.targetExpression_.data(), inputTree);
+  TTreeFormula* selectionFormula = ( cfg.selection_ != "" ) ?
+    new TTreeFormula("selection", cfg.selection_.data(), inputTree) : 0;
+  TTreeFormula* eventFormula = new TTreeFormula("event", cfg.eventBranchName_.data(), inputTree);
+
+  std::vector<TTreeFormula*> allFormulas = inputFormulas;
+  allFormulas.push_back(targetFormula);
+  if ( selectionFormula ) allFormulas.push_back(selectionFormula);
+  allFormulas.push_back(eventFormula);
+
+//--- find branches referenced by expressions;
+//    only these are read from the input files and kept in the output
+  std::set<std::string> referencedBranchNames;
+  for ( std::vector<TTreeFormula*>::const_iterator formula = allFormulas.begin();
+	formula != allFormulas.end(); ++formula ) {
+    if ( !(*formula)->GetNdim() )
+      throw cms::Exception("prepareNeuralMtautauTrainingData")
+	<< "Failed to compile expression = " << (*formula)->GetTitle() << " !!\n";
+    for ( int iCode = 0; iCode < (*formula)->GetNcodes(); ++iCode ) {
+      TLeaf* leaf = (*formula)->GetLeaf(iCode);
+      if ( leaf ) referencedBranchNames.insert(leaf->GetBranch()->GetName());
+    }
+  }
+  inputTree->SetBranchStatus("*", 0);
+  for ( std::set<std::string>::const_iterator branchName = referencedBranchNames.begin();
+	branchName != referencedBranchNames.end(); ++branchName ) {
+    inputTree->SetBranchStatus(branchName->data(), 1);
+  }
+
+//--- clone referenced branches, keeping the types of the input branches,
+//    and add columns for input variables and target
+  TFile* outputFile = new TFile(outputFileName.data(), "RECREATE");
+  const char* outputTreeNames[] = { "train", "test" };
+  TTree* outputTrees[2];
+  std::vector<Float_t> inputValues(inputFormulas.size());
+  Float_t targetValue;
+  for ( int iTree = 0; iTree < 2; ++iTree ) {
+    outputFile->cd();
+    outputTrees[iTree] = inputTree->CloneTree(0);
+    outputTrees[iTree]->SetNameTitle(outputTreeNames[iTree], outputTreeNames[iTree]);
+    for ( size_t iInput = 0; iInput < inputFormulas.size(); ++iInput ) {
+      outputTrees[iTree]->Branch(Form("var%i", (int)iInput), &inputValues[iInput], Form("var%i/F", (int)iInput));
+    }
+    outputTrees[iTree]->Branch("target", &targetValue, "target/F");
+  }
+
+  int currentTreeNumber = -1;
+  Long64_t numEntries = inputTree->GetEntries();
+  for ( Long64_t iEntry = 0; iEntry < numEntries; ++iEntry ) {
+    Long64_t iLocalEntry = inputTree->LoadTree(iEntry);
+    if ( iLocalEntry < 0 ) break;
+    if ( inputTree->GetTreeNumber() != currentTreeNumber ) {
+      for ( std::vector<TTreeFormula*>::iterator formula = allFormulas.begin();
+	    formula != allFormulas.end(); ++formula ) {
+	(*formula)->UpdateFormulaLeaves();
+      }
+      currentTreeNumber = inputTree->GetTreeNumber();
+    }
+    inputTree->GetEntry(iEntry);
+
+    if ( selectionFormula && !(selectionFormula->EvalInstance() > 0.5) ) continue;
+
+    for ( size_t iInput = 0; iInput < inputFormulas.size(); ++iInput ) {
+      inputValues[iInput] = inputFormulas[iInput]->EvalInstance();
+    }
+    targetValue = targetFormula->EvalInstance();
+
+    Long64_t eventNumber = (Long64_t)eventFormula->EvalInstance64();
+    bool isTest = ((eventNumber % 1000) < cfg.testFractionPerMille_);
+    outputTrees[isTest ? 1 : 0]->Fill();
+  }
+
+  outputFile->Write();
+  delete outputFile;
+
+  for ( std::vector<TTreeFormula*>::iterator formula = allFormulas.begin();
+	formula != allFormulas.end(); ++formula ) {
+    delete (*formula);
+  }
+  delete inputTree;
+}
+
+int main(int argc, char* argv[])
+{
+//--- parse command-line arguments
+  if ( argc < 2 ) {
+    std::cout << "Usage: " << argv[0] << " [parameters.py]" << std::endl;
+    return 0;
+  }
+
+  std::cout << "<prepareNeuralMtautauTrainingData>:" << std::endl;
+
+//--- load framework libraries
+  gSystem->Load("libFWCoreFWLite");
+  AutoLibraryLoader::enable();
+
+//--- keep track of time it takes the macro to execute
+  TBenchmark clock;
+  clock.Start("prepareNeuralMtautauTrainingData");
+
+//--- read python configuration parameters
+  if ( !edm::readPSetsFrom(argv[1])->existsAs<edm::ParameterSet>("process") )
+    throw cms::Exception("prepareNeuralMtautauTrainingData")
+      << "No ParameterSet 'process' found in configuration file = " << argv[1] << " !!\n";
+
+  edm::ParameterSet cfg = edm::readPSetsFrom(argv[1])->getParameter<edm::ParameterSet>("process");
+
+  edm::ParameterSet cfgPrepareTrainingData = cfg.getParameter<edm::ParameterSet>("prepareNeuralMtautauTrainingData");
+
+  preparationConfigType preparationConfig;
+  preparationConfig.treeName_ = cfgPrepareTrainingData.getParameter<std::string>("treeName");
+  preparationConfig.inputExpressions_ = cfgPrepareTrainingData.getParameter<vstring>("inputBranchNames");
+  preparationConfig.targetExpression_ = cfgPrepareTrainingData.getParameter<std::string>("targetBranchName");
+  preparationConfig.selection_ = ( cfgPrepareTrainingData.exists("selection") ) ?
+    cfgPrepareTrainingData.getParameter<std::string>("selection") : "";
+  preparationConfig.eventBranchName_ = ( cfgPrepareTrainingData.exists("eventBranchName") ) ?
+    cfgPrepareTrainingData.getParameter<std::string>("eventBranchName") : "event";
+  double testFraction = cfgPrepareTrainingData.getParameter<double>("testFraction");
+  if ( !(testFraction >= 0. && testFraction < 1.) )
+    throw cms::Exception("prepareNeuralMtautauTrainingData")
+      << "Invalid Configuration parameter 'testFraction' = " << testFraction << " !!\n";
+  preparationConfig.testFractionPerMille_ = (unsigned)(1000.*testFraction + 0.5);
+  unsigned numWorkers = ( cfgPrepareTrainingData.exists("numWorkers") ) ?
+    cfgPrepareTrainingData.getParameter<unsigned>("numWorkers") : 1;
+  if ( numWorkers < 1 ) numWorkers = 1;
+  std::string outputFileName = cfgPrepareTrainingData.getParameter<std::string>("outputFileName");
+
+  fwlite::InputSource inputFiles(cfg);
+  const vstring& inputFileNames = inputFiles.files();
+  if ( inputFileNames.size() == 0 )
+    throw cms::Exception("prepareNeuralMtautauTrainingData")
+      << "No input files given !!\n";
+  if ( numWorkers > inputFileNames.size() ) numWorkers = inputFileNames.size();
+
+//--- distribute input files on worker processes in contiguous blocks;
+//    each worker writes its own output file, which are merged at the end.
+//   (worker processes are used instead of threads, as ROOT I/O is not thread-safe)
+  vstring outputFileNames_worker;
+  std::vector<pid_t> workerPIds;
+  std::cout.flush();
+  for ( unsigned iWorker = 0; iWorker < numWorkers; ++iWorker ) {
+    size_t iFirstFile = (iWorker*inputFileNames.size())/numWorkers;
+    size_t iLastFile = ((iWorker + 1)*inputFileNames.size())/numWorkers;
+    vstring inputFileNames_worker(inputFileNames.begin() + iFirstFile, inputFileNames.begin() + iLastFile);
+    std::string outputFileName_worker = Form("%s.part%u.root", outputFileName.data(), iWorker);
+    outputFileNames_worker.push_back(outputFileName_worker);
+    pid_t pid = fork();
+    if ( pid < 0 )
+      throw cms::Exception("prepareNeuralMtautauTrainingData")
+	<< "Failed to fork worker #" << iWorker << " !!\n";
+    if ( pid == 0 ) {
+      int status = 0;
+      try {
+	prepareTrainingData(preparationConfig, inputFileNames_worker, outputFileName_worker);
+      } catch ( cms::Exception& e ) {
+	std::cerr << e.what() << std::endl;
+	status = 1;
+      }
+      _exit(status); // do not run exit handlers/destructors of objects owned by parent process
+    }
+    workerPIds.push_back(pid);
+  }
+
+  bool isSuccess = true;
+  for ( unsigned iWorker = 0; iWorker < numWorkers; ++iWorker ) {
+    int status = 0;
+    waitpid(workerPIds[iWorker], &status, 0);
+    if ( !(WIFEXITED(status) && WEXITSTATUS(status) == 0) ) isSuccess = false;
+  }
+  if ( !isSuccess )
+    throw cms::Exception("prepareNeuralMtautauTrainingData")
+      << "Failed to prepare training data in worker processes !!\n";
+
+//--- merge output files of worker processes in order of the worker index
+//   (outputFileNames_worker is indexed by worker, independent of the order in which the workers finished)
+  TFile* outputFile = new TFile(outputFileName.data(), "RECREATE");
+  const char* treeNames[] = { "train", "test" };
+  for ( int iTree = 0; iTree < 2; ++iTree ) {
+    TChain* chain = new TChain(treeNames[iTree]);
+    for ( vstring::const_iterator outputFileName_worker = outputFileNames_worker.begin();
+	  outputFileName_worker != outputFileNames_worker.end(); ++outputFileName_worker ) {
+      chain->AddFile(outputFileName_worker->data());
+    }
+    outputFile->cd();
+    TTree* tree = chain->CloneTree(-1, "fast");
+    std::cout << " " << treeNames[iTree] << ": " << tree->GetEntries() << " events." << std::endl;
+    tree->Write();
+    delete chain;
+  }
+  delete outputFile;
+  for ( vstring::const_iterator outputFileName_worker = outputFileNames_worker.begin();
+	outputFileName_worker != outputFileNames_worker.end(); ++outputFileName_worker ) {
+    gSystem->Unlink(outputFileName_worker->data());
+  }
+
+  clock.Show("prepareNeuralMtautauTrainingData");
+
+  return 0;
+}
@@ -0,0 +1,268 @@
+/** \executable replaySVfitInputs
+ *
+ * Replay SVfit computation for tau lepton pairs recorded by CompositePtrCandidateT1T2MEtProducer
+ * (cf. interface/NSVfitInputRecorder.h), using the standalone version of SVfit,
+ * and measure the time spent per pair.
+ *
+ * In case an output file is given, the replayed solutions are added to the records
+ * (label = "replaySVfitInputs_" + mode) and the records are written to the output file.
+ * When the output file of an earlier replay is replayed with the same mode,
+ * the masses are compared to the solutions of the earlier replay,
+ * which provides a regression check of the standalone version of SVfit that does not require cmsRun.
+ *
+ * The masses are also compared to the solutions of earlier replays with other modes contained in the records,
+ * which, together with the time and the number of likelihood evaluations per pair,
+ * allows to compare the precision and speed of the different integration methods.
+ *
+ * NOTE: the solutions recorded by the CMSSW modules are computed by the nSVfit plugin algorithms, not by the standalone version.
+ *       For records without a solution of an earlier replay, the mass is compared to the first recorded solution;
+ *       this comparison shows differences between the two algorithms and is not a regression check.
+ *       The standalone version uses the kinematic and MET likelihoods only;
+ *       the recorded primary event vertex and tracks are not used in the replay.
+ *       The recorded decay modes determine the type of tau lepton decay (hadronic or leptonic).
+ *
+ * Usage: replaySVfitInputs inputFile [mode] [maxPairs] [maxIntegrandCalls] [outputFile]
+ *   mode = 'markovChain' (default), 'vegas', 'vegasMultiMass', 'qmc' or 'fit'
+ *
+ * Example (comparison of VEGAS integration per mass hypothesis and of all mass hypotheses at once):
+ *   replaySVfitInputs svfitInputs.bin vegas -1 0 svfitInputs_vegas.bin
+ *   replaySVfitInputs svfitInputs_vegas.bin vegasMultiMass -1 0 svfitInputs_vegas_vegasMultiMass.bin
+ *
+ */
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TauAnalysis/CandidateTools/interface/NSVfitInputRecorder.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneAlgorithm.h"
+
+#include <TMath.h>
+#include <TMatrixD.h>
+#include <TStopwatch.h>
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <stdlib.h>
+
+namespace
+{
+  // maximum relative difference between replayed mass and mass of earlier replay
+  // for which the solutions are considered to be unchanged
+  const double maxRelDiff_unchanged = 1.e-4;
+
+  // sums of relative differences between replayed mass and mass of earlier replay with other mode
+  struct massComparisonType
+  {
+    massComparisonType()
+      : numComparisons_(0),
+	sumMassDiff_(0.),
+	sumMassDiff2_(0.)
+    {}
+    int numComparisons_;
+    double sumMassDiff_;
+    double sumMassDiff2_;
+  };
+}
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 2 ) {
+    std::cout << "Usage: " << argv[0] << " inputFile [mode] [maxPairs] [maxIntegrandCalls] [outputFile]" << std::endl;
+    return 0;
+  }
+
+  std::string inputFileName = argv[1];
+  std::string mode = ( argc >= 3 ) ? argv[2] : "markovChain";
+  if ( !(mode == "markovChain" || mode == "vegas" || mode == "vegasMultiMass" || mode == "qmc" || mode == "fit") )
+    throw cms::Exception("replaySVfitInputs")
+      << "Invalid mode = " << mode << ", expected 'markovChain', 'vegas', 'vegasMultiMass', 'qmc' or 'fit' !!\n";
+  int maxPairs = ( argc >= 4 ) ? atoi(argv[3]) : -1;
+  unsigned maxIntegrandCalls = ( argc >= 5 ) ? atoi(argv[4]) : 0;
+  std::string outputFileName = ( argc >= 6 ) ? argv[5] : "";
+  if ( outputFileName == inputFileName )
+    throw cms::Exception("replaySVfitInputs")
+      << "Output file must differ from input file = " << inputFileName << " !!\n";
+
+  std::string replayLabel = std::string("replaySVfitInputs_").append(mode);
+
+  std::cout << "<replaySVfitInputs>:" << std::endl;
+  std::cout << " inputFile = " << inputFileName << std::endl;
+  std::cout << " mode = " << mode << std::endl;
+  if ( outputFileName != "" ) std::cout << " outputFile = " << outputFileName << std::endl;
+
+  NSVfitInputReader reader(inputFileName);
+  NSVfitInputRecord record;
+
+  NSVfitInputRecorder* recorder = ( outputFileName != "" ) ? 
+    new NSVfitInputRecorder(outputFileName) : 0;
+
+  TStopwatch timer;
+  timer.Stop();
+
+  int numPairs = 0;
+  int numPairs_skipped = 0;
+  int numPairs_valid = 0;
+  int numPairs_withTracks = 0;
+  int numPairs_withPrimaryVertex = 0;
+  double recordedTime = 0.;
+  int numRecordedTimes = 0;
+  int numMassComparisons = 0;
+  double sumMassDiff = 0.;
+  double sumMassDiff2 = 0.;
+  int numRegressionComparisons = 0;
+  int numRegressionComparisons_changed = 0;
+  double maxRegressionMassDiff = 0.;
+  double sumIntegrandCalls = 0.;
+  std::map<std::string, massComparisonType> otherReplayComparisons; // key = label of earlier replay with other mode
+
+  while ( reader.read(record) ) {
+    if ( maxPairs >= 0 && numPairs >= maxPairs ) break;
+
+//--- standalone version of SVfit supports pairs of two tau leptons only
+    if ( record.legs_.size() != 2 ) {
+      ++numPairs_skipped;
+      continue;
+    }
+
+    std::vector<NSVfitStandalone::MeasuredTauLepton> measuredTauLeptons;
+    bool hasTracks = false;
+    for ( std::vector<NSVfitInputRecord::legType>::const_iterator leg = record.legs_.begin();
+	  leg != record.legs_.end(); ++leg ) {
+//--- decay mode is recorded for tau-jets only (-1 for electrons and muons)
+      NSVfitStandalone::kDecayType decayType = NSVfitStandalone::kHadDecay;
+      if ( leg->decayMode_ < 0 && (TMath::Abs(leg->pdgId_) == 11 || TMath::Abs(leg->pdgId_) == 13) ) 
+	decayType = NSVfitStandalone::kLepDecay;
+      NSVfitStandalone::LorentzVector p4(leg->px_, leg->py_, leg->pz_, leg->energy_);
+      measuredTauLeptons.push_back(NSVfitStandalone::MeasuredTauLepton(decayType, p4));
+      if ( leg->tracks_.size() > 0 ) hasTracks = true;
+    }
+    if ( hasTracks ) ++numPairs_withTracks;
+    if ( record.hasPrimaryVertex_ ) ++numPairs_withPrimaryVertex;
+    NSVfitStandalone::Vector measuredMET(record.metPx_, record.metPy_, 0.);
+    TMatrixD covMET(2, 2);
+    covMET(0, 0) = record.metCov_[0];
+    covMET(0, 1) = record.metCov_[1];
+    covMET(1, 0) = record.metCov_[2];
+    covMET(1, 1) = record.metCov_[3];
+
+    TStopwatch timerPair;
+    timer.Start(false);
+    NSVfitStandaloneAlgorithm algorithm(measuredTauLeptons, measuredMET, covMET, 0);
+    algorithm.addLogM(false);
+    if ( maxIntegrandCalls > 0 ) algorithm.maxIntegrandCalls(maxIntegrandCalls);
+    if      ( mode == "markovChain"    ) algorithm.integrateMarkovChain();
+    else if ( mode == "vegas"          ) algorithm.integrateVEGAS();
+    else if ( mode == "vegasMultiMass" ) algorithm.integrateVEGASMultiMass();
+    else if ( mode == "qmc"            ) algorithm.integrateQMC();
+    else                                 algorithm.fit();
+    timer.Stop();
+    timerPair.Stop();
+
+    bool isValidSolution = ( mode == "fit" ) ? algorithm.isValidSolution() : algorithm.isValidNLL();
+    if ( isValidSolution ) ++numPairs_valid;
+    sumIntegrandCalls += algorithm.numIntegrandCalls();
+
+    std::cout << "run = " << record.run_ << ", ls = " << record.lumi_ << ", event = " << record.event_ << ":"
+	      << " mass = " << algorithm.mass();
+
+//--- compare to solution of earlier replay with the same mode, if available;
+//    else compare to first solution recorded by the CMSSW modules
+    std::vector<NSVfitInputRecord::resultType>::iterator replayResult = record.results_.end();
+    for ( std::vector<NSVfitInputRecord::resultType>::iterator result = record.results_.begin();
+	  result != record.results_.end(); ++result ) {
+      if ( result->label_ == replayLabel ) {
+	replayResult = result;
+      } else if ( result->label_.find("replaySVfitInputs_") == 0 ) {
+	if ( isValidSolution && result->isValidSolution_ && result->mass_ > 0. ) {
+	  massComparisonType& otherReplayComparison = otherReplayComparisons[result->label_];
+	  double massDiff = (algorithm.mass() - result->mass_)/result->mass_;
+	  otherReplayComparison.sumMassDiff_ += massDiff;
+	  otherReplayComparison.sumMassDiff2_ += massDiff*massDiff;
+	  ++otherReplayComparison.numComparisons_;
+	}
+      }
+    }
+    if ( replayResult != record.results_.end() ) {
+      std::cout << " (earlier replay = " << replayResult->mass_ << ")";
+      if ( isValidSolution != (bool)replayResult->isValidSolution_ ) {
+	std::cout << " [validity changed]";
+	++numRegressionComparisons_changed;
+      } else if ( isValidSolution && replayResult->mass_ > 0. ) {
+	double massDiff = TMath::Abs(algorithm.mass() - replayResult->mass_)/replayResult->mass_;
+	if ( massDiff > maxRegressionMassDiff ) maxRegressionMassDiff = massDiff;
+	if ( massDiff > maxRelDiff_unchanged ) {
+	  std::cout << " [changed]";
+	  ++numRegressionComparisons_changed;
+	}
+      }
+      ++numRegressionComparisons;
+    } else if ( record.results_.size() >= 1 ) {
+      const NSVfitInputRecord::resultType& result = record.results_.front();
+      std::cout << " (recorded: " << result.label_ << " = " << result.mass_ << ")";
+      recordedTime += result.time_;
+      ++numRecordedTimes;
+      if ( isValidSolution && result.isValidSolution_ && result.mass_ > 0. ) {
+	double massDiff = (algorithm.mass() - result.mass_)/result.mass_;
+	sumMassDiff += massDiff;
+	sumMassDiff2 += massDiff*massDiff;
+	++numMassComparisons;
+      }
+    }
+    if ( algorithm.isBudgetExhausted() ) std::cout << " [budget exhausted]";
+    std::cout << std::endl;
+
+    if ( recorder ) {
+      NSVfitInputRecord::resultType result;
+      result.label_ = replayLabel;
+      result.isValidSolution_ = isValidSolution;
+      result.mass_ = algorithm.mass();
+      result.massErrUp_ = algorithm.massUncert();
+      result.massErrDown_ = algorithm.massUncert();
+      result.time_ = timerPair.RealTime();
+      if ( replayResult != record.results_.end() ) (*replayResult) = result;
+      else record.results_.push_back(result);
+      recorder->write(record);
+    }
+
+    ++numPairs;
+  }
+
+  std::cout << std::endl;
+  std::cout << "replayed " << numPairs << " pairs (valid solution = " << numPairs_valid << ")";
+  if ( numPairs_skipped > 0 ) std::cout << ", skipped " << numPairs_skipped << " records with number of legs != 2";
+  std::cout << "." << std::endl;
+  if ( numPairs_withTracks > 0 || numPairs_withPrimaryVertex > 0 ) 
+    std::cout << " (tracks recorded for " << numPairs_withTracks << " pairs,"
+	      << " primary event vertex for " << numPairs_withPrimaryVertex << " pairs; not used by the replay)" << std::endl;
+  if ( numPairs > 0 ) {
+    std::cout << " real/CPU time = " << timer.RealTime() << "/" << timer.CpuTime() << " seconds" << std::endl;
+    std::cout << " real/CPU time per pair = "
+	      << timer.RealTime()/numPairs << "/" << timer.CpuTime()/numPairs << " seconds";
+    if ( numRecordedTimes > 0 ) std::cout << " (recorded real time per pair = " << recordedTime/numRecordedTimes << " seconds)";
+    std::cout << std::endl;
+    if ( mode != "fit" ) 
+      std::cout << " likelihood evaluations per pair = " << sumIntegrandCalls/numPairs << std::endl;
+  }
+  if ( numRegressionComparisons > 0 ) {
+    std::cout << " regression check against earlier replay: " << numRegressionComparisons_changed << " out of " 
+	      << numRegressionComparisons << " pairs changed, max. |mass - earlier mass|/earlier mass = " << maxRegressionMassDiff << std::endl;
+  }
+  for ( std::map<std::string, massComparisonType>::const_iterator otherReplayComparison = otherReplayComparisons.begin();
+	otherReplayComparison != otherReplayComparisons.end(); ++otherReplayComparison ) {
+    int numComparisons = otherReplayComparison->second.numComparisons_;
+    double meanMassDiff = otherReplayComparison->second.sumMassDiff_/numComparisons;
+    double rmsMassDiff = TMath::Sqrt(TMath::Max(0., otherReplayComparison->second.sumMassDiff2_/numComparisons - meanMassDiff*meanMassDiff));
+    std::cout << " (mass - mass of " << otherReplayComparison->first << ")/mass of " << otherReplayComparison->first << ":"
+	      << " mean = " << meanMassDiff << ", rms = " << rmsMassDiff << " (" << numComparisons << " pairs)" << std::endl;
+  }
+  if ( numMassComparisons > 0 ) {
+    double meanMassDiff = sumMassDiff/numMassComparisons;
+    double rmsMassDiff = TMath::Sqrt(TMath::Max(0., sumMassDiff2/numMassComparisons - meanMassDiff*meanMassDiff));
+    std::cout << " (mass - recorded mass)/recorded mass: mean = " << meanMassDiff << ", rms = " << rmsMassDiff
+	      << " (" << numMassComparisons << " pairs; recorded by nSVfit plugin algorithms, not a regression check)" << std::endl;
+  }
+
+  delete recorder;
+
+  return ( numRegressionComparisons_changed > 0 ) ? 1 : 0;
+}
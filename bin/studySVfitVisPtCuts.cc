@@ -25,6 +25,7 @@
 
 #include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneAlgorithm.h"
 #include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneLikelihood.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneColumnarReader.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 #include "DataFormats/Candidate/interface/Candidate.h"
 
@@ -39,6 +40,10 @@
 #include <TMath.h>
 #include <TRandom3.h>
 
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <iostream>
 #include <string>
 #include <vector>
@@ -48,58 +53,17 @@ using namespace SVfit_namespace;
 
 struct inputVariableSet
 {
-  inputVariableSet(TTree* tree, bool runSVfit)
+  inputVariableSet(bool runSVfit)
     : recMEtCov_(2,2),
       runSVfit_(runSVfit)
-  {
-    if ( tree ) {
-      tree->SetBranchAddress("genTau1En", &genTau1En_);
-      tree->SetBranchAddress("genTau1Px", &genTau1Px_);
-      tree->SetBranchAddress("genTau1Py", &genTau1Py_);
-      tree->SetBranchAddress("genTau1Pz", &genTau1Pz_);
-      tree->SetBranchAddress("genTau1M", &genTau1Mass_);
-      tree->SetBranchAddress("genVis1En", &genVis1En_);
-      tree->SetBranchAddress("genVis1Px", &genVis1Px_);
-      tree->SetBranchAddress("genVis1Py", &genVis1Py_);
-      tree->SetBranchAddress("genVis1Pz", &genVis1Pz_);
-      tree->SetBranchAddress("genVis1M", &genVis1Mass_);
-      tree->SetBranchAddress("genNu1En", &genNu1En_);
-      tree->SetBranchAddress("genNu1Px", &genNu1Px_);
-      tree->SetBranchAddress("genNu1Py", &genNu1Py_);
-      tree->SetBranchAddress("genNu1Pz", &genNu1Pz_);
-      tree->SetBranchAddress("genNu1M", &genNu1Mass_);
-      
-      tree->SetBranchAddress("genTau2En", &genTau2En_);
-      tree->SetBranchAddress("genTau2Px", &genTau2Px_);
-      tree->SetBranchAddress("genTau2Py", &genTau2Py_);
-      tree->SetBranchAddress("genTau2Pz", &genTau2Pz_);
-      tree->SetBranchAddress("genTau2M", &genTau2Mass_);
-      tree->SetBranchAddress("genVis2En", &genVis2En_);
-      tree->SetBranchAddress("genVis2Px", &genVis2Px_);
-      tree->SetBranchAddress("genVis2Py", &genVis2Py_);
-      tree->SetBranchAddress("genVis2Pz", &genVis2Pz_);
-      tree->SetBranchAddress("genVis2M", &genVis2Mass_);
-      tree->SetBranchAddress("genNu2En", &genNu2En_);
-      tree->SetBranchAddress("genNu2Px", &genNu2Px_);
-      tree->SetBranchAddress("genNu2Py", &genNu2Py_);
-      tree->SetBranchAddress("genNu2Pz", &genNu2Pz_);
-      tree->SetBranchAddress("genNu2M", &genNu2Mass_);
-      
-      tree->SetBranchAddress("recMEtPx", &recMEtPx_);
-      tree->SetBranchAddress("recMEtPy", &recMEtPy_);
-      tree->SetBranchAddress("recMEtVxx", &recMEtVxx_);
-      tree->SetBranchAddress("recMEtVxy", &recMEtVxy_);
-      tree->SetBranchAddress("recMEtVyy", &recMEtVyy_);
-      
-      tree->SetBranchAddress("genMEtPx", &genMEtPx_);
-      tree->SetBranchAddress("genMEtPy", &genMEtPy_);
-      
-      tree->SetBranchAddress("genMtautau", &genMtautau_);
-    }
-  }
+  {}
   ~inputVariableSet() {}
 
-  void initialize()
+  static std::vector<std::string> columnNames();
+
+  void loadEntry(const NSVfitStandaloneColumnarReader& columns, size_t iEntry);
+
+  void initialize(bool compSVfitMass = true)
   {
     genTau1P4_.SetPxPyPzE(genTau1Px_, genTau1Py_, genTau1Pz_, genTau1En_);
     genVis1P4_.SetPxPyPzE(genVis1Px_, genVis1Py_, genVis1Pz_, genVis1En_);
@@ -114,7 +78,7 @@ struct inputVariableSet
     recMEtCov_(1,0) = recMEtVxy_;
     recMEtCov_(1,1) = recMEtVyy_;
 
-    if ( runSVfit_ ) {
+    if ( runSVfit_ && compSVfitMass ) {
       svFitMassFromGenInput_ = compSVfitMassFromGenInput();
     } else {
       svFitMassFromGenInput_ = -1.;
@@ -224,6 +188,71 @@ struct inputVariableSet
   Float_t svFitMassFromGenInput_; // computed "on-the-fly"
 };
 
+//--- mapping of n-tuple branches to data-members of inputVariableSet
+struct columnEntryType
+{
+  const char* columnName_;
+  Float_t inputVariableSet::* value_;
+};
+
+const columnEntryType columnEntries[] = {
+  { "genTau1En", &inputVariableSet::genTau1En_ },
+  { "genTau1Px", &inputVariableSet::genTau1Px_ },
+  { "genTau1Py", &inputVariableSet::genTau1Py_ },
+  { "genTau1Pz", &inputVariableSet::genTau1Pz_ },
+  { "genTau1M", &inputVariableSet::genTau1Mass_ },
+  { "genVis1En", &inputVariableSet::genVis1En_ },
+  { "genVis1Px", &inputVariableSet::genVis1Px_ },
+  { "genVis1Py", &inputVariableSet::genVis1Py_ },
+  { "genVis1Pz", &inputVariableSet::genVis1Pz_ },
+  { "genVis1M", &inputVariableSet::genVis1Mass_ },
+  { "genNu1En", &inputVariableSet::genNu1En_ },
+  { "genNu1Px", &inputVariableSet::genNu1Px_ },
+  { "genNu1Py", &inputVariableSet::genNu1Py_ },
+  { "genNu1Pz", &inputVariableSet::genNu1Pz_ },
+  { "genNu1M", &inputVariableSet::genNu1Mass_ },
+  { "genTau2En", &inputVariableSet::genTau2En_ },
+  { "genTau2Px", &inputVariableSet::genTau2Px_ },
+  { "genTau2Py", &inputVariableSet::genTau2Py_ },
+  { "genTau2Pz", &inputVariableSet::genTau2Pz_ },
+  { "genTau2M", &inputVariableSet::genTau2Mass_ },
+  { "genVis2En", &inputVariableSet::genVis2En_ },
+  { "genVis2Px", &inputVariableSet::genVis2Px_ },
+  { "genVis2Py", &inputVariableSet::genVis2Py_ },
+  { "genVis2Pz", &inputVariableSet::genVis2Pz_ },
+  { "genVis2M", &inputVariableSet::genVis2Mass_ },
+  { "genNu2En", &inputVariableSet::genNu2En_ },
+  { "genNu2Px", &inputVariableSet::genNu2Px_ },
+  { "genNu2Py", &inputVariableSet::genNu2Py_ },
+  { "genNu2Pz", &inputVariableSet::genNu2Pz_ },
+  { "genNu2M", &inputVariableSet::genNu2Mass_ },
+  { "recMEtPx", &inputVariableSet::recMEtPx_ },
+  { "recMEtPy", &inputVariableSet::recMEtPy_ },
+  { "recMEtVxx", &inputVariableSet::recMEtVxx_ },
+  { "recMEtVxy", &inputVariableSet::recMEtVxy_ },
+  { "recMEtVyy", &inputVariableSet::recMEtVyy_ },
+  { "genMEtPx", &inputVariableSet::genMEtPx_ },
+  { "genMEtPy", &inputVariableSet::genMEtPy_ },
+  { "genMtautau", &inputVariableSet::genMtautau_ }
+};
+const size_t numColumnEntries = sizeof(columnEntries)/sizeof(columnEntries[0]);
+
+std::vector<std::string> inputVariableSet::columnNames()
+{
+  std::vector<std::string> columnNames;
+  for ( size_t idx = 0; idx < numColumnEntries; ++idx ) {
+    columnNames.push_back(columnEntries[idx].columnName_);
+  }
+  return columnNames;
+}
+
+void inputVariableSet::loadEntry(const NSVfitStandaloneColumnarReader& columns, size_t iEntry)
+{
+  for ( size_t idx = 0; idx < numColumnEntries; ++idx ) {
+    this->*(columnEntries[idx].value_) = columns.value(idx, iEntry);
+  }
+}
+
 struct plotEntryType
 {
   plotEntryType(Float_t massPoint, Float_t massWindowLo, Float_t massWindowHi)
@@ -642,8 +671,14 @@ void genTauToHadDecay(inputVariableSet& inputVariables, reco::Candidate::Lorentz
   inputVariables.genNu2Mass_ = 0.; 
 }
 
-void fillHistograms(inputVariableSet& inputVariables, 
-		    const reco::Candidate::LorentzVector& nuP4Leg1, const reco::Candidate::LorentzVector& nuP4Leg2, 		    
+void addToyMCneutrinos(inputVariableSet& inputVariables, 
+		       const reco::Candidate::LorentzVector& nuP4Leg1, const reco::Candidate::LorentzVector& nuP4Leg2)
+{
+  inputVariables.genMEtPx_ += (nuP4Leg1.px() + nuP4Leg2.px()) - (inputVariables.genNu1Px_ + inputVariables.genNu2Px_);
+  inputVariables.genMEtPy_ += (nuP4Leg1.py() + nuP4Leg2.py()) - (inputVariables.genNu1Py_ + inputVariables.genNu2Py_);
+}
+
+void fillHistograms(const inputVariableSet& inputVariables, 
 		    std::vector<plotEntryType*>& plotsBeforeVisPtCuts,
 		    std::vector<plotEntryType*>& plotsAfterVisEtaCutsLeg1, 
 		    std::vector<plotEntryType*>& plotsAfterVisEtaAndPtCutsLeg1,
@@ -653,11 +688,6 @@ void fillHistograms(inputVariableSet& inputVariables,
 		    std::vector<plotEntryType*>& plotsAfterVisEtaAndPtCutsLeg1and2,
 		    double evtWeight)
 {
-  inputVariables.genMEtPx_ += (nuP4Leg1.px() + nuP4Leg2.px()) - (inputVariables.genNu1Px_ + inputVariables.genNu2Px_);
-  inputVariables.genMEtPy_ += (nuP4Leg1.py() + nuP4Leg2.py()) - (inputVariables.genNu1Py_ + inputVariables.genNu2Py_);
- 
-  inputVariables.initialize();
-
   for ( std::vector<plotEntryType*>::iterator plot = plotsBeforeVisPtCuts.begin();
 	plot != plotsBeforeVisPtCuts.end(); ++plot ) {
     (*plot)->fillHistograms(inputVariables, evtWeight);
@@ -708,6 +738,95 @@ void fillHistograms(inputVariableSet& inputVariables,
   }
 }
 
+struct eventEntryType
+{
+  eventEntryType(bool runSVfit)
+    : inputVariables_(runSVfit),
+      inputVariables_toyMCps_(runSVfit),
+      inputVariables_toyMCme_(runSVfit)
+  {}
+  inputVariableSet inputVariables_;
+  inputVariableSet inputVariables_toyMCps_;
+  inputVariableSet inputVariables_toyMCme_;
+};
+
+void compSVfitMasses(std::vector<inputVariableSet*>& inputVariables, unsigned numWorkers)
+{
+//--- run SVfit for all given events.
+//    In case numWorkers > 1, the events are split into contiguous blocks,
+//    each of which is processed by a separate worker process.
+//
+//    NOTE: processes are used instead of threads, as NSVfitStandaloneAlgorithm 
+//          accesses the likelihood via the global NSVfitStandaloneLikelihood::gNSVfitStandaloneLikelihood pointer
+//          and is hence not thread-safe.
+//          The SVfit mass computed for each event does not depend on how events are distributed among workers,
+//          so that the output is identical to running with a single worker.
+  size_t numJobs = inputVariables.size();
+  if ( numWorkers <= 1 || numJobs < 2 ) {
+    for ( size_t iJob = 0; iJob < numJobs; ++iJob ) {
+      inputVariables[iJob]->svFitMassFromGenInput_ = inputVariables[iJob]->compSVfitMassFromGenInput();
+    }
+    return;
+  }
+
+  if ( numWorkers > numJobs ) numWorkers = numJobs;
+  std::vector<pid_t> workerPIds(numWorkers);
+  std::vector<int> workerPipes(numWorkers);
+  std::vector<size_t> firstJobs(numWorkers + 1);
+  for ( unsigned iWorker = 0; iWorker <= numWorkers; ++iWorker ) {
+    firstJobs[iWorker] = (iWorker*numJobs)/numWorkers;
+  }
+
+  std::cout.flush();
+  for ( unsigned iWorker = 0; iWorker < numWorkers; ++iWorker ) {
+    int pipeFDs[2];
+    if ( pipe(pipeFDs) != 0 ) 
+      throw cms::Exception("compSVfitMasses") 
+	<< "Failed to create pipe for worker #" << iWorker << " !!\n";
+    pid_t pid = fork();
+    if ( pid < 0 ) 
+      throw cms::Exception("compSVfitMasses") 
+	<< "Failed to fork worker #" << iWorker << " !!\n";
+    if ( pid == 0 ) {
+      close(pipeFDs[0]);
+      for ( size_t iJob = firstJobs[iWorker]; iJob < firstJobs[iWorker + 1]; ++iJob ) {
+	double svFitMass = inputVariables[iJob]->compSVfitMassFromGenInput();
+	if ( write(pipeFDs[1], &svFitMass, sizeof(double)) != sizeof(double) ) _exit(1);
+      }
+      close(pipeFDs[1]);
+      _exit(0); // do not run exit handlers/destructors of objects owned by parent process
+    }
+    close(pipeFDs[1]);
+    workerPIds[iWorker] = pid;
+    workerPipes[iWorker] = pipeFDs[0];
+  }
+
+  bool isSuccess = true;
+  for ( unsigned iWorker = 0; iWorker < numWorkers; ++iWorker ) {
+    for ( size_t iJob = firstJobs[iWorker]; iJob < firstJobs[iWorker + 1] && isSuccess; ++iJob ) {
+      double svFitMass;
+      char* buffer = reinterpret_cast<char*>(&svFitMass);
+      size_t numBytes_read = 0;
+      while ( numBytes_read < sizeof(double) ) {
+	ssize_t numBytes = read(workerPipes[iWorker], buffer + numBytes_read, sizeof(double) - numBytes_read);
+	if ( numBytes <= 0 ) {
+	  isSuccess = false;
+	  break;
+	}
+	numBytes_read += numBytes;
+      }
+      if ( isSuccess ) inputVariables[iJob]->svFitMassFromGenInput_ = svFitMass;
+    }
+    close(workerPipes[iWorker]);
+    int status = 0;
+    waitpid(workerPIds[iWorker], &status, 0);
+    if ( !(WIFEXITED(status) && WEXITSTATUS(status) == 0) ) isSuccess = false;
+  }
+  if ( !isSuccess ) 
+    throw cms::Exception("compSVfitMasses") 
+      << "Failed to retrieve SVfit results from worker processes !!\n";
+}
+
 int main(int argc, char* argv[]) 
 {
 //--- parse command-line arguments
@@ -743,6 +862,21 @@ int main(int argc, char* argv[])
   bool runSVfit = cfgStudySVfitVisPtCuts.getParameter<bool>("runSVfit");
   std::cout << " runSVfit = " << runSVfit << std::endl;
 
+//--- optionally keep columns read from input files in memory-mapped binary cache files,
+//    to speed-up repeated processing of the same input files
+  std::string columnCacheDirectory = ( cfgStudySVfitVisPtCuts.exists("columnCacheDirectory") ) ?
+    cfgStudySVfitVisPtCuts.getParameter<std::string>("columnCacheDirectory") : "";
+  std::cout << " columnCacheDirectory = " << columnCacheDirectory << std::endl;
+
+//--- number of worker processes used to run SVfit
+//    and number of events processed per chunk
+  unsigned numWorkers = ( cfgStudySVfitVisPtCuts.exists("numWorkers") ) ?
+    cfgStudySVfitVisPtCuts.getParameter<unsigned>("numWorkers") : 1;
+  std::cout << " numWorkers = " << numWorkers << std::endl;
+  int eventChunkSize = ( cfgStudySVfitVisPtCuts.exists("eventChunkSize") ) ?
+    cfgStudySVfitVisPtCuts.getParameter<int>("eventChunkSize") : 1000;
+  if ( eventChunkSize < 1 ) eventChunkSize = 1;
+
   fwlite::InputSource inputFiles(cfg); 
   int maxEvents = inputFiles.maxEvents();
 
@@ -876,123 +1010,126 @@ int main(int argc, char* argv[])
   typedef std::vector<std::string> vstring;
   for ( vstring::const_iterator inputFileName = inputFiles.files().begin();
   	inputFileName != inputFiles.files().end(); ++inputFileName ) {
-    TFile* inputFile = new TFile(inputFileName->data());
-    TTree* tree = dynamic_cast<TTree*>(inputFile->Get(treeName.c_str()));
-
-    inputVariableSet inputVariables(tree, runSVfit);
-    inputVariableSet inputVariables_toyMCps(NULL, runSVfit);
-    inputVariableSet inputVariables_toyMCme(NULL, runSVfit);
-
-    int numEntries = tree->GetEntries();
-    for ( int iEntry = 0; iEntry < numEntries && (numEvents_processed < maxEvents || maxEvents == -1); ++iEntry ) {
-      //std::cout << "Event #" << numEvents_processed << ":" << std::endl;
-      if ( numEvents_processed > 0 && (numEvents_processed % 1000) == 0 ) {
-	std::cout << "processing Event " << numEvents_processed << std::endl;
-      }
-
-      tree->GetEntry(iEntry);
-
-      inputVariables.initialize();
-
-      const Float_t evtWeight = 1.0;
+    NSVfitStandaloneColumnarReader columns(inputVariableSet::columnNames());
+    std::string cacheFileName;
+    if ( columnCacheDirectory != "" ) 
+      cacheFileName = NSVfitStandaloneColumnarReader::makeCacheFileName(columnCacheDirectory, *inputFileName, treeName);
+    if ( cacheFileName == "" || !columns.openCache(cacheFileName, *inputFileName) ) {
+      TFile* inputFile = new TFile(inputFileName->data());
+      TTree* tree = dynamic_cast<TTree*>(inputFile->Get(treeName.c_str()));
+      if ( !tree ) 
+	throw cms::Exception("studySVfitVisPtCuts") 
+	  << "Failed to find TTree = " << treeName << " in input file = " << (*inputFileName) << " !!\n";
+//--- read all entries in case cache file is to be written,
+//    else only the entries that are going to be processed
+      Long64_t maxEntries = ( cacheFileName == "" && maxEvents != -1 ) ? (maxEvents - numEvents_processed) : -1;
+      columns.readTree(tree, maxEntries);
+      if ( cacheFileName != "" ) columns.writeCache(cacheFileName, *inputFileName);
+      delete inputFile;
+    }
 
-      for ( std::vector<plotEntryType*>::iterator plot = plotsBeforeVisEtaAndPtCuts.begin();
-	    plot != plotsBeforeVisEtaAndPtCuts.end(); ++plot ) {
-	(*plot)->fillHistograms(inputVariables, evtWeight);
-      }
-      
-      bool passedVisEtaCutsLeg1          = inputVariables.passedVisEtaCutsLeg1();
-      bool passedVisEtaAndPtCutsLeg1     = inputVariables.passedVisEtaAndPtCutsLeg1();
-      bool passedVisEtaCutsLeg2          = inputVariables.passedVisEtaCutsLeg2();
-      bool passedVisEtaAndPtCutsLeg2     = inputVariables.passedVisEtaAndPtCutsLeg2();
-      bool passedVisEtaCutsLeg1and2      = inputVariables.passedVisEtaCutsLeg1and2();
-      bool passedVisEtaAndPtCutsLeg1and2 = inputVariables.passedVisEtaAndPtCutsLeg1and2();
+    int numEntries = columns.numEntries();
+    int iEntry = 0;
+    while ( iEntry < numEntries && (numEvents_processed < maxEvents || maxEvents == -1) ) {
       
-      if ( passedVisEtaCutsLeg1 ) {
-	for ( std::vector<plotEntryType*>::iterator plot = plotsAfterVisEtaCutsLeg1.begin();
-	      plot != plotsAfterVisEtaCutsLeg1.end(); ++plot ) {
-	  (*plot)->fillHistograms(inputVariables, evtWeight);
-	}
-      }
-      if ( passedVisEtaAndPtCutsLeg1 ) {
-	for ( std::vector<plotEntryType*>::iterator plot = plotsAfterVisEtaAndPtCutsLeg1.begin();
-	      plot != plotsAfterVisEtaAndPtCutsLeg1.end(); ++plot ) {
-	  (*plot)->fillHistograms(inputVariables, evtWeight);
-	}
-      }
-      if ( passedVisEtaCutsLeg2 ) {
-	for ( std::vector<plotEntryType*>::iterator plot = plotsAfterVisEtaCutsLeg2.begin();
-	      plot != plotsAfterVisEtaCutsLeg2.end(); ++plot ) {
-	  (*plot)->fillHistograms(inputVariables, evtWeight);
-	}
-      }
-      if ( passedVisEtaAndPtCutsLeg2 ) {
-	for ( std::vector<plotEntryType*>::iterator plot = plotsAfterVisEtaAndPtCutsLeg2.begin();
-	      plot != plotsAfterVisEtaAndPtCutsLeg2.end(); ++plot ) {
-	  (*plot)->fillHistograms(inputVariables, evtWeight);
-	}
-      }
-      if ( passedVisEtaCutsLeg1and2 ) {
-	for ( std::vector<plotEntryType*>::iterator plot = plotsAfterVisEtaCutsLeg1and2.begin();
-	      plot != plotsAfterVisEtaCutsLeg1and2.end(); ++plot ) {
-	  (*plot)->fillHistograms(inputVariables, evtWeight);
+//--- prepare inputs for next chunk of events.
+//    The toy Monte Carlo decays are generated sequentially, 
+//    so that the sequence of random numbers does not depend on numWorkers and eventChunkSize
+      std::vector<eventEntryType> eventEntries;
+      eventEntries.reserve(eventChunkSize);
+      std::vector<inputVariableSet*> svFitJobs;
+      while ( iEntry < numEntries && (numEvents_processed < maxEvents || maxEvents == -1) && (int)eventEntries.size() < eventChunkSize ) {
+	//std::cout << "Event #" << numEvents_processed << ":" << std::endl;
+	if ( numEvents_processed > 0 && (numEvents_processed % 1000) == 0 ) {
+	  std::cout << "processing Event " << numEvents_processed << std::endl;
 	}
+
+	eventEntries.push_back(eventEntryType(runSVfit));
+	eventEntryType& eventEntry = eventEntries.back();
+
+	inputVariableSet& inputVariables = eventEntry.inputVariables_;
+	inputVariables.loadEntry(columns, iEntry);
+	inputVariables.initialize(false);
+	
+	//-------------------------------------------------------------------------
+	// toy Monte Carlo to check difference between simple Phase-Space model
+	// used by SVfit likelihood functions and "real" tau decays implemented in TAUOLA
+	
+	inputVariableSet& inputVariables_toyMCps = eventEntry.inputVariables_toyMCps_;
+	inputVariables_toyMCps = inputVariables;
+	
+	reco::Candidate::LorentzVector nuP4Leg1_toyMCps;
+	reco::Candidate::LorentzVector nuP4Leg2_toyMCps;
+	genTauToLepDecay_ps(inputVariables_toyMCps, nuP4Leg1_toyMCps, rnd);
+	genTauToHadDecay(inputVariables_toyMCps, nuP4Leg2_toyMCps, rnd);
+	addToyMCneutrinos(inputVariables_toyMCps, nuP4Leg1_toyMCps, nuP4Leg2_toyMCps);
+	inputVariables_toyMCps.initialize(false);
+	//-------------------------------------------------------------------------
+	
+	//-------------------------------------------------------------------------
+	// toy Monte Carlo to check difference between tau decay matrix elements
+	// implemented in SVfit likelihood functions and tau decays implemented in TAUOLA
+	
+	inputVariableSet& inputVariables_toyMCme = eventEntry.inputVariables_toyMCme_;
+	inputVariables_toyMCme = inputVariables;
+	
+	reco::Candidate::LorentzVector nuP4Leg1_toyMCme;
+	reco::Candidate::LorentzVector nuP4Leg2_toyMCme;
+	genTauToLepDecay_me(inputVariables_toyMCme, nuP4Leg1_toyMCme, rnd);
+	genTauToHadDecay(inputVariables_toyMCme, nuP4Leg2_toyMCme, rnd);
+	addToyMCneutrinos(inputVariables_toyMCme, nuP4Leg1_toyMCme, nuP4Leg2_toyMCme);
+	inputVariables_toyMCme.initialize(false);
+	//-------------------------------------------------------------------------
+	
+	++iEntry;
+	++numEvents_processed;
       }
-      if ( passedVisEtaAndPtCutsLeg1and2 ) {
-	for ( std::vector<plotEntryType*>::iterator plot = plotsAfterVisEtaAndPtCutsLeg1and2.begin();
-	      plot != plotsAfterVisEtaAndPtCutsLeg1and2.end(); ++plot ) {
-	  (*plot)->fillHistograms(inputVariables, evtWeight);
+
+//--- run SVfit on all events of the chunk
+      if ( runSVfit ) {
+	for ( std::vector<eventEntryType>::iterator eventEntry = eventEntries.begin();
+	      eventEntry != eventEntries.end(); ++eventEntry ) {
+	  svFitJobs.push_back(&eventEntry->inputVariables_);
+	  svFitJobs.push_back(&eventEntry->inputVariables_toyMCps_);
+	  svFitJobs.push_back(&eventEntry->inputVariables_toyMCme_);
 	}
+	compSVfitMasses(svFitJobs, numWorkers);
       }
 
-      //-------------------------------------------------------------------------
-      // toy Monte Carlo to check difference between simple Phase-Space model
-      // used by SVfit likelihood functions and "real" tau decays implemented in TAUOLA
-
-      inputVariables_toyMCps = inputVariables;
-
-      reco::Candidate::LorentzVector nuP4Leg1_toyMCps;
-      reco::Candidate::LorentzVector nuP4Leg2_toyMCps;
-      genTauToLepDecay_ps(inputVariables_toyMCps, nuP4Leg1_toyMCps, rnd);
-      genTauToHadDecay(inputVariables_toyMCps, nuP4Leg2_toyMCps, rnd);
-      
-      fillHistograms(inputVariables_toyMCps, nuP4Leg1_toyMCps, nuP4Leg2_toyMCps,
-		     plotsBeforeVisEtaAndPtCuts_toyMCps,
-		     plotsAfterVisEtaCutsLeg1_toyMCps, 
-		     plotsAfterVisEtaAndPtCutsLeg1_toyMCps,
-		     plotsAfterVisEtaCutsLeg2_toyMCps, 
-		     plotsAfterVisEtaAndPtCutsLeg2_toyMCps,
-		     plotsAfterVisEtaCutsLeg1and2_toyMCps, 
-		     plotsAfterVisEtaAndPtCutsLeg1and2_toyMCps, 
-		     evtWeight);
-      //-------------------------------------------------------------------------
-
-      //-------------------------------------------------------------------------
-      // toy Monte Carlo to check difference between tau decay matrix elements
-      // implemented in SVfit likelihood functions and tau decays implemented in TAUOLA
-
-      inputVariables_toyMCme = inputVariables;
-
-      reco::Candidate::LorentzVector nuP4Leg1_toyMCme;
-      reco::Candidate::LorentzVector nuP4Leg2_toyMCme;
-      genTauToLepDecay_me(inputVariables_toyMCme, nuP4Leg1_toyMCme, rnd);
-      genTauToHadDecay(inputVariables_toyMCme, nuP4Leg2_toyMCme, rnd);
-      
-      fillHistograms(inputVariables_toyMCme, nuP4Leg1_toyMCme, nuP4Leg2_toyMCme,
-		     plotsBeforeVisEtaAndPtCuts_toyMCme,
-		     plotsAfterVisEtaCutsLeg1_toyMCme, 
-		     plotsAfterVisEtaAndPtCutsLeg1_toyMCme,
-		     plotsAfterVisEtaCutsLeg2_toyMCme, 
-		     plotsAfterVisEtaAndPtCutsLeg2_toyMCme,
-		     plotsAfterVisEtaCutsLeg1and2_toyMCme, 
-		     plotsAfterVisEtaAndPtCutsLeg1and2_toyMCme, 
-		     evtWeight);
-      //-------------------------------------------------------------------------
-
-      ++numEvents_processed;
+//--- fill histograms in order of events,
+//    so that the output does not depend on numWorkers and eventChunkSize
+      const Float_t evtWeight = 1.0;
+      for ( std::vector<eventEntryType>::const_iterator eventEntry = eventEntries.begin();
+	    eventEntry != eventEntries.end(); ++eventEntry ) {
+	fillHistograms(eventEntry->inputVariables_,
+		       plotsBeforeVisEtaAndPtCuts,
+		       plotsAfterVisEtaCutsLeg1, 
+		       plotsAfterVisEtaAndPtCutsLeg1,
+		       plotsAfterVisEtaCutsLeg2, 
+		       plotsAfterVisEtaAndPtCutsLeg2,
+		       plotsAfterVisEtaCutsLeg1and2, 
+		       plotsAfterVisEtaAndPtCutsLeg1and2, 
+		       evtWeight);
+	fillHistograms(eventEntry->inputVariables_toyMCps_,
+		       plotsBeforeVisEtaAndPtCuts_toyMCps,
+		       plotsAfterVisEtaCutsLeg1_toyMCps, 
+		       plotsAfterVisEtaAndPtCutsLeg1_toyMCps,
+		       plotsAfterVisEtaCutsLeg2_toyMCps, 
+		       plotsAfterVisEtaAndPtCutsLeg2_toyMCps,
+		       plotsAfterVisEtaCutsLeg1and2_toyMCps, 
+		       plotsAfterVisEtaAndPtCutsLeg1and2_toyMCps, 
+		       evtWeight);
+	fillHistograms(eventEntry->inputVariables_toyMCme_,
+		       plotsBeforeVisEtaAndPtCuts_toyMCme,
+		       plotsAfterVisEtaCutsLeg1_toyMCme, 
+		       plotsAfterVisEtaAndPtCutsLeg1_toyMCme,
+		       plotsAfterVisEtaCutsLeg2_toyMCme, 
+		       plotsAfterVisEtaAndPtCutsLeg2_toyMCme,
+		       plotsAfterVisEtaCutsLeg1and2_toyMCme, 
+		       plotsAfterVisEtaAndPtCutsLeg1and2_toyMCme, 
+		       evtWeight);
+      }
     }
-    
-    delete inputFile;
   }
   
   clock.Show("studySVfitVisPtCuts");
@@ -95,7 +95,11 @@ int main(int argc, char* argv[])
   std::string targetBranchName = cfgTestNeuralMtautau.getParameter<std::string>("targetBranchName");
   std::string NNconfigFileName = cfgTestNeuralMtautau.getParameter<std::string>("NNconfigFileName");
 
-  NeuralMtautauAlgorithm* neuralMtautauAlgorithm = new NeuralMtautauAlgorithm(NNconfigFileName.data());
+  bool useCompiledMLP = ( cfgTestNeuralMtautau.exists("useCompiledMLP") ) ?
+    cfgTestNeuralMtautau.getParameter<bool>("useCompiledMLP") : false;
+  std::cout << " useCompiledMLP = " << useCompiledMLP << std::endl;
+
+  NeuralMtautauAlgorithm* neuralMtautauAlgorithm = new NeuralMtautauAlgorithm(NNconfigFileName.data(), useCompiledMLP);
 
   bool runSVfit = cfgTestNeuralMtautau.getParameter<bool>("runSVfit");
   std::cout << " runSVfit = " << runSVfit << std::endl;
@@ -26,16 +26,69 @@
 #include "TMVA/Reader.h"
 #include "TMVA/Tools.h"
 
+#include "TMVA/MethodBase.h"
+
 #include <TSystem.h>
 #include <TFile.h>
 #include <TChain.h>
 #include <TTree.h>
+#include <TString.h>
+#include <TXMLEngine.h>
 #include <TBenchmark.h>
 
 #include <iostream>
 #include <string>
 #include <vector>
 
+typedef std::vector<std::string> vstring;
+
+//--- replace the column names 'var0', 'var1',..., 'target' of the samples prepared by bin/prepareNeuralMtautauTrainingData.cc
+//    by the original expressions in the TMVA weights file,
+//    so that the network can be read by TMVA::Reader and NeuralMtautauMLP with the original input variables
+void setExpression(TXMLEngine& xml, XMLNodePointer_t node, const std::string& expression)
+{
+  const char* attributes[] = { "Expression", "Label", "Internal" };
+  for ( int iAttribute = 0; iAttribute < 3; ++iAttribute ) {
+    if ( !xml.HasAttr(node, attributes[iAttribute]) ) continue;
+    std::string value = ( std::string(attributes[iAttribute]) == "Internal" ) ?
+      TMVA::gTools().ReplaceRegularExpressions(expression.data(), "_").Data() : expression;
+    xml.FreeAttr(node, attributes[iAttribute]);
+    xml.NewAttr(node, 0, attributes[iAttribute], value.data());
+  }
+}
+
+void restoreExpressions(const std::string& weightsFileName, const vstring& inputExpressions, const std::string& targetExpression)
+{
+  TXMLEngine xml;
+  XMLDocPointer_t document = xml.ParseFile(weightsFileName.data());
+  if ( !document )
+    throw cms::Exception("trainNeuralMtautau")
+      << "Failed to parse weights file = " << weightsFileName << " !!\n";
+  XMLNodePointer_t methodSetup = xml.DocGetRootElement(document);
+  unsigned numVariables = 0;
+  for ( XMLNodePointer_t node = xml.GetChild(methodSetup); node; node = xml.GetNext(node) ) {
+    std::string nodeName = xml.GetNodeName(node);
+    if ( !(nodeName == "Variables" || nodeName == "Targets") ) continue;
+    for ( XMLNodePointer_t variable = xml.GetChild(node); variable; variable = xml.GetNext(variable) ) {
+      if ( nodeName == "Targets" ) {
+	setExpression(xml, variable, targetExpression);
+      } else {
+	if ( numVariables >= inputExpressions.size() )
+	  throw cms::Exception("trainNeuralMtautau")
+	    << "Weights file = " << weightsFileName << " contains more variables than expected !!\n";
+	setExpression(xml, variable, inputExpressions[numVariables]);
+	++numVariables;
+      }
+    }
+  }
+  if ( numVariables != inputExpressions.size() )
+    throw cms::Exception("trainNeuralMtautau")
+      << "Weights file = " << weightsFileName << " contains " << numVariables << " variables,"
+      << " expected = " << inputExpressions.size() << " !!\n";
+  xml.SaveDoc(document, weightsFileName.data());
+  xml.FreeDoc(document);
+}
+
 int main(int argc, char* argv[]) 
 {
 //--- parse command-line arguments
@@ -79,16 +132,33 @@ int main(int argc, char* argv[])
   std::string mvaTrainingOptions = cfgTrainNeuralMtautau.getParameter<std::string>("mvaTrainingOptions");
   std::cout << " mvaTrainingOptions = " << mvaTrainingOptions << std::endl;
 
-  typedef std::vector<std::string> vstring;
   vstring inputBranchNames = cfgTrainNeuralMtautau.getParameter<vstring>("inputBranchNames");
   std::string targetBranchName = cfgTrainNeuralMtautau.getParameter<std::string>("targetBranchName");
 
-  fwlite::InputSource inputFiles(cfg); 
-
-  TChain* tree = new TChain(treeName.c_str());
-  for ( vstring::const_iterator inputFileName = inputFiles.files().begin();
-	inputFileName != inputFiles.files().end(); ++inputFileName ) {
-    tree->AddFile(inputFileName->c_str());
+//--- read training and test samples prepared by bin/prepareNeuralMtautauTrainingData.cc, if given;
+//    else read full n-tuples and let TMVA split them into training and test samples
+  std::string preparedInputFileName = ( cfgTrainNeuralMtautau.exists("preparedInputFileName") ) ?
+    cfgTrainNeuralMtautau.getParameter<std::string>("preparedInputFileName") : "";
+
+  TChain* tree = 0;
+  TFile* preparedInputFile = 0;
+  TTree* trainingTree = 0;
+  TTree* testTree = 0;
+  if ( preparedInputFileName != "" ) {
+    preparedInputFile = new TFile(preparedInputFileName.data());
+    trainingTree = dynamic_cast<TTree*>(preparedInputFile->Get("train"));
+    testTree = dynamic_cast<TTree*>(preparedInputFile->Get("test"));
+    if ( !(trainingTree && testTree) )
+      throw cms::Exception("trainNeuralMtautau") 
+	<< "Failed to find training and test samples in file = " << preparedInputFileName << " !!\n";
+  } else {
+    fwlite::InputSource inputFiles(cfg); 
+
+    tree = new TChain(treeName.c_str());
+    for ( vstring::const_iterator inputFileName = inputFiles.files().begin();
+	  inputFileName != inputFiles.files().end(); ++inputFileName ) {
+      tree->AddFile(inputFileName->c_str());
+    }
   }
 
   fwlite::OutputFiles outputFile(cfg);
@@ -97,24 +167,47 @@ int main(int argc, char* argv[])
   TMVA::Tools::Instance();
   TMVA::Factory* factory = new TMVA::Factory("trainNeuralMtautau", &fs.file(), "!V:!Silent:Color:DrawProgressBar");
   
-  factory->AddRegressionTree(tree);
+  if ( preparedInputFile ) {
+    factory->AddRegressionTree(trainingTree, 1., TMVA::Types::kTraining);
+    factory->AddRegressionTree(testTree, 1., TMVA::Types::kTesting);
+  } else {
+    factory->AddRegressionTree(tree);
+  }
 
-  for ( vstring::const_iterator branchName = inputBranchNames.begin();
-	branchName != inputBranchNames.end(); ++branchName ) {
-    factory->AddVariable(branchName->c_str(), 'F'); 
+//--- train prepared samples on the precomputed columns 'var0', 'var1',..., 'target',
+//    instead of evaluating the expressions again
+  if ( preparedInputFile ) {
+    for ( size_t iInput = 0; iInput < inputBranchNames.size(); ++iInput ) {
+      std::string columnName = Form("var%i", (int)iInput);
+      if ( !(trainingTree->GetBranch(columnName.data()) && testTree->GetBranch(columnName.data())) )
+	throw cms::Exception("trainNeuralMtautau") 
+	  << "No column = " << columnName << " for input variable = " << inputBranchNames[iInput]
+	  << " found in file = " << preparedInputFileName << " !!\n";
+      factory->AddVariable(columnName.data(), inputBranchNames[iInput].data(), "", 'F');
+    }
+    factory->AddRegressionTarget("target", targetBranchName.data(), "", 'F');
+  } else {
+    for ( vstring::const_iterator branchName = inputBranchNames.begin();
+	  branchName != inputBranchNames.end(); ++branchName ) {
+      factory->AddVariable(branchName->c_str(), 'F'); 
+    }
+    factory->AddRegressionTarget(targetBranchName.c_str(), 'F');
   }
-  factory->AddRegressionTarget(targetBranchName.c_str(), 'F');
 
   TCut cut = "";
   
   factory->PrepareTrainingAndTestTree(cut, "nTrain_Regression=0:nTest_Regression=0:SplitMode=Random:NormMode=NumEvents:!V");
-  factory->BookMethod(mvaType, mvaName.c_str(), mvaTrainingOptions.c_str());
+  TMVA::MethodBase* method = dynamic_cast<TMVA::MethodBase*>(factory->BookMethod(mvaType, mvaName.c_str(), mvaTrainingOptions.c_str()));
   factory->TrainAllMethods();
+  if ( preparedInputFile && method ) restoreExpressions(method->GetWeightFileName().Data(), inputBranchNames, targetBranchName);
   factory->TestAllMethods();
   factory->EvaluateAllMethods();  
   
   delete factory;
 
+  delete tree;
+  delete preparedInputFile;
+
   clock.Show("trainNeuralMtautau");
 
   return 0;
@@ -3,6 +3,7 @@
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Digest.h"
 #include "DataFormats/Math/interface/deltaR.h"
 #include "DataFormats/Math/interface/normalizedPhi.h"
 
@@ -18,11 +19,16 @@
 
 #include "TauAnalysis/CandidateTools/interface/PFMEtSignInterface.h"
 #include "TauAnalysis/CandidateTools/interface/NSVfitAlgorithmBase.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitResultCache.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitInputRecorder.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitTimeBudget.h"
 #include "TauAnalysis/CandidateTools/interface/mTauTauMinAlgo.h"
 #include "TauAnalysis/CandidateTools/interface/candidateAuxFunctions.h"
 #include "TauAnalysis/CandidateTools/interface/generalAuxFunctions.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 
+#include "CommonTools/Utils/interface/StringCutObjectSelector.h"
+
 #include "TMath.h"
 #include "TF1.h"
 #include "TMatrixD.h"
@@ -45,10 +51,14 @@ class CompositePtrCandidateT1T2MEtAlgorithm
     : pfMEtSign_(0),
       pfMEtCov_(2, 2),
       pfMEtCovInverse_(2, 2),
+      nSVfitCache_(0),
+      nSVfitInputRecorder_(0),
+      expensiveQuantitiesPreselection_(0),
       timerTotal_(0),
       timerPFMEtSign_(0),
       timerNSVFit_(0),
-      timerMTauTauMin_(0)
+      timerMTauTauMin_(0),
+      mTauTauMinRandomGenerator_("mTauTauMin")
   {
     //std::cout << "<CompositePtrCandidateT1T2MEtAlgorithm::CompositePtrCandidateT1T2MEtAlgorithm>:" << std::endl;
 
@@ -57,6 +67,7 @@ class CompositePtrCandidateT1T2MEtAlgorithm
     if ( cfg.exists("pfMEtSign") ) {
       edm::ParameterSet cfgPFMEtSign = cfg.getParameter<edm::ParameterSet>("pfMEtSign");
       pfMEtSign_ = new PFMEtSignInterface(cfgPFMEtSign);
+      pfMEtSign_->setSharedEventData(pfMEtSignSharedEventData_);
     }
 
     if ( cfg.exists("nSVfit") ) {
@@ -72,6 +83,7 @@ class CompositePtrCandidateT1T2MEtAlgorithm
 	cfg_algorithm.addParameter<std::string>("pluginName", *nSVfitAlgorithmName);
 	std::string pluginType = cfg_algorithm.getParameter<std::string>("pluginType");
 	NSVfitAlgorithmBase* nSVfitAlgorithm = NSVfitAlgorithmPluginFactory::get()->create(pluginType, cfg_algorithm);
+	nSVfitAlgorithm->setPFMEtSignSharedEventData(&pfMEtSignSharedEventData_);
         try {
           nSVfitAlgorithms_.insert(std::pair<std::string, NSVfitAlgorithmBase*>(*nSVfitAlgorithmName, nSVfitAlgorithm));
         } catch (...) {
@@ -81,9 +93,39 @@ class CompositePtrCandidateT1T2MEtAlgorithm
           throw;
         }
 	//std::cout << "--> adding nSVfit algorithm: name = " << (*nSVfitAlgorithmName) << std::endl;
+	cms::Digest nSVfitConfigDigest(cfgNSVfitAlgorithm.trackedPart().toString());
+	nSVfitConfigDigests_[*nSVfitAlgorithmName] = nSVfitConfigDigest.digest().toString();
+      }
+    }
+
+//--- cache of nSVfit results, used to skip the nSVfit computation
+//    when the same events are reprocessed with unchanged nSVfit configuration
+//   (no cache is used in case fileName is empty)
+    if ( cfg.exists("nSVfitCache") ) {
+      edm::ParameterSet cfgNSVfitCache = cfg.getParameter<edm::ParameterSet>("nSVfitCache");
+      std::string nSVfitCacheFileName = cfgNSVfitCache.getParameter<std::string>("fileName");
+      if ( nSVfitCacheFileName != "" ) {
+	bool nSVfitCacheReadOnly = cfgNSVfitCache.exists("readOnly") ?
+	  cfgNSVfitCache.getParameter<bool>("readOnly") : false;
+	nSVfitCache_ = new NSVfitResultCache(nSVfitCacheFileName, nSVfitCacheReadOnly);
+	nSVfitCacheMomentumQuantum_ = cfgNSVfitCache.exists("momentumQuantum") ?
+	  cfgNSVfitCache.getParameter<double>("momentumQuantum") : 1.e-3;
+	nSVfitCachePositionQuantum_ = cfgNSVfitCache.exists("positionQuantum") ?
+	  cfgNSVfitCache.getParameter<double>("positionQuantum") : 1.e-4;
       }
     }
 
+//--- record input to nSVfit computation and nSVfit solutions,
+//    for replaying the nSVfit computation without the framework (cf. bin/replaySVfitInputs.cc);
+//    the module label is inserted into the file name, as modules cloned for systematic shifts share the configuration
+    std::string recordNSVfitInputFileName = cfg.exists("recordNSVfitInputFileName") ?
+      cfg.getParameter<std::string>("recordNSVfitInputFileName") : "";
+    if ( recordNSVfitInputFileName != "" ) {
+      std::string moduleLabel = cfg.exists("@module_label") ?
+	cfg.getParameter<std::string>("@module_label") : "";
+      nSVfitInputRecorder_ = new NSVfitInputRecorder(NSVfitInputRecorder::makeFileName(recordNSVfitInputFileName, moduleLabel));
+    }
+
     scaleFuncImprovedCollinearApprox_ = cfg.exists("scaleFuncImprovedCollinearApprox") ?
       cfg.getParameter<std::string>("scaleFuncImprovedCollinearApprox") : "1";
     /// compute the scale factor to weight the diTau mass
@@ -91,6 +133,14 @@ class CompositePtrCandidateT1T2MEtAlgorithm
     /// NO re-scaling of the p4 is made at this stage.
     scaleFunc_ = new TF1("scaleFunc_", scaleFuncImprovedCollinearApprox_.c_str(), 10, 300);
 
+//--- cut applied on the diTau object, after all quantities that are fast to compute have been set,
+//    in order to decide whether the time consuming mTauTauMin and SVfit computations are run
+    if ( cfg.exists("expensiveQuantitiesPreselection") ) {
+      std::string expensiveQuantitiesPreselection_string = cfg.getParameter<std::string>("expensiveQuantitiesPreselection");
+      if ( expensiveQuantitiesPreselection_string != "" ) 
+	expensiveQuantitiesPreselection_ = new StringCutObjectSelector<CompositePtrCandidateT1T2MEt<T1,T2> >(expensiveQuantitiesPreselection_string);
+    }
+
     if ( cfg.exists("genParticleMatchPdgId") ) {
       genParticleMatchPdgId_ = cfg.getParameter<vint>("genParticleMatchPdgId");
     } else {
@@ -118,8 +168,13 @@ class CompositePtrCandidateT1T2MEtAlgorithm
       delete it->second;
     }
 
+    delete nSVfitCache_;
+    delete nSVfitInputRecorder_;
+
     delete scaleFunc_;
 
+    delete expensiveQuantitiesPreselection_;
+
     //std::cout << "<CompositePtrCandidateT1T2MEtAlgorithm::~CompositePtrCandidateT1T2MEtAlgorithm>:" << std::endl;
     //std::cout.precision(2);
     //std::cout << "Total: real/CPU time = " << timerTotal_->RealTime() 
@@ -154,10 +209,30 @@ class CompositePtrCandidateT1T2MEtAlgorithm
     //timerTotal_->Stop();
   }
 
+  void endJob()
+  {
+    if ( nSVfitCache_ ) {
+      nSVfitCache_->write();
+      nSVfitCache_->print(std::cout);
+    }
+    if ( nSVfitInputRecorder_ ) {
+      std::cout << "<CompositePtrCandidateT1T2MEtAlgorithm::endJob>:" << std::endl;
+      std::cout << " recorded nSVfit input for " << nSVfitInputRecorder_->numRecords() << " pairs." << std::endl;
+    }
+  }
+
   void beginEvent(edm::Event& evt, const edm::EventSetup& es, bool doSVreco, bool doPFMEtSign)
   {
     //timerTotal_->Start(false);
 
+    mTauTauMinRandomGenerator_.setEvent(evt.id().run(), evt.luminosityBlock(), evt.id().event());
+
+    if ( nSVfitInputRecorder_ ) {
+      nSVfitInputRecord_.run_ = evt.id().run();
+      nSVfitInputRecord_.lumi_ = evt.luminosityBlock();
+      nSVfitInputRecord_.event_ = evt.id().event();
+    }
+
     if ( doPFMEtSign && pfMEtSign_ ) {
       //timerPFMEtSign_->Start(false);
       pfMEtSign_->beginEvent(evt, es);
@@ -184,7 +259,8 @@ class CompositePtrCandidateT1T2MEtAlgorithm
                                                                  const reco::BeamSpot* beamSpot,
                                                                  const TransientTrackBuilder* trackBuilder,
 								 const std::string& recoMode,
-								 bool doSVreco, bool doPFMEtSign, bool doMtautauMin)
+								 bool doSVreco, bool doPFMEtSign, bool doMtautauMin,
+								 const CompositePtrCandidateT1T2MEt<T1,T2>* nSVfitSolutionsToReuse = 0)
   { 
     //std::cout << "<CompositePtrCandidateT1T2MEtAlgorithm::buildCompositePtrCandidate>:"<< std::endl;
     //if ( !met.isNull() ) std::cout << " MET: pt = " << met->pt() << std::endl;
@@ -201,36 +277,61 @@ class CompositePtrCandidateT1T2MEtAlgorithm
     }
 
 //--- compute quantities that are independent of MET
+//   (four-vectors of visible decay products are retrieved once,
+//    as each call to p4() goes through the virtual reco::Candidate interface)
+    const reco::Candidate::LorentzVector& leg1P4 = leg1->p4();
+    const reco::Candidate::LorentzVector& leg2P4 = leg2->p4();
     compositePtrCandidate.setCharge(leg1->charge() + leg2->charge());
-    compositePtrCandidate.setP4Vis(leg1->p4() + leg2->p4());
-    compositePtrCandidate.setDR12(reco::deltaR(leg1->p4(), leg2->p4()));
-    compositePtrCandidate.setDPhi12(TMath::Abs(normalizedPhi(leg1->phi() - leg2->phi())));
-    compositePtrCandidate.setVisEtaMin(TMath::Min(leg1->eta(), leg2->eta()));
-    compositePtrCandidate.setVisEtaMax(TMath::Max(leg1->eta(), leg2->eta()));
+    compositePtrCandidate.setP4Vis(leg1P4 + leg2P4);
+    compositePtrCandidate.setDR12(reco::deltaR(leg1P4, leg2P4));
+    compositePtrCandidate.setDPhi12(TMath::Abs(normalizedPhi(leg1P4.phi() - leg2P4.phi())));
+    compositePtrCandidate.setVisEtaMin(TMath::Min(leg1P4.eta(), leg2P4.eta()));
+    compositePtrCandidate.setVisEtaMax(TMath::Max(leg1P4.eta(), leg2P4.eta()));
 
 //--- compute quantities that do dependent on MET
     if ( met.isNonnull() ) {
-      compCollinearApprox(compositePtrCandidate, leg1->p4(), leg2->p4(), met->px(), met->py());
-      compImprovedCollinearApprox(compositePtrCandidate, leg1->p4(), leg2->p4(), met->px(), met->py());
-      compositePtrCandidate.setP4CDFmethod(compP4CDFmethod(leg1->p4(), leg2->p4(), met->px(), met->py()));
-      compositePtrCandidate.setMt12MET(compMt(leg1->p4(), leg2->p4(), met->px(), met->py()));
-      compositePtrCandidate.setMt1MET(compMt(leg1->p4(), met->px(), met->py()));
-      compositePtrCandidate.setMt2MET(compMt(leg2->p4(), met->px(), met->py()));
-      compositePtrCandidate.setDPhi1MET(TMath::Abs(normalizedPhi(leg1->phi() - met->phi())));
-      compositePtrCandidate.setDPhi2MET(TMath::Abs(normalizedPhi(leg2->phi() - met->phi())));
+      double metPx = met->px();
+      double metPy = met->py();
+      double metPhi = met->phi();
+      compCollinearApprox(compositePtrCandidate, leg1P4, leg2P4, metPx, metPy);
+      compImprovedCollinearApprox(compositePtrCandidate, leg1P4, leg2P4, metPx, metPy);
+      compositePtrCandidate.setP4CDFmethod(compP4CDFmethod(leg1P4, leg2P4, metPx, metPy));
+      compositePtrCandidate.setMt12MET(compMt(leg1P4, leg2P4, metPx, metPy));
+      compositePtrCandidate.setMt1MET(compMt(leg1P4, metPx, metPy));
+      compositePtrCandidate.setMt2MET(compMt(leg2P4, metPx, metPy));
+      compositePtrCandidate.setDPhi1MET(TMath::Abs(normalizedPhi(leg1P4.phi() - metPhi)));
+      compositePtrCandidate.setDPhi2MET(TMath::Abs(normalizedPhi(leg2P4.phi() - metPhi)));
+
+//--- compute (PF)MEt significance matrix
+      if ( doPFMEtSign && pfMEtSign_ ) {
+	//timerPFMEtSign_->Start(false);
+	std::list<const reco::Candidate*> daughterHypothesesList;
+	daughterHypothesesList.push_back(leg1.get());
+	daughterHypothesesList.push_back(leg2.get());
+	compositePtrCandidate.setMEtSignMatrix((*pfMEtSign_)(daughterHypothesesList));
+	//timerPFMEtSign_->Stop();
+      }
+
+      compZeta(compositePtrCandidate, leg1P4, leg2P4, metPx, metPy);
+
+//--- skip time consuming computations for diTau objects failing preselection
+      bool isPreselected = ( expensiveQuantitiesPreselection_ ) ? 
+	(*expensiveQuantitiesPreselection_)(compositePtrCandidate) : true;
       
 //--- compute lower bound on tau-pair mass,
 //    using the algorithm described in:
 //      "Speedy Higgs boson discovery in decays to tau lepton pairs: h --> tau tau"
 //      by Alan J. Barr, Sky T. French, James A. Frost, Christopher G. Lester,
 //       arXiv: 1106.2322v1 [hep-ph]
-      if ( doMtautauMin ) {
+      if ( doMtautauMin && isPreselected ) {
 	//timerMTauTauMin_->Start(false);
+	mTauTauMinRandomGenerator_.setCandidate(hashPtr(hashPtr(hashPtr(0, leg1), leg2), met));
 	double mTauTauMin_value = 
-	  mTauTauMin(leg1->energy(), leg1->px(), leg1->py(), leg1->pz(),
-		     leg2->energy(), leg2->px(), leg2->py(), leg2->pz(),
-		     met->px(), met->py(),
-		     SVfit_namespace::tauLeptonMass);
+	  mTauTauMin(leg1P4.energy(), leg1P4.px(), leg1P4.py(), leg1P4.pz(),
+		     leg2P4.energy(), leg2P4.px(), leg2P4.py(), leg2P4.pz(),
+		     metPx, metPy,
+		     SVfit_namespace::tauLeptonMass,
+		     mTauTauMinRandomGenerator_);
 	//timerMTauTauMin_->Stop();
 	if ( mTauTauMin_value > 0. ) {
 	  compositePtrCandidate.setTauPairMassMin(mTauTauMin_value);
@@ -244,40 +345,67 @@ class CompositePtrCandidateT1T2MEtAlgorithm
 	compositePtrCandidate.setTauPairMassMin_isValid(false);
       }
 
-//--- compute (PF)MEt significance matrix
-      if ( doPFMEtSign && pfMEtSign_ ) {
-	//timerPFMEtSign_->Start(false);
-	std::list<const reco::Candidate*> daughterHypothesesList;
-	daughterHypothesesList.push_back(leg1.get());
-	daughterHypothesesList.push_back(leg2.get());
-	compositePtrCandidate.setMEtSignMatrix((*pfMEtSign_)(daughterHypothesesList));
-	//timerPFMEtSign_->Stop();
-      }
-
-      compZeta(compositePtrCandidate, leg1->p4(), leg2->p4(), met->px(), met->py());
-
 //--- SV method computation (if we have the PV and beamspot)
-      if ( doSVreco ) {
+      if ( doSVreco && isPreselected ) {
 	//timerNSVFit_->Start(false);
 	if ( pv ) {
+//--- build input particles once per pair and run all nSVfit configurations on them;
+//    the MET covariance matrix (PFMEtSignInterface) and the TransientTracks (NSVfitTrackService)
+//    are computed once per pair and shared between the configurations
+//   (per-event data of PFMEtSignInterface are owned by this object, cf. pfMEtSignSharedEventData).
+//    Event hypotheses and likelihood values are computed separately by each configuration.
+//    nSVfit solutions computed before for another pair with identical input are copied instead
+//   (used for systematic shifts which do not change leg1, leg2 and MET of the pair
+//    and for deferred computation of nSVfit solutions on previously selected pairs)
+//    NOTE: the configurations are run one after the other,
+//          as the nSVfit plugins book ROOT histograms and make use of NSVfitAlgorithmBase::gNSVfitAlgorithm
+//          and hence cannot be executed concurrently
+	  typedef edm::Ptr<reco::Candidate> CandidatePtr;
+	  typedef std::map<std::string, CandidatePtr> inputParticleMap;
+	  inputParticleMap inputParticles;
+	  inputParticles.insert(std::pair<std::string, CandidatePtr>("leg1", leg1));
+	  inputParticles.insert(std::pair<std::string, CandidatePtr>("leg2", leg2));
+	  inputParticles.insert(std::pair<std::string, CandidatePtr>("met",  met));
+	  NSVfitResultCache::Key nSVfitCacheKey;
+	  if ( nSVfitCache_ ) nSVfitCacheKey = compNSVfitCacheKey(*leg1, *leg2, *met, *pv, compositePtrCandidate);
+	  if ( nSVfitInputRecorder_ ) beginNSVfitInputRecord(leg1, leg2, met, pv, compositePtrCandidate);
 	  for ( typename std::map<std::string, NSVfitAlgorithmBase*>::const_iterator nSVfitAlgorithm = nSVfitAlgorithms_.begin();
 		nSVfitAlgorithm != nSVfitAlgorithms_.end(); ++nSVfitAlgorithm ) {
+	    const NSVfitResonanceHypothesisSummary* nSVfitSolutionToReuse = ( nSVfitSolutionsToReuse ) ?
+	      nSVfitSolutionsToReuse->nSVfitSolution(nSVfitAlgorithm->first) : 0;
+	    if ( nSVfitSolutionToReuse ) {
+	      compositePtrCandidate.addNSVfitSolution(*nSVfitSolutionToReuse);
+	      if ( nSVfitInputRecorder_ ) nSVfitInputRecord_.addResult(nSVfitAlgorithm->first, *nSVfitSolutionToReuse, 0.);
+	      continue;
+	    }
+	    NSVfitResultCache::Key nSVfitAlgorithmCacheKey = nSVfitCacheKey;
+	    if ( nSVfitCache_ ) {
+	      nSVfitAlgorithmCacheKey.add(nSVfitConfigDigests_[nSVfitAlgorithm->first]);
+	      NSVfitResonanceHypothesisSummary nSVfitCachedSolution;
+	      if ( nSVfitCache_->get(nSVfitAlgorithmCacheKey, nSVfitCachedSolution) ) {
+		nSVfitCachedSolution.setName(nSVfitAlgorithm->first);
+		compositePtrCandidate.addNSVfitSolution(nSVfitCachedSolution);
+		if ( nSVfitInputRecorder_ ) nSVfitInputRecord_.addResult(nSVfitAlgorithm->first, nSVfitCachedSolution, 0.);
+		continue;
+	      }
+	    }
 	    //std::cout << "--> running nSVfit algorithm: name = " << nSVfitAlgorithm->first << std::endl;
-	    typedef edm::Ptr<reco::Candidate> CandidatePtr;
-	    typedef std::map<std::string, CandidatePtr> inputParticleMap;
-	    inputParticleMap inputParticles;
-	    inputParticles.insert(std::pair<std::string, CandidatePtr>("leg1", leg1));
-	    inputParticles.insert(std::pair<std::string, CandidatePtr>("leg2", leg2));
-	    inputParticles.insert(std::pair<std::string, CandidatePtr>("met",  met));
+	    double nSVfitStartTime = ( nSVfitInputRecorder_ ) ? NSVfitTimeBudget::getTime() : 0.;
 	    std::auto_ptr<NSVfitEventHypothesisBase> nSVfitHypothesis(nSVfitAlgorithm->second->fit(inputParticles, pv));	    
 	    //nSVfitHypothesis->print(std::cout);
 	    assert(nSVfitHypothesis->numResonances() == 1);
 	    NSVfitResonanceHypothesisSummary nSVfitHypothesisSummary(*nSVfitHypothesis->resonance(0));
 	    nSVfitHypothesisSummary.setName(nSVfitAlgorithm->first);
 	    compositePtrCandidate.addNSVfitSolution(nSVfitHypothesisSummary);
+//--- do not cache results of integrations stopped early because the time budget was exhausted
+	    if ( nSVfitCache_ && !nSVfitAlgorithm->second->isBudgetExhausted() )
+	      nSVfitCache_->put(nSVfitAlgorithmCacheKey, nSVfitHypothesisSummary);
+	    if ( nSVfitInputRecorder_ )
+	      nSVfitInputRecord_.addResult(nSVfitAlgorithm->first, nSVfitHypothesisSummary, NSVfitTimeBudget::getTime() - nSVfitStartTime);
 	    //compositePtrCandidate.nSVfitSolution(nSVfitAlgorithm->first)->print(std::cout);
 	    //std::cout << " done." << std::endl;
 	  }
+	  if ( nSVfitInputRecorder_ ) nSVfitInputRecorder_->write(nSVfitInputRecord_);
 	}
 	//timerNSVFit_->Stop();
       }
@@ -618,13 +746,73 @@ class CompositePtrCandidateT1T2MEtAlgorithm
     return TMath::Sqrt(mt2);
   }
 
+//--- compute key identifying input to nSVfit computation in cache of nSVfit results
+//   (four-vectors, charge and decay mode of visible decay products, MET, MET covariance matrix and primary event vertex)
+  NSVfitResultCache::Key compNSVfitCacheKey(const reco::Candidate& leg1, const reco::Candidate& leg2,
+					    const reco::MET& met, const reco::Vertex& pv,
+					    const CompositePtrCandidateT1T2MEt<T1,T2>& compositePtrCandidate)
+  {
+    NSVfitResultCache::Key key;
+    addNSVfitCacheKey(key, leg1);
+    addNSVfitCacheKey(key, leg2);
+    key.add(met.px(), nSVfitCacheMomentumQuantum_);
+    key.add(met.py(), nSVfitCacheMomentumQuantum_);
+    TMatrixD metCov = ( compositePtrCandidate.hasMEtSignMatrix() ) ?
+      compositePtrCandidate.metSignMatrix() : met.getSignificanceMatrix();
+    for ( int iRow = 0; iRow < metCov.GetNrows(); ++iRow ) {
+      for ( int iColumn = 0; iColumn < metCov.GetNcols(); ++iColumn ) {
+	key.add(metCov(iRow, iColumn), nSVfitCacheMomentumQuantum_);
+      }
+    }
+    key.add(pv.x(), nSVfitCachePositionQuantum_);
+    key.add(pv.y(), nSVfitCachePositionQuantum_);
+    key.add(pv.z(), nSVfitCachePositionQuantum_);
+    return key;
+  }
+  void beginNSVfitInputRecord(const T1Ptr leg1, const T2Ptr leg2, const MEtPtr met, const reco::Vertex* pv,
+			      const CompositePtrCandidateT1T2MEt<T1,T2>& compositePtrCandidate)
+  {
+    UInt_t run = nSVfitInputRecord_.run_;
+    UInt_t lumi = nSVfitInputRecord_.lumi_;
+    UInt_t event = nSVfitInputRecord_.event_;
+    nSVfitInputRecord_.clear();
+    nSVfitInputRecord_.run_ = run;
+    nSVfitInputRecord_.lumi_ = lumi;
+    nSVfitInputRecord_.event_ = event;
+    nSVfitInputRecord_.candidateKey_ = hashPtr(hashPtr(hashPtr(0, leg1), leg2), met);
+    nSVfitInputRecord_.addLeg(*leg1);
+    nSVfitInputRecord_.addLeg(*leg2);
+    nSVfitInputRecord_.setMEt(*met, ( compositePtrCandidate.hasMEtSignMatrix() ) ?
+			      compositePtrCandidate.metSignMatrix() : met->getSignificanceMatrix());
+    nSVfitInputRecord_.setPrimaryVertex(pv);
+  }
+  void addNSVfitCacheKey(NSVfitResultCache::Key& key, const reco::Candidate& leg)
+  {
+    const reco::Candidate::LorentzVector& legP4 = leg.p4();
+    key.add(legP4.px(), nSVfitCacheMomentumQuantum_);
+    key.add(legP4.py(), nSVfitCacheMomentumQuantum_);
+    key.add(legP4.pz(), nSVfitCacheMomentumQuantum_);
+    key.add(legP4.energy(), nSVfitCacheMomentumQuantum_);
+    key.add((Long64_t)leg.charge());
+    const pat::Tau* tau = dynamic_cast<const pat::Tau*>(&leg);
+    key.add((Long64_t)(( tau ) ? tau->decayMode() : leg.pdgId()));
+  }
+
   int verbosity_;
   std::string scaleFuncImprovedCollinearApprox_;
+  PFMEtSignSharedEventData pfMEtSignSharedEventData_; // NOTE: needs to be declared before pfMEtSign and nSVfitAlgorithms
   PFMEtSignInterface* pfMEtSign_;
   TMatrixD pfMEtCov_;
   TMatrixD pfMEtCovInverse_;
   std::map<std::string, NSVfitAlgorithmBase*> nSVfitAlgorithms_;
+  std::map<std::string, std::string> nSVfitConfigDigests_;
+  NSVfitResultCache* nSVfitCache_;
+  double nSVfitCacheMomentumQuantum_;
+  double nSVfitCachePositionQuantum_;
+  NSVfitInputRecorder* nSVfitInputRecorder_;
+  NSVfitInputRecord nSVfitInputRecord_;
   TF1* scaleFunc_;
+  StringCutObjectSelector<CompositePtrCandidateT1T2MEt<T1,T2> >* expensiveQuantitiesPreselection_;
   typedef std::vector<int> vint;
   vint genParticleMatchPdgId_;
 
@@ -632,6 +820,8 @@ class CompositePtrCandidateT1T2MEtAlgorithm
   TStopwatch* timerPFMEtSign_;
   TStopwatch* timerNSVFit_;
   TStopwatch* timerMTauTauMin_;
+
+  NSVfitRandomGenerator mTauTauMinRandomGenerator_;
 };
 
 #endif
@@ -7,6 +7,31 @@
  * of a pair of tau leptons plus missing transverse momentum 
  * (representing the undetected momentum carried away by the neutrinos 
  *  produced in the two tau decays) 
+ *
+ * Optionally, collections for systematic shifts of the leg1, leg2 and MET input collections
+ * can be produced by the same module, configured via the 'systematics' parameter:
+ *
+ *   systematics = cms.PSet(
+ *     sysTauJetEnUp = cms.PSet(
+ *       srcLeg2 = cms.InputTag('patTausJECshiftUp')
+ *     ),
+ *     ...
+ *   )
+ *
+ * Input collections not specified for a shift are taken from the nominal configuration.
+ * The collection for each shift is stored with product instance label equal to the name of the shift.
+ * For pairs which have leg1, leg2 and MET identical to a nominal pair
+ * (same keys of leg1 and leg2 in their collections, identical four-vectors and MET covariance matrix),
+ * the nSVfit solutions of the nominal pair are reused; all other shifted pairs are evaluated in one pass,
+ * sharing the per-event initialization of the nSVfit algorithms with the nominal pairs.
+ *
+ * Deferred SVfit computation: 
+ * diTau objects can be built without SVfit (doSVreco = False) and selected by downstream modules first.
+ * A second instance of this module, with 'srcReRecoDiTauObjects' set to the selected collection
+ * and no 'srcReRecoDiTauToMEtAssociations' defined, then rebuilds the selected diTau objects
+ * from their leg1, leg2 and MET and runs SVfit only on them.
+ * nSVfit solutions present in the input objects are copied instead of being recomputed,
+ * so that chaining further modules of this kind does not repeat the fits.
  * 
  * \authors Colin Bernet,
  *          Michal Bluj,
@@ -27,6 +52,7 @@
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
 #include "FWCore/Framework/interface/ESHandle.h"
 
 #include "TrackingTools/TransientTrack/interface/TransientTrackBuilder.h"
@@ -55,6 +81,8 @@
 #include "DataFormats/METReco/interface/MET.h"
 
 #include <string>
+#include <vector>
+#include <map>
 
 template<typename T1, typename T2>
 class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer 
@@ -88,7 +116,26 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
     recoMode_ = cfg.getParameter<std::string>("recoMode");
     if ( cfg.exists("srcReRecoDiTauObjects") ) {
       srcReRecoDiTauObjects_ = cfg.getParameter<edm::InputTag>("srcReRecoDiTauObjects");
-      srcReRecoDiTauToMEtAssociations_ = cfg.getParameter<edm::InputTag>("srcReRecoDiTauToMEtAssociations");
+      srcReRecoDiTauToMEtAssociations_ = ( cfg.exists("srcReRecoDiTauToMEtAssociations") ) ? 
+	cfg.getParameter<edm::InputTag>("srcReRecoDiTauToMEtAssociations") : edm::InputTag();
+    }
+    if ( cfg.exists("systematics") ) {
+      if ( srcReRecoDiTauObjects_.label() != "" )
+	throw cms::Exception("ConfigError")
+	  << " Configuration parameter 'systematics' not supported in combination with 'srcReRecoDiTauObjects' !!\n";
+      edm::ParameterSet cfgSystematics = cfg.getParameter<edm::ParameterSet>("systematics");
+      typedef std::vector<std::string> vstring;
+      vstring sysNames = cfgSystematics.getParameterNamesForType<edm::ParameterSet>();
+      for ( vstring::const_iterator sysName = sysNames.begin();
+	    sysName != sysNames.end(); ++sysName ) {
+	edm::ParameterSet cfgSys = cfgSystematics.getParameter<edm::ParameterSet>(*sysName);
+	sysInputType sysInput;
+	sysInput.name_ = (*sysName);
+	sysInput.srcLeg1_ = ( cfgSys.exists("srcLeg1") ) ? cfgSys.getParameter<edm::InputTag>("srcLeg1") : srcLeg1_;
+	sysInput.srcLeg2_ = ( cfgSys.exists("srcLeg2") ) ? cfgSys.getParameter<edm::InputTag>("srcLeg2") : srcLeg2_;
+	sysInput.srcMET_ = ( cfgSys.exists("srcMET") ) ? cfgSys.getParameter<edm::InputTag>("srcMET") : srcMET_;
+	systematics_.push_back(sysInput);
+      }
     }
     verbosity_ = cfg.getUntrackedParameter<int>("verbosity", 0);
 
@@ -129,6 +176,10 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
     //std::cout << " doSVreco = " << doSVreco_ << std::endl;
     
     produces<CompositePtrCandidateCollection>("");
+    for ( typename std::vector<sysInputType>::const_iterator sysInput = systematics_.begin();
+	  sysInput != systematics_.end(); ++sysInput ) {
+      produces<CompositePtrCandidateCollection>(sysInput->name_);
+    }
   }
 
   ~CompositePtrCandidateT1T2MEtProducer() {}
@@ -138,6 +189,11 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
     algorithm_.beginJob(doSVreco_);
   }
 
+  void endJob()
+  {
+    algorithm_.endJob();
+  }
+
   void produce(edm::Event& evt, const edm::EventSetup& es)
   {
     //std::cout << "<CompositePtrCandidateT1T2MEtProducer::produce (moduleLabel = " << moduleLabel_ << ")>:" << std::endl;
@@ -149,21 +205,18 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
       pf::fetchCollection(diTauCandidateCollection, srcReRecoDiTauObjects_, evt);
       numDiTauCandidates = diTauCandidateCollection->size();
     } else {
-      typedef edm::View<T1> T1View;
-      edm::Handle<T1View> leg1Collection;
-      pf::fetchCollection(leg1Collection, srcLeg1_, evt);
-      typedef edm::View<T2> T2View;
-      edm::Handle<T2View> leg2Collection;
-      pf::fetchCollection(leg2Collection, srcLeg2_, evt);
-      numDiTauCandidates = leg1Collection->size()*leg2Collection->size();
+      numDiTauCandidates = countDiTauCandidates(evt, srcLeg1_, srcLeg2_);
+      for ( typename std::vector<sysInputType>::const_iterator sysInput = systematics_.begin();
+	    sysInput != systematics_.end(); ++sysInput ) {
+	numDiTauCandidates += countDiTauCandidates(evt, sysInput->srcLeg1_, sysInput->srcLeg2_);
+      }
     }
     if ( numDiTauCandidates == 0 ) {
       if ( verbosity_ >= 1 ) {
 	std::cout << "<CompositePtrCandidateT1T2MEtProducer::produce (moduleLabel = " << moduleLabel_ << ")>:" << std::endl;
 	std::cout << " No diTauCandidates to be produced --> skipping !!" << std::endl;
       }
-      std::auto_ptr<CompositePtrCandidateCollection> emptyCompositePtrCandidateCollection(new CompositePtrCandidateCollection());
-      evt.put(emptyCompositePtrCandidateCollection);
+      putEmptyCollections(evt);
       return;
     }
 
@@ -173,8 +226,7 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
       edm::LogError ("produce") 
 	<< " Error in Configuration ParameterSet" 
 	<< " --> CompositePtrCandidateT1T2MEt collection will NOT be produced !!";
-      std::auto_ptr<CompositePtrCandidateCollection> emptyCompositePtrCandidateCollection(new CompositePtrCandidateCollection());
-      evt.put(emptyCompositePtrCandidateCollection);
+      putEmptyCollections(evt);
       return;
     }
     
@@ -227,31 +279,44 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
 
       typedef edm::AssociationVector<edm::RefProd<CompositePtrCandidateCollection>, std::vector<int> > diTauToMEtAssociation;
       edm::Handle<diTauToMEtAssociation> correctedMEtAssociation;
-      pf::fetchCollection(correctedMEtAssociation, srcReRecoDiTauToMEtAssociations_, evt);
-
       typedef edm::View<reco::MET> MEtView;
       edm::Handle<MEtView> correctedMEtCollection;
-      pf::fetchCollection(correctedMEtCollection, srcMET_, evt);
+      bool useCorrectedMEt = ( srcReRecoDiTauToMEtAssociations_.label() != "" );
+      if ( useCorrectedMEt ) {
+	pf::fetchCollection(correctedMEtAssociation, srcReRecoDiTauToMEtAssociations_, evt);
+	pf::fetchCollection(correctedMEtCollection, srcMET_, evt);
+      }
 
       size_t numDiTauCandidates = diTauCandidateCollection->size();
       for ( size_t iDiTauCandidate = 0; iDiTauCandidate < numDiTauCandidates; ++iDiTauCandidate ) {
 	edm::Ref<CompositePtrCandidateCollection> diTauCandidateRef(diTauCandidateCollection, iDiTauCandidate);
 
-	int correctedMEt_index = (*correctedMEtAssociation)[diTauCandidateRef];
-
-	if ( (int)correctedMEtCollection->size() < correctedMEt_index ) {
-	  edm::LogError ("produce") 
-	    << " DiTauToMEtAssociation index = " << correctedMEt_index << "," 
-	    << " but found only " << correctedMEtCollection->size() << " MET objects in collection = " << srcMET_ 
-	    << " --> skipping !!";
-	  continue;
-	}
+	MEtPtr metPtr;
+	const CompositePtrCandidateT1T2MEt<T1,T2>* nSVfitSolutionsToReuse = 0;
+	if ( useCorrectedMEt ) {
+	  int correctedMEt_index = (*correctedMEtAssociation)[diTauCandidateRef];
+
+	  if ( (int)correctedMEtCollection->size() < correctedMEt_index ) {
+	    edm::LogError ("produce") 
+	      << " DiTauToMEtAssociation index = " << correctedMEt_index << "," 
+	      << " but found only " << correctedMEtCollection->size() << " MET objects in collection = " << srcMET_ 
+	      << " --> skipping !!";
+	    continue;
+	  }
 	
-	MEtPtr correctedMEtPtr = correctedMEtCollection->ptrAt(correctedMEt_index);
+	  metPtr = correctedMEtCollection->ptrAt(correctedMEt_index);
+	} else {
+//--- deferred SVfit mode: diTau objects have been built (and selected) before,
+//    run SVfit on the same leg1, leg2 and MET; 
+//    nSVfit solutions already present in the input objects are reused
+	  metPtr = diTauCandidateRef->met();
+	  nSVfitSolutionsToReuse = &(*diTauCandidateRef);
+	}
 
 	CompositePtrCandidateT1T2MEt<T1,T2> compositePtrCandidate = 
-	  algorithm_.buildCompositePtrCandidate(diTauCandidateRef->leg1(), diTauCandidateRef->leg2(), correctedMEtPtr, genParticles, 
-						pv, beamSpot, trackBuilder, recoMode_, doSVreco_, doPFMEtSign_, doMtautauMin_);
+	  algorithm_.buildCompositePtrCandidate(diTauCandidateRef->leg1(), diTauCandidateRef->leg2(), metPtr, genParticles, 
+						pv, beamSpot, trackBuilder, recoMode_, doSVreco_, doPFMEtSign_, doMtautauMin_, 
+						nSVfitSolutionsToReuse);
 
 	//std::cout << "mass(SVfit) **after** Z-recoil correction = " 
 	//	    << compositePtrCandidate.svFitSolution("psKine_MEt_ptBalance")->mass() << std::endl;
@@ -260,124 +325,245 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
       }
     } else {
 //--- "regular" creation of diTau objects from leg1, leg2, met input collections
+      if ( !buildCompositePtrCandidates(evt, srcLeg1_, srcLeg2_, srcMET_, genParticles, pv, beamSpot, trackBuilder, 
+					*compositePtrCandidateCollection, 0) ) {
+	putEmptyCollections(evt);
+	return;
+      }
+
+//--- create diTau objects for systematic shifts,
+//    reusing nSVfit solutions of nominal diTau objects with identical input
+      for ( typename std::vector<sysInputType>::const_iterator sysInput = systematics_.begin();
+	    sysInput != systematics_.end(); ++sysInput ) {
+	std::auto_ptr<CompositePtrCandidateCollection> compositePtrCandidateCollection_shifted(new CompositePtrCandidateCollection());
+	if ( !buildCompositePtrCandidates(evt, sysInput->srcLeg1_, sysInput->srcLeg2_, sysInput->srcMET_, genParticles, pv, beamSpot, trackBuilder, 
+					  *compositePtrCandidateCollection_shifted, compositePtrCandidateCollection.get()) ) {
+	  compositePtrCandidateCollection_shifted->clear();
+	}
+	evt.put(compositePtrCandidateCollection_shifted, sysInput->name_);
+      }
+    }
+
+    //std::cout << "--> num. diTau objects = " << compositePtrCandidateCollection->size() << std::endl;
+
+//--- add the collection of reconstructed CompositePtrCandidateT1T2MEts to the event
+    evt.put(compositePtrCandidateCollection);
+  }
+
+ private:
+
+  size_t countDiTauCandidates(const edm::Event& evt, const edm::InputTag& srcLeg1, const edm::InputTag& srcLeg2)
+  {
+    typedef edm::View<T1> T1View;
+    edm::Handle<T1View> leg1Collection;
+    pf::fetchCollection(leg1Collection, srcLeg1, evt);
+    typedef edm::View<T2> T2View;
+    edm::Handle<T2View> leg2Collection;
+    pf::fetchCollection(leg2Collection, srcLeg2, evt);
+    return leg1Collection->size()*leg2Collection->size();
+  }
+
+  void putEmptyCollections(edm::Event& evt)
+  {
+    std::auto_ptr<CompositePtrCandidateCollection> emptyCompositePtrCandidateCollection(new CompositePtrCandidateCollection());
+    evt.put(emptyCompositePtrCandidateCollection);
+    for ( typename std::vector<sysInputType>::const_iterator sysInput = systematics_.begin();
+	  sysInput != systematics_.end(); ++sysInput ) {
+      std::auto_ptr<CompositePtrCandidateCollection> emptyCompositePtrCandidateCollection_shifted(new CompositePtrCandidateCollection());
+      evt.put(emptyCompositePtrCandidateCollection_shifted, sysInput->name_);
+    }
+  }
+
+//--- index nominal diTau objects by the keys of their leg1 and leg2 Ptrs
+//   (shifted leg1 and leg2 collections contain the same objects in the same order as the nominal ones,
+//    so that keys of shifted and nominal objects agree)
+  typedef std::map<std::pair<size_t, size_t>, const CompositePtrCandidateT1T2MEt<T1,T2>*> nominalCompositePtrCandidateMap;
+  void fillNominalCompositePtrCandidateMap(const CompositePtrCandidateCollection& nominalCompositePtrCandidates,
+					   nominalCompositePtrCandidateMap& nominalCompositePtrCandidateLookup)
+  {
+    for ( typename CompositePtrCandidateCollection::const_iterator nominalCompositePtrCandidate = nominalCompositePtrCandidates.begin();
+	  nominalCompositePtrCandidate != nominalCompositePtrCandidates.end(); ++nominalCompositePtrCandidate ) {
+      std::pair<size_t, size_t> key(nominalCompositePtrCandidate->leg1().key(), nominalCompositePtrCandidate->leg2().key());
+      nominalCompositePtrCandidateLookup.insert(std::make_pair(key, &(*nominalCompositePtrCandidate)));
+    }
+  }
+
+//--- find nominal diTau object built from leg1, leg2 and MET with identical kinematics and MET covariance matrix
+  const CompositePtrCandidateT1T2MEt<T1,T2>* findNominalCompositePtrCandidate(const nominalCompositePtrCandidateMap* nominalCompositePtrCandidateLookup,
+									       const T1Ptr& leg1, const T2Ptr& leg2, const MEtPtr& met)
+  {
+    if ( !nominalCompositePtrCandidateLookup ) return 0;
+    typename nominalCompositePtrCandidateMap::const_iterator nominalCompositePtrCandidate = 
+      nominalCompositePtrCandidateLookup->find(std::pair<size_t, size_t>(leg1.key(), leg2.key()));
+    if ( nominalCompositePtrCandidate == nominalCompositePtrCandidateLookup->end() ) return 0;
+    const CompositePtrCandidateT1T2MEt<T1,T2>* nominal = nominalCompositePtrCandidate->second;
+    if ( !(nominal->leg1()->p4() == leg1->p4()) ) return 0;
+    if ( !(nominal->leg2()->p4() == leg2->p4()) ) return 0;
+    const MEtPtr& nominalMEt = nominal->met();
+    if ( nominalMEt.isNonnull() != met.isNonnull() ) return 0;
+    if ( met.isNonnull() ) {
+      if ( !(nominalMEt->p4() == met->p4()) ) return 0;
+      if ( !(nominalMEt->getSignificanceMatrix() == met->getSignificanceMatrix()) ) return 0;
+    }
+    return nominal;
+  }
+
+  CompositePtrCandidateT1T2MEt<T1,T2> buildCompositePtrCandidate(const T1Ptr& leg1, const T2Ptr& leg2, const MEtPtr& met, 
+								 const reco::GenParticleCollection* genParticles,
+								 const reco::Vertex* pv,
+								 const reco::BeamSpot* beamSpot,
+								 const TransientTrackBuilder* trackBuilder,
+								 const nominalCompositePtrCandidateMap* nominalCompositePtrCandidateLookup)
+  {
+    const CompositePtrCandidateT1T2MEt<T1,T2>* nominalCompositePtrCandidate = ( doSVreco_ ) ?
+      findNominalCompositePtrCandidate(nominalCompositePtrCandidateLookup, leg1, leg2, met) : 0;
+    return algorithm_.buildCompositePtrCandidate(leg1, leg2, met, genParticles, 
+						 pv, beamSpot, trackBuilder, recoMode_, doSVreco_, doPFMEtSign_, doMtautauMin_, 
+						 nominalCompositePtrCandidate);
+  }
 
-      typedef edm::View<T1> T1View;
-      edm::Handle<T1View> leg1Collection;
-      pf::fetchCollection(leg1Collection, srcLeg1_, evt);
-      typedef edm::View<T2> T2View;
-      edm::Handle<T2View> leg2Collection;
-      pf::fetchCollection(leg2Collection, srcLeg2_, evt);
-
-      MEtPtr metPtr;
-      if ( srcMET_.label() != "" ) {
-	typedef edm::View<reco::MET> MEtView;
-	edm::Handle<MEtView> metCollection;
-	pf::fetchCollection(metCollection, srcMET_, evt);
+//--- create diTau objects from leg1, leg2, met input collections;
+//    returns false in case the MET collection does not contain exactly one object
+  bool buildCompositePtrCandidates(edm::Event& evt, 
+				   const edm::InputTag& srcLeg1, const edm::InputTag& srcLeg2, const edm::InputTag& srcMET,
+				   const reco::GenParticleCollection* genParticles,
+				   const reco::Vertex* pv,
+				   const reco::BeamSpot* beamSpot,
+				   const TransientTrackBuilder* trackBuilder,
+				   CompositePtrCandidateCollection& compositePtrCandidateCollection,
+				   const CompositePtrCandidateCollection* nominalCompositePtrCandidates)
+  {
+    typedef edm::View<T1> T1View;
+    edm::Handle<T1View> leg1Collection;
+    pf::fetchCollection(leg1Collection, srcLeg1, evt);
+    typedef edm::View<T2> T2View;
+    edm::Handle<T2View> leg2Collection;
+    pf::fetchCollection(leg2Collection, srcLeg2, evt);
+
+    MEtPtr metPtr;
+    if ( srcMET.label() != "" ) {
+      typedef edm::View<reco::MET> MEtView;
+      edm::Handle<MEtView> metCollection;
+      pf::fetchCollection(metCollection, srcMET, evt);
 	
 //--- check that there is exactly one MET object in the event
 //    (missing transverse momentum is an **event level** quantity)
-	if ( metCollection->size() == 1 ) {
-	  metPtr = metCollection->ptrAt(0);
-	} else {
-	  edm::LogError ("produce") 
-	    << " Found " << metCollection->size() << " MET objects in collection = " << srcMET_ << ","
-	    << " --> CompositePtrCandidateT1T2MEt collection will NOT be produced !!";
-	  std::auto_ptr<CompositePtrCandidateCollection> emptyCompositePtrCandidateCollection(new CompositePtrCandidateCollection());
-	  evt.put(emptyCompositePtrCandidateCollection);
-	  return;
-	}
-      } 
+      if ( metCollection->size() == 1 ) {
+	metPtr = metCollection->ptrAt(0);
+      } else {
+	edm::LogError ("produce") 
+	  << " Found " << metCollection->size() << " MET objects in collection = " << srcMET << ","
+	  << " --> CompositePtrCandidateT1T2MEt collection will NOT be produced !!";
+	return false;
+      }
+    } 
+
+    nominalCompositePtrCandidateMap nominalCompositePtrCandidateLookup;
+    if ( doSVreco_ && nominalCompositePtrCandidates ) 
+      fillNominalCompositePtrCandidateMap(*nominalCompositePtrCandidates, nominalCompositePtrCandidateLookup);
+    const nominalCompositePtrCandidateMap* nominalCompositePtrCandidateLookup_ptr = ( nominalCompositePtrCandidates ) ?
+      &nominalCompositePtrCandidateLookup : 0;
 
 //--- check if only one combination of tau decay products 
 //    (the combination of highest Pt object in leg1 collection + highest Pt object in leg2 collection)
 //    shall be produced, or all possible combinations of leg1 and leg2 objects   
-      if ( useLeadingTausOnly_ ) {
+    if ( useLeadingTausOnly_ ) {
 
 //--- find highest Pt particles in leg1 and leg2 collections
-	int idxLeadingLeg1 = -1;
-	double leg1PtMax = 0.;
-	for ( unsigned idxLeg1 = 0, numLeg1 = leg1Collection->size(); 
-	      idxLeg1 < numLeg1; ++idxLeg1 ) {
-	  T1Ptr leg1Ptr = leg1Collection->ptrAt(idxLeg1);
-	  if ( idxLeadingLeg1 == -1 || leg1Ptr->pt() > leg1PtMax ) {
-	    idxLeadingLeg1 = idxLeg1;
-	    leg1PtMax = leg1Ptr->pt();
-	  }
+      int idxLeadingLeg1 = -1;
+      double leg1PtMax = 0.;
+      for ( unsigned idxLeg1 = 0, numLeg1 = leg1Collection->size(); 
+	    idxLeg1 < numLeg1; ++idxLeg1 ) {
+	T1Ptr leg1Ptr = leg1Collection->ptrAt(idxLeg1);
+	if ( idxLeadingLeg1 == -1 || leg1Ptr->pt() > leg1PtMax ) {
+	  idxLeadingLeg1 = idxLeg1;
+	  leg1PtMax = leg1Ptr->pt();
 	}
+      }
 	
-	int idxLeadingLeg2 = -1;
-	double leg2PtMax = 0.;
-	for ( unsigned idxLeg2 = 0, numLeg2 = leg2Collection->size(); 
-	      idxLeg2 < numLeg2; ++idxLeg2 ) {
-	  T2Ptr leg2Ptr = leg2Collection->ptrAt(idxLeg2);
+      int idxLeadingLeg2 = -1;
+      double leg2PtMax = 0.;
+      for ( unsigned idxLeg2 = 0, numLeg2 = leg2Collection->size(); 
+	    idxLeg2 < numLeg2; ++idxLeg2 ) {
+	T2Ptr leg2Ptr = leg2Collection->ptrAt(idxLeg2);
 	  
 //--- do not create CompositePtrCandidateT1T2MEt object 
 //    for combination of particle with itself
-	  if ( idxLeadingLeg1 != -1 ) {
-	    T1Ptr leadingLeg1Ptr = leg1Collection->ptrAt(idxLeadingLeg1);
-	    double dR = reco::deltaR(leadingLeg1Ptr->p4(), leg2Ptr->p4());
-	    if ( dR < dRmin12_ ) continue;
-	  }
+	if ( idxLeadingLeg1 != -1 ) {
+	  T1Ptr leadingLeg1Ptr = leg1Collection->ptrAt(idxLeadingLeg1);
+	  double dR = reco::deltaR(leadingLeg1Ptr->p4(), leg2Ptr->p4());
+	  if ( dR < dRmin12_ ) continue;
+	}
 	  
-	  if ( idxLeadingLeg2 == -1 || leg2Ptr->pt() > leg2PtMax ) {
-	    idxLeadingLeg2 = idxLeg2;
-	    leg2PtMax = leg2Ptr->pt();
-	  }
+	if ( idxLeadingLeg2 == -1 || leg2Ptr->pt() > leg2PtMax ) {
+	  idxLeadingLeg2 = idxLeg2;
+	  leg2PtMax = leg2Ptr->pt();
 	}
+      }
 	
-	if ( idxLeadingLeg1 != -1 &&
-	     idxLeadingLeg2 != -1 ) {
-	  T1Ptr leadingLeg1Ptr = leg1Collection->ptrAt(idxLeadingLeg1);
-	  T2Ptr leadingLeg2Ptr = leg2Collection->ptrAt(idxLeadingLeg2);
+      if ( idxLeadingLeg1 != -1 &&
+	   idxLeadingLeg2 != -1 ) {
+	T1Ptr leadingLeg1Ptr = leg1Collection->ptrAt(idxLeadingLeg1);
+	T2Ptr leadingLeg2Ptr = leg2Collection->ptrAt(idxLeadingLeg2);
 	  
-	  CompositePtrCandidateT1T2MEt<T1,T2> compositePtrCandidate = 
-	    algorithm_.buildCompositePtrCandidate(leadingLeg1Ptr, leadingLeg2Ptr, metPtr, genParticles, 
-						  pv, beamSpot, trackBuilder, recoMode_, doSVreco_, doPFMEtSign_, doMtautauMin_);
-	  compositePtrCandidateCollection->push_back(compositePtrCandidate);
-	} else {
-	  if ( verbosity_ >= 1 ) {
-	    edm::LogInfo ("produce") 
-	      << " Found no combination of particles in Collections" 
-	      << " leg1 = " << srcLeg1_ << " and leg2 = " << srcLeg2_ << ".";
-	  }
-	}
+	CompositePtrCandidateT1T2MEt<T1,T2> compositePtrCandidate = 
+	  buildCompositePtrCandidate(leadingLeg1Ptr, leadingLeg2Ptr, metPtr, genParticles, 
+				     pv, beamSpot, trackBuilder, nominalCompositePtrCandidateLookup_ptr);
+	compositePtrCandidateCollection.push_back(compositePtrCandidate);
       } else {
+	if ( verbosity_ >= 1 ) {
+	  edm::LogInfo ("produce") 
+	    << " Found no combination of particles in Collections" 
+	    << " leg1 = " << srcLeg1 << " and leg2 = " << srcLeg2 << ".";
+	}
+      }
+    } else {
 //--- check if the same collection is used on both legs;
 //    if so, skip diTau(j,i), j > i combination in order to avoid two diTau objects being produced
 //    for combinations (i,j) and (j,i) of the same pair of particles in leg1 and leg2 collections
-	bool sameCollection = (leg1Collection.id () == leg2Collection.id());
+      bool sameCollection = (leg1Collection.id () == leg2Collection.id());
+
+//--- retrieve Ptrs and directions of leg1 and leg2 objects once per collection
+//   (instead of once per pair), so that the dR12 check runs over contiguous arrays
+      unsigned numLeg1 = leg1Collection->size();
+      std::vector<T1Ptr> leg1Ptrs(numLeg1);
+      std::vector<double> leg1Eta(numLeg1);
+      std::vector<double> leg1Phi(numLeg1);
+      for ( unsigned idxLeg1 = 0; idxLeg1 < numLeg1; ++idxLeg1 ) {
+	leg1Ptrs[idxLeg1] = leg1Collection->ptrAt(idxLeg1);
+	leg1Eta[idxLeg1] = leg1Ptrs[idxLeg1]->eta();
+	leg1Phi[idxLeg1] = leg1Ptrs[idxLeg1]->phi();
+      }
+      unsigned numLeg2 = leg2Collection->size();
+      std::vector<T2Ptr> leg2Ptrs(numLeg2);
+      std::vector<double> leg2Eta(numLeg2);
+      std::vector<double> leg2Phi(numLeg2);
+      for ( unsigned idxLeg2 = 0; idxLeg2 < numLeg2; ++idxLeg2 ) {
+	leg2Ptrs[idxLeg2] = leg2Collection->ptrAt(idxLeg2);
+	leg2Eta[idxLeg2] = leg2Ptrs[idxLeg2]->eta();
+	leg2Phi[idxLeg2] = leg2Ptrs[idxLeg2]->phi();
+      }
    
-	for ( unsigned idxLeg1 = 0, numLeg1 = leg1Collection->size(); 
-	      idxLeg1 < numLeg1; ++idxLeg1 ) {
-	  T1Ptr leg1Ptr = leg1Collection->ptrAt(idxLeg1);
-	  
-	  unsigned idxLeg2_first = ( sameCollection ) ? (idxLeg1 + 1) : 0;
-	  for ( unsigned idxLeg2 = idxLeg2_first, numLeg2 = leg2Collection->size(); 
-		idxLeg2 < numLeg2; ++idxLeg2 ) {
-	    T2Ptr leg2Ptr = leg2Collection->ptrAt(idxLeg2);
+      for ( unsigned idxLeg1 = 0; idxLeg1 < numLeg1; ++idxLeg1 ) {
+	unsigned idxLeg2_first = ( sameCollection ) ? (idxLeg1 + 1) : 0;
+	for ( unsigned idxLeg2 = idxLeg2_first; idxLeg2 < numLeg2; ++idxLeg2 ) {
 
 //--- do not create CompositePtrCandidateT1T2MEt object 
 //    for combination of particle with itself
-	    double dR = reco::deltaR(leg1Ptr->p4(), leg2Ptr->p4());
-	    if ( dR < dRmin12_ ) continue;
+	  double dR = reco::deltaR(leg1Eta[idxLeg1], leg1Phi[idxLeg1], leg2Eta[idxLeg2], leg2Phi[idxLeg2]);
+	  if ( dR < dRmin12_ ) continue;
 	  
-	    CompositePtrCandidateT1T2MEt<T1,T2> compositePtrCandidate = 
-	      algorithm_.buildCompositePtrCandidate(leg1Ptr, leg2Ptr, metPtr, genParticles, 
-						    pv, beamSpot, trackBuilder, recoMode_, doSVreco_, doPFMEtSign_, doMtautauMin_);
-	    compositePtrCandidateCollection->push_back(compositePtrCandidate);
-	  }
+	  CompositePtrCandidateT1T2MEt<T1,T2> compositePtrCandidate = 
+	    buildCompositePtrCandidate(leg1Ptrs[idxLeg1], leg2Ptrs[idxLeg2], metPtr, genParticles, 
+				       pv, beamSpot, trackBuilder, nominalCompositePtrCandidateLookup_ptr);
+	  compositePtrCandidateCollection.push_back(compositePtrCandidate);
 	}
       }
     }
 
-    //std::cout << "--> num. diTau objects = " << compositePtrCandidateCollection->size() << std::endl;
-
-//--- add the collection of reconstructed CompositePtrCandidateT1T2MEts to the event
-    evt.put(compositePtrCandidateCollection);
+    return true;
   }
 
- private:
-
   std::string moduleLabel_;
 
   CompositePtrCandidateT1T2MEtAlgorithm<T1,T2> algorithm_;
@@ -396,6 +582,16 @@ class CompositePtrCandidateT1T2MEtProducer : public edm::EDProducer
   bool doMtautauMin_;
   edm::InputTag srcReRecoDiTauObjects_;
   edm::InputTag srcReRecoDiTauToMEtAssociations_;
+
+  struct sysInputType
+  {
+    std::string name_;
+    edm::InputTag srcLeg1_;
+    edm::InputTag srcLeg2_;
+    edm::InputTag srcMET_;
+  };
+  std::vector<sysInputType> systematics_;
+
   int verbosity_;
 
   int cfgError_;
@@ -12,6 +12,21 @@
  *  [2] "Bayesian Training of Backpropagation Networks by the Hybrid Monte Carlo Method",
  *      R. Neal, http://www.cs.toronto.edu/pub/radford/bbp.ps
  *
+ * The step-size of the "dynamic moves" can optionally be adapted during the "burnin" stage,
+ * by the "dual averaging" algorithm described in:
+ *  [3] "The No-U-Turn Sampler: Adaptively Setting Path Lengths in Hamiltonian Monte Carlo",
+ *      M. Hoffman and A. Gelman, arXiv:1111.4246
+ * together with a diagonal mass matrix (per-dimension step-sizes) estimated from the positions visited during "burnin".
+ * Step-size and mass matrix are kept fixed during the sampling stage.
+ *
+ * For the purpose of diagnosing badly performing Markov Chains, the moves can be recorded in a ring-buffer
+ * (cf. MarkovChainTrace class), which is written into a binary file on request of the calling code.
+ * Tracing can be enabled and disabled at runtime; when disabled, the overhead is one check per move.
+ *
+ * The time and number of integrand evaluations spent per integration can be limited (cf. NSVfitTimeBudget class).
+ * Once the budget is exhausted, the integration stops and the result is computed from the moves made in the sampling stage so far.
+ * Chains for which no valid start-position is found do not enter the computation of the integral value and uncertainty.
+ *
  * NOTE: integrand and callBackFunctions passed to MarkovChainIntegrator class
  *       must not be deleted until all integrations have finished.
  *
@@ -25,10 +40,11 @@
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
+#include "TauAnalysis/CandidateTools/interface/MarkovChainTrace.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitTimeBudget.h"
+
 #include <Math/Functor.h>
-#include <TRandom3.h>
-#include <TFile.h>
-#include <TTree.h>
 
 #include <vector>
 #include <string>
@@ -66,10 +82,42 @@ class MarkovChainIntegrator
 
 //--- set function to evaluate function values 
 //    in N-dimensional space in which the integration is performed
-//   (e.g. to monitor variation of resonance mass)
+//   (e.g. to monitor variation of resonance mass);
+//    the function values are recorded together with the moves of the Markov Chain 
+//    made in the sampling stage when tracing is enabled
   void setF(const ROOT::Math::Functor&, const std::string&);
 
-  void integrate(const std::vector<double>&, const std::vector<double>&, double&, double&, int&, const std::string& = "");
+  void integrate(const std::vector<double>&, const std::vector<double>&, double&, double&, int&);
+
+//--- enable/disable recording of moves in ring-buffer
+//   (arguments = size of ring-buffer and prescale, i.e. every n-th move gets recorded)
+  void enableTrace(unsigned, unsigned = 1);
+  void disableTrace() { traceEnabled_ = false; }
+  bool isTraceEnabled() const { return traceEnabled_; }
+
+//--- append moves recorded during last integration to binary file
+//   (second argument = label identifying the integration, e.g. run + event number)
+  void writeTrace(const std::string&, const std::string&) const;
+
+//--- fraction of moves accepted during sampling stage of last integration
+  double getAcceptanceRate() const;
+
+//--- limit time (in seconds) and number of integrand evaluations spent per integration
+//   (zero = unlimited)
+  void setBudget(double maxTime, unsigned long maxIntegrandCalls) { budget_.setLimits(maxTime, maxIntegrandCalls); }
+
+//--- check if last integration was stopped before all moves were made, 
+//    because the time or the number of integrand evaluations exceeded the budget
+//   (errorFlag is set to zero in case at least one move has been made in the sampling stage)
+  bool isBudgetExhausted() const { return budget_.isExhausted(); }
+
+//--- number of integrand evaluations spent in last integration
+  unsigned long numIntegrandCalls() const { return budget_.numIntegrandCalls(); }
+
+//--- access random number generator, 
+//    in order to set key identifying event and candidate before calling integrate
+//   (the sequence of random numbers is restarted at the beginning of each integration)
+  NSVfitRandomGenerator& getRandomGenerator() { return rnd_; }
 
   void print(std::ostream&) const;
 
@@ -77,6 +125,10 @@ class MarkovChainIntegrator
 
   void initializeStartPosition_and_Momentum();
 
+  void initializeAdaptation();
+  void updateAdaptation(unsigned);
+  void finalizeAdaptation();
+
   void makeStochasticMove(unsigned, bool&, bool&);
   void makeDynamicMoves(const std::vector<double>&);
   
@@ -84,6 +136,8 @@ class MarkovChainIntegrator
 
   void updateX(const std::vector<double>&);
 
+  void fillTrace(unsigned, unsigned, bool, bool);
+
   double evalProb(const std::vector<double>&);
   double evalE(const std::vector<double>&);
   double evalK(const std::vector<double>&, unsigned, unsigned);
@@ -158,8 +212,34 @@ class MarkovChainIntegrator
   bool useVariableEpsilon0_;
   double nu_;
 
+  // parameters for automatic adaptation of "dynamic moves" during "burnin" stage
+  // (adaptation starts after the "simulated annealing" stage)
+  //  adaptEpsilon:         flag to enable adaptation of step-size to target acceptance rate, by "dual averaging"
+  //  adaptMassMatrix:      flag to enable estimation of diagonal mass matrix 
+  //                        from variance of positions visited in first half of adaptation stage
+  //  targetAcceptanceRate: acceptance rate targeted by step-size adaptation
+  bool adaptEpsilon_;
+  bool adaptMassMatrix_;
+  double targetAcceptanceRate_;
+
+  // internal variables storing state of adaptation
+  //  epsilonScale:    common scale factor applied to step-sizes 
+  //  epsilonMass:     per-dimension step-sizes (initialized to epsilon0, 
+  //                   set to standard deviation of positions visited during "burnin" in case mass matrix is adapted)
+  //  acceptanceProb:  acceptance probability of last "stochastic move"
+  double epsilonScale_;
+  vdouble epsilonMass_; // index = dimension
+  double acceptanceProb_;
+  double dualAveragingMu_;
+  double dualAveragingHbar_;
+  double dualAveragingLogEpsilonBar_;
+  unsigned dualAveragingIter_;
+  unsigned numSamplesMassMatrix_;
+  vdouble qMean_;       // index = dimension
+  vdouble qM2_;         // index = dimension
+
   // random number generator
-  TRandom3 rnd_;
+  NSVfitRandomGenerator rnd_;
 
   // internal variables storing current state of Markov Chain
   vdouble p_;
@@ -173,6 +253,7 @@ class MarkovChainIntegrator
   vdouble qProposal_;
 
   vdouble probSum_; // index = chain*numBatches + batch 
+  std::vector<unsigned> numMovesBatch_; // index = chain*numBatches + batch 
   vdouble integral_;
 
   long numMoves_accepted_;
@@ -184,25 +265,21 @@ class MarkovChainIntegrator
   long numMovesTotal_accepted_;
   long numMovesTotal_rejected_;
 
-  void openMonitorFile(const std::string&);
-  void updateMonitorFile();
-  void closeMonitorFile();
-
-  TFile* monitorFile_;
-  TTree* monitorTree_;
-  std::vector<Float_t> branchValues_;
-  struct monitorElementType
-  {
-    monitorElementType(const ROOT::Math::Functor* f, const std::string& branchName)
-      : f_(f),
-	branchName_(branchName)
-    {}
-    ~monitorElementType() {}
-    const ROOT::Math::Functor* f_;
-    std::string branchName_;
-    Float_t branchValue_;
-  };
-  std::vector<monitorElementType> extraMonitorBranches_;
+  // limits on time and number of integrand evaluations per integration
+  NSVfitTimeBudget budget_;
+
+  // step-size of last "stochastic move"
+  double stepSize_;
+
+  // ring-buffer for recording moves of Markov Chain
+  MarkovChainTrace* trace_;
+  bool traceEnabled_;
+  unsigned traceBufferSize_;
+  unsigned tracePrescale_;
+
+  std::vector<const ROOT::Math::Functor*> extraValueFunctions_;
+  std::vector<std::string> extraValueNames_;
+  vdouble extraValues_;
 
   int verbosity_; // flag to enable/disable debug output
 };
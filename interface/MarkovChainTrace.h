@@ -0,0 +1,90 @@
+#ifndef TauAnalysis_CandidateTools_MarkovChainTrace_h
+#define TauAnalysis_CandidateTools_MarkovChainTrace_h
+
+/** \class MarkovChainTrace
+ *
+ * Record moves of Markov Chain (position, probability, acceptance probability and step-size)
+ * in a ring-buffer of fixed size, allocated once when tracing is enabled,
+ * and write the content of the buffer into a binary file on request
+ * (e.g. for events in which the integration has failed or gave a suspicious result).
+ *
+ * Only every n-th move is recorded (n = prescale).
+ * Once the buffer is full, the oldest entries get overwritten.
+ *
+ * Each call to write appends one block to the output file,
+ * consisting of a header followed by the entries in chronological order:
+ *
+ *  header:
+ *    char[4]   magic word "MCTR"
+ *    UInt_t    format version
+ *    UInt_t    number of dimensions N
+ *    UInt_t    number of extra values M (function values computed for monitoring purposes)
+ *    UInt_t    number of entries in block
+ *    UInt_t    number of moves recorded in total (including entries overwritten in ring-buffer)
+ *    UInt_t    length of label, followed by label characters (no terminating '\0')
+ *    M times: UInt_t length of name, followed by name characters
+ *  entry:
+ *    UInt_t    index of move
+ *    UShort_t  index of Markov Chain
+ *    UShort_t  flags (bit 0 = move accepted, bit 1 = move made during "burnin" stage)
+ *    Float_t   probability, acceptance probability and step-size
+ *    Float_t   position q (N values in interval ]0..1[)
+ *    Float_t   extra values (M values)
+ *
+ * All numbers are written in the native byte-order of the machine.
+ *
+ */
+
+#include <Rtypes.h>
+
+#include <vector>
+#include <string>
+
+class MarkovChainTrace
+{
+ public:
+  MarkovChainTrace(unsigned, unsigned, unsigned, unsigned);
+  ~MarkovChainTrace() {}
+
+  unsigned numExtraValues() const { return numExtraValues_; }
+
+//--- discard all entries
+  void reset();
+
+//--- check if current move is to be recorded
+  bool isToBeRecorded()
+  {
+    if ( ++prescaleCounter_ < prescale_ ) return false;
+    prescaleCounter_ = 0;
+    return true;
+  }
+
+//--- record move
+  void fill(unsigned, unsigned, bool, bool, double, double, double, const std::vector<double>&, const std::vector<double>&);
+
+//--- append content of ring-buffer to binary file
+  void write(const std::string&, const std::string&, const std::vector<std::string>&) const;
+
+ private:
+  unsigned numDimensions_;
+  unsigned numExtraValues_;
+  unsigned bufferSize_;
+  unsigned prescale_;
+  unsigned prescaleCounter_;
+
+  struct entryType
+  {
+    UInt_t idxMove_;
+    UShort_t idxChain_;
+    UShort_t flags_;
+    Float_t prob_;
+    Float_t acceptanceProb_;
+    Float_t stepSize_;
+  };
+  std::vector<entryType> entries_;   // index = position in ring-buffer
+  std::vector<Float_t> values_;      // index = position in ring-buffer*(numDimensions + numExtraValues) + value
+  unsigned idxNext_;
+  unsigned numEntriesTotal_;
+};
+
+#endif
@@ -29,14 +29,20 @@
 #include "TauAnalysis/CandidateTools/interface/NSVfitEventBuilderBase.h"
 #include "TauAnalysis/CandidateTools/interface/NSVfitParameter.h"
 #include "TauAnalysis/CandidateTools/interface/NSVfitTrackService.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitPluginTiming.h"
 
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitEventHypothesis.h"
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitResonanceHypothesis.h"
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitSingleParticleHypothesis.h"
 
+#include <TH1.h>
+
 #include <vector>
 #include <string>
 
+class PFMEtSignSharedEventData;
+
 class NSVfitAlgorithmBase
 {
  public:
@@ -73,6 +79,31 @@ class NSVfitAlgorithmBase
 
   const NSVfitEventHypothesis* currentEventHypothesis() const { return currentEventHypothesis_; }
 
+  // NOTE: integration algorithms stop in case the time or number of integrand evaluations 
+  //       exceeds the budget configured per tau lepton pair and return the best estimate obtained so far;
+  //       this function indicates whether the result of the last call to fit is such a partial result
+  bool isBudgetExhausted() const { return isBudgetExhausted_; }
+
+  // NOTE: random number generators used by the algorithm and its plugins 
+  //       need to be initialized for each candidate by calling this function,
+  //       in order for the result to be independent of the order in which events and candidates are processed
+  void initializeRandomGenerator(NSVfitRandomGenerator&) const;
+
+  // NOTE: per-event data of PFMEtSignInterface objects owned by likelihood plugins
+  //       are shared with other PFMEtSignInterface objects of identical configuration
+  //       in case the calling code sets this object before calling beginJob
+  //      (object is **not** owned by NSVfitAlgorithmBase)
+  void setPFMEtSignSharedEventData(PFMEtSignSharedEventData* sharedEventData) { pfMEtSignSharedEventData_ = sharedEventData; }
+  PFMEtSignSharedEventData* getPFMEtSignSharedEventData() const { return pfMEtSignSharedEventData_; }
+
+  // NOTE: objects measuring number of calls and CPU cycles spent in builder and likelihood plugins
+  //       are booked only in case configuration parameter 'monitorPluginTiming' is enabled;
+  //       null pointer is returned otherwise.
+  //       Calls of plugins with the same name are accumulated in the same object.
+  NSVfitPluginTiming* bookPluginTiming(const std::string&, const std::string&);
+  void printPluginTiming(std::ostream&) const;
+  const std::vector<TH1*>& getPluginTimingHistograms() const { return pluginTimingHistograms_; }
+
   friend class NSVfitTauLikelihoodTrackInfo;
 
  protected:
@@ -103,6 +134,8 @@ class NSVfitAlgorithmBase
 	  allLikelihoods.push_back(likelihood);
 	}
       }
+      numLikelihoods_ = likelihoods_.size();
+      likelihoodTimings_.assign(numLikelihoods_, 0);
     }
     ~daughterModelType()
     {
@@ -111,6 +144,12 @@ class NSVfitAlgorithmBase
 	delete (*it);
       }
     }
+    void bookPluginTiming(NSVfitAlgorithmBase* algorithm)
+    {
+      for ( unsigned iLikelihood = 0; iLikelihood < numLikelihoods_; ++iLikelihood ) {
+	likelihoodTimings_[iLikelihood] = algorithm->bookPluginTiming(likelihoods_[iLikelihood]->pluginName(), likelihoods_[iLikelihood]->pluginType());
+      }
+    }
     void beginCandidate(const NSVfitSingleParticleHypothesis* hypothesis)
     {
       for ( std::vector<NSVfitSingleParticleLikelihood*>::const_iterator likelihood = likelihoods_.begin();
@@ -121,15 +160,19 @@ class NSVfitAlgorithmBase
     double prob(const NSVfitSingleParticleHypothesis* hypothesis, int idxPolState) const
     {
       double retVal = 1.;
-      for ( std::vector<NSVfitSingleParticleLikelihood*>::const_iterator likelihood = likelihoods_.begin();
-	    likelihood != likelihoods_.end(); ++likelihood ) {
-	retVal *= (**likelihood)(hypothesis, hypothesis->polSign(idxPolState));
+      for ( unsigned iLikelihood = 0; iLikelihood < numLikelihoods_; ++iLikelihood ) {
+	NSVfitPluginTiming* timing = likelihoodTimings_[iLikelihood];
+	if ( timing ) timing->start();
+	retVal *= (*likelihoods_[iLikelihood])(hypothesis, hypothesis->polSign(idxPolState));
+	if ( timing ) timing->stop();
       }
       return retVal;
     }
     std::string daughterName_;
     std::string prodParticleLabel_;
     std::vector<NSVfitSingleParticleLikelihood*> likelihoods_;
+    unsigned numLikelihoods_;
+    std::vector<NSVfitPluginTiming*> likelihoodTimings_;
   };
 
   struct resonanceModelType
@@ -161,6 +204,8 @@ class NSVfitAlgorithmBase
 	daughters_.push_back(new daughterModelType(*daughterName, cfg_daughter, allLikelihoods));
       }
       numDaughters_ = daughters_.size();
+      numLikelihoods_ = likelihoods_.size();
+      likelihoodTimings_.assign(numLikelihoods_, 0);
     }
     ~resonanceModelType()
     {
@@ -173,6 +218,15 @@ class NSVfitAlgorithmBase
 	delete (*it);
       }
     }
+    void bookPluginTiming(NSVfitAlgorithmBase* algorithm)
+    {
+      for ( unsigned iLikelihood = 0; iLikelihood < numLikelihoods_; ++iLikelihood ) {
+	likelihoodTimings_[iLikelihood] = algorithm->bookPluginTiming(likelihoods_[iLikelihood]->pluginName(), likelihoods_[iLikelihood]->pluginType());
+      }
+      for ( unsigned iDaughter = 0; iDaughter < numDaughters_; ++iDaughter ) {
+	daughters_[iDaughter]->bookPluginTiming(algorithm);
+      }
+    }
     void beginCandidate(const NSVfitResonanceHypothesis* hypothesis)
     {
       for ( std::vector<NSVfitResonanceLikelihood*>::const_iterator likelihood = likelihoods_.begin();
@@ -187,9 +241,11 @@ class NSVfitAlgorithmBase
     double prob(const NSVfitResonanceHypothesis* hypothesis, int idxPolState) const
     {
       double retVal = 1.;
-      for ( std::vector<NSVfitResonanceLikelihood*>::const_iterator likelihood = likelihoods_.begin();
-	    likelihood != likelihoods_.end(); ++likelihood ) {
-	retVal *= (**likelihood)(hypothesis, hypothesis->polHandedness(idxPolState));
+      for ( unsigned iLikelihood = 0; iLikelihood < numLikelihoods_; ++iLikelihood ) {
+	NSVfitPluginTiming* timing = likelihoodTimings_[iLikelihood];
+	if ( timing ) timing->start();
+	retVal *= (*likelihoods_[iLikelihood])(hypothesis, hypothesis->polHandedness(idxPolState));
+	if ( timing ) timing->stop();
       }
       assert(hypothesis->numDaughters() == numDaughters_);
       for ( unsigned iDaughter = 0; iDaughter < numDaughters_; ++iDaughter ) {
@@ -201,6 +257,8 @@ class NSVfitAlgorithmBase
     std::vector<NSVfitResonanceLikelihood*> likelihoods_;
     std::vector<daughterModelType*> daughters_;
     unsigned numDaughters_;
+    unsigned numLikelihoods_;
+    std::vector<NSVfitPluginTiming*> likelihoodTimings_;
   };
 
   struct eventModelType
@@ -234,6 +292,8 @@ class NSVfitAlgorithmBase
 	resonances_.push_back(new resonanceModelType(*resonanceName, cfg_resonance, allLikelihoods));
       }
       numResonances_ = resonances_.size();
+      numLikelihoods_ = likelihoods_.size();
+      likelihoodTimings_.assign(numLikelihoods_, 0);
     }
     ~eventModelType()
     {
@@ -247,6 +307,15 @@ class NSVfitAlgorithmBase
 	delete (*it);
       }
     }
+    void bookPluginTiming(NSVfitAlgorithmBase* algorithm)
+    {
+      for ( unsigned iLikelihood = 0; iLikelihood < numLikelihoods_; ++iLikelihood ) {
+	likelihoodTimings_[iLikelihood] = algorithm->bookPluginTiming(likelihoods_[iLikelihood]->pluginName(), likelihoods_[iLikelihood]->pluginType());
+      }
+      for ( unsigned iResonance = 0; iResonance < numResonances_; ++iResonance ) {
+	resonances_[iResonance]->bookPluginTiming(algorithm);
+      }
+    }
     void beginCandidate(const NSVfitEventHypothesis* hypothesis)
     {
       for ( std::vector<NSVfitEventLikelihood*>::const_iterator likelihood = likelihoods_.begin();
@@ -261,9 +330,11 @@ class NSVfitAlgorithmBase
     double nll(const NSVfitEventHypothesis* hypothesis) const
     {
       double prob = 1.;
-      for ( std::vector<NSVfitEventLikelihood*>::const_iterator likelihood = likelihoods_.begin();
-	    likelihood != likelihoods_.end(); ++likelihood ) {
-	prob *= (**likelihood)(hypothesis);
+      for ( unsigned iLikelihood = 0; iLikelihood < numLikelihoods_; ++iLikelihood ) {
+	NSVfitPluginTiming* timing = likelihoodTimings_[iLikelihood];
+	if ( timing ) timing->start();
+	prob *= (*likelihoods_[iLikelihood])(hypothesis);
+	if ( timing ) timing->stop();
       }
       //std::cout << "prob (1) = " << prob << std::endl;
       assert(hypothesis->numResonances() == numResonances_);
@@ -313,6 +384,8 @@ class NSVfitAlgorithmBase
     std::vector<NSVfitEventLikelihood*> likelihoods_;
     std::vector<resonanceModelType*> resonances_;
     unsigned numResonances_;
+    unsigned numLikelihoods_;
+    std::vector<NSVfitPluginTiming*> likelihoodTimings_;
   };
 
   eventModelType* eventModel_;
@@ -322,14 +395,31 @@ class NSVfitAlgorithmBase
 
   edm::Service<NSVfitTrackService> trackService_;
   const edm::EventSetup* currentEventSetup_;
+  edm::RunNumber_t currentRunNumber_;
+  edm::LuminosityBlockNumber_t currentLumiSectionNumber_;
+  edm::EventNumber_t currentEventNumber_;
+  mutable UInt_t currentCandidateKey_;
   mutable NSVfitEventHypothesis* currentEventHypothesis_;
   mutable bool currentEventHypothesis_isValidSolution_;
   mutable NSVfitEventHypothesisBase* fittedEventHypothesis_;
   mutable double fittedEventHypothesis_nll_;
+  mutable bool isBudgetExhausted_;
+
+  PFMEtSignSharedEventData* pfMEtSignSharedEventData_;
 
   mutable std::vector<NSVfitParameter> fitParameters_;
   int fitParameterCounter_;
 
+  // instrumentation of time spent in builder and likelihood plugins
+  //  fitTiming:                 time spent per call of fit method (including building of hypotheses)
+  //  pluginTimingHistograms:    number of integrand (builder) calls and CPU cycles per call of fit method
+  bool monitorPluginTiming_;
+  std::vector<NSVfitPluginTiming*> pluginTimings_;
+  NSVfitPluginTiming* fitTiming_;
+  TH1* histogramNumIntegrandCalls_;
+  TH1* histogramNumCycles_;
+  std::vector<TH1*> pluginTimingHistograms_;
+
   int verbosity_;
 };
 
@@ -18,6 +18,8 @@
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
+#include "TauAnalysis/CandidateTools/interface/NSVfitPluginTiming.h"
+
 #include <string>
 #include <iostream>
 
@@ -29,7 +31,8 @@ class NSVfitBuilderBase
   NSVfitBuilderBase(const edm::ParameterSet& cfg)
     : pluginName_(cfg.getParameter<std::string>("pluginName")),
       pluginType_(cfg.getParameter<std::string>("pluginType")),
-      barcodeCounter_(0)
+      barcodeCounter_(0),
+      timing_(0)
   {
     verbosity_ = cfg.exists("verbosity") ?
       cfg.getParameter<int>("verbosity") : 0;
@@ -41,6 +44,14 @@ class NSVfitBuilderBase
 
   virtual void print(std::ostream&) const {}
 
+  const std::string& pluginType() const { return pluginType_; }
+  const std::string& pluginName() const { return pluginName_; }
+
+//--- set object used to measure time spent in applyFitParameter
+//   (null pointer in case timing is disabled)
+  void setTiming(NSVfitPluginTiming* timing) { timing_ = timing; }
+  NSVfitPluginTiming* timing() const { return timing_; }
+
  protected:
   int getFitParameterIdx(NSVfitAlgorithmBase*, const std::string&, int, bool = false);
 
@@ -50,6 +61,8 @@ class NSVfitBuilderBase
   int verbosity_;
 
   mutable int barcodeCounter_;
+
+  NSVfitPluginTiming* timing_;
 };
 
 #endif
@@ -17,6 +17,7 @@
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
 
 #include "TrackingTools/TransientTrack/interface/TransientTrackBuilder.h"
 #include "RecoVertex/KalmanVertexFit/interface/KalmanVertexFitter.h"
@@ -24,6 +25,8 @@
 #include "DataFormats/TrackReco/interface/Track.h"
 #include "DataFormats/TrackReco/interface/TrackFwd.h"
 
+#include "TauAnalysis/CandidateTools/interface/NSVfitTrackService.h"
+
 class NSVfitDecayVertexFitter
 {
  public:
@@ -38,6 +41,12 @@ class NSVfitDecayVertexFitter
  private:
   const TransientTrackBuilder* trackBuilder_;
 
+  /// Build TransientTrack via NSVfitTrackService, if available,
+  /// in order to share TransientTracks with the other NSVfit components
+  reco::TransientTrack transientTrack(const reco::Track*) const;
+  edm::Service<NSVfitTrackService> trackService_;
+  bool trackServiceIsAvailable_;
+
   const KalmanVertexFitter* vertexFitAlgorithm_;
 
   unsigned minNumTracksFit_;
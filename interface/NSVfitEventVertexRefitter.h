@@ -6,6 +6,18 @@
  * Class to refit position of primary event vertex,
  * excluding the tracks associated to tau decay products
  *
+ * Refitted vertices are cached per event, keyed by the original vertex
+ * and the set of excluded tracks, so that hypotheses sharing the same legs
+ * reuse the refit.
+ *
+ * In case the configuration parameter 'incrementalRefit' is set to true,
+ * the primary event vertex is fitted once per event with all its tracks
+ * and the tracks associated to tau decay products are then removed
+ * from the fitted vertex by Kalman "smoothing-out" of their contributions
+ * (cf. KalmanVertexUpdator::remove), instead of refitting the vertex from scratch.
+ * For the AdaptiveVertexFitter, the track weights determined in the fit
+ * of the full vertex are kept fixed in that case.
+ *
  * \author Evan Friis, Christian Veelken; UC Davis
  *
  * \version $Revision: 1.3 $
@@ -17,16 +29,24 @@
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
 
 #include "TrackingTools/TransientTrack/interface/TransientTrackBuilder.h"
 #include "RecoVertex/AdaptiveVertexFit/interface/AdaptiveVertexFitter.h"
 #include "RecoVertex/KalmanVertexFit/interface/KalmanVertexFitter.h"
+#include "RecoVertex/KalmanVertexFit/interface/KalmanVertexUpdator.h"
+#include "RecoVertex/VertexPrimitives/interface/CachingVertex.h"
 #include "DataFormats/BeamSpot/interface/BeamSpot.h"
 #include "DataFormats/VertexReco/interface/Vertex.h"
 #include "RecoVertex/VertexPrimitives/interface/TransientVertex.h"
 #include "DataFormats/TrackReco/interface/Track.h"
 #include "DataFormats/TrackReco/interface/TrackFwd.h"
 
+#include "TauAnalysis/CandidateTools/interface/NSVfitTrackService.h"
+
+#include <vector>
+#include <map>
+
 class NSVfitEventVertexRefitter
 {
  public:
@@ -47,10 +67,41 @@ class NSVfitEventVertexRefitter
 
   const TransientTrackBuilder* trackBuilder_;
 
+  /// Build TransientTrack via NSVfitTrackService, if available,
+  /// in order to share TransientTracks with the other NSVfit components
+  reco::TransientTrack transientTrack(const reco::Track*) const;
+  edm::Service<NSVfitTrackService> trackService_;
+  bool trackServiceIsAvailable_;
+
   const VertexFitter<5>* vertexFitAlgorithm_;
 
   unsigned minNumTracksRefit_;
 
+  /// Fit vertex, applying beam-spot constraint if requested
+  CachingVertex<5> fitVertex(const std::vector<reco::TransientTrack>&) const;
+
+  /// Tracks of primary event vertex and result of fit with all tracks,
+  /// computed once per event and vertex
+  struct eventVertexFitType
+  {
+    eventVertexFitType() : isFitted_(false) {}
+    std::vector<const reco::Track*> pvTracks_;
+    std::vector<reco::TransientTrack> pvTracks_transient_;
+    std::vector<unsigned> pvTrackOrder_; // order in which tracks are passed to the refit
+    CachingVertex<5> fittedVertex_;
+    bool isFitted_;
+  };
+  eventVertexFitType& getEventVertexFit(const reco::Vertex*) const;
+  mutable std::map<const reco::Vertex*, eventVertexFitType> eventVertexFits_;
+
+  /// Refitted vertices, keyed by original vertex and
+  /// (sorted) indices of tracks excluded from the refit
+  typedef std::pair<const reco::Vertex*, std::vector<unsigned> > refitSignatureType;
+  mutable std::map<refitSignatureType, TransientVertex> refittedVertices_;
+
+  bool incrementalRefit_;
+  KalmanVertexUpdator<5> vertexUpdator_;
+
   bool applyBeamSpotConstraint_;
 
   int verbosity_;
@@ -0,0 +1,161 @@
+#ifndef TauAnalysis_CandidateTools_NSVfitInputRecorder_h
+#define TauAnalysis_CandidateTools_NSVfitInputRecorder_h
+
+/** \class NSVfitInputRecorder
+ *
+ * Record input to nSVfit computation (per tau lepton pair) in a compact binary file,
+ * together with the nSVfit solutions and the time spent in the computation,
+ * so that the nSVfit computation can be replayed without running the full cmsRun configuration
+ * (cf. bin/replaySVfitInputs.cc)
+ *
+ * Input is recorded by CompositePtrCandidateT1T2MEtProducer (configuration parameter 'recordNSVfitInputFileName').
+ * The records are replayed by the standalone version of SVfit, which uses the kinematic and MET likelihoods only;
+ * the primary event vertex and tracks are recorded for inspection, but are not used in the replay.
+ * The nSVfit plugin algorithms (NSVfitProducer) depend on the EventSetup and on the track service
+ * and cannot be replayed without the framework; their input is not recorded.
+ * The label of the module is inserted into the file name (cf. makeFileName),
+ * so that modules cloned from the same configuration (e.g. for systematic shifts) write separate files.
+ *
+ * File format:
+ *
+ *  header:
+ *    char[4]   magic word "SVFI"
+ *    UInt_t    format version
+ *  record:
+ *    UInt_t    run, luminosity section and event number
+ *    UInt_t    key identifying the candidate within the event (cf. hashPtr in candidateAuxFunctions.h)
+ *    UInt_t    number of visible tau decay products N
+ *    N times:  Int_t pdgId, Int_t decay mode (-1 for electrons and muons), Float_t px, py, pz, energy,
+ *              UInt_t number of tracks T (track of electron or muon, signal cone tracks of tau-jet)
+ *              T times: Int_t charge, Float_t reference point (x, y, z), track parameters (qoverp, lambda, phi, dxy, dsz),
+ *                       covariance matrix of track parameters (15 elements of upper triangle, row-wise)
+ *    Float_t   MET px, py
+ *    Float_t   MET covariance matrix (xx, xy, yx, yy)
+ *    UInt_t    flag indicating whether primary event vertex is present
+ *    Float_t   position of primary event vertex (x, y, z)
+ *    UInt_t    number of nSVfit solutions M
+ *    M times:  UInt_t length of label, followed by label characters (no terminating '\0'),
+ *              UInt_t isValidSolution, Float_t mass, massErrUp, massErrDown, real time (in seconds)
+ *
+ * All numbers are written in the native byte-order of the machine.
+ *
+ * Tracks are recorded since format version 2; files of format version 1 can still be read.
+ *
+ */
+
+#include <Rtypes.h>
+#include <TMatrixD.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+namespace reco
+{
+  class Candidate;
+  class MET;
+  class Vertex;
+}
+
+struct NSVfitInputRecord
+{
+  NSVfitInputRecord() { clear(); }
+  ~NSVfitInputRecord() {}
+
+  void clear();
+
+  void addLeg(const reco::Candidate&);
+  void setMEt(const reco::MET&, const TMatrixD&);
+  void setPrimaryVertex(const reco::Vertex*);
+  template <typename T>
+  void addResult(const std::string& label, const T& resonance, double time)
+  {
+    resultType result;
+    result.label_ = label;
+    result.isValidSolution_ = resonance.isValidSolution();
+    result.mass_ = resonance.mass();
+    result.massErrUp_ = resonance.massErrUp();
+    result.massErrDown_ = resonance.massErrDown();
+    result.time_ = time;
+    results_.push_back(result);
+  }
+
+  UInt_t run_;
+  UInt_t lumi_;
+  UInt_t event_;
+  UInt_t candidateKey_;
+
+  struct legType
+  {
+    Int_t pdgId_;
+    Int_t decayMode_;
+    Float_t px_;
+    Float_t py_;
+    Float_t pz_;
+    Float_t energy_;
+    struct trackType
+    {
+      Int_t charge_;
+      Float_t referencePoint_[3];
+      Float_t parameters_[5];
+      Float_t covariance_[15];
+    };
+    std::vector<trackType> tracks_;
+  };
+  std::vector<legType> legs_;
+
+  Float_t metPx_;
+  Float_t metPy_;
+  Float_t metCov_[4];
+
+  UInt_t hasPrimaryVertex_;
+  Float_t primaryVertexPos_[3];
+
+  struct resultType
+  {
+    std::string label_;
+    UInt_t isValidSolution_;
+    Float_t mass_;
+    Float_t massErrUp_;
+    Float_t massErrDown_;
+    Float_t time_;
+  };
+  std::vector<resultType> results_;
+};
+
+class NSVfitInputRecorder
+{
+ public:
+  NSVfitInputRecorder(const std::string&);
+  ~NSVfitInputRecorder() {}
+
+//--- insert module label into file name, before the extension 
+//   (e.g. "nSVfitInput.bin" --> "nSVfitInput_muTauPairs.bin")
+  static std::string makeFileName(const std::string&, const std::string&);
+
+  void write(const NSVfitInputRecord&);
+
+  unsigned numRecords() const { return numRecords_; }
+
+ private:
+  std::string fileName_;
+  std::ofstream stream_;
+  unsigned numRecords_;
+};
+
+class NSVfitInputReader
+{
+ public:
+  NSVfitInputReader(const std::string&);
+  ~NSVfitInputReader() {}
+
+//--- read next record, return false at end of file
+  bool read(NSVfitInputRecord&);
+
+ private:
+  std::string fileName_;
+  std::ifstream stream_;
+  UInt_t formatVersion_;
+};
+
+#endif
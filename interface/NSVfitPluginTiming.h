@@ -0,0 +1,71 @@
+#ifndef TauAnalysis_CandidateTools_NSVfitPluginTiming_h
+#define TauAnalysis_CandidateTools_NSVfitPluginTiming_h
+
+/** \class NSVfitPluginTiming
+ *
+ * Count number of calls and accumulate number of CPU cycles
+ * spent in builder and likelihood plugins of NSVfit algorithm
+ *
+ * NOTE: objects are booked by NSVfitAlgorithmBase::bookPluginTiming,
+ *       only in case timing is enabled by configuration parameter 'monitorPluginTiming';
+ *       calling code is expected to check the pointer to the NSVfitPluginTiming object before calling start/stop,
+ *       so that the overhead is one comparison per call in case timing is disabled
+ *
+ */
+
+#include <Rtypes.h>
+
+#include <string>
+#include <time.h>
+
+class NSVfitPluginTiming
+{
+ public:
+  NSVfitPluginTiming(const std::string& pluginName, const std::string& pluginType)
+    : pluginName_(pluginName),
+      pluginType_(pluginType),
+      numCalls_(0),
+      numCycles_(0),
+      start_(0)
+  {}
+  ~NSVfitPluginTiming() {}
+
+  void start() { start_ = readCycleCounter(); }
+  void stop()
+  {
+    numCycles_ += (readCycleCounter() - start_);
+    ++numCalls_;
+  }
+
+  const std::string& pluginName() const { return pluginName_; }
+  const std::string& pluginType() const { return pluginType_; }
+
+  ULong64_t numCalls() const { return numCalls_; }
+  ULong64_t numCycles() const { return numCycles_; }
+
+//--- read time-stamp counter of CPU
+//   (number of nanoseconds on platforms other than x86)
+  static ULong64_t readCycleCounter()
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    UInt_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((ULong64_t)hi << 32) | lo;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULong64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+#endif
+  }
+
+ private:
+  std::string pluginName_;
+  std::string pluginType_;
+
+  ULong64_t numCalls_;
+  ULong64_t numCycles_;
+
+  ULong64_t start_;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TauAnalysis_CandidateTools_NSVfitRandomGenerator_h
+#define TauAnalysis_CandidateTools_NSVfitRandomGenerator_h
+
+/** \class NSVfitRandomGenerator
+ *
+ * Counter-based random number generator used by all stochastic components of SVfit
+ * (Markov Chain and VEGAS integration, toy MC in MET likelihood, mTauTauMin start-point search).
+ *
+ * The random numbers are computed by the Philox4x32-10 algorithm described in:
+ *  "Parallel Random Numbers: As Easy as 1, 2, 3",
+ *   J. Salmon, M. Moraes, R. Dror and D. Shaw, SC11 (2011)
+ * as a function of a key and a counter, without any state carried over from previous events:
+ * the sequence of random numbers is fully determined by
+ * (run, luminosity section, event, candidate, component, stream),
+ * so that results are reproducible independently of the order in which events and candidates are processed
+ * and of which other components have drawn random numbers before.
+ *
+ *  o component: name of the module or plugin drawing random numbers (e.g. pluginName)
+ *  o candidate: key identifying the candidate within the event (cf. hashPtr in candidateAuxFunctions.h)
+ *  o stream:    index to distinguish independent sequences drawn by the same component for the same candidate
+ *
+ * The interface follows TRandom, so that the class can be used as replacement for TRandom3.
+ *
+ */
+
+#include <Rtypes.h>
+
+#include <string>
+
+class NSVfitRandomGenerator
+{
+ public:
+  NSVfitRandomGenerator(const std::string& = "", UInt_t = 0);
+  ~NSVfitRandomGenerator() {}
+
+  void setComponent(const std::string&);
+  void setEvent(UInt_t, UInt_t, UInt_t);
+  void setCandidate(UInt_t);
+  void setStream(UInt_t);
+
+//--- restart sequence of random numbers for current key
+//   (called by the integrators at the beginning of each integration,
+//    in order to make integration results independent of processing history)
+  void reset();
+
+//--- random numbers uniformly distributed in ]0..2^32-1] and ]0..1[
+  UInt_t Integer32();
+  Double_t Rndm();
+
+//--- random numbers distributed according to uniform, Gaussian and Breit-Wigner distributions
+//   (same conventions as TRandom)
+  Double_t Uniform(Double_t, Double_t);
+  Double_t Gaus(Double_t = 0., Double_t = 1.);
+  Double_t BreitWigner(Double_t = 0., Double_t = 1.);
+
+//--- auxiliary functions to compute keys from strings and sequences of integers
+  static UInt_t hashString(const std::string&);
+  static UInt_t hashCombine(UInt_t, UInt_t);
+
+//--- Philox4x32-10 function computing four random numbers from counter (4 words) and key (2 words)
+  static void philox4x32(const UInt_t*, const UInt_t*, UInt_t*);
+
+ private:
+  void updateKey();
+  void generateBlock();
+
+  UInt_t componentHash_;
+  UInt_t stream_;
+  UInt_t run_;
+  UInt_t lumi_;
+  UInt_t event_;
+  UInt_t candidate_;
+
+  UInt_t key_[2];
+  UInt_t counter_[4];
+  UInt_t block_[4];
+  unsigned idxBlock_;
+};
+
+#endif
@@ -18,6 +18,8 @@
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
+#include "FWCore/Utilities/interface/Exception.h"
+
 #include "TauAnalysis/CandidateTools/interface/NSVfitLikelihoodBase.h"
 
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitResonanceHypothesis.h"
@@ -36,6 +38,27 @@ class NSVfitResonanceLikelihood : public NSVfitLikelihoodBase
   virtual void beginCandidate(const NSVfitResonanceHypothesis*) const {}
 
   virtual double operator()(const NSVfitResonanceHypothesis*, int) const = 0;
+
+//--- optional batch interface:
+//    compute likelihood for numPoints resonance hypotheses at once,
+//    the fitted kinematic quantities being given as one array per quantity (struct-of-arrays)
+  struct batchInputType
+  {
+    batchInputType()
+      : numPoints_(0),
+        mass_(0),
+        prod_angle_rf_(0)
+    {}
+    size_t numPoints_;
+    const double* mass_;          // mass of resonance
+    const double* prod_angle_rf_; // production angle of visible decay products in resonance rest-frame
+  };
+  virtual bool supportsBatchEvaluation() const { return false; }
+  virtual void evaluateBatch(const batchInputType&, int, double*) const
+  {
+    throw cms::Exception("NSVfitResonanceLikelihood")
+      << " Batch evaluation not implemented for plugin = " << pluginName_ << " of type = " << pluginType_ << " !!\n";
+  }
 };
 
 #include "FWCore/PluginManager/interface/PluginFactory.h"
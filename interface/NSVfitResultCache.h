@@ -0,0 +1,148 @@
+#ifndef TauAnalysis_CandidateTools_NSVfitResultCache_h
+#define TauAnalysis_CandidateTools_NSVfitResultCache_h
+
+/** \class NSVfitResultCache
+ *
+ * Persistent cache of nSVfit results, used to skip the time consuming integration
+ * when the same events are reprocessed with the same nSVfit configuration.
+ *
+ * Entries are content-addressed: the key is built from the (quantized) input to the fit,
+ * i.e. the four-vectors and decay modes of the visible decay products, MET, MET covariance matrix,
+ * position of the primary event vertex and the MD5 digest of the nSVfit configuration parameters.
+ * Inputs not included in the key (e.g. the particles used by the likelihood plugins to compute their own MET covariance)
+ * are assumed to be determined by the quantities that are.
+ *
+ * The results are stored as ROOT streamed objects, so that schema evolution of the data-formats is handled by ROOT.
+ *
+ * The cache file is mapped into memory (read-only) when the cache is opened
+ * and only an index of 64-bit key hashes to record positions is kept in memory,
+ * so that the memory consumption is small even for large cache files.
+ * New entries are kept in memory and appended to the file by calling write (e.g. at the end of the job).
+ *
+ * File format:
+ *
+ *  header:
+ *    char[4]   magic word "SVFC"
+ *    UInt_t    format version
+ *  record:
+ *    UInt_t    length of key
+ *    UInt_t    length of value
+ *    char[]    key
+ *    char[]    value
+ *
+ * All numbers are written in the native byte-order of the machine.
+ * A record truncated by a job that crashed while writing the cache file is ignored.
+ *
+ * The cache file is locked while new entries are appended,
+ * so that several jobs (or modules) may write to the same cache file.
+ * Entries appended by other jobs after the cache file has been opened are not visible to the current job.
+ * Cache files can be merged by concatenating the records, skipping the header of all but the first file.
+ *
+ */
+
+#include <Rtypes.h>
+#include <TBufferFile.h>
+#include <TClass.h>
+
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <typeinfo>
+#include <cmath>
+
+class NSVfitResultCache
+{
+ public:
+  NSVfitResultCache(const std::string&, bool);
+  ~NSVfitResultCache();
+
+  class Key
+  {
+   public:
+    Key() {}
+    ~Key() {}
+
+//--- append value, rounded to a multiple of quantum
+    void add(double value, double quantum)
+    {
+      add((Long64_t)std::floor(value/quantum + 0.5));
+    }
+    void add(Long64_t value)
+    {
+      data_.append(reinterpret_cast<const char*>(&value), sizeof(Long64_t));
+    }
+    void add(const std::string& value)
+    {
+      add((Long64_t)value.length());
+      data_.append(value);
+    }
+
+    const std::string& data() const { return data_; }
+
+   private:
+    std::string data_;
+  };
+
+//--- find entry, return true in case of cache hit
+  template <typename T>
+  bool get(const Key& key, T& value) const
+  {
+    const char* valueData = 0;
+    UInt_t valueLength = 0;
+    if ( !find(key.data(), valueData, valueLength) ) return false;
+    TClass* cl = TClass::GetClass(typeid(T));
+    TBufferFile buffer(TBuffer::kRead, valueLength, const_cast<char*>(valueData), kFALSE);
+    void* object = buffer.ReadObjectAny(cl);
+    if ( !object ) return false;
+    value = *static_cast<T*>(object);
+    cl->Destructor(object);
+    return true;
+  }
+
+//--- add entry
+  template <typename T>
+  void put(const Key& key, const T& value)
+  {
+    if ( isReadOnly_ ) return;
+    TBufferFile buffer(TBuffer::kWrite);
+    buffer.WriteObjectAny(&value, TClass::GetClass(typeid(T)));
+    insert(key.data(), std::string(buffer.Buffer(), buffer.Length()));
+  }
+
+//--- append new entries to cache file
+  void write();
+
+  unsigned numEntries() const { return index_.size() + newEntries_.size(); }
+  unsigned long numHits() const { return numHits_; }
+  unsigned long numMisses() const { return numMisses_; }
+
+  void print(std::ostream&) const;
+
+ private:
+  bool find(const std::string&, const char*&, UInt_t&) const;
+  void insert(const std::string&, const std::string&);
+
+  static ULong64_t hash(const std::string&);
+
+  std::string fileName_;
+  bool isReadOnly_;
+
+//--- memory mapped cache file
+  const char* fileData_;
+  size_t fileSize_;   // size of complete records (excluding truncated record at end of file)
+  size_t mappedSize_;
+
+//--- index of records in cache file (key hash --> position of record in file)
+  std::multimap<ULong64_t, size_t> index_;
+
+//--- entries added in current job, not yet written to cache file
+  std::multimap<ULong64_t, unsigned> newEntryIndex_;
+  std::vector<std::pair<std::string, std::string> > newEntries_;
+  unsigned numEntriesWritten_;
+
+  mutable unsigned long numHits_;
+  mutable unsigned long numMisses_;
+};
+
+#endif
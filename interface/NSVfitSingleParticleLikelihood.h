@@ -56,6 +56,34 @@ class NSVfitSingleParticleLikelihood : public NSVfitLikelihoodBase
 
   virtual double operator()(const NSVfitSingleParticleHypothesis*, int) const = 0;
 
+//--- optional batch interface:
+//    compute likelihood for numPoints tau decay hypotheses at once,
+//    the fitted kinematic quantities being given as one array per quantity (struct-of-arrays)
+  struct batchInputType
+  {
+    batchInputType()
+      : numPoints_(0),
+        visEnFracX_(0),
+        decayAngle_(0),
+        visMass_(0),
+        pVis_rf_(0),
+        pt_fitted_(0)
+    {}
+    size_t numPoints_;
+    const double* visEnFracX_; // fraction of tau lepton energy carried by visible decay products
+    const double* decayAngle_; // angle between tau lepton and visible decay products (Gottfried-Jackson angle)
+    const double* visMass_;    // mass of visible decay products
+    const double* pVis_rf_;    // momentum of visible decay products in tau lepton rest-frame
+    const double* pt_fitted_;  // transverse momentum of fitted tau lepton; 
+                               // needs to be given only in case visPtCutCorrection is applied
+  };
+  virtual bool supportsBatchEvaluation() const { return false; }
+  virtual void evaluateBatch(const batchInputType&, int, double*) const
+  {
+    throw cms::Exception("NSVfitSingleParticleLikelihood")
+      << " Batch evaluation not implemented for plugin = " << pluginName_ << " of type = " << pluginType_ << " !!\n";
+  }
+
  protected:
   std::string prodParticleLabel_;
 
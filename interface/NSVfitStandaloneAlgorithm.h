@@ -3,6 +3,9 @@
 
 #include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneLikelihood.h"
 #include "TauAnalysis/CandidateTools/interface/MarkovChainIntegrator.h"
+#include "TauAnalysis/CandidateTools/interface/VegasIntegrator.h"
+#include "TauAnalysis/CandidateTools/interface/QuasiMonteCarloIntegrator.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitTimeBudget.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 
 #include <TMath.h>
@@ -54,6 +57,24 @@ namespace NSVfitStandalone{
     int par;      //final state type
     double mtest; //current mass hypothesis
   };
+  // for VEGAS and quasi-Monte Carlo integration of a set of mass hypotheses from a shared set of points
+  class MultiMassObjectiveFunctionAdapter : public VegasIntegrator::Integrand
+  {
+  public:
+    void operator()(const double* x, double* f) const // NOTE: return values = likelihood, **not** -log(likelihood)
+    {
+      NSVfitStandaloneLikelihood::gNSVfitStandaloneLikelihood->probint(x, mtest, par, f);
+    }
+    void evaluate(const double* x, const std::vector<bool>& isActive, double* f) const
+    {
+      NSVfitStandaloneLikelihood::gNSVfitStandaloneLikelihood->probint(x, mtest, par, f, &isActive);
+    }
+    void SetPar(int parr) { par = parr; }
+    void SetM(const std::vector<double>& m) { mtest = m; }
+  private:
+    int par;                   //final state type
+    std::vector<double> mtest; //mass hypotheses
+  };
   // for markov chain integration
   void map_x(const double*, int, double*);
   // class definitions for markov chain integration method
@@ -226,7 +247,21 @@ namespace NSVfitStandalone{
 
    In the integration mode xFrac for the second leptons is determiend from xFrac of the first lepton for given di-tau mass, thus reducing 
    the number of parameters to be integrated out wrt. to the fit version by one. The di-tau mass is scanned for the highest likelihood 
-   starting from the visible mass of the two leptons. The return value is just the di-tau mass. 
+   starting from the visible mass of the two leptons. The return value is just the di-tau mass. In the function integrateVEGAS each 
+   mass hypothesis is integrated separately. In the function integrateVEGASMultiMass the likelihood is integrated for all mass 
+   hypotheses at once, from one set of points sampled by VEGAS (cf. interface/VegasIntegrator.h). The kinematics and likelihood 
+   of the first decay branch are computed once per point for all mass hypotheses. A coarse pass with few points on every 4th 
+   mass hypothesis determines the mass above which the likelihood is negligible; only the mass hypotheses below are integrated, 
+   with the same number of points per mass hypothesis as in integrateVEGAS, and mass hypotheses for which the likelihood 
+   becomes negligible are dropped after each VEGAS iteration. The number of likelihood evaluations (counted per mass hypothesis) 
+   is therefore similar to integrateVEGAS; the advantage is that the statistical fluctuations of neighbouring mass hypotheses 
+   are correlated, which yields a smooth likelihood curve as function of the di-tau mass. The function integrateQMC does the 
+   same, using randomized quasi-Monte Carlo points (scrambled Sobol sequence, cf. interface/QuasiMonteCarloIntegrator.h) instead of 
+   points sampled by VEGAS. For smooth integrands of low dimension, the uncertainty of quasi-Monte Carlo integration decreases 
+   faster with the number of points than for VEGAS; integrateQMC therefore uses 4 replicas of 256 points per mass hypothesis, 
+   about half the number of likelihood evaluations of integrateVEGAS. The precision obtained on recorded events 
+   can be compared to the VEGAS modes by the replaySVfitInputs executable. The scanned mass hypotheses and the corresponding likelihood values can be accessed via the functions massScan() 
+   and massScanLikelihood(). 
 
    Common usage is: 
    
@@ -251,6 +286,18 @@ namespace NSVfitStandalone{
    \var metPower : indicating an additional power to enhance the MET likelihood (default is 1.)
    \var addLogM : specifying whether to use the LogM penalty term or not (default is true)     
    \var maxObjFunctionCalls : the maximum of function calls before the minimization procedure is terminated (default is 5000)
+
+   The time and number of likelihood evaluations spent in integration mode can be limited, in order to bound the latency per 
+   tau lepton pair. Once the budget is exhausted, the integration stops and returns the best estimate obtained so far; 
+   optionally, the result of the fit mode is returned instead:
+
+   //algo.maxIntegrationTime(0.1);    // applies for integration modes (in units of seconds, default is 0. = unlimited)
+   //algo.maxIntegrandCalls(100000);  // applies for integration modes (default is 0 = unlimited)
+   //algo.fallbackToFit(true);        // applies for integration modes (default is false)
+   algo.integrateMarkovChain();
+   if(algo.isBudgetExhausted()){
+     std::cout << "integration stopped early, result is approximate" << std::endl;
+   }
 */
 class NSVfitStandaloneAlgorithm
 {
@@ -266,6 +313,12 @@ class NSVfitStandaloneAlgorithm
   void metPower(double value) { nll_->metPower(value); }
   /// maximum function calls after which to stop the minimization procedure (default is 5000)
   void maxObjFunctionCalls(double value) { maxObjFunctionCalls_ = value; }
+  /// maximum time (in seconds) spent per integration (default is 0. = unlimited)
+  void maxIntegrationTime(double value) { budget_.setLimits(value, budget_.maxIntegrandCalls()); }
+  /// maximum number of likelihood evaluations per integration (default is 0 = unlimited)
+  void maxIntegrandCalls(unsigned value) { budget_.setLimits(budget_.maxTime(), value); }
+  /// run fit instead in case the integration gets stopped because the budget is exhausted (default is false)
+  void fallbackToFit(bool value) { fallbackToFit_ = value; }
 
   /// fit to be called from outside
   void fit();
@@ -273,6 +326,10 @@ class NSVfitStandaloneAlgorithm
   void integrate() { return integrateVEGAS(); }
   /// integration by VEGAS to be called from outside
   void integrateVEGAS();
+  /// integration by VEGAS for all mass hypotheses from a shared set of points, to be called from outside
+  void integrateVEGASMultiMass();
+  /// integration by randomized quasi-Monte Carlo for all mass hypotheses from a shared set of points, to be called from outside
+  void integrateQMC();
   /// integration by Markov Chain MC to be called from outside
   void integrateMarkovChain();
 
@@ -292,12 +349,22 @@ class NSVfitStandaloneAlgorithm
   bool isValidFit() { return fitStatus_ == 0; };
   /// return whether this is a valid solution or not
   bool isValidNLL() { return nllStatus_ == 0; };
+  /// return whether the last integration was stopped because the time or number of likelihood evaluations exceeded the budget
+  bool isBudgetExhausted() const { return isBudgetExhausted_; }
+  /// return number of likelihood evaluations spent in the last integration (counted per mass hypothesis)
+  unsigned long numIntegrandCalls() const { return numIntegrandCalls_; }
+  /// return whether the result of the last integration was replaced by the result of the fit
+  bool isFallbackToFit() const { return isFallbackToFit_; }
   /// return mass of the di-tau system 
   double mass() const { return mass_; };
   /// return uncertainty on the mass of the fitted di-tau system
   double massUncert() const { return massUncert_; };
   /// return mass of the di-tau system (kept for legacy)
   double getMass() const {return mass();};
+  /// return mass hypotheses scanned in the last VEGAS or quasi-Monte Carlo integration
+  const std::vector<double>& massScan() const { return massScan_; }
+  /// return likelihood values for the mass hypotheses scanned in the last VEGAS or quasi-Monte Carlo integration
+  const std::vector<double>& massScanLikelihood() const { return massScanLikelihood_; }
 
   /// return pt, eta, phi values and their uncertainties
   /*
@@ -333,6 +400,11 @@ class NSVfitStandaloneAlgorithm
  private:
   /// setup the starting values for the minimization (default values for the fit parameters are taken from src/SVFitParameters.cc in the same package)
   void setup();
+  /// replace result of integration by result of fit, in case budget is exhausted and fallback is enabled
+  void applyFallbackToFit();
+  /// integrate all mass hypotheses from a shared set of points (T = VegasIntegrator or QuasiMonteCarloIntegrator);
+  /// the first integrator is used for a coarse pass that determines the mass range integrated by the second one
+  template <typename T> void integrateMultiMass(T&, T&);
 
  private:
   /// return whether this is a valid solution or not
@@ -343,6 +415,12 @@ class NSVfitStandaloneAlgorithm
   unsigned int verbosity_;
   /// stop minimization after a maximal number of function calls
   unsigned int maxObjFunctionCalls_;
+  /// limits on time and number of likelihood evaluations per integration
+  NSVfitTimeBudget budget_;
+  bool fallbackToFit_;
+  bool isBudgetExhausted_;
+  bool isFallbackToFit_;
+  unsigned long numIntegrandCalls_;
 
   /// minuit instance 
   ROOT::Math::Minimizer* minimizer_;
@@ -350,10 +428,15 @@ class NSVfitStandaloneAlgorithm
   NSVfitStandalone::NSVfitStandaloneLikelihood* nll_;
   /// needed to make the fit function callable from within minuit
   NSVfitStandalone::ObjectiveFunctionAdapter standaloneObjectiveFunctionAdapter_;
+  /// needed for VEGAS and quasi-Monte Carlo integration of all mass hypotheses from a shared set of points
+  NSVfitStandalone::MultiMassObjectiveFunctionAdapter standaloneMultiMassObjectiveFunctionAdapter_;
   
   double mass_;
   /// uncertainty of the fitted di-tau mass
   double massUncert_;
+  /// mass hypotheses and likelihood values scanned in VEGAS or quasi-Monte Carlo integration
+  std::vector<double> massScan_;
+  std::vector<double> massScanLikelihood_;
   /// fit result for each of the decay branches 
   std::vector<NSVfitStandalone::LorentzVector> fittedTauLeptons_;
   /// fitted di-tau system
@@ -0,0 +1,90 @@
+#ifndef TauAnalysis_CandidateTools_NSVfitStandaloneColumnarReader_h
+#define TauAnalysis_CandidateTools_NSVfitStandaloneColumnarReader_h
+
+/** \class NSVfitStandaloneColumnarReader
+ *
+ * Read a fixed set of branches of a flat TTree into contiguous per-column arrays
+ * for use by the standalone SVfit batch tools (bin/nsvfitStandalone.cc, bin/studySVfitVisPtCuts.cc).
+ *
+ * Only the requested branches are enabled, all other branches of the TTree are never read.
+ * The columns can optionally be saved in a compact binary cache file,
+ * which is memory-mapped (without copying) when the same input is processed again.
+ *
+ * Layout of the cache file:
+ *   header (magic word, version, number of columns, number of entries, offset of data block,
+ *           size and modification time of input file, length of input file name)
+ *   absolute path of input file (null-terminated, padded to multiple of 8 bytes)
+ *   column names (null-terminated, padded to multiple of 8 bytes)
+ *   data block (numColumns x numEntries Float_t values, one column after the other)
+ *
+ * The cache file is used only in case the absolute path, size and modification time of the input file
+ * match the values stored in the header. Names of cache files that are unique for each input file and tree
+ * can be obtained from the makeCacheFileName function.
+ *
+ * NOTE: all values are converted to Float_t,
+ *       which is the type used for the branches of the SVfit input n-tuples.
+ *
+ */
+
+#include <TTree.h>
+
+#include <vector>
+#include <string>
+
+class NSVfitStandaloneColumnarReader
+{
+ public:
+  NSVfitStandaloneColumnarReader(const std::vector<std::string>&);
+  ~NSVfitStandaloneColumnarReader();
+
+//--- read columns from TTree given as function argument
+//   (maxEntries = -1 means all entries)
+  void readTree(TTree*, Long64_t maxEntries = -1);
+
+//--- memory-map columns from cache file.
+//    Returns false in case the cache file does not exist, has been written for a different input file
+//   (absolute path, size or modification time differ) or for a different set of columns;
+//    the reader is left empty in that case.
+//   (the input file is not checked in case inputFileName is empty)
+  bool openCache(const std::string& cacheFileName, const std::string& inputFileName = "");
+
+//--- write columns into cache file,
+//    recording absolute path, size and modification time of input file from which the columns have been read
+  void writeCache(const std::string& cacheFileName, const std::string& inputFileName = "") const;
+
+//--- compose name of cache file in given directory,
+//    from name of input file, hash of its absolute path and name of tree
+  static std::string makeCacheFileName(const std::string& directory, const std::string& inputFileName, const std::string& treeName);
+
+//--- read columns from cache file if valid,
+//    else read columns from TTree and (re)write cache file
+  void read(TTree*, const std::string& inputFileName, const std::string& cacheFileName);
+
+  size_t numEntries() const { return numEntries_; }
+  size_t numColumns() const { return columnNames_.size(); }
+  const std::vector<std::string>& columnNames() const { return columnNames_; }
+
+  size_t columnIndex(const std::string&) const;
+
+//--- access to contiguous array of numEntries values
+  const Float_t* column(size_t idx) const { return data_ + idx*numEntries_; }
+  const Float_t* column(const std::string& columnName) const { return column(columnIndex(columnName)); }
+
+  Float_t value(size_t idx, size_t iEntry) const { return data_[idx*numEntries_ + iEntry]; }
+
+  bool isMemoryMapped() const { return (mappedFile_ != 0); }
+
+ private:
+  void clear();
+
+  std::vector<std::string> columnNames_;
+
+  size_t numEntries_;
+
+  std::vector<Float_t> buffer_; // owned storage in case columns are read from TTree
+  void* mappedFile_;            // start of memory-mapped cache file (0 if not mapped)
+  size_t mappedFileSize_;
+  const Float_t* data_;
+};
+
+#endif
@@ -159,6 +159,11 @@ namespace NSVfitStandalone{
     double prob(const double* x) const;
     /// same as above but for integration mode.     
     double probint(const double* x, const double mtt, const int par) const;	
+    /// same as above but for a set of mass hypotheses, evaluated at the same point x. The parts of the computation that do not 
+    /// depend on the mass hypothesis (kinematics and likelihood of the first decay branch) are computed only once. The likelihood 
+    /// values are written to the array probs, which needs to be of the same size as mtt. In case isActive is given, the likelihood 
+    /// is computed only for the mass hypotheses flagged as active; the values for the other mass hypotheses are set to zero.
+    void probint(const double* x, const std::vector<double>& mtt, const int par, double* probs, const std::vector<bool>* isActive = 0) const;
     /// read out potential likelihood errors
     unsigned error() const { return errorCode_; };
 
@@ -177,11 +182,16 @@ namespace NSVfitStandalone{
     const double* transform(double* xPrime, const double* x) const;
     /// same as above but for integration mode. This function provides the mapping of integration parameters.
     const double* transformint(double* xPrime, const double* x, const double mtt, const int par) const;
+    /// kinematics of one decay branch in integration mode: fills the branch-wise nll parameters of xPrime and returns the four 
+    /// vector of the tau lepton in the labframe
+    LorentzVector transformintLeg(double* xPrime, unsigned int idx, double labframeXFrac, double nunuMass, double labframePhi) const;
     /// combined likelihood function. The same function os called for fit and integratino mode. Has to be const to be usable 
     /// by minuit/VEGAS/MarkovChain. The additional boolean phiPenalty is added to prevent singularities at the +/-pi boundaries 
     /// of kPhi within the fit parameters (kFitParams). It is only used in fit mode. In integration mode the passed on value 
     /// is always 0. 
     double prob(const double* xPrime, double phiPenalty) const;
+    /// likelihood of the tau decay for the decay branch idx (hadronic or leptonic)
+    double probTauDecay(unsigned int idx, const double* xPrime) const;
     
   private:
     /// additional power to enhance MET term in the nll (default is 1.)
@@ -0,0 +1,87 @@
+#ifndef TauAnalysis_CandidateTools_NSVfitTimeBudget_h
+#define TauAnalysis_CandidateTools_NSVfitTimeBudget_h
+
+/** \class NSVfitTimeBudget
+ *
+ * Limit the (wall-clock) time and number of integrand evaluations
+ * spent in the integration of one tau lepton pair.
+ *
+ * The budget is started at the beginning of each integration;
+ * the integration algorithms check it in between integrand evaluations
+ * and return the best estimate obtained so far once it is exhausted.
+ *
+ * A value of zero for either limit means "unlimited".
+ * In case the limit on the number of integrand evaluations is used alone,
+ * the result of the integration does not depend on the speed of the machine.
+ *
+ */
+
+#include <sys/time.h>
+
+class NSVfitTimeBudget
+{
+ public:
+  NSVfitTimeBudget(double maxTime = 0., unsigned long maxIntegrandCalls = 0)
+    : maxTime_(maxTime),
+      maxIntegrandCalls_(maxIntegrandCalls),
+      startTime_(0.),
+      numIntegrandCalls_(0),
+      isExhausted_(false)
+  {}
+  ~NSVfitTimeBudget() {}
+
+  void setLimits(double maxTime, unsigned long maxIntegrandCalls)
+  {
+    maxTime_ = maxTime;
+    maxIntegrandCalls_ = maxIntegrandCalls;
+  }
+  double maxTime() const { return maxTime_; }
+  unsigned long maxIntegrandCalls() const { return maxIntegrandCalls_; }
+  bool isLimited() const { return (maxTime_ > 0. || maxIntegrandCalls_ > 0); }
+
+//--- reset counters at beginning of integration
+  void start()
+  {
+    if ( maxTime_ > 0. ) startTime_ = getTime();
+    numIntegrandCalls_ = 0;
+    isExhausted_ = false;
+  }
+
+  void addIntegrandCalls(unsigned long numIntegrandCalls) { numIntegrandCalls_ += numIntegrandCalls; }
+
+//--- check if time or number of integrand evaluations exceed the limits;
+//    once exhausted, the budget stays exhausted until the next call to start
+  bool checkIsExhausted()
+  {
+    if ( !isExhausted_ ) {
+      if      ( maxIntegrandCalls_ > 0 && numIntegrandCalls_ >= maxIntegrandCalls_ ) isExhausted_ = true;
+      else if ( maxTime_ > 0. && (getTime() - startTime_) > maxTime_             ) isExhausted_ = true;
+    }
+    return isExhausted_;
+  }
+  bool isExhausted() const { return isExhausted_; }
+
+  unsigned long numIntegrandCalls() const { return numIntegrandCalls_; }
+
+//--- time elapsed since the budget was started
+//   (only available in case the time is limited)
+  double elapsedTime() const { return ( maxTime_ > 0. ) ? getTime() - startTime_ : 0.; }
+
+//--- read wall-clock time (in units of seconds)
+  static double getTime()
+  {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + 1.e-6*tv.tv_usec;
+  }
+
+ private:
+  double maxTime_;
+  unsigned long maxIntegrandCalls_;
+
+  double startTime_;
+  unsigned long numIntegrandCalls_;
+  bool isExhausted_;
+};
+
+#endif
@@ -10,6 +10,14 @@
  *
  * The caches are flushed automatically at the end of each event.
  *
+ * The TransientTrack cache is shared by all consumers within the event
+ * (NSVfit builders, NSVfitEventVertexRefitter, NSVfitDecayVertexFitter).
+ * It is implemented as open-addressing hash table of fixed capacity
+ * (configurable via the 'cacheCapacity' parameter), the entries of which
+ * are stored in a preallocated arena.  Lookups do not take any lock and may
+ * proceed concurrently with insertions; if the table is full, TransientTracks
+ * are built without being cached.
+ *
  * Author: Evan K. Friis (UC Davis)
  *
  */
@@ -29,6 +37,9 @@
 #include "TauAnalysis/CandidateTools/interface/SVfitTrackExtrapolation.h"
 #include "TrackingTools/TransientTrack/interface/TransientTrack.h"
 
+#include <vector>
+#include <map>
+
 // Forward declarations needed to register as edm::Service
 namespace edm {
   class ActivityRegistry;
@@ -50,6 +61,11 @@ class NSVfitTrackService
   /// (i.e. the nominal PV).
   void setup(const edm::EventSetup&, const reco::Candidate::Point&);
 
+  /// Retrieve TransientTrackBuilder only (for use by consumers which do not
+  /// need track linearization, e.g. the vertex fitters). The reference point
+  /// is left unchanged.
+  void setup(const edm::EventSetup&);
+
   /// Build a transient track from a TrackRef
   reco::TransientTrack transientTrack(const reco::Track*) const;
 
@@ -70,11 +86,28 @@ private:
   /// automatically by the servic eregisterat end of event.
   void reset(const edm::Event& evt, const edm::EventSetup&);
   edm::ESHandle<TransientTrackBuilder> builder_;
-  typedef std::map<const reco::Track*, reco::TransientTrack> TransTrackCache;
-  mutable TransTrackCache cacheTransientTrack_;
+
+  /// Slot of open-addressing hash table. The key is claimed by compare-and-swap,
+  /// the entry is published once the TransientTrack has been built.
+  struct TransTrackCacheSlot 
+  {
+    TransTrackCacheSlot() : key_(0), entry_(0) {}
+    const reco::Track* volatile key_;
+    const reco::TransientTrack* volatile entry_;
+  };
+  const reco::TransientTrack* findOrInsertTransientTrack(const reco::Track*) const;
+  mutable std::vector<TransTrackCacheSlot> cacheTransientTrack_;
+  size_t cacheMask_;
+  /// Arena holding the cached TransientTracks; entries are handed out via
+  /// atomic increment of numArenaEntries_
+  mutable std::vector<reco::TransientTrack> arenaTransientTrack_;
+  mutable volatile size_t numArenaEntries_;
+  mutable volatile size_t numSlotsUsed_;
+
   typedef std::map<const reco::Track*, SVfitTrackExtrapolation> TrackExtrapolationCache;
   mutable TrackExtrapolationCache cacheTrackExtrapolations_;
   bool isValid_;
+  bool hasRefPoint_;
   AlgebraicVector3 refPoint_;
 };
 
@@ -4,6 +4,13 @@
 /** \class NeuralMtautauAlgorithm
  *
  * Reconstruct tau+ tau- invariant mass using neural network
+ *
+ * The network is evaluated by TMVA::Reader (default)
+ * or, in case configuration parameter 'useCompiledMLP' is enabled, by NeuralMtautauMLP.
+ * The latter is faster, reentrant and supports the evaluation of many candidates in one batch;
+ * its output is expected to agree with TMVA::Reader within float precision.
+ * NOTE: run bin/exportNeuralMtautau.cc, which compares the two, on the weights file 
+ *       before enabling 'useCompiledMLP' for that file.
  * 
  * \authors Christian Veelken
  *
@@ -18,6 +25,8 @@
 
 #include "DataFormats/Candidate/interface/Candidate.h"
 
+#include "TauAnalysis/CandidateTools/interface/NeuralMtautauMLP.h"
+
 #include "TMVA/Reader.h"
 
 #include <TMatrixD.h>
@@ -29,17 +38,32 @@ class NeuralMtautauAlgorithm
  public:
 
   explicit NeuralMtautauAlgorithm(const edm::ParameterSet&);
-  explicit NeuralMtautauAlgorithm(const std::string&);
+  explicit NeuralMtautauAlgorithm(const std::string&, bool useCompiledMLP = false);
   ~NeuralMtautauAlgorithm();
 
   double operator()(const reco::Candidate::LorentzVector&, const reco::Candidate::LorentzVector&, double, double, const TMatrixD&);
 
+  // number of input variables of neural net
+  enum { kNumInputs = 11 };
+
+  // compute input variables of neural net for one candidate
+  // (Float_t array of size kNumInputs)
+  static void compInputVariables(const reco::Candidate::LorentzVector&, const reco::Candidate::LorentzVector&, double, double, const TMatrixD&,
+				 Float_t*);
+
+  // compute neural net output for numCandidates candidates,
+  // input variables stored one candidate after the other (numCandidates x kNumInputs values).
+  // NOTE: supported for 'useCompiledMLP' mode only
+  void evaluate(const Float_t*, size_t numCandidates, Float_t*) const;
+
  private:
 
-  void initialize(const std::string&);
+  void initialize(const std::string&, bool);
 
   TMVA::Reader* mva_;
 
+  NeuralMtautauMLP* mlp_;
+
   // NOTE: these variables need to match the list of variables used for MVA training,
   //       defined in TauAnalysis/CandidateTools/test/trainNeuralMtautau_cfg.py
   Float_t recLeg1Px_;
@@ -0,0 +1,79 @@
+#ifndef TauAnalysis_CandidateTools_NeuralMtautauMLP_h
+#define TauAnalysis_CandidateTools_NeuralMtautauMLP_h
+
+/** \class NeuralMtautauMLP
+ *
+ * Dense-layer representation of a TMVA MLP regression network,
+ * used for fast evaluation of the neural network reconstructing the tau+ tau- invariant mass.
+ *
+ * The network is read either directly from the TMVA weights file (trainNeuralMtautau_*_MLP.weights.xml)
+ * or from the compact text format written by writeFile (see bin/exportNeuralMtautau.cc).
+ *
+ * The evaluation reproduces the computation performed by TMVA::Reader::EvaluateRegression:
+ * the normalization of input variables and target is done in single precision,
+ * the neuron activations are computed in double precision, summing the synapses in the same order as TMVA.
+ *
+ * The evaluate methods are const and do not modify the object,
+ * so that a single instance can be shared by several threads.
+ *
+ */
+
+#include <Rtypes.h>
+
+#include <vector>
+#include <string>
+
+class NeuralMtautauMLP
+{
+ public:
+  NeuralMtautauMLP();
+  ~NeuralMtautauMLP();
+
+//--- read network from TMVA weights file in XML format
+  void readTMVAWeightsFile(const std::string&);
+
+//--- read/write network from/to compact text file
+  void readFile(const std::string&);
+  void writeFile(const std::string&) const;
+
+  unsigned numInputs() const { return numInputs_; }
+
+//--- expressions of input variables, as used in training
+//   (available only in case network has been read from TMVA weights file)
+  const std::vector<std::string>& inputExpressions() const { return inputExpressions_; }
+
+//--- compute network output for one set of input variables
+  Float_t evaluate(const Float_t*) const;
+
+//--- compute network output for numEvents sets of input variables,
+//    stored one event after the other (numEvents x numInputs values)
+  void evaluate(const Float_t*, size_t numEvents, Float_t*) const;
+
+  enum { kLinear, kTanh, kSigmoid, kRadial };
+
+ private:
+  void evaluateBlock(const Float_t*, size_t, Float_t*, std::vector<double>&, std::vector<double>&) const;
+
+  unsigned numInputs_;
+  std::vector<std::string> inputExpressions_;
+
+//--- normalization of input variables and target
+//    (TMVA "Norm" variable transformation, mapping [min, max] to [-1, +1])
+  bool hasNormalization_;
+  std::vector<Float_t> inputMin_;
+  std::vector<Float_t> inputMax_;
+  Float_t targetMin_;
+  Float_t targetMax_;
+
+  struct layerType
+  {
+    unsigned numInputs_;
+    unsigned numOutputs_;
+    int activation_;
+    std::vector<double> weights_; // numOutputs x (numInputs + 1) matrix, bias weight stored last in each row
+  };
+  std::vector<layerType> layers_;
+  unsigned maxNumNeurons_;
+};
+
+#endif
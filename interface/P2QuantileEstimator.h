@@ -0,0 +1,59 @@
+#ifndef TauAnalysis_CandidateTools_P2QuantileEstimator_h
+#define TauAnalysis_CandidateTools_P2QuantileEstimator_h
+
+/** \class P2QuantileEstimator
+ *
+ * Estimate quantiles and (interpolated) mode of a distribution
+ * from a stream of values, without storing the values.
+ *
+ * The estimate is based on the P^2 algorithm described in:
+ *   "The P^2 Algorithm for Dynamic Calculation of Quantiles and Histograms Without Storing Observations",
+ *   R. Jain and I. Chlamtac, Communications of the ACM 28 (1985) 1076,
+ * extended to multiple quantiles by placing one marker per quantile,
+ * one marker in between each pair of neighbouring quantiles
+ * and (optionally) markers at equidistant probabilities,
+ * which are used to estimate the density of the distribution and its maximum.
+ *
+ * Memory and CPU time per value are proportional to the number of markers
+ * and do not depend on the number of values.
+ *
+ */
+
+#include <vector>
+
+class P2QuantileEstimator
+{
+ public:
+  P2QuantileEstimator(const std::vector<double>&, unsigned = 0);
+  ~P2QuantileEstimator() {}
+
+  void reset();
+
+  void fill(double);
+
+  unsigned long numEntries() const { return numEntries_; }
+
+//--- return estimate of quantile for given probability
+//   (exact marker positions for the probabilities given in the constructor, linear interpolation otherwise)
+  double quantile(double) const;
+
+//--- return position of maximum of distribution,
+//    estimated by parabolic interpolation of density computed from distance between markers
+//    enclosing windows of 10% probability
+  double mode() const;
+
+  double mean() const { return ( numEntries_ > 0 ) ? sum_/numEntries_ : 0.; }
+
+ private:
+  std::vector<double> probabilities_; // probability of each marker (first = 0, last = 1)
+  unsigned numMarkers_;
+
+  std::vector<double> heights_;       // position of marker on x-axis (or values, before numMarkers values have been filled)
+  std::vector<double> positions_;     // number of values smaller than marker
+  std::vector<double> desiredPositions_;
+
+  unsigned long numEntries_;
+  double sum_;
+};
+
+#endif
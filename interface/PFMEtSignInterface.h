@@ -8,6 +8,13 @@
  *  RecoMET/METAlgorithms/interface/significanceAlgo.h 
  * (see CMS AN-10/400 for description of the (PF)MEt significance computation)
  *
+ * The lists of PFJets and PFCandidates and the covariance matrices computed for each set of leptons
+ * are reused within the same event. Instances attached to the same PFMEtSignSharedEventData object
+ * (cf. setSharedEventData) share these data with all other attached instances of identical configuration.
+ * This avoids repeating the (expensive) computation of the MET covariance matrix when several nSVfit configurations,
+ * which each own a PFMEtSignInterface, are run on the same di-tau pair.
+ * Only the covariance matrix is shared; the MET likelihood itself is evaluated separately by each configuration.
+ *
  * \author Christian Veelken, UC Davis
  *
  * \version $Revision: 1.5 $
@@ -23,12 +30,48 @@
 #include "DataFormats/ParticleFlowCandidate/interface/PFCandidateFwd.h"
 #include "DataFormats/JetReco/interface/PFJet.h"
 #include "DataFormats/JetReco/interface/PFJetCollection.h"
+#include "DataFormats/Provenance/interface/EventID.h"
 
 #include "JetMETCorrections/METPUSubtraction/interface/PFMEtSignInterfaceBase.h"
 
 #include <TMatrixD.h>
 
 #include <list>
+#include <map>
+#include <vector>
+#include <string>
+
+//--- per-event data of PFMEtSignInterface
+struct PFMEtSignEventData
+{
+  PFMEtSignEventData()
+    : pfCandidates_(0)
+  {}
+  edm::EventID eventId_;
+  const reco::PFCandidateCollection* pfCandidates_; // identifies event together with eventId
+  std::list<const reco::PFJet*> pfJetList_;
+  std::list<const reco::PFCandidate*> pfCandidateList_;
+  typedef std::map<std::vector<const reco::Candidate*>, TMatrixD> covMatrixCacheType;
+  covMatrixCacheType covMatrixCache_;
+};
+
+//--- per-event data shared between PFMEtSignInterface instances,
+//    owned by the code running these instances (e.g. CompositePtrCandidateT1T2MEtAlgorithm)
+//   (one PFMEtSignEventData object per configuration of PFMEtSignInterface)
+class PFMEtSignSharedEventData
+{
+ public:
+  PFMEtSignSharedEventData() {}
+  ~PFMEtSignSharedEventData();
+
+  PFMEtSignEventData* getEventData(const std::string&);
+
+ private:
+  PFMEtSignSharedEventData(const PFMEtSignSharedEventData&);
+  PFMEtSignSharedEventData& operator=(const PFMEtSignSharedEventData&);
+
+  std::map<std::string, PFMEtSignEventData*> eventData_; // key = configuration
+};
 
 class PFMEtSignInterface : public PFMEtSignInterfaceBase
 {
@@ -37,17 +80,24 @@ class PFMEtSignInterface : public PFMEtSignInterfaceBase
   PFMEtSignInterface(const edm::ParameterSet&);
   ~PFMEtSignInterface();
 
+//--- share per-event data with other instances attached to the same PFMEtSignSharedEventData object
+//   (needs to be called before first call to beginEvent)
+  void setSharedEventData(PFMEtSignSharedEventData&);
+
   void beginEvent(const edm::Event&, const edm::EventSetup&);
 
   TMatrixD operator()(const std::list<const reco::Candidate*>&) const; 
 
  private:
 
+  TMatrixD compCovMatrix(const std::list<const reco::Candidate*>&) const;
+
   edm::InputTag srcPFJets_;
   edm::InputTag srcPFCandidates_;
 
-  std::list<const reco::PFJet*> pfJetList_;
-  std::list<const reco::PFCandidate*> pfCandidateList_;
+  std::string sharedEventDataKey_;
+  PFMEtSignEventData ownEventData_;
+  PFMEtSignEventData* eventData_; // either ownEventData or shared
 
   double dRoverlapPFJet_;
   double dRoverlapPFCandidate_;
@@ -0,0 +1,150 @@
+#ifndef TauAnalysis_CandidateTools_QuasiMonteCarloIntegrator_h
+#define TauAnalysis_CandidateTools_QuasiMonteCarloIntegrator_h
+
+/** \class QuasiMonteCarloIntegrator
+ *
+ * Generic class to compute the integrals of K functions
+ * over the same hypercube in N-dimensional space,
+ * by randomized quasi-Monte Carlo integration.
+ *
+ * The points are taken from the Sobol sequence described in:
+ *  [1] "On the distribution of points in a cube and the approximate evaluation of integrals",
+ *      I. M. Sobol, USSR Comput. Math. Math. Phys. 7 (1967) 86
+ * using the direction numbers of:
+ *  [2] "Constructing Sobol sequences with better two-dimensional projections",
+ *      S. Joe and F. Y. Kuo, SIAM J. Sci. Comput. 30 (2008) 2635
+ * The sequence is randomized by a random linear matrix scrambling plus a random digital shift, as described in:
+ *  [3] "On the L2-discrepancy for anchored boxes",
+ *      J. Matousek, J. Complexity 14 (1998) 527
+ * Each randomized copy ("replica") of the first numPoints points of the sequence yields an unbiased estimate of the integrals.
+ * The integrals are computed by the average over numReplicas independent replicas,
+ * their uncertainties by the spread of the replicas.
+ *
+ * For smooth integrands in few dimensions, the uncertainty decreases almost as 1/numPoints,
+ * compared to 1/sqrt(numPoints) for (pseudo-)random sampling.
+ * The number of points per replica is rounded up to the next power of two,
+ * for which the Sobol points are distributed most uniformly.
+ *
+ * The class has the same interface as the VegasIntegrator class.
+ * All K functions are evaluated at the same points.
+ * In case the configuration parameter pruneThreshold is positive, functions whose integral is negligible
+ * are no longer evaluated in subsequent replicas, using the same criterion as the VegasIntegrator class
+ * (applied after each replica, starting from the second one).
+ * The time and number of integrand evaluations spent per integration can be limited (cf. NSVfitTimeBudget class).
+ * The evaluation of each function at each point is counted as one integrand evaluation.
+ * Once the budget is exhausted, the integration stops and the integrals are computed from the replicas completed so far.
+ *
+ * NOTE: integrand passed to QuasiMonteCarloIntegrator class
+ *       must not be deleted until all integrations have finished.
+ *
+ */
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "TauAnalysis/CandidateTools/interface/VegasIntegrator.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitTimeBudget.h"
+
+#include <Rtypes.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+class QuasiMonteCarloIntegrator
+{
+ public:
+//--- interface of functions to be integrated (same as for VegasIntegrator)
+  typedef VegasIntegrator::Integrand Integrand;
+
+  QuasiMonteCarloIntegrator(const edm::ParameterSet&);
+  ~QuasiMonteCarloIntegrator() {}
+
+//--- set functions to be integrated
+//   (second argument = number K of functions)
+  void setIntegrand(const Integrand&, unsigned);
+
+//--- compute integrals of all K functions
+//    over the hypercube given by lower and upper boundaries xMin and xMax
+//   (errorFlag is set to zero in case at least one replica has been completed)
+  void integrate(const std::vector<double>&, const std::vector<double>&, std::vector<double>&, std::vector<double>&, int&);
+
+//--- limit time (in seconds) and number of integrand evaluations spent per integration
+//   (zero = unlimited)
+  void setBudget(double maxTime, unsigned long maxIntegrandCalls) { budget_.setLimits(maxTime, maxIntegrandCalls); }
+
+//--- check if last integration was stopped before all replicas were completed,
+//    because the time or the number of integrand evaluations exceeded the budget
+  bool isBudgetExhausted() const { return budget_.isExhausted(); }
+
+//--- number of integrand evaluations spent in last integration
+//   (counted per function, cf. above)
+  unsigned long numIntegrandCalls() const { return budget_.numIntegrandCalls(); }
+
+//--- number of functions not dropped in last integration
+  unsigned numActiveIntegrals() const { return numActive_; }
+
+//--- access random number generator used for scrambling the Sobol sequence,
+//    in order to set key identifying event and candidate before calling integrate
+//   (cf. NSVfitRandomGenerator::reset)
+  NSVfitRandomGenerator& getRandomGenerator() { return rnd_; }
+
+  void print(std::ostream&) const;
+
+//--- maximum number of dimensions for which direction numbers are available
+  static const unsigned maxDimensions = 21;
+
+ protected:
+  void initializeDirections();
+  void scrambleDirections();
+  unsigned runReplica();
+  void pruneIntegrals();
+
+  std::string name_;
+
+  const Integrand* integrand_;
+  unsigned numIntegrals_;
+
+  // parameters defining integration region
+  unsigned numDimensions_;
+  std::vector<double> xMin_; // index = dimension
+  std::vector<double> xMax_; // index = dimension
+
+  // parameters defining number of points per replica and number of replicas
+  unsigned numPoints_;
+  unsigned numReplicas_;
+
+  // threshold (relative to highest integral) below which functions are no longer evaluated (0 = never)
+  double pruneThreshold_;
+
+  // direction numbers of the Sobol sequence (cf. [1, 2]), before and after scrambling
+  std::vector<UInt_t> directions_;          // index = dimension*numBits + bit
+  std::vector<UInt_t> scrambledDirections_; // index = dimension*numBits + bit
+  std::vector<UInt_t> digitalShifts_;       // index = dimension
+
+  // sums of function values in current replica
+  std::vector<double> sumF_;                // index = function
+
+  // sums of integrals computed in different replicas
+  std::vector<double> sumIntegrals_;        // index = function
+  std::vector<double> sumIntegrals2_;       // index = function
+  unsigned numReplicasDone_;
+
+  // functions still evaluated and estimates of integrals of functions that have been dropped
+  std::vector<bool> isActive_;              // index = function
+  unsigned numActive_;
+  std::vector<double> prunedIntegrals_;     // index = function
+  std::vector<double> prunedIntegralErrs_;  // index = function
+
+  NSVfitRandomGenerator rnd_;
+  NSVfitTimeBudget budget_;
+
+  // temporary variables
+  std::vector<UInt_t> y_;                   // index = dimension
+  std::vector<double> x_;                   // index = dimension
+  std::vector<double> f_;                   // index = function
+
+  int verbosity_;
+};
+
+#endif
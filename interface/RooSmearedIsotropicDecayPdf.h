@@ -5,6 +5,8 @@
 #include "RooAbsReal.h"
 #include "RooRealProxy.h"
 
+#include <vector>
+
 class RooSmearedIsotropicDecayPdf : public RooAbsPdf {
   public:
     RooSmearedIsotropicDecayPdf(const char *name, const char *title,
@@ -25,10 +27,39 @@ class RooSmearedIsotropicDecayPdf : public RooAbsPdf {
 
     Double_t analyticalIntegral(Int_t code, const char *rangeName) const;
 
+    /// Give the PDF value for the specified x, location and smearing,
+    /// without the overhead of RooFit proxies
+    static Double_t evaluate(Double_t x, Double_t location, Double_t smear);
+
+    /// Give the PDF values for an array of n x values,
+    /// for fixed location and smearing.
+    /// The polynomial coefficients depending on location and smearing are computed only once.
+    static void evaluateBatch(const Double_t* x, Double_t* pdf, size_t n, Double_t location, Double_t smear);
+
+    /// Switch to tabulated evaluation: the PDF is precomputed on a regular grid
+    /// in (x, location, smearing) and evaluated by trilinear interpolation.
+    /// Values outside of the grid are computed analytically.
+    void tabulate(unsigned numBinsX, Double_t xMax,
+        unsigned numBinsLocation, Double_t locationMin, Double_t locationMax,
+        unsigned numBinsSmear, Double_t smearMin, Double_t smearMax);
+    bool isTabulated() const { return !table_.empty(); }
+
   private:
+    Double_t evaluateTable(Double_t x, Double_t location, Double_t smear) const;
+
     RooRealProxy x;
     RooRealProxy smear;
     RooRealProxy location;
+
+    std::vector<Double_t> table_;
+    unsigned tableNumPointsX_;
+    Double_t tableMaxX_;
+    unsigned tableNumPointsLocation_;
+    Double_t tableMinLocation_;
+    Double_t tableMaxLocation_;
+    unsigned tableNumPointsSmear_;
+    Double_t tableMinSmear_;
+    Double_t tableMaxSmear_;
 };
 
 #endif /* end of include guard: TauAnalysis_CandidateTools_RooSmearedIsotropicDecayPdf_h */
@@ -0,0 +1,164 @@
+#ifndef TauAnalysis_CandidateTools_VegasIntegrator_h
+#define TauAnalysis_CandidateTools_VegasIntegrator_h
+
+/** \class VegasIntegrator
+ *
+ * Generic class to compute the integrals of K functions
+ * over the same hypercube in N-dimensional space,
+ * by the VEGAS algorithm described in:
+ *  [1] "A New Algorithm for Adaptive Multidimensional Integration",
+ *      G. P. Lepage, J. Comput. Phys. 27 (1978) 192
+ *
+ * All K functions are evaluated at the same points, which are sampled according to one (separable) adaptive grid.
+ * After each iteration the grid is refined according to the sum of the contributions of the K functions,
+ * each normalized to one, so that every function has the same weight in the adaptation.
+ * This is useful in case the K functions are similar in shape and share part of the computations,
+ * e.g. the likelihood evaluated for a set of mass hypotheses (cf. NSVfitStandaloneAlgorithm::integrateVEGASMultiMass).
+ *
+ * In case the configuration parameter pruneThreshold is positive, functions whose integral is negligible
+ * are no longer evaluated in subsequent iterations: after each iteration, functions for which the estimate of the integral 
+ * plus three times its uncertainty is below pruneThreshold times the highest integral estimate of all functions are dropped.
+ * For dropped functions, the estimate obtained up to the iteration in which they were dropped is returned.
+ *
+ * The integration proceeds in two stages:
+ *  o grid optimization: numIterGridOpt iterations with numCallsGridOpt integrand evaluations each,
+ *    used for adapting the grid only
+ *  o integral evaluation: numIterIntEval iterations with numCallsIntEval integrand evaluations each;
+ *    the integrals and their uncertainties are computed by the weighted average of the iterations
+ *   (eqs. (5) and (6) in [1])
+ *
+ * The time and number of integrand evaluations spent per integration can be limited (cf. NSVfitTimeBudget class).
+ * The evaluation of each function at each point is counted as one integrand evaluation,
+ * i.e. a point at which K functions are evaluated counts as K integrand evaluations.
+ * Once the budget is exhausted, the integration stops and the integrals are computed from the points sampled so far.
+ *
+ * NOTE: integrand passed to VegasIntegrator class
+ *       must not be deleted until all integrations have finished.
+ *
+ */
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitTimeBudget.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+class VegasIntegrator
+{
+ public:
+//--- interface of functions to be integrated:
+//    the values of all K functions at point x are to be written into array f of size K
+  class Integrand
+  {
+   public:
+    virtual ~Integrand() {}
+    virtual void operator()(const double* x, double* f) const = 0;
+//--- compute values of functions flagged as active only
+//   (values of inactive functions are ignored; the default implementation computes all functions)
+    virtual void evaluate(const double* x, const std::vector<bool>& isActive, double* f) const { (*this)(x, f); }
+  };
+
+  VegasIntegrator(const edm::ParameterSet&);
+  ~VegasIntegrator() {}
+
+//--- set functions to be integrated
+//   (second argument = number K of functions)
+  void setIntegrand(const Integrand&, unsigned);
+
+//--- compute integrals of all K functions
+//    over the hypercube given by lower and upper boundaries xMin and xMax
+//   (errorFlag is set to zero in case at least one iteration of the integral evaluation stage has been completed)
+  void integrate(const std::vector<double>&, const std::vector<double>&, std::vector<double>&, std::vector<double>&, int&);
+
+//--- limit time (in seconds) and number of integrand evaluations spent per integration
+//   (zero = unlimited)
+  void setBudget(double maxTime, unsigned long maxIntegrandCalls) { budget_.setLimits(maxTime, maxIntegrandCalls); }
+
+//--- check if last integration was stopped before all iterations were completed,
+//    because the time or the number of integrand evaluations exceeded the budget
+  bool isBudgetExhausted() const { return budget_.isExhausted(); }
+
+//--- number of integrand evaluations spent in last integration
+//   (counted per function, cf. above)
+  unsigned long numIntegrandCalls() const { return budget_.numIntegrandCalls(); }
+
+//--- number of functions not dropped in last integration
+  unsigned numActiveIntegrals() const { return numActive_; }
+
+//--- access random number generator,
+//    in order to set key identifying event and candidate before calling integrate
+//   (cf. NSVfitRandomGenerator::reset)
+  NSVfitRandomGenerator& getRandomGenerator() { return rnd_; }
+
+  void print(std::ostream&) const;
+
+ protected:
+  void initializeGrid();
+  unsigned runIteration(unsigned, bool);
+  void pruneIntegrals();
+  void refineGrid();
+
+  std::string name_;
+
+  const Integrand* integrand_;
+  unsigned numIntegrals_;
+
+  // parameters defining integration region
+  unsigned numDimensions_;
+  std::vector<double> xMin_; // index = dimension
+  std::vector<double> xMax_; // index = dimension
+
+  // parameters defining number of iterations and integrand evaluations per iteration
+  unsigned numIterGridOpt_;
+  unsigned numCallsGridOpt_;
+  unsigned numIterIntEval_;
+  unsigned numCallsIntEval_;
+
+  // parameters of adaptive grid
+  //  numBins: number of bins per dimension
+  //  alpha:   parameter controlling the speed with which the grid gets adapted (eq. (17) in [1])
+  unsigned numBins_;
+  double alpha_;
+
+  // threshold (relative to highest integral) below which functions are no longer evaluated (0 = never)
+  double pruneThreshold_;
+
+  // bin boundaries in interval [0..1], mapped to [xMin..xMax]
+  std::vector<double> gridEdges_;       // index = dimension*(numBins + 1) + bin boundary
+  // contributions of each function to the variance of its integral estimate per bin
+  std::vector<double> gridWeights_;     // index = (function*numDimensions + dimension)*numBins + bin
+
+  // sums of function values (times jacobian) in current iteration
+  std::vector<double> sumF_;            // index = function
+  std::vector<double> sumF2_;           // index = function
+
+  // weighted averages of integrals over iterations of the integral evaluation stage
+  std::vector<double> sumWeightedIntegrals_;  // index = function
+  std::vector<double> sumWeightedIntegrals2_; // index = function
+  std::vector<double> sumWeights_;            // index = function
+  unsigned numIterIntEvalDone_;
+
+  // functions still evaluated and estimates of integrals of functions that have been dropped
+  std::vector<bool> isActive_;                // index = function
+  unsigned numActive_;
+  std::vector<double> prunedIntegrals_;       // index = function
+  std::vector<double> prunedIntegralErrs_;    // index = function
+  // estimates of integrals computed in current iteration
+  std::vector<double> iterIntegrals_;         // index = function
+  std::vector<double> iterIntegralErrs_;      // index = function
+
+  NSVfitRandomGenerator rnd_;
+  NSVfitTimeBudget budget_;
+
+  // temporary variables
+  std::vector<double> x_;               // index = dimension
+  std::vector<unsigned> idxBins_;       // index = dimension
+  std::vector<double> f_;               // index = function
+
+  int verbosity_;
+};
+
+#endif
@@ -11,6 +11,9 @@
 #include "DataFormats/VertexReco/interface/VertexFwd.h"
 #include "DataFormats/PatCandidates/interface/Tau.h"
 #include "DataFormats/JetReco/interface/GenJet.h"
+#include "DataFormats/Common/interface/Ptr.h"
+
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
 
 #include <TVector2.h>
 
@@ -57,4 +60,15 @@ std::pair<double, double> compMEtProjU(double, double, double, double, int&, boo
 std::vector<double> compTrackPtSums(const reco::VertexCollection&);
 size_t getNumVerticesPtGtThreshold(const std::vector<double>&, double);
 
+/// Combine hash with key identifying object referenced by edm::Ptr
+/// (used to initialize NSVfitRandomGenerator for each candidate, independently of processing order)
+template <typename T>
+UInt_t hashPtr(UInt_t hash, const edm::Ptr<T>& ptr)
+{
+  hash = NSVfitRandomGenerator::hashCombine(hash, ptr.id().processIndex());
+  hash = NSVfitRandomGenerator::hashCombine(hash, ptr.id().productIndex());
+  hash = NSVfitRandomGenerator::hashCombine(hash, ptr.key());
+  return hash;
+}
+
 #endif
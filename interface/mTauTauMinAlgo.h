@@ -20,6 +20,8 @@
  *
  */
 
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
+
 // function parameters
 //-------------------------------------------------------------------------------
 //   se, sx, sy, sz: 
@@ -30,6 +32,9 @@
 //     components of reconstructed missing transverse momentum (MEt) in px, py direction
 //   mtau:
 //     nominal tau lepton mass (1.777 GeV)
+//   rnd:
+//     random number generator used to find start-point of minimization
+//    (to be initialized with key identifying event and candidate by calling code)
 //
 // return value
 //-------------------------------------------------------------------------------
@@ -41,6 +46,7 @@
 double mTauTauMin(const double se, const double sx, const double sy, const double sz,
 		  const double te, const double tx, const double ty, const double tz,
 		  const double pmissx, const double pmissy,
-		  const double mtau);
+		  const double mtau,
+		  NSVfitRandomGenerator& rnd);
 
 #endif
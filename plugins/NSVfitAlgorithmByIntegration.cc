@@ -13,11 +13,14 @@
 #include <TPRegexp.h>
 
 #include <limits>
+#include <new>
 
 using namespace SVfit_namespace;
 
 enum { kMax, kMedian };
 
+enum { kVEGAS, kQMC };
+
 namespace 
 {
   double g(double* x, size_t dim, void* param)
@@ -31,6 +34,42 @@ namespace
     //++callCounter;
     return retVal;
   }
+
+//--- wrap NSVfitRandomGenerator into gsl_rng type, 
+//    so that the random numbers used by VEGAS are reproducible independently of the processing order;
+//    the NSVfitRandomGenerator object is stored as state of the gsl_rng object
+//   (the gsl_rng object is not created by gsl_rng_alloc, which would call gslRandomGenerator_set
+//    on the uninitialized state, but set up by hand after the NSVfitRandomGenerator has been constructed)
+  void gslRandomGenerator_set(void* state, unsigned long int seed)
+  {
+    ((NSVfitRandomGenerator*)state)->setStream(seed);
+  }
+  unsigned long int gslRandomGenerator_get(void* state)
+  {
+    return ((NSVfitRandomGenerator*)state)->Integer32();
+  }
+  double gslRandomGenerator_get_double(void* state)
+  {
+    return ((NSVfitRandomGenerator*)state)->Rndm();
+  }
+  const gsl_rng_type gslRandomGeneratorType = 
+    { "NSVfitRandomGenerator", 0xffffffffUL, 0, sizeof(NSVfitRandomGenerator), 
+      &gslRandomGenerator_set, &gslRandomGenerator_get, &gslRandomGenerator_get_double };
+
+//--- wrap integrand function used by VEGAS for use by QuasiMonteCarloIntegrator
+  class qmcIntegrandType : public QuasiMonteCarloIntegrator::Integrand
+  {
+   public:
+    qmcIntegrandType(const gsl_monte_function* integrand)
+      : integrand_(integrand)
+    {}
+    void operator()(const double* x, double* f) const
+    {
+      f[0] = g(const_cast<double*>(x), integrand_->dim, integrand_->params);
+    }
+   private:
+    const gsl_monte_function* integrand_;
+  };
 }
 
 NSVfitAlgorithmByIntegration::NSVfitAlgorithmByIntegration(const edm::ParameterSet& cfg)
@@ -41,6 +80,9 @@ NSVfitAlgorithmByIntegration::NSVfitAlgorithmByIntegration(const edm::ParameterS
     integrand_(0),
     workspace_(0),
     rnd_(0),
+    randomGenerator_(0),
+    qmcIntegrator_(0),
+    qmcIntegrand_(0),
     numMassParameters_(0),
     massParForReplacements_(0)
 {
@@ -76,12 +118,36 @@ NSVfitAlgorithmByIntegration::NSVfitAlgorithmByIntegration(const edm::ParameterS
     fitParameterReplacements_.push_back(replacement);
   }
 
-  edm::ParameterSet cfg_vegas = cfg.getParameter<edm::ParameterSet>("vegasOptions");
-  numCallsGridOpt_ = cfg_vegas.getParameter<unsigned>("numCallsGridOpt");
-  numCallsIntEval_ = cfg_vegas.getParameter<unsigned>("numCallsIntEval");
-  maxChi2_         = cfg_vegas.getParameter<double>("maxChi2");
-  maxIntEvalIter_  = cfg_vegas.getParameter<unsigned>("maxIntEvalIter");
-  precision_       = cfg_vegas.getParameter<double>("precision");
+  std::string integrator_string = ( cfg.exists("integrator") ) ?
+    cfg.getParameter<std::string>("integrator") : "vegas";
+  if ( integrator_string == "vegas" ) {
+    integratorType_ = kVEGAS;
+    edm::ParameterSet cfg_vegas = cfg.getParameter<edm::ParameterSet>("vegasOptions");
+    numCallsGridOpt_ = cfg_vegas.getParameter<unsigned>("numCallsGridOpt");
+    numCallsIntEval_ = cfg_vegas.getParameter<unsigned>("numCallsIntEval");
+    maxChi2_         = cfg_vegas.getParameter<double>("maxChi2");
+    maxIntEvalIter_  = cfg_vegas.getParameter<unsigned>("maxIntEvalIter");
+    precision_       = cfg_vegas.getParameter<double>("precision");
+    double maxTime = ( cfg_vegas.exists("maxTime") ) ?
+      cfg_vegas.getParameter<double>("maxTime") : 0.;
+    unsigned maxIntegrandCalls = ( cfg_vegas.exists("maxIntegrandCalls") ) ?
+      cfg_vegas.getParameter<unsigned>("maxIntegrandCalls") : 0;
+    budget_.setLimits(maxTime, maxIntegrandCalls);
+  } else if ( integrator_string == "qmc" ) {
+    integratorType_ = kQMC;
+    edm::ParameterSet cfg_qmc = cfg.getParameter<edm::ParameterSet>("qmcOptions");
+    precision_       = cfg_qmc.getParameter<double>("precision");
+    double maxTime = ( cfg_qmc.exists("maxTime") ) ?
+      cfg_qmc.getParameter<double>("maxTime") : 0.;
+    unsigned maxIntegrandCalls = ( cfg_qmc.exists("maxIntegrandCalls") ) ?
+      cfg_qmc.getParameter<unsigned>("maxIntegrandCalls") : 0;
+    budget_.setLimits(maxTime, maxIntegrandCalls);
+    cfg_qmc.addParameter<std::string>("name", pluginName_);
+    qmcIntegrator_ = new QuasiMonteCarloIntegrator(cfg_qmc);
+//--- limits on time and number of integrand evaluations apply per tau lepton pair, not per mass hypothesis
+    qmcIntegrator_->setBudget(0., 0);
+  } else throw cms::Exception("NSVfitAlgorithmByIntegration")
+    << " Invalid Configuration Parameter 'integrator' = " << integrator_string << ", expected 'vegas' or 'qmc' !!\n";
 
   std::string max_or_median_string = cfg.getParameter<std::string>("max_or_median");
   if      ( max_or_median_string == "max"    ) max_or_median_ = kMax;
@@ -105,7 +171,11 @@ NSVfitAlgorithmByIntegration::~NSVfitAlgorithmByIntegration()
   if ( integrand_ ) delete [] (double*)integrand_->params;
   delete integrand_;
   if ( workspace_ ) gsl_monte_vegas_free(workspace_);
-  if ( rnd_       ) gsl_rng_free(rnd_);
+  delete rnd_;
+  delete randomGenerator_;
+
+  delete qmcIntegrator_;
+  delete qmcIntegrand_;
 
   delete massParForReplacements_;
 }
@@ -146,18 +216,19 @@ void NSVfitAlgorithmByIntegration::beginJob()
   integrand_->f = &g;
   integrand_->dim = numDimensions_;
   integrand_->params = new double[numMassParameters_];
-  workspace_ = gsl_monte_vegas_alloc(numDimensions_);
-  gsl_rng_env_setup();
-  rnd_ = gsl_rng_alloc(gsl_rng_default);
-}
-
-void NSVfitAlgorithmByIntegration::beginEvent(const edm::Event& evt, const edm::EventSetup& es)
-{
-  NSVfitAlgorithmBase::beginEvent(evt, es);
 
-  currentRunNumber_ = evt.id().run();
-  currentLumiSectionNumber_ = evt.luminosityBlock();
-  currentEventNumber_ = evt.id().event();
+//--- allocate workspace and random number generator of VEGAS
+//    or integrand of quasi-Monte Carlo integration, depending on which integrator is used
+  if ( integratorType_ == kVEGAS ) {
+    workspace_ = gsl_monte_vegas_alloc(numDimensions_);
+    randomGenerator_ = new NSVfitRandomGenerator(pluginName_);
+    rnd_ = new gsl_rng;
+    rnd_->type = &gslRandomGeneratorType;
+    rnd_->state = randomGenerator_;
+  } else if ( integratorType_ == kQMC ) {
+    qmcIntegrand_ = new qmcIntegrandType(integrand_);
+    qmcIntegrator_->setIntegrand(*qmcIntegrand_, 1);
+  }
 }
 
 void NSVfitAlgorithmByIntegration::fitImp() const
@@ -200,6 +271,8 @@ void NSVfitAlgorithmByIntegration::fitImp() const
     	        << " xl = " << xl_[iDimension] << ", xu = " << xu_[iDimension] << std::endl;
     }
   }
+  std::vector<double> xl(xl_, xl_ + numDimensions_);
+  std::vector<double> xu(xu_, xu_ + numDimensions_);
 
   TH1* histResults = 0;
   std::ostringstream histResultsName;
@@ -223,6 +296,9 @@ void NSVfitAlgorithmByIntegration::fitImp() const
   double pMax = 0.;
   unsigned numMassParBelowThreshold = 0;
   bool skipHighMassTail = false;
+  bool isMassParSkipped_budget = false;
+
+  budget_.start();
 
   while ( massParForReplacements_->isValid() ) {
 
@@ -233,19 +309,32 @@ void NSVfitAlgorithmByIntegration::fitImp() const
       ((double*)integrand_->params)[iMassParameter] = massParameterValue;
       massParameterValues[iMassParameter] = massParameterValue;
     }
-    // CV: reset random number generator required by VEGAS (for what ?)
-    //     for each event, in order to make mass reconstruction not depend on "processing history"    
-    gsl_rng_set(rnd_, 12345); 
-
 //--- call VEGAS routine (part of GNU scientific library)
-//    to perform actual integration
+//    or randomized quasi-Monte Carlo integration to perform actual integration
     double p    = 0.; 
     double pErr = 0.;
-    if ( !skipHighMassTail ) {
+//--- stop integration in case time or number of integrand evaluations exceed the budget;
+//    mass hypotheses not integrated yet get assigned probability zero,
+//    so that the solution gets flagged as not valid (cf. setMassResults below)
+//    NOTE: the budget is checked before the integration of each mass hypothesis
+//         (and between the iterations of VEGAS) only, so that the time and number of integrand evaluations
+//          may exceed the limits by up to numCallsGridOpt + numCallsIntEval for VEGAS
+//          and by up to numPoints*numReplicas for quasi-Monte Carlo integration
+    if ( !skipHighMassTail && budget_.checkIsExhausted() ) {
+      skipHighMassTail = true;
+      isMassParSkipped_budget = true;
+    }
+    if ( !skipHighMassTail && integratorType_ == kVEGAS ) {
+      // CV: reset random number generator required by VEGAS (for what ?)
+      //     for each event, in order to make mass reconstruction not depend on "processing history"    
+      initializeRandomGenerator(*randomGenerator_);
+      gsl_rng_set(rnd_, 12345); 
+
       gsl_monte_vegas_init(workspace_);
       workspace_->stage = 0;
       gsl_monte_vegas_integrate(integrand_, xl_, xu_, numDimensions_, 
 				numCallsGridOpt_/workspace_->iterations, rnd_, workspace_, &p, &pErr);
+      budget_.addIntegrandCalls(numCallsGridOpt_);
       workspace_->stage = 1;
 
       // CV: repeat integration in case chi2 of estimated integral/uncertainty values
@@ -256,18 +345,37 @@ void NSVfitAlgorithmByIntegration::fitImp() const
       do {
 	gsl_monte_vegas_integrate(integrand_, xl_, xu_, numDimensions_, 
 				  numCallsIntEval_/workspace_->iterations, rnd_, workspace_, &p, &pErr);
+	budget_.addIntegrandCalls(numCallsIntEval_);
 	workspace_->stage = 3;
 	++iteration;
 	//chi2 = gsl_monte_vegas_chisq(workspace_);
 	chi2 = workspace_->chisq;
 	//std::cout << " chi2 = " << chi2 << std::endl;
-      } while ( chi2 > maxChi2_ && iteration < maxIntEvalIter_ );	
+      } while ( chi2 > maxChi2_ && iteration < maxIntEvalIter_ && !budget_.checkIsExhausted() );	
       
       if ( verbosity_ >= 2 ) {
 	std::cout << "--> M = " << format_vdouble(massParameterValues) << ": p = " << p << " +/- " << pErr 
 		  << " (chi2 = " << chi2 << ")" << std::endl;
       }
-      
+    } else if ( !skipHighMassTail && integratorType_ == kQMC ) {
+      // the same scrambled Sobol points are used for all mass hypotheses,
+      //     which reduces the fluctuations of the likelihood between neighbouring mass hypotheses
+      initializeRandomGenerator(qmcIntegrator_->getRandomGenerator());
+
+      std::vector<double> pVector;
+      std::vector<double> pErrVector;
+      int errorFlag = 0;
+      qmcIntegrator_->integrate(xl, xu, pVector, pErrVector, errorFlag);
+      budget_.addIntegrandCalls(qmcIntegrator_->numIntegrandCalls());
+      p    = pVector[0];
+      pErr = pErrVector[0];
+
+      if ( verbosity_ >= 2 ) {
+	std::cout << "--> M = " << format_vdouble(massParameterValues) << ": p = " << p << " +/- " << pErr << std::endl;
+      }
+    }
+
+    if ( !skipHighMassTail ) {
       // CV: in order to reduce computing time, skip precise computation of integral
       //     if in high mass tail and probability negligible anyway
       if ( p > pMax ) pMax = p;
@@ -288,6 +396,7 @@ void NSVfitAlgorithmByIntegration::fitImp() const
 
     massParForReplacements_->next();
   }
+  isBudgetExhausted_ = budget_.isExhausted();
 
   NSVfitEventHypothesisByIntegration* persistentEventHypothesis = new NSVfitEventHypothesisByIntegration(*currentEventHypothesis_);
   persistentEventHypothesis->histMassResults_.reset(histResults);
@@ -298,6 +407,9 @@ void NSVfitAlgorithmByIntegration::fitImp() const
     NSVfitResonanceHypothesisBase* resonance = 
       const_cast<NSVfitResonanceHypothesisBase*>(persistentEventHypothesis->NSVfitEventHypothesisBase::resonance(resonanceName));
     setMassResults(dynamic_cast<NSVfitResonanceHypothesisByIntegration*>(resonance), histResults, iMassParameter);
+//--- mass distribution is truncated in case mass hypotheses have been skipped because the budget got exhausted,
+//    which biases the reconstructed mass towards low values
+    if ( isMassParSkipped_budget ) resonance->isValidSolution_ = false;
   }
   
   persistentEventHypothesis->mass_            = 0.;
@@ -5,7 +5,7 @@
  *
  * Concrete implementation of (n)SVfit algorithm
  * by integration of likelihood functions
- * (based on VEGAS integration algorithm)
+ * (based on VEGAS integration algorithm or, optionally, on randomized quasi-Monte Carlo integration)
  *
  * \author Christian Veelken, UC Davis
  *
@@ -27,6 +27,8 @@
 #include "TauAnalysis/CandidateTools/interface/NSVfitAlgorithmBase.h"
 #include "TauAnalysis/CandidateTools/interface/IndepCombinatoricsGeneratorT.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitTimeBudget.h"
+#include "TauAnalysis/CandidateTools/interface/QuasiMonteCarloIntegrator.h"
 
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitEventHypothesisByIntegration.h"
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitResonanceHypothesisByIntegration.h"
@@ -50,7 +52,6 @@ class NSVfitAlgorithmByIntegration : public NSVfitAlgorithmBase
   ~NSVfitAlgorithmByIntegration();
 
   void beginJob();
-  void beginEvent(const edm::Event&, const edm::EventSetup&);
 
   void print(std::ostream&) const {}
 
@@ -86,10 +87,6 @@ class NSVfitAlgorithmByIntegration : public NSVfitAlgorithmBase
 
   std::vector<NSVfitParameterMappingType> fitParameterMappings_;
 
-  edm::RunNumber_t currentRunNumber_;
-  edm::LuminosityBlockNumber_t currentLumiSectionNumber_;
-  edm::EventNumber_t currentEventNumber_;
-
   struct replaceParByFitParameter : replaceParBase
   {
     void beginJob(NSVfitAlgorithmByIntegration* algorithm)
@@ -213,7 +210,8 @@ class NSVfitAlgorithmByIntegration : public NSVfitAlgorithmBase
 
   gsl_monte_function* integrand_;
   gsl_monte_vegas_state* workspace_;
-  mutable gsl_rng* rnd_;
+  mutable gsl_rng* rnd_; // wrapper of NSVfitRandomGenerator for use by VEGAS
+  NSVfitRandomGenerator* randomGenerator_;
   unsigned numCallsGridOpt_;
   unsigned numCallsIntEval_;
   double maxChi2_;
@@ -221,6 +219,16 @@ class NSVfitAlgorithmByIntegration : public NSVfitAlgorithmBase
   double precision_;
   unsigned numDimensions_;
 
+  // integration algorithm (VEGAS or randomized quasi-Monte Carlo)
+  int integratorType_;
+  QuasiMonteCarloIntegrator* qmcIntegrator_;
+  QuasiMonteCarloIntegrator::Integrand* qmcIntegrand_;
+
+  // limits on time and number of integrand evaluations per tau lepton pair;
+  // once exhausted, the remaining mass hypotheses are not integrated
+  // (checked between mass hypotheses only, so that the limits may be exceeded, cf. fitImp)
+  mutable NSVfitTimeBudget budget_;
+
   unsigned numMassParameters_;
   mutable IndepCombinatoricsGeneratorT<int>* massParForReplacements_;
 
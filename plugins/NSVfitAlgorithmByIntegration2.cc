@@ -5,6 +5,7 @@
 
 #include "TauAnalysis/CandidateTools/interface/generalAuxFunctions.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/CandidateTools/interface/candidateAuxFunctions.h"
 
 #include <TArrayF.h>
 #include <TH1D.h>
@@ -17,6 +18,7 @@
 using namespace SVfit_namespace;
 
 enum { kMax, kMedian };
+enum { kHistogram, kP2 };
 
 namespace 
 {
@@ -165,8 +167,13 @@ NSVfitAlgorithmByIntegration2::NSVfitAlgorithmByIntegration2(const edm::Paramete
     integrator_(0),
     auxPhysicalSolutionFinder_(0),
     fitParameterValues_(0),
+    monitorMarkovChain_(false),
+    monitorAllEvents_(false),
+    monitorMinAcceptanceRate_(0.),
+    monitorMaxMassDeviation_(0.),
     probHistEventMass_(0),        
-    auxFillProbHistograms_(0)
+    auxFillProbHistograms_(0),
+    quantileEstimatorGridPoints_(0)
 {
   if ( cfg.exists("parameters") ) {
     edm::ParameterSet cfgReplacements = cfg.getParameter<edm::ParameterSet>("parameters");
@@ -202,13 +209,40 @@ NSVfitAlgorithmByIntegration2::NSVfitAlgorithmByIntegration2(const edm::Paramete
 
   monitorMarkovChain_ = ( cfg.exists("monitorMarkovChain") ) ?
     cfg.getParameter<bool>("monitorMarkovChain") : false;
-  if ( monitorMarkovChain_ ) monitorFilePath_ = cfg.getParameter<std::string>("monitorFilePath");
+  if ( monitorMarkovChain_ ) {
+    monitorFilePath_ = cfg.getParameter<std::string>("monitorFilePath");
+//--- record moves of Markov Chain in ring-buffer;
+//    write content of ring-buffer to file only for events in which the integration failed,
+//    the acceptance rate is low or the reconstructed mass deviates from the value given by the collinear approximation
+    unsigned monitorBufferSize = ( cfg.exists("monitorBufferSize") ) ?
+      cfg.getParameter<unsigned>("monitorBufferSize") : 10000;
+    unsigned monitorPrescale = ( cfg.exists("monitorPrescale") ) ?
+      cfg.getParameter<unsigned>("monitorPrescale") : 10;
+    integrator_->enableTrace(monitorBufferSize, monitorPrescale);
+    monitorAllEvents_ = ( cfg.exists("monitorAllEvents") ) ?
+      cfg.getParameter<bool>("monitorAllEvents") : false;
+    monitorMinAcceptanceRate_ = ( cfg.exists("monitorMinAcceptanceRate") ) ?
+      cfg.getParameter<double>("monitorMinAcceptanceRate") : 0.05;
+    monitorMaxMassDeviation_ = ( cfg.exists("monitorMaxMassDeviation") ) ?
+      cfg.getParameter<double>("monitorMaxMassDeviation") : 0.5;
+  }
 
   std::string max_or_median_string = cfg.getParameter<std::string>("max_or_median");
   if      ( max_or_median_string == "max"    ) max_or_median_ = kMax;
   else if ( max_or_median_string == "median" ) max_or_median_ = kMedian;
   else throw cms::Exception("NSVfitAlgorithmByIntegration2")
     << " Invalid Configuration Parameter 'max_or_median' = " << max_or_median_string << " !!\n";
+
+//--- estimate mass, pt, eta, phi and fitParameter values either from histograms (default)
+//    or by P^2 streaming quantile estimator (cf. interface/P2QuantileEstimator.h)
+  std::string quantileEstimator_string = ( cfg.exists("quantileEstimator") ) ?
+    cfg.getParameter<std::string>("quantileEstimator") : "histogram";
+  if      ( quantileEstimator_string == "histogram" ) quantileEstimator_ = kHistogram;
+  else if ( quantileEstimator_string == "P2"        ) quantileEstimator_ = kP2;
+  else throw cms::Exception("NSVfitAlgorithmByIntegration2")
+    << " Invalid Configuration Parameter 'quantileEstimator' = " << quantileEstimator_string << " !!\n";
+  quantileEstimatorGridPoints_ = ( cfg.exists("quantileEstimatorGridPoints") ) ?
+    cfg.getParameter<unsigned>("quantileEstimatorGridPoints") : 32;
 }
 
 NSVfitAlgorithmByIntegration2::~NSVfitAlgorithmByIntegration2() 
@@ -224,7 +258,7 @@ NSVfitAlgorithmByIntegration2::~NSVfitAlgorithmByIntegration2()
 
   delete [] fitParameterValues_;
 
-  for ( std::vector<TH1*>::iterator it = probHistFitParameter_.begin();
+  for ( std::vector<ProbDistribution*>::iterator it = probHistFitParameter_.begin();
 	it != probHistFitParameter_.end(); ++it ) {
     delete (*it);
   }
@@ -309,9 +343,13 @@ void NSVfitAlgorithmByIntegration2::beginJob()
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
     const NSVfitParameter* fitParameter_ref = fitParameterMappings_[iDimension].base_;
     const std::string& fitParameterName = fitParameter_ref->UniqueName();
-    std::string histogramName = std::string(pluginName_).append("_").append(fitParameterName);
-    TH1* histogram = new TH1D(histogramName.data(), histogramName.data(), 1000, fitParameter_ref->LowerLimit(), fitParameter_ref->UpperLimit());
-    probHistFitParameter_[iDimension] = histogram;
+    if ( quantileEstimator_ == kP2 ) {
+      probHistFitParameter_[iDimension] = bookProbDistribution(0, fitParameterName);
+    } else {
+      std::string histogramName = std::string(pluginName_).append("_").append(fitParameterName);
+      TH1* histogram = new TH1D(histogramName.data(), histogramName.data(), 1000, fitParameter_ref->LowerLimit(), fitParameter_ref->UpperLimit());
+      probHistFitParameter_[iDimension] = new ProbDistribution(histogram, 0);
+    }
   }
   size_t idxResonance = 0;
   for ( std::vector<resonanceModelType*>::const_iterator resonance = eventModel_->resonances_.begin();
@@ -320,13 +358,13 @@ void NSVfitAlgorithmByIntegration2::beginJob()
     AuxProbHistogramsResonance* probHistResonance = new AuxProbHistogramsResonance();
     probHistResonance->idxResonance_ = idxResonance;    
     std::string histogramPtName = std::string("probHistResonancePt").append("_").append(resonanceName);
-    probHistResonance->probHistResonancePt_ = bookPtHistogram(histogramPtName.data());
+    probHistResonance->probHistResonancePt_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookPtHistogram, histogramPtName);
     std::string histogramEtaName = std::string("probHistResonanceEta").append("_").append(resonanceName);
-    probHistResonance->probHistResonanceEta_ = bookEtaHistogram(histogramEtaName.data());
+    probHistResonance->probHistResonanceEta_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookEtaHistogram, histogramEtaName);
     std::string histogramPhiName = std::string("probHistResonancePhi").append("_").append(resonanceName);
-    probHistResonance->probHistResonancePhi_ = bookPhiHistogram(histogramPhiName.data());
+    probHistResonance->probHistResonancePhi_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookPhiHistogram, histogramPhiName);
     std::string histogramMassName = std::string("probHistResonanceMass").append("_").append(resonanceName);
-    probHistResonance->probHistResonanceMass_ = bookMassHistogram(histogramMassName.data());
+    probHistResonance->probHistResonanceMass_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookMassHistogram, histogramMassName);
     size_t idxDaughter = 0;
     for ( std::vector<daughterModelType*>::const_iterator daughter = (*resonance)->daughters_.begin();
 	  daughter != (*resonance)->daughters_.end(); ++daughter ) {
@@ -334,18 +372,18 @@ void NSVfitAlgorithmByIntegration2::beginJob()
       AuxProbHistogramsDaughter* probHistDaughter = new AuxProbHistogramsDaughter();
       probHistDaughter->idxDaughter_ = idxDaughter;
       std::string histogramPtName = std::string("probHistDaughterPt").append("_").append(resonanceName).append("_").append(daughterName);
-      probHistDaughter->probHistDaughterPt_ = bookPtHistogram(histogramPtName.data());
+      probHistDaughter->probHistDaughterPt_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookPtHistogram, histogramPtName);
       std::string histogramEtaName = std::string("probHistDaughterEta").append("_").append(resonanceName).append("_").append(daughterName);
-      probHistDaughter->probHistDaughterEta_ = bookEtaHistogram(histogramEtaName.data());
+      probHistDaughter->probHistDaughterEta_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookEtaHistogram, histogramEtaName);
       std::string histogramPhiName = std::string("probHistDaughterPhi").append("_").append(resonanceName).append("_").append(daughterName);
-      probHistDaughter->probHistDaughterPhi_ = bookPhiHistogram(histogramPhiName.data());
+      probHistDaughter->probHistDaughterPhi_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookPhiHistogram, histogramPhiName);
       probHistResonance->probHistDaughters_.push_back(probHistDaughter);
       ++idxDaughter;
     }
     probHistResonances_.push_back(probHistResonance);
     ++idxResonance;
   }
-  probHistEventMass_ = bookMassHistogram("probHistEventMass");
+  probHistEventMass_ = bookProbDistribution(&NSVfitAlgorithmByIntegration2::bookMassHistogram, "probHistEventMass");
   auxFillProbHistograms_ = new AuxFillProbHistograms(this);
   integrator_->registerCallBackFunction(*auxFillProbHistograms_);
 
@@ -386,13 +424,19 @@ void NSVfitAlgorithmByIntegration2::beginJob()
   }
 }
 
-void NSVfitAlgorithmByIntegration2::beginEvent(const edm::Event& evt, const edm::EventSetup& es)
+NSVfitAlgorithmByIntegration2::ProbDistribution* NSVfitAlgorithmByIntegration2::bookProbDistribution(bookHistogramFunction bookHistogram, const std::string& name)
 {
-  NSVfitAlgorithmBase::beginEvent(evt, es);
-
-  currentRunNumber_ = evt.id().run();
-  currentLumiSectionNumber_ = evt.luminosityBlock();
-  currentEventNumber_ = evt.id().event();
+//--- no histogram is booked in case P^2 quantile estimator is used
+  if ( quantileEstimator_ == kP2 ) {
+    std::vector<double> probabilities;
+    probabilities.push_back(0.16);
+    probabilities.push_back(0.50);
+    probabilities.push_back(0.84);
+    return new ProbDistribution(0, new P2QuantileEstimator(probabilities, quantileEstimatorGridPoints_));
+  } else {
+    assert(bookHistogram);
+    return new ProbDistribution((this->*bookHistogram)(name), 0);
+  }
 }
 
 TH1* NSVfitAlgorithmByIntegration2::bookPtHistogram(const std::string& histogramName)
@@ -461,6 +505,36 @@ TH1* compHistogramDensity(const TH1* histogram)
   return histogram_density;
 }
 
+bool NSVfitAlgorithmByIntegration2::ProbDistribution::extractProperties(
+       double& maximum_interpol, double& mean, double& quantile016, double& quantile050, double& quantile084) const
+{
+  maximum_interpol = 0.;
+  mean = 0.;
+  quantile016 = 0.;
+  quantile050 = 0.;
+  quantile084 = 0.;
+  if ( quantileEstimator_ ) {
+    if ( !(quantileEstimator_->numEntries() > 0) ) return false;
+    maximum_interpol = quantileEstimator_->mode();
+    mean = quantileEstimator_->mean();
+    quantile016 = quantileEstimator_->quantile(0.16);
+    quantile050 = quantileEstimator_->quantile(0.50);
+    quantile084 = quantileEstimator_->quantile(0.84);
+    return true;
+  } else {
+    TH1* histogram_density = compHistogramDensity(histogram_);
+    bool isValid = ( histogram_density->Integral() > 0. );
+    if ( isValid ) {
+      double maximum;
+      extractHistogramProperties(
+        histogram_, histogram_density,
+        maximum, maximum_interpol, mean, quantile016, quantile050, quantile084);
+    }
+    delete histogram_density;
+    return isValid;
+  }
+}
+
 void NSVfitAlgorithmByIntegration2::fitImp() const
 {
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
@@ -486,37 +560,30 @@ void NSVfitAlgorithmByIntegration2::fitImp() const
 #endif
   integrator_->initializeStartPosition_and_Momentum(startPosition_);
 
-  for ( std::vector<TH1*>::iterator histogram = probHistFitParameter_.begin();
-	histogram != probHistFitParameter_.end(); ++histogram ) {
-    (*histogram)->Reset();
+  for ( std::vector<ProbDistribution*>::iterator probHistFitParameter = probHistFitParameter_.begin();
+	probHistFitParameter != probHistFitParameter_.end(); ++probHistFitParameter ) {
+    (*probHistFitParameter)->reset();
   }
   for ( std::vector<AuxProbHistogramsResonance*>::iterator probHistResonance = probHistResonances_.begin();
 	probHistResonance != probHistResonances_.end(); ++probHistResonance ) {
-    (*probHistResonance)->probHistResonancePt_->Reset();
-    (*probHistResonance)->probHistResonanceEta_->Reset();
-    (*probHistResonance)->probHistResonancePhi_->Reset();
-    (*probHistResonance)->probHistResonanceMass_->Reset();
+    (*probHistResonance)->probHistResonancePt_->reset();
+    (*probHistResonance)->probHistResonanceEta_->reset();
+    (*probHistResonance)->probHistResonancePhi_->reset();
+    (*probHistResonance)->probHistResonanceMass_->reset();
     for ( std::vector<AuxProbHistogramsDaughter*>::iterator probHistDaughter = (*probHistResonance)->probHistDaughters_.begin();
 	  probHistDaughter != (*probHistResonance)->probHistDaughters_.end(); ++probHistDaughter ) {
-      (*probHistDaughter)->probHistDaughterPt_->Reset();
-      (*probHistDaughter)->probHistDaughterEta_->Reset();
-      (*probHistDaughter)->probHistDaughterPhi_->Reset();
+      (*probHistDaughter)->probHistDaughterPt_->reset();
+      (*probHistDaughter)->probHistDaughterEta_->reset();
+      (*probHistDaughter)->probHistDaughterPhi_->reset();
     }
   }
-  probHistEventMass_->Reset();
-  probListEventMass_.clear();
+  probHistEventMass_->reset();
 
   double integral, integralErr;
   int errorFlag = 0;
-  TString monitorFileName;
-  if ( monitorMarkovChain_ ) {
-    monitorFileName = monitorFilePath_.data();
-    if ( monitorFileName.Length() > 0 && !monitorFileName.EndsWith("/") ) monitorFileName.Append("/");
-    monitorFileName.Append(Form("%s_run%i_ls%i_ev%i_mc.root", pluginName_.data(), currentRunNumber_, currentLumiSectionNumber_, currentEventNumber_));
-  } else {
-    monitorFileName = "";
-  }
-  integrator_->integrate(intBoundaryLower_, intBoundaryUpper_, integral, integralErr, errorFlag, monitorFileName.Data());
+  initializeRandomGenerator(integrator_->getRandomGenerator());
+  integrator_->integrate(intBoundaryLower_, intBoundaryUpper_, integral, integralErr, errorFlag);
+  isBudgetExhausted_ = integrator_->isBudgetExhausted();
 
 //--- set central values and uncertainties on reconstructed masses
   if ( errorFlag == 0 ) {
@@ -525,32 +592,20 @@ void NSVfitAlgorithmByIntegration2::fitImp() const
       NSVfitResonanceHypothesis* resonance = const_cast<NSVfitResonanceHypothesis*>(currentEventHypothesis_->resonance((*probHistResonance)->idxResonance_));
       assert(resonance);
 
-      const TH1* histogramMass = (*probHistResonance)->probHistResonanceMass_;
-      setMassResults(resonance, histogramMass);
-
-      const TH1* histogramPt_resonance = (*probHistResonance)->probHistResonancePt_;
-      TH1* histogramPt_resonance_density = compHistogramDensity(histogramPt_resonance);
-      const TH1* histogramEta_resonance = (*probHistResonance)->probHistResonanceEta_;
-      TH1* histogramEta_resonance_density = compHistogramDensity(histogramEta_resonance);
-      const TH1* histogramPhi_resonance = (*probHistResonance)->probHistResonancePhi_;
-      TH1* histogramPhi_resonance_density = compHistogramDensity(histogramPhi_resonance);
-      if ( histogramPt_resonance_density->Integral()  > 0. &&
-	   histogramEta_resonance_density->Integral() > 0. &&
-	   histogramPhi_resonance_density->Integral() > 0. ) {
-	double ptMaximum, ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084;
-        extractHistogramProperties(
-          histogramPt_resonance, histogramPt_resonance_density,
-          ptMaximum, ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084);
+      setMassResults(resonance, (*probHistResonance)->probHistResonanceMass_);
+
+      double ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084;
+      bool ptIsValid = (*probHistResonance)->probHistResonancePt_->extractProperties(
+        ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084);
+      double etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084;
+      bool etaIsValid = (*probHistResonance)->probHistResonanceEta_->extractProperties(
+        etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084);
+      double phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084;
+      bool phiIsValid = (*probHistResonance)->probHistResonancePhi_->extractProperties(
+        phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084);
+      if ( ptIsValid && etaIsValid && phiIsValid ) {
 	double pt = ptMaximum_interpol;
-	double etaMaximum, etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084;
-        extractHistogramProperties(
-          histogramEta_resonance, histogramEta_resonance_density,
-          etaMaximum, etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084);
 	double eta = etaMaximum_interpol;
-	double phiMaximum, phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084;
-        extractHistogramProperties(
-          histogramPhi_resonance, histogramPhi_resonance_density,
-          phiMaximum, phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084);
 	double phi = phiMaximum_interpol;
 	resonance->pt_ = pt;
 	resonance->ptErrUp_ = TMath::Abs(ptQuantile084 - pt);
@@ -571,29 +626,18 @@ void NSVfitAlgorithmByIntegration2::fitImp() const
 	NSVfitSingleParticleHypothesis* daughter = const_cast<NSVfitSingleParticleHypothesis*>(resonance->daughter((*probHistDaughter)->idxDaughter_));
 	assert(daughter);
 	
-	const TH1* histogramPt_daughter = (*probHistDaughter)->probHistDaughterPt_;
-	TH1* histogramPt_daughter_density = compHistogramDensity(histogramPt_daughter);
-	const TH1* histogramEta_daughter = (*probHistDaughter)->probHistDaughterEta_;
-	TH1* histogramEta_daughter_density = compHistogramDensity(histogramEta_daughter);
-	const TH1* histogramPhi_daughter = (*probHistDaughter)->probHistDaughterPhi_;
-	TH1* histogramPhi_daughter_density = compHistogramDensity(histogramPhi_daughter);
-	if ( histogramPt_daughter_density->Integral()  > 0. &&
-	     histogramEta_daughter_density->Integral() > 0. &&
-	     histogramPhi_daughter_density->Integral() > 0. ) {
-	  double ptMaximum, ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084;
-	  extractHistogramProperties(
-  	    histogramPt_daughter, histogramPt_daughter_density,
-	    ptMaximum, ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084);
+	double ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084;
+	bool ptIsValid = (*probHistDaughter)->probHistDaughterPt_->extractProperties(
+	  ptMaximum_interpol, ptMean, ptQuantile016, ptQuantile050, ptQuantile084);
+	double etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084;
+	bool etaIsValid = (*probHistDaughter)->probHistDaughterEta_->extractProperties(
+	  etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084);
+	double phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084;
+	bool phiIsValid = (*probHistDaughter)->probHistDaughterPhi_->extractProperties(
+	  phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084);
+	if ( ptIsValid && etaIsValid && phiIsValid ) {
 	  double pt = ptMaximum_interpol;
-	  double etaMaximum, etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084;
-  	  extractHistogramProperties(
-            histogramEta_daughter, histogramEta_daughter_density,
-	    etaMaximum, etaMaximum_interpol, etaMean, etaQuantile016, etaQuantile050, etaQuantile084);
 	  double eta = etaMaximum_interpol;
-	  double phiMaximum, phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084;
-	  extractHistogramProperties(
-            histogramPhi_daughter, histogramPhi_daughter_density,
-	    phiMaximum, phiMaximum_interpol, phiMean, phiQuantile016, phiQuantile050, phiQuantile084);
 	  double phi = phiMaximum_interpol;
 	  daughter->pt_ = pt;
 	  daughter->ptErrUp_ = TMath::Abs(ptQuantile084 - pt);
@@ -629,28 +673,31 @@ void NSVfitAlgorithmByIntegration2::fitImp() const
       }
     }
   }
+
+  if ( monitorMarkovChain_ && isMonitorTriggered(errorFlag) ) {
+    TString monitorFileName = monitorFilePath_.data();
+    if ( monitorFileName.Length() > 0 && !monitorFileName.EndsWith("/") ) monitorFileName.Append("/");
+    monitorFileName.Append(Form("%s_mc.bin", pluginName_.data()));
+    std::string label = Form("run%u_ls%u_ev%u_cand%u", currentRunNumber_, currentLumiSectionNumber_, currentEventNumber_, currentCandidateKey_);
+    integrator_->writeTrace(monitorFileName.Data(), label);
+  }
 #ifdef SVFIT_DEBUG   
   if ( verbosity_ >= 2 ) {
     currentEventHypothesis_->print(std::cout);
-    std::vector<double> quantiles;
-    quantiles.push_back(0.16);
-    quantiles.push_back(0.50);
-    quantiles.push_back(0.84);
-    std::sort(probListEventMass_.begin(), probListEventMass_.end());
-    for ( std::vector<double>::const_iterator quantile = quantiles.begin();
-	  quantile != quantiles.end(); ++quantile ) {
-      int idx = TMath::Nint((*quantile)*probListEventMass_.size());
-      std::cout << "probListEventMass[" << idx << "] (" << (*quantile)*100. << "% quantile) = " << probListEventMass_[idx] << std::endl;
+    double massMaximum_interpol, massMean, massQuantile016, massQuantile050, massQuantile084;
+    if ( probHistEventMass_->extractProperties(massMaximum_interpol, massMean, massQuantile016, massQuantile050, massQuantile084) ) {
+      std::cout << "eventMass: 16% quantile = " << massQuantile016 << ","
+		<< " 50% quantile = " << massQuantile050 << ","
+		<< " 84% quantile = " << massQuantile084 << std::endl;
     }
   }
 #endif
   fittedEventHypothesis_ = currentEventHypothesis_;  
   if ( errorFlag == 0 ) {
     for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-      double valueMaximum, valueMaximum_interpol, valueMean, valueQuantile016, valueQuantile050, valueQuantile084;
-      extractHistogramProperties(
-        probHistFitParameter_[iDimension], probHistFitParameter_[iDimension],
-	valueMaximum, valueMaximum_interpol, valueMean, valueQuantile016, valueQuantile050, valueQuantile084);
+      double valueMaximum_interpol, valueMean, valueQuantile016, valueQuantile050, valueQuantile084;
+      probHistFitParameter_[iDimension]->extractProperties(
+	valueMaximum_interpol, valueMean, valueQuantile016, valueQuantile050, valueQuantile084);
       if      ( max_or_median_ == kMax    ) fitParameterValues_[iDimension] = valueMaximum_interpol;
       else if ( max_or_median_ == kMedian ) fitParameterValues_[iDimension] = valueQuantile050;
       else assert(0);
@@ -684,24 +731,10 @@ void NSVfitAlgorithmByIntegration2::fitImp() const
   }
 }
 
-void NSVfitAlgorithmByIntegration2::setMassResults(NSVfitResonanceHypothesisBase* resonance, const TH1* histMassResult) const
+void NSVfitAlgorithmByIntegration2::setMassResults(NSVfitResonanceHypothesisBase* resonance, const ProbDistribution* probMassResult) const
 {
-  //if ( verbosity_ ) {
-  //  std::cout << "<NSVfitAlgorithmByIntegration2::setMassResults>:" << std::endl;
-  //  TAxis* xAxis = histMassResult->GetXaxis();
-  //  for ( int iBin = 1; iBin <= histMassResult->GetNbinsX(); ++iBin ) {
-  //    std::cout << "bin #" << iBin << " (x = " << xAxis->GetBinLowEdge(iBin) << ".." << xAxis->GetBinUpEdge(iBin) << ", width = " << histMassResult->GetBinWidth(iBin) << "):"
-  //		  << " " << histMassResult->GetBinContent(iBin) << " +/- " << histMassResult->GetBinError(iBin) << std::endl;
-  //  }
-  //}
-
-  TH1* histMassResult_density = compHistogramDensity(histMassResult);
-  if ( histMassResult_density->Integral() > 0. ) {
-    double massMaximum, massMaximum_interpol, massMean, massQuantile016, massQuantile050, massQuantile084;
-    extractHistogramProperties(
-      histMassResult, histMassResult_density,
-      massMaximum, massMaximum_interpol, massMean, massQuantile016, massQuantile050, massQuantile084);
-    
+  double massMaximum_interpol, massMean, massQuantile016, massQuantile050, massQuantile084;
+  if ( probMassResult->extractProperties(massMaximum_interpol, massMean, massQuantile016, massQuantile050, massQuantile084) ) {
     double mass;
     if      ( max_or_median_ == kMax    ) mass = massMaximum_interpol;
     else if ( max_or_median_ == kMedian ) mass = massQuantile050;
@@ -716,7 +749,7 @@ void NSVfitAlgorithmByIntegration2::setMassResults(NSVfitResonanceHypothesisBase
       std::cout << "<NSVfitAlgorithmByIntegration2::setMassResults>:" << std::endl;
       std::cout << " pluginName = " << pluginName_ << std::endl;
       std::cout << "--> mass = " << resonance->mass_ << " + " << resonance->massErrUp_ << " - " << resonance->massErrDown_ << std::endl;
-      std::cout << " (mean = " << massMean << ", median = " << massQuantile050 << ", max = " << massMaximum << ")" << std::endl;
+      std::cout << " (mean = " << massMean << ", median = " << massQuantile050 << ", max = " << massMaximum_interpol << ")" << std::endl;
     }
 #endif
   } else {
@@ -724,8 +757,6 @@ void NSVfitAlgorithmByIntegration2::setMassResults(NSVfitResonanceHypothesisBase
       << "Likelihood functions returned Probability zero for all tested mass hypotheses --> no valid solution found !!";
     resonance->isValidSolution_ = false;
   }
-  
-  delete histMassResult_density;
 }
 
 bool NSVfitAlgorithmByIntegration2::isDaughter(const std::string& daughterName)
@@ -920,7 +951,7 @@ void NSVfitAlgorithmByIntegration2::fillProbHistograms(const double* x)
 
 //--- fill histograms of fitParameter distributions
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-    probHistFitParameter_[iDimension]->Fill(x[iDimension]);
+    probHistFitParameter_[iDimension]->fill(x[iDimension]);
   }
 
 //--- fill mass distribution histograms
@@ -929,22 +960,48 @@ void NSVfitAlgorithmByIntegration2::fillProbHistograms(const double* x)
     const NSVfitResonanceHypothesis* resonance = currentEventHypothesis_->resonance((*probHistResonance)->idxResonance_);
     assert(resonance);
     reco::Candidate::LorentzVector resonanceP4_fitted = resonance->p4_fitted();
-    (*probHistResonance)->probHistResonancePt_->Fill(resonanceP4_fitted.pt());
-    (*probHistResonance)->probHistResonanceEta_->Fill(resonanceP4_fitted.eta());
-    (*probHistResonance)->probHistResonancePhi_->Fill(resonanceP4_fitted.phi());
-    (*probHistResonance)->probHistResonanceMass_->Fill(resonanceP4_fitted.mass());
+    (*probHistResonance)->probHistResonancePt_->fill(resonanceP4_fitted.pt());
+    (*probHistResonance)->probHistResonanceEta_->fill(resonanceP4_fitted.eta());
+    (*probHistResonance)->probHistResonancePhi_->fill(resonanceP4_fitted.phi());
+    (*probHistResonance)->probHistResonanceMass_->fill(resonanceP4_fitted.mass());
     for ( std::vector<AuxProbHistogramsDaughter*>::iterator probHistDaughter = (*probHistResonance)->probHistDaughters_.begin();
 	  probHistDaughter != (*probHistResonance)->probHistDaughters_.end(); ++probHistDaughter ) {
       const NSVfitSingleParticleHypothesis* daughter = resonance->daughter((*probHistDaughter)->idxDaughter_);
       assert(daughter);
       reco::Candidate::LorentzVector daughterP4_fitted = daughter->p4_fitted();
-      (*probHistDaughter)->probHistDaughterPt_->Fill(daughterP4_fitted.pt());
-      (*probHistDaughter)->probHistDaughterEta_->Fill(daughterP4_fitted.eta());
-      (*probHistDaughter)->probHistDaughterPhi_->Fill(daughterP4_fitted.phi());
+      (*probHistDaughter)->probHistDaughterPt_->fill(daughterP4_fitted.pt());
+      (*probHistDaughter)->probHistDaughterEta_->fill(daughterP4_fitted.eta());
+      (*probHistDaughter)->probHistDaughterPhi_->fill(daughterP4_fitted.phi());
     }
   }
-  probHistEventMass_->Fill(currentEventHypothesis_->p4_fitted().mass());  
-  probListEventMass_.push_back(currentEventHypothesis_->p4_fitted().mass());  
+  probHistEventMass_->fill(currentEventHypothesis_->p4_fitted().mass());  
+}
+
+bool NSVfitAlgorithmByIntegration2::isMonitorTriggered(int errorFlag) const
+{
+  if ( monitorAllEvents_ || errorFlag != 0 || integrator_->isBudgetExhausted() ) return true;
+
+  if ( integrator_->getAcceptanceRate() < monitorMinAcceptanceRate_ ) return true;
+
+//--- compare reconstructed mass to value given by collinear approximation,
+//    for resonances decaying into two visible daughters with physical solution of collinear approximation
+  if ( monitorMaxMassDeviation_ > 0. ) {
+    const reco::Candidate::LorentzVector& p4MEt = currentEventHypothesis_->p4MEt();
+    size_t numResonances = currentEventHypothesis_->numResonances();
+    for ( size_t iResonance = 0; iResonance < numResonances; ++iResonance ) {
+      const NSVfitResonanceHypothesis* resonance = currentEventHypothesis_->resonance(iResonance);
+      if ( !(resonance->numDaughters() == 2 && resonance->isValidSolution()) ) continue;
+      const reco::Candidate::LorentzVector& leg1P4 = resonance->daughter(0)->p4();
+      const reco::Candidate::LorentzVector& leg2P4 = resonance->daughter(1)->p4();
+      double x1, x2;
+      compX1X2byCollinearApprox(x1, x2, leg1P4.px(), leg1P4.py(), leg2P4.px(), leg2P4.py(), p4MEt.px(), p4MEt.py());
+      if ( !(x1 > 0. && x1 <= 1. && x2 > 0. && x2 <= 1.) ) continue;
+      double massCollinearApprox = (leg1P4 + leg2P4).mass()/TMath::Sqrt(x1*x2);
+      if ( TMath::Abs(resonance->mass() - massCollinearApprox) > monitorMaxMassDeviation_*massCollinearApprox ) return true;
+    }
+  }
+
+  return false;
 }
 
 #include "FWCore/Framework/interface/MakerMacros.h"
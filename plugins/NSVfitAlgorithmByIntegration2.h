@@ -26,6 +26,7 @@
 
 #include "TauAnalysis/CandidateTools/interface/NSVfitAlgorithmBase.h"
 #include "TauAnalysis/CandidateTools/interface/MarkovChainIntegrator.h"
+#include "TauAnalysis/CandidateTools/interface/P2QuantileEstimator.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 
 #include <Math/Functor.h>
@@ -41,7 +42,6 @@ class NSVfitAlgorithmByIntegration2 : public NSVfitAlgorithmBase
   ~NSVfitAlgorithmByIntegration2();
 
   void beginJob();
-  void beginEvent(const edm::Event&, const edm::EventSetup&);
 
   unsigned getNumDimensions() const { return numDimensions_; }
 
@@ -53,6 +53,40 @@ class NSVfitAlgorithmByIntegration2 : public NSVfitAlgorithmBase
   void fillProbHistograms(const double*);
 
  protected:
+//--- distribution of values sampled by the Markov Chain,
+//    represented either by a histogram or by a streaming quantile estimator
+//   (the latter needs a small and fixed amount of memory, independent of the range and resolution of the values)
+  struct ProbDistribution
+  {
+    ProbDistribution(TH1* histogram, P2QuantileEstimator* quantileEstimator)
+      : histogram_(histogram),
+        quantileEstimator_(quantileEstimator)
+    {}
+    ~ProbDistribution()
+    {
+      delete histogram_;
+      delete quantileEstimator_;
+    }
+    void fill(double x)
+    {
+      if ( histogram_         ) histogram_->Fill(x);
+      if ( quantileEstimator_ ) quantileEstimator_->fill(x);
+    }
+    void reset()
+    {
+      if ( histogram_         ) histogram_->Reset();
+      if ( quantileEstimator_ ) quantileEstimator_->reset();
+    }
+//--- compute (interpolated) position of maximum, mean and 16%, 50%, 84% quantiles;
+//    return false in case distribution is empty
+    bool extractProperties(double&, double&, double&, double&, double&) const;
+    TH1* histogram_;
+    P2QuantileEstimator* quantileEstimator_;
+  };
+
+  typedef TH1* (NSVfitAlgorithmByIntegration2::*bookHistogramFunction)(const std::string&);
+  ProbDistribution* bookProbDistribution(bookHistogramFunction, const std::string&);
+
   TH1* bookPtHistogram(const std::string& name);
   TH1* bookEtaHistogram(const std::string& name);
   TH1* bookPhiHistogram(const std::string& name);
@@ -60,7 +94,9 @@ class NSVfitAlgorithmByIntegration2 : public NSVfitAlgorithmBase
 
   void fitImp() const;
 
-  void setMassResults(NSVfitResonanceHypothesisBase*, const TH1*) const;
+  void setMassResults(NSVfitResonanceHypothesisBase*, const ProbDistribution*) const;
+
+  bool isMonitorTriggered(int) const;
     
   bool isDaughter(const std::string&);
   bool isResonance(const std::string&);
@@ -87,10 +123,6 @@ class NSVfitAlgorithmByIntegration2 : public NSVfitAlgorithmBase
 
   std::vector<NSVfitParameterMappingType> fitParameterMappings_;
 
-  edm::RunNumber_t currentRunNumber_;
-  edm::LuminosityBlockNumber_t currentLumiSectionNumber_;
-  edm::EventNumber_t currentEventNumber_;
-
   struct replaceParByFitParameter : replaceParBase
   {
     void beginJob(NSVfitAlgorithmByIntegration2* algorithm)
@@ -181,32 +213,36 @@ class NSVfitAlgorithmByIntegration2 : public NSVfitAlgorithmBase
 
   bool monitorMarkovChain_;  
   std::string monitorFilePath_;
+  bool monitorAllEvents_;
+  double monitorMinAcceptanceRate_;
+  double monitorMaxMassDeviation_;
   std::vector<ROOT::Math::Functor*> auxResonance_or_DaughterValues_;
 
   double* fitParameterValues_;
 
-  mutable std::vector<TH1*> probHistFitParameter_;
+  mutable std::vector<ProbDistribution*> probHistFitParameter_;
   struct AuxProbHistogramsDaughter
   {
     size_t idxDaughter_;
-    TH1* probHistDaughterPt_;
-    TH1* probHistDaughterEta_;
-    TH1* probHistDaughterPhi_;
+    ProbDistribution* probHistDaughterPt_;
+    ProbDistribution* probHistDaughterEta_;
+    ProbDistribution* probHistDaughterPhi_;
   };
   struct AuxProbHistogramsResonance
   {
     size_t idxResonance_;
-    TH1* probHistResonancePt_;
-    TH1* probHistResonanceEta_;
-    TH1* probHistResonancePhi_;
-    TH1* probHistResonanceMass_;
+    ProbDistribution* probHistResonancePt_;
+    ProbDistribution* probHistResonanceEta_;
+    ProbDistribution* probHistResonancePhi_;
+    ProbDistribution* probHistResonanceMass_;
     std::vector<AuxProbHistogramsDaughter*> probHistDaughters_;
   };
   mutable std::vector<AuxProbHistogramsResonance*> probHistResonances_;
-  mutable TH1* probHistEventMass_;
-  mutable std::vector<double> probListEventMass_;
+  mutable ProbDistribution* probHistEventMass_;
   ROOT::Math::Functor* auxFillProbHistograms_;
   int max_or_median_;
+  int quantileEstimator_;
+  unsigned quantileEstimatorGridPoints_;
 };
 
 #endif
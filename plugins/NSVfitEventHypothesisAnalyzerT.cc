@@ -42,6 +42,9 @@ NSVfitEventHypothesisAnalyzerT<T>::NSVfitEventHypothesisAnalyzerT(const edm::Par
   svFitSigmaMax_ = cfg.getParameter<double>("svFitSigmaMax");
 
   dqmDirectory_ = cfg.getParameter<std::string>("dqmDirectory");
+
+  fillLocalHistograms_ = ( cfg.exists("fillLocalHistograms") ) ?
+    cfg.getParameter<bool>("fillLocalHistograms") : false;
 }
 
 template <typename T>
@@ -98,7 +101,7 @@ void NSVfitEventHypothesisAnalyzerT<T>::beginJob()
   
   for ( typename std::vector<plotEntryType*>::iterator plotEntry = plotEntries_.begin();
 	plotEntry != plotEntries_.end(); ++plotEntry ) {
-    (*plotEntry)->bookHistograms(dqmStore);
+    (*plotEntry)->bookHistograms(dqmStore, fillLocalHistograms_);
   }
 }
 
@@ -129,6 +132,127 @@ namespace
   }
 }
 
+template <typename T>
+void NSVfitEventHypothesisAnalyzerT<T>::compFillInput(fillInputType& input,
+						      const reco::Candidate::LorentzVector& genDiTauP4, 
+						      const reco::Candidate::LorentzVector& genLeg1P4, const reco::Candidate::LorentzVector& genLeg2P4, 
+						      const reco::Candidate::LorentzVector& genMEtP4,
+						      const NSVfitResonanceHypothesisBase* svFitResonanceHypothesis,
+						      const reco::Candidate::LorentzVector& recLeg1P4, 
+						      const reco::Candidate::LorentzVector& recLeg2P4, int recLeg2DecayMode,
+						      const reco::Candidate::LorentzVector& recMEtP4,
+						      bool eventVertexIsValid, const AlgebraicVector3& eventVertexPos) const
+{
+  input.svFitIsValidSolution_ = svFitResonanceHypothesis->isValidSolution();
+
+  input.dPhi12_ = TMath::ACos(TMath::Cos(recLeg1P4.phi() - recLeg2P4.phi()))*TMath::RadToDeg();
+  input.qT_ = genDiTauP4.pt();
+
+  input.recLeg1Pt_ = recLeg1P4.pt();
+  input.recLeg2Pt_ = recLeg2P4.pt();
+  input.recMEtPt_ = recMEtP4.pt();
+  input.visMass_ = (recLeg1P4 + recLeg2P4).mass();
+  input.genMass_ = genDiTauP4.mass();
+  input.genVisMass_ = (genLeg1P4 + genLeg2P4).mass();
+
+  input.genDiTauPt_ = genDiTauP4.pt();
+  input.genDiTauEta_ = genDiTauP4.eta();
+  input.genDiTauPhi_ = genDiTauP4.phi();
+
+  input.svFitMass_ = svFitResonanceHypothesis->mass();
+  double svFitSigmaUp   = svFitResonanceHypothesis->massErrUp();
+  double svFitSigmaDown = svFitResonanceHypothesis->massErrDown();
+  input.svFitSigma_ = TMath::Sqrt(0.5*(svFitSigmaUp*svFitSigmaUp + svFitSigmaDown*svFitSigmaDown));
+
+  input.recDiTauP4isValid_ = false;
+  const NSVfitResonanceHypothesis* svFitResonanceHypothesis_nonbase = dynamic_cast<const NSVfitResonanceHypothesis*>(svFitResonanceHypothesis);
+  if ( svFitResonanceHypothesis_nonbase ) {
+    if ( svFitResonanceHypothesis_nonbase->pt_isValid() && svFitResonanceHypothesis_nonbase->eta_isValid() && svFitResonanceHypothesis_nonbase->phi_isValid() ) {
+      reco::Candidate::LorentzVector recDiTauP4 = svFitResonanceHypothesis_nonbase->p4_fitted(); 
+      input.recDiTauP4isValid_ = true;
+
+      input.recDiTauPt_ = recDiTauP4.pt();
+      input.recDiTauEta_ = recDiTauP4.eta();
+      input.recDiTauPhi_ = recDiTauP4.phi();
+      
+      input.deltaDiTauPt_ = recDiTauP4.pt() - genDiTauP4.pt();
+      input.deltaDiTauPx_ = recDiTauP4.px() - genDiTauP4.px();
+      input.deltaDiTauPy_ = recDiTauP4.py() - genDiTauP4.py();
+      input.deltaDiTauEta_ = recDiTauP4.eta() - genDiTauP4.eta();
+      input.deltaDiTauPhi_ = normalizedPhi(recDiTauP4.phi() - genDiTauP4.phi());
+      input.deltaDiTauMass_ = recDiTauP4.mass() - genDiTauP4.mass();
+      
+      if ( TMath::Abs(recDiTauP4.mass() - input.svFitMass_) > (1.e-2*genDiTauP4.mass()) ) {
+	std::cerr << "Problem with large rounding errors:" << std::endl;
+	std::cerr << " svFitMass = " << input.svFitMass_ << std::endl;
+	std::cerr << " recDiTauP4: E = " << recDiTauP4.E() << ", eta = " << recDiTauP4.eta() << ", phi = " << recDiTauP4.phi() << ", mass = " << recDiTauP4.mass() << std::endl;
+      }
+      
+      reco::Candidate::LorentzVector recMEtBySVfitP4 = recDiTauP4 - (recLeg1P4 + recLeg2P4);
+      input.deltaMEtBySVfitPt_ = recMEtBySVfitP4.pt() - genMEtP4.pt();
+      input.deltaMEtBySVfitPx_ = recMEtBySVfitP4.px() - genMEtP4.px();
+      input.deltaMEtBySVfitPy_ = recMEtBySVfitP4.py() - genMEtP4.py();
+      input.deltaMEtBySVfitPhi_ = normalizedPhi(recMEtBySVfitP4.phi() - genMEtP4.phi());
+    }
+  }
+
+  const NSVfitTauDecayHypothesis* daughter1 = dynamic_cast<const NSVfitTauDecayHypothesis*>(svFitResonanceHypothesis->daughter(0));
+  const NSVfitTauDecayHypothesis* daughter2 = dynamic_cast<const NSVfitTauDecayHypothesis*>(svFitResonanceHypothesis->daughter(1));
+
+  input.leg1DecayVertexType_ = 0;
+  input.leg2DecayVertexType_ = 0;
+  if ( eventVertexIsValid ) {
+    if ( daughter1 ) {
+      if ( daughter1->hasDecayVertexFit() ) input.leg1DecayVertexType_ = 3;
+      else if ( daughter1->leadTrackExtrapolationIsValid() ) input.leg1DecayVertexType_ = 1;
+      if ( input.leg1DecayVertexType_ ) input.deltaLeg1DecayVertexPhi_ = normalizedPhi(SVfit_namespace::phi(daughter1->reconstructedDecayVertexPos() - eventVertexPos) - genLeg1P4.phi());
+    }
+    if ( daughter2 ) {
+      if ( daughter2->hasDecayVertexFit() ) input.leg2DecayVertexType_ = 3;
+      else if ( daughter2->leadTrackExtrapolationIsValid() ) input.leg2DecayVertexType_ = 1;
+      if ( input.leg2DecayVertexType_ ) input.deltaLeg2DecayVertexPhi_ = normalizedPhi(SVfit_namespace::phi(daughter2->reconstructedDecayVertexPos() - eventVertexPos) - genLeg2P4.phi());
+    }
+  }
+
+  input.deltaLeg1PtIsValid_  = ( daughter1 && daughter1->pt_isValid()  );
+  if ( input.deltaLeg1PtIsValid_  ) input.deltaLeg1Pt_ = daughter1->pt() - genLeg1P4.pt();
+  input.deltaLeg1EtaIsValid_ = ( daughter1 && daughter1->eta_isValid() );
+  if ( input.deltaLeg1EtaIsValid_ ) input.deltaLeg1Eta_ = daughter1->eta() - genLeg1P4.eta();
+  input.deltaLeg1PhiIsValid_ = ( daughter1 && daughter1->phi_isValid() );
+  if ( input.deltaLeg1PhiIsValid_ ) input.deltaLeg1Phi_ = daughter1->phi() - genLeg1P4.phi();
+  input.deltaLeg2PtIsValid_  = ( daughter2 && daughter2->pt_isValid()  );
+  if ( input.deltaLeg2PtIsValid_  ) input.deltaLeg2Pt_ = daughter2->pt() - genLeg2P4.pt();
+  input.deltaLeg2EtaIsValid_ = ( daughter2 && daughter2->eta_isValid() );
+  if ( input.deltaLeg2EtaIsValid_ ) input.deltaLeg2Eta_ = daughter2->eta() - genLeg2P4.eta();
+  input.deltaLeg2PhiIsValid_ = ( daughter2 && daughter2->phi_isValid() );
+  if ( input.deltaLeg2PhiIsValid_ ) input.deltaLeg2Phi_ = daughter2->phi() - genLeg2P4.phi();
+
+  reco::Candidate::LorentzVector recLeg12MEtP4 = recLeg1P4 + recLeg2P4 + recMEtP4;
+  input.recLeg12MEtPt_ = recLeg12MEtP4.pt();
+  input.recLeg12MEtPhi_ = recLeg12MEtP4.phi();
+  input.deltaLeg12MEtPt_ = recLeg12MEtP4.pt() - genDiTauP4.pt();
+  input.deltaLeg12MEtPx_ = recLeg12MEtP4.px() - genDiTauP4.px();
+  input.deltaLeg12MEtPy_ = recLeg12MEtP4.py() - genDiTauP4.py();
+  input.deltaLeg12MEtPhi_ = normalizedPhi(recLeg12MEtP4.phi() - genDiTauP4.phi());
+
+  input.deltaMEtPt_ = recMEtP4.pt() - genMEtP4.pt();
+  input.deltaMEtPx_ = recMEtP4.px() - genMEtP4.px();
+  input.deltaMEtPy_ = recMEtP4.py() - genMEtP4.py();
+  input.deltaMEtPhi_ = normalizedPhi(recMEtP4.phi() - genMEtP4.phi());
+
+  const NSVfitResonanceHypothesisByIntegration* svFitResonanceHypothesisByIntegration = 
+    dynamic_cast<const NSVfitResonanceHypothesisByIntegration*>(svFitResonanceHypothesis);
+  input.isByIntegration_ = ( svFitResonanceHypothesisByIntegration != 0 );
+  if ( input.isByIntegration_ ) {
+    input.svFitMass_mean_        = svFitResonanceHypothesisByIntegration->mass_mean();
+    input.svFitMass_median_      = svFitResonanceHypothesisByIntegration->mass_median();
+    input.svFitMass_maximum_     = svFitResonanceHypothesisByIntegration->mass_maximum();
+    input.svFitMass_maxInterpol_ = svFitResonanceHypothesisByIntegration->mass_maxInterpol();
+  }
+
+  input.recLeg2DecayMode_ = recLeg2DecayMode;
+}
+
 template <typename T>
 void NSVfitEventHypothesisAnalyzerT<T>::analyze(const edm::Event& evt, const edm::EventSetup& es)
 {
@@ -188,9 +312,6 @@ void NSVfitEventHypothesisAnalyzerT<T>::analyze(const edm::Event& evt, const edm
     const NSVfitSingleParticleHypothesis* svFitDaughter1 = dynamic_cast<const NSVfitSingleParticleHypothesis*>(
       svFitResonanceHypothesis->daughter(0));
     const reco::Candidate::LorentzVector& svFitDaughter1P4 = svFitDaughter1->p4();
-    int daughter1DecayMode = reco::PFTau::kNull;
-    if ( dynamic_cast<const pat::Tau*>(svFitDaughter1->particle().get()) != 0 )
-      daughter1DecayMode = (dynamic_cast<const pat::Tau*>(svFitDaughter1->particle().get()))->decayMode();
     const NSVfitSingleParticleHypothesis* svFitDaughter2 = dynamic_cast<const NSVfitSingleParticleHypothesis*>(
       svFitResonanceHypothesis->daughter(1));
     const reco::Candidate::LorentzVector& svFitDaughter2P4 = svFitDaughter2->p4();
@@ -203,31 +324,29 @@ void NSVfitEventHypothesisAnalyzerT<T>::analyze(const edm::Event& evt, const edm
     //std::cout << "cov(MEt):" << std::endl;
     //(dynamic_cast<const reco::MET*>(svFitEventHypothesis->met().get()))->getSignificanceMatrix().Print();
 
+//--- matching of reconstructed to generator level tau decay products
+//    does not depend on the generator level tau pair, so do it only once
+    double dRcombination1 = square(deltaR(svFitDaughter1P4, genLeg1P4)) + square(deltaR(svFitDaughter2P4, genLeg2P4));
+    double dRcombination2 = square(deltaR(svFitDaughter1P4, genLeg2P4)) + square(deltaR(svFitDaughter2P4, genLeg1P4));
+    const reco::Candidate::LorentzVector& genLeg1P4_matched = ( dRcombination1 < dRcombination2 ) ? genLeg1P4 : genLeg2P4;
+    const reco::Candidate::LorentzVector& genLeg2P4_matched = ( dRcombination1 < dRcombination2 ) ? genLeg2P4 : genLeg1P4;
+
     for ( CandidateView::const_iterator genTauPair = genTauPairs->begin();
 	  genTauPair != genTauPairs->end(); ++genTauPair ) {
-
-      double dRcombination1 = square(deltaR(svFitDaughter1P4, genLeg1P4)) + square(deltaR(svFitDaughter2P4, genLeg2P4));
-      double dRcombination2 = square(deltaR(svFitDaughter1P4, genLeg2P4)) + square(deltaR(svFitDaughter2P4, genLeg1P4));
-      reco::Candidate::LorentzVector genLeg1P4_matched, genLeg2P4_matched;
-      if ( dRcombination1 < dRcombination2 ) {
-	genLeg1P4_matched = genLeg1P4;
-	genLeg2P4_matched = genLeg2P4;
-      } else {
-	genLeg1P4_matched = genLeg2P4;
-	genLeg2P4_matched = genLeg1P4;
-      }
+      fillInputType fillInput;
+      compFillInput(
+        fillInput,
+        genTauPair->p4(), 
+	genLeg1P4_matched, genLeg2P4_matched, 
+	genMEtP4,
+	svFitResonanceHypothesis,
+	svFitDaughter1P4, svFitDaughter2P4, daughter2DecayMode, 
+	recMEtP4,	  
+	svFitEventHypothesis->eventVertexIsValid(), svFitEventHypothesis->reconstructedEventVertexPos());
 
       for ( typename std::vector<plotEntryType*>::iterator plotEntry = plotEntries_.begin();
 	  plotEntry != plotEntries_.end(); ++plotEntry ) {
-	(*plotEntry)->fillHistograms(
-          genTauPair->p4(), 
-	  genLeg1P4_matched, genLeg2P4_matched, 
-	  genMEtP4,
-	  svFitResonanceHypothesis, svFitEventHypothesis->nll(), 
-	  svFitDaughter1P4, daughter1DecayMode, svFitDaughter2P4, daughter2DecayMode, 
-	  recMEtP4,	  
-	  svFitEventHypothesis->eventVertexIsValid(), svFitEventHypothesis->reconstructedEventVertexPos(),
-	  evtWeight);
+	(*plotEntry)->fillHistograms(fillInput, evtWeight);
       }
     }
   }
@@ -23,8 +23,12 @@
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 
 #include <TMath.h>
+#include <TH1.h>
+#include <TH2.h>
 
 #include <string>
+#include <vector>
+#include <utility>
 
 template <typename T>
 class NSVfitEventHypothesisAnalyzerT : public edm::EDAnalyzer 
@@ -66,6 +70,96 @@ class NSVfitEventHypothesisAnalyzerT : public edm::EDAnalyzer
 
   std::string dqmDirectory_;
 
+//--- fill histograms not owned by DQMStore during the event loop
+//    and add them to the DQMStore histograms in endJob
+  bool fillLocalHistograms_;
+
+//--- quantities filled into histograms,
+//    computed once per SVfit hypothesis and generator level tau pair
+//    and shared by all plotEntries
+  struct fillInputType
+  {
+    bool svFitIsValidSolution_;
+    double dPhi12_;
+    double qT_;
+
+    double recLeg1Pt_;
+    double recLeg2Pt_;
+    double recMEtPt_;
+    double visMass_;
+    double genMass_;
+    double genVisMass_;
+
+    double genDiTauPt_;
+    double genDiTauEta_;
+    double genDiTauPhi_;
+
+    bool recDiTauP4isValid_;
+    double recDiTauPt_;
+    double recDiTauEta_;
+    double recDiTauPhi_;
+    double deltaDiTauPt_;
+    double deltaDiTauPx_;
+    double deltaDiTauPy_;
+    double deltaDiTauEta_;
+    double deltaDiTauPhi_;
+    double deltaDiTauMass_;
+    double deltaMEtBySVfitPt_;
+    double deltaMEtBySVfitPx_;
+    double deltaMEtBySVfitPy_;
+    double deltaMEtBySVfitPhi_;
+
+    int leg1DecayVertexType_; // 0 = no decay vertex information, 1 = 1-prong, 3 = 3-prong
+    double deltaLeg1DecayVertexPhi_;
+    int leg2DecayVertexType_;
+    double deltaLeg2DecayVertexPhi_;
+
+    bool deltaLeg1PtIsValid_;
+    double deltaLeg1Pt_;
+    bool deltaLeg1EtaIsValid_;
+    double deltaLeg1Eta_;
+    bool deltaLeg1PhiIsValid_;
+    double deltaLeg1Phi_;
+    bool deltaLeg2PtIsValid_;
+    double deltaLeg2Pt_;
+    bool deltaLeg2EtaIsValid_;
+    double deltaLeg2Eta_;
+    bool deltaLeg2PhiIsValid_;
+    double deltaLeg2Phi_;
+
+    double recLeg12MEtPt_;
+    double recLeg12MEtPhi_;
+    double deltaLeg12MEtPt_;
+    double deltaLeg12MEtPx_;
+    double deltaLeg12MEtPy_;
+    double deltaLeg12MEtPhi_;
+
+    double deltaMEtPt_;
+    double deltaMEtPx_;
+    double deltaMEtPy_;
+    double deltaMEtPhi_;
+
+    double svFitMass_;
+    double svFitSigma_;
+    bool isByIntegration_;
+    double svFitMass_mean_;
+    double svFitMass_median_;
+    double svFitMass_maximum_;
+    double svFitMass_maxInterpol_;
+
+    int recLeg2DecayMode_;
+  };
+
+  void compFillInput(fillInputType&,
+		     const reco::Candidate::LorentzVector& genDiTauP4, 
+		     const reco::Candidate::LorentzVector& genLeg1P4, const reco::Candidate::LorentzVector& genLeg2P4, 
+		     const reco::Candidate::LorentzVector& genMEtP4,
+		     const NSVfitResonanceHypothesisBase* svFitResonanceHypothesis,
+		     const reco::Candidate::LorentzVector& recLeg1P4, 
+		     const reco::Candidate::LorentzVector& recLeg2P4, int recLeg2DecayMode,
+		     const reco::Candidate::LorentzVector& recMEtP4,
+		     bool eventVertexIsValid, const AlgebraicVector3& eventVertexPos) const;
+
   struct plotEntryType
   {
     plotEntryType(const std::string& dqmDirectory, 
@@ -80,7 +174,8 @@ class NSVfitEventHypothesisAnalyzerT : public edm::EDAnalyzer
 	numBinsSVfitMass_(numBinsSVfitMass), 
 	svFitMassMax_(svFitMassMax),
 	numBinsSVfitSigma_(numBinsSVfitSigma), 
-	svFitSigmaMax_(svFitSigmaMax)
+	svFitSigmaMax_(svFitSigmaMax),
+	fillLocalHistograms_(false)
     {
       TString dqmDirectory_full = dqmDirectory.data();
       if ( !dqmDirectory_full.EndsWith("/") ) dqmDirectory_full.Append("/");
@@ -103,245 +198,216 @@ class NSVfitEventHypothesisAnalyzerT : public edm::EDAnalyzer
       dqmDirectory_full.ReplaceAll(".", "_");
       dqmDirectory_ = dqmDirectory_full.Data();
     }
-    ~plotEntryType() {}
-    void bookHistograms(DQMStore& dqmStore)
+    ~plotEntryType() 
+    {
+      for ( std::vector<std::pair<MonitorElement*, TH1*> >::iterator localHistogram = localHistograms_.begin();
+	    localHistogram != localHistograms_.end(); ++localHistogram ) {
+	delete localHistogram->second;
+      }
+    }
+    TH1* book1D(DQMStore& dqmStore, const std::string& name, int numBinsX, double xMin, double xMax)
+    {
+      return getHistogram(dqmStore.book1D(name, name, numBinsX, xMin, xMax));
+    }
+    TH2* book2D(DQMStore& dqmStore, const std::string& name, int numBinsX, double xMin, double xMax, int numBinsY, double yMin, double yMax)
+    {
+      return dynamic_cast<TH2*>(getHistogram(dqmStore.book2D(name, name, numBinsX, xMin, xMax, numBinsY, yMin, yMax)));
+    }
+    TH1* getHistogram(MonitorElement* me)
+    {
+      if ( !fillLocalHistograms_ ) return me->getTH1();
+      TH1* histogram = dynamic_cast<TH1*>(me->getTH1()->Clone());
+      histogram->SetDirectory(0);
+      histogram->Reset();
+      localHistograms_.push_back(std::pair<MonitorElement*, TH1*>(me, histogram));
+      return histogram;
+    }
+    void bookHistograms(DQMStore& dqmStore, bool fillLocalHistograms)
     {
+      fillLocalHistograms_ = fillLocalHistograms;
+
       dqmStore.setCurrentFolder(dqmDirectory_.data());
       
-      leg1Pt_                         = dqmStore.book1D("leg1Pt",                         "leg1Pt",                         numBinsSVfitMass_/2,            0., 0.5*svFitMassMax_);
-      leg2Pt_                         = dqmStore.book1D("leg2Pt",                         "leg2Pt",                         numBinsSVfitMass_/2,            0., 0.5*svFitMassMax_);
-      dPhi12_                         = dqmStore.book1D("dPhi12",                         "dPhi12",                                         180,            0.,              180.);
-      metPt_                          = dqmStore.book1D("metPt",                          "metPt",                          numBinsSVfitMass_/2,            0., 0.5*svFitMassMax_);
-      visMass_                        = dqmStore.book1D("visMass",                        "visMass",                          numBinsSVfitMass_,            0.,     svFitMassMax_);
-      genMass_                        = dqmStore.book1D("genMass",                        "genMass",                          numBinsSVfitMass_,            0.,     svFitMassMax_);
-      genVisMass_                     = dqmStore.book1D("genVisMass",                     "genVisMass",                       numBinsSVfitMass_,            0.,     svFitMassMax_);
+      leg1Pt_                         = book1D(dqmStore, "leg1Pt",                         numBinsSVfitMass_/2,            0., 0.5*svFitMassMax_);
+      leg2Pt_                         = book1D(dqmStore, "leg2Pt",                         numBinsSVfitMass_/2,            0., 0.5*svFitMassMax_);
+      dPhi12_                         = book1D(dqmStore, "dPhi12",                                         180,            0.,              180.);
+      metPt_                          = book1D(dqmStore, "metPt",                          numBinsSVfitMass_/2,            0., 0.5*svFitMassMax_);
+      visMass_                        = book1D(dqmStore, "visMass",                          numBinsSVfitMass_,            0.,     svFitMassMax_);
+      genMass_                        = book1D(dqmStore, "genMass",                          numBinsSVfitMass_,            0.,     svFitMassMax_);
+      genVisMass_                     = book1D(dqmStore, "genVisMass",                       numBinsSVfitMass_,            0.,     svFitMassMax_);
       
-      genDiTauPt_                     = dqmStore.book1D("genDiTauPt",                     "genDiTauPt",                                     250,            0.,             +250.);
-      genDiTauEta_                    = dqmStore.book1D("genDiTauEta",                    "genDiTauEta",                                    198,          -9.9,              +9.9);
-      genDiTauPhi_                    = dqmStore.book1D("genDiTauPhi",                    "genDiTauPhi",                                    360,  -TMath::Pi(),      +TMath::Pi());
+      genDiTauPt_                     = book1D(dqmStore, "genDiTauPt",                                     250,            0.,             +250.);
+      genDiTauEta_                    = book1D(dqmStore, "genDiTauEta",                                    198,          -9.9,              +9.9);
+      genDiTauPhi_                    = book1D(dqmStore, "genDiTauPhi",                                    360,  -TMath::Pi(),      +TMath::Pi());
   
-      recDiTauPt_                     = dqmStore.book1D("recDiTauPt",                     "recDiTauPt",                                     250,            0.,             +250.);
-      recDiTauEta_                    = dqmStore.book1D("recDiTauEta",                    "recDiTauEta",                                    198,          -9.9,              +9.9);
-      recDiTauPhi_                    = dqmStore.book1D("recDiTauPhi",                    "recDiTauPhi",                                    360,  -TMath::Pi(),      +TMath::Pi());
+      recDiTauPt_                     = book1D(dqmStore, "recDiTauPt",                                     250,            0.,             +250.);
+      recDiTauEta_                    = book1D(dqmStore, "recDiTauEta",                                    198,          -9.9,              +9.9);
+      recDiTauPhi_                    = book1D(dqmStore, "recDiTauPhi",                                    360,  -TMath::Pi(),      +TMath::Pi());
         
-      deltaDiTauPt_                   = dqmStore.book1D("deltaDiTauPt",                   "deltaDiTauPt",                                   350,         -100.,             +250.);
-      deltaDiTauPx_                   = dqmStore.book1D("deltaDiTauPx",                   "deltaDiTauPx",                                   350,         -175.,             +175.);
-      deltaDiTauPy_                   = dqmStore.book1D("deltaDiTauPy",                   "deltaDiTauPy",                                   350,         -175.,             +175.);  
-      deltaDiTauEta_                  = dqmStore.book1D("deltaDiTauEta",                  "deltaDiTauEta",                                  198,          -9.9,              +9.9);
-      deltaDiTauPhi_                  = dqmStore.book1D("deltaDiTauPhi",                  "deltaDiTauPhi",                                  360,  -TMath::Pi(),      +TMath::Pi());
-      deltaDiTauMass_                 = dqmStore.book1D("deltaDiTauMass",                 "deltaDiTauMass",                 2*numBinsSVfitMass_, -svFitMassMax_,   +svFitMassMax_);
+      deltaDiTauPt_                   = book1D(dqmStore, "deltaDiTauPt",                                   350,         -100.,             +250.);
+      deltaDiTauPx_                   = book1D(dqmStore, "deltaDiTauPx",                                   350,         -175.,             +175.);
+      deltaDiTauPy_                   = book1D(dqmStore, "deltaDiTauPy",                                   350,         -175.,             +175.);  
+      deltaDiTauEta_                  = book1D(dqmStore, "deltaDiTauEta",                                  198,          -9.9,              +9.9);
+      deltaDiTauPhi_                  = book1D(dqmStore, "deltaDiTauPhi",                                  360,  -TMath::Pi(),      +TMath::Pi());
+      deltaDiTauMass_                 = book1D(dqmStore, "deltaDiTauMass",                 2*numBinsSVfitMass_, -svFitMassMax_,   +svFitMassMax_);
              
-      recLeg12MEtPt_                  = dqmStore.book1D("recLeg12MEtPt",                  "recLeg12MEtPt",                                  250,            0.,             +250.);  
-      recLeg12MEtPhi_                 = dqmStore.book1D("recLeg12MEtPhi",                 "recLeg12MEtPhi",                                 360,  -TMath::Pi(),      +TMath::Pi());
+      recLeg12MEtPt_                  = book1D(dqmStore, "recLeg12MEtPt",                                  250,            0.,             +250.);  
+      recLeg12MEtPhi_                 = book1D(dqmStore, "recLeg12MEtPhi",                                 360,  -TMath::Pi(),      +TMath::Pi());
 
-      deltaLeg12MEtPt_                = dqmStore.book1D("deltaLeg12MEtPt",                "deltaLeg12MEtPt",                                350,         -100.,             +250.);
-      deltaLeg12MEtPx_                = dqmStore.book1D("deltaLeg12MEtPx",                "deltaLeg12MEtPx",                                350,         -175.,             +175.);
-      deltaLeg12MEtPy_                = dqmStore.book1D("deltaLeg12MEtPy",                "deltaLeg12MEtPy",                                350,         -175.,             +175.);
-      deltaLeg12MEtPhi_               = dqmStore.book1D("deltaLeg12MEtPhi",               "deltaLeg12MEtPhi",                               360,  -TMath::Pi(),      +TMath::Pi());
+      deltaLeg12MEtPt_                = book1D(dqmStore, "deltaLeg12MEtPt",                                350,         -100.,             +250.);
+      deltaLeg12MEtPx_                = book1D(dqmStore, "deltaLeg12MEtPx",                                350,         -175.,             +175.);
+      deltaLeg12MEtPy_                = book1D(dqmStore, "deltaLeg12MEtPy",                                350,         -175.,             +175.);
+      deltaLeg12MEtPhi_               = book1D(dqmStore, "deltaLeg12MEtPhi",                               360,  -TMath::Pi(),      +TMath::Pi());
       
-      deltaMEtPt_                     = dqmStore.book1D("deltaMEtPt",                     "deltaMEtPt",                                     350,         -100.,             +250.);
-      deltaMEtPx_                     = dqmStore.book1D("deltaMEtPx",                     "deltaMEtPx",                                     350,         -175.,             +175.);
-      deltaMEtPy_                     = dqmStore.book1D("deltaMEtPy",                     "deltaMEtPy",                                     350,         -175.,             +175.);
-      deltaMEtPhi_                    = dqmStore.book1D("deltaMEtPhi",                    "deltaMEtPhi",                                    360,  -TMath::Pi(),      +TMath::Pi());
-
-      deltaMEtBySVfitPt_              = dqmStore.book1D("deltaMEtBySVfitPt",              "deltaMEtBySVfitPt",                              350,         -100.,             +250.);
-      deltaMEtBySVfitPx_              = dqmStore.book1D("deltaMEtBySVfitPx",              "deltaMEtBySVfitPx",                              350,         -175.,             +175.);
-      deltaMEtBySVfitPy_              = dqmStore.book1D("deltaMEtBySVfitPy",              "deltaMEtBySVfitPy",                              350,         -175.,             +175.);
-      deltaMEtBySVfitPhi_             = dqmStore.book1D("deltaMEtBySVfitPhi",             "deltaMEtBySVfitPhi",                             360,  -TMath::Pi(),      +TMath::Pi());
+      deltaMEtPt_                     = book1D(dqmStore, "deltaMEtPt",                                     350,         -100.,             +250.);
+      deltaMEtPx_                     = book1D(dqmStore, "deltaMEtPx",                                     350,         -175.,             +175.);
+      deltaMEtPy_                     = book1D(dqmStore, "deltaMEtPy",                                     350,         -175.,             +175.);
+      deltaMEtPhi_                    = book1D(dqmStore, "deltaMEtPhi",                                    360,  -TMath::Pi(),      +TMath::Pi());
+
+      deltaMEtBySVfitPt_              = book1D(dqmStore, "deltaMEtBySVfitPt",                              350,         -100.,             +250.);
+      deltaMEtBySVfitPx_              = book1D(dqmStore, "deltaMEtBySVfitPx",                              350,         -175.,             +175.);
+      deltaMEtBySVfitPy_              = book1D(dqmStore, "deltaMEtBySVfitPy",                              350,         -175.,             +175.);
+      deltaMEtBySVfitPhi_             = book1D(dqmStore, "deltaMEtBySVfitPhi",                             360,  -TMath::Pi(),      +TMath::Pi());
            
-      deltaLeg1DecayVertexPhi_1prong_ = dqmStore.book1D("deltaLeg1DecayVertexPhi_1prong", "deltaLeg1DecayVertexPhi_1prong",                 360,  -TMath::Pi(),      +TMath::Pi());      
-      deltaLeg1DecayVertexPhi_3prong_ = dqmStore.book1D("deltaLeg1DecayVertexPhi_3prong", "deltaLeg1DecayVertexPhi_3prong",                 360,  -TMath::Pi(),      +TMath::Pi());
-      deltaLeg2DecayVertexPhi_1prong_ = dqmStore.book1D("deltaLeg2DecayVertexPhi_1prong", "deltaLeg2DecayVertexPhi_1prong",                 360,  -TMath::Pi(),      +TMath::Pi());      
-      deltaLeg2DecayVertexPhi_3prong_ = dqmStore.book1D("deltaLeg2DecayVertexPhi_3prong", "deltaLeg2DecayVertexPhi_3prong",                 360,  -TMath::Pi(),      +TMath::Pi());
-
-      deltaLeg1Pt_                    = dqmStore.book1D("deltaLeg1Pt",                    "deltaLeg1Pt",                                    350,         -100.,             +250.);
-      deltaLeg1Eta_                   = dqmStore.book1D("deltaLeg1Eta",                   "deltaLeg1Eta",                                   198,          -9.9,              +9.9);
-      deltaLeg1Phi_                   = dqmStore.book1D("deltaLeg1Phi",                   "deltaLeg1Phi",                                   360,  -TMath::Pi(),      +TMath::Pi());
-      deltaLeg2Pt_                    = dqmStore.book1D("deltaLeg2Pt",                    "deltaLeg2Pt",                                    350,         -100.,             +250.);
-      deltaLeg2Eta_                   = dqmStore.book1D("deltaLeg2Eta",                   "deltaLeg2Eta",                                   198,          -9.9,              +9.9);
-      deltaLeg2Phi_                   = dqmStore.book1D("deltaLeg2Phi",                   "deltaLeg2Phi",                                   360,  -TMath::Pi(),      +TMath::Pi());
-
-      svFitMass_                      = dqmStore.book1D("svFitMass",                      "svFitMass",                        numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitSigma_                     = dqmStore.book1D("svFitSigma",                     "svFitSigma",                      numBinsSVfitSigma_,            0.,    svFitSigmaMax_);
-      svFitIsValidSolution_           = dqmStore.book1D("svFitIsValidSolution",           "svFitIsValidSolution",                             2,          -0.5,               1.5);
-
-      svFitMass_mean_                 = dqmStore.book1D("svFitMass_mean",                 "svFitMass_mean",                   numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitMass_median_               = dqmStore.book1D("svFitMass_median",               "svFitMass_median",                 numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitMass_maximum_              = dqmStore.book1D("svFitMass_maximum",              "svFitMass_maximum",                numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitMass_maxInterpol_          = dqmStore.book1D("svFitMass_maxInterpol",          "svFitMass_maxInterpol",            numBinsSVfitMass_,            0.,     svFitMassMax_);
-
-      svFitMassVsSigma_               = dqmStore.book2D("svFitMassVsSigma",               "svFitMassVsSigma",                               100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
-      svFitMassVsSigma_mean_          = dqmStore.book2D("svFitMassVsSigma_mean",          "svFitMassVsSigma_mean",                          100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
-      svFitMassVsSigma_median_        = dqmStore.book2D("svFitMassVsSigma_median",        "svFitMassVsSigma_median",                        100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
-      svFitMassVsSigma_maximum_       = dqmStore.book2D("svFitMassVsSigma_maximum",       "svFitMassVsSigma_maximum",                       100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
-      svFitMassVsSigma_maxInterpol_   = dqmStore.book2D("svFitMassVsSigma_maxInterpol",   "svFitMassVsSigma_maxInterpol",                   100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
-
-      svFitMassVsMEt_                 = dqmStore.book2D("svFitMassVsMEt",                 "svFitMassVsMEt",                                 100, 0., 0.5*svFitMassMax_, 100, 0., svFitMassMax_);
-      svFitSigmaVsMEt_                = dqmStore.book2D("svFitSigmaVsMEt",                "svFitSigmaVsMEt",                                100, 0., 0.5*svFitMassMax_, 100, 0., svFitSigmaMax_);
-
-      svFitMass_oneProng0pi0_         = dqmStore.book1D("svFitMass_oneProng0pi0",         "svFitMass_oneProng0pi0",           numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitMass_oneProng1pi0_         = dqmStore.book1D("svFitMass_oneProng1pi0",         "svFitMass_oneProng1pi0",           numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitMass_oneProng2pi0_         = dqmStore.book1D("svFitMass_oneProng2pi0",         "svFitMass_oneProng2pi0",           numBinsSVfitMass_,            0.,     svFitMassMax_);
-      svFitMass_threeProng0pi0_       = dqmStore.book1D("svFitMass_threeProng0pi0",       "svFitMass_threeProng0pi0",         numBinsSVfitMass_,            0.,     svFitMassMax_);
+      deltaLeg1DecayVertexPhi_1prong_ = book1D(dqmStore, "deltaLeg1DecayVertexPhi_1prong",                 360,  -TMath::Pi(),      +TMath::Pi());      
+      deltaLeg1DecayVertexPhi_3prong_ = book1D(dqmStore, "deltaLeg1DecayVertexPhi_3prong",                 360,  -TMath::Pi(),      +TMath::Pi());
+      deltaLeg2DecayVertexPhi_1prong_ = book1D(dqmStore, "deltaLeg2DecayVertexPhi_1prong",                 360,  -TMath::Pi(),      +TMath::Pi());      
+      deltaLeg2DecayVertexPhi_3prong_ = book1D(dqmStore, "deltaLeg2DecayVertexPhi_3prong",                 360,  -TMath::Pi(),      +TMath::Pi());
+
+      deltaLeg1Pt_                    = book1D(dqmStore, "deltaLeg1Pt",                                    350,         -100.,             +250.);
+      deltaLeg1Eta_                   = book1D(dqmStore, "deltaLeg1Eta",                                   198,          -9.9,              +9.9);
+      deltaLeg1Phi_                   = book1D(dqmStore, "deltaLeg1Phi",                                   360,  -TMath::Pi(),      +TMath::Pi());
+      deltaLeg2Pt_                    = book1D(dqmStore, "deltaLeg2Pt",                                    350,         -100.,             +250.);
+      deltaLeg2Eta_                   = book1D(dqmStore, "deltaLeg2Eta",                                   198,          -9.9,              +9.9);
+      deltaLeg2Phi_                   = book1D(dqmStore, "deltaLeg2Phi",                                   360,  -TMath::Pi(),      +TMath::Pi());
+
+      svFitMass_                      = book1D(dqmStore, "svFitMass",                        numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitSigma_                     = book1D(dqmStore, "svFitSigma",                      numBinsSVfitSigma_,            0.,    svFitSigmaMax_);
+      svFitIsValidSolution_           = book1D(dqmStore, "svFitIsValidSolution",                             2,          -0.5,               1.5);
+
+      svFitMass_mean_                 = book1D(dqmStore, "svFitMass_mean",                   numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitMass_median_               = book1D(dqmStore, "svFitMass_median",                 numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitMass_maximum_              = book1D(dqmStore, "svFitMass_maximum",                numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitMass_maxInterpol_          = book1D(dqmStore, "svFitMass_maxInterpol",            numBinsSVfitMass_,            0.,     svFitMassMax_);
+
+      svFitMassVsSigma_               = book2D(dqmStore, "svFitMassVsSigma",                               100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
+      svFitMassVsSigma_mean_          = book2D(dqmStore, "svFitMassVsSigma_mean",                          100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
+      svFitMassVsSigma_median_        = book2D(dqmStore, "svFitMassVsSigma_median",                        100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
+      svFitMassVsSigma_maximum_       = book2D(dqmStore, "svFitMassVsSigma_maximum",                       100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
+      svFitMassVsSigma_maxInterpol_   = book2D(dqmStore, "svFitMassVsSigma_maxInterpol",                   100, 0.,    svFitSigmaMax_, 100, 0., svFitMassMax_);
+
+      svFitMassVsMEt_                 = book2D(dqmStore, "svFitMassVsMEt",                                 100, 0., 0.5*svFitMassMax_, 100, 0., svFitMassMax_);
+      svFitSigmaVsMEt_                = book2D(dqmStore, "svFitSigmaVsMEt",                                100, 0., 0.5*svFitMassMax_, 100, 0., svFitSigmaMax_);
+
+      svFitMass_oneProng0pi0_         = book1D(dqmStore, "svFitMass_oneProng0pi0",           numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitMass_oneProng1pi0_         = book1D(dqmStore, "svFitMass_oneProng1pi0",           numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitMass_oneProng2pi0_         = book1D(dqmStore, "svFitMass_oneProng2pi0",           numBinsSVfitMass_,            0.,     svFitMassMax_);
+      svFitMass_threeProng0pi0_       = book1D(dqmStore, "svFitMass_threeProng0pi0",         numBinsSVfitMass_,            0.,     svFitMassMax_);
        
-      svFitMassVsNLL_                 = dqmStore.book2D("svFitMassVsNLL",                 "svFitMassVsNLL",                                 400, 0., 10., TMath::Nint(0.5*svFitMassMax_), 0., svFitMassMax_);
+      svFitMassVsNLL_                 = book2D(dqmStore, "svFitMassVsNLL",                                 400, 0., 10., TMath::Nint(0.5*svFitMassMax_), 0., svFitMassMax_);
 
     }
-    void fillHistograms(const reco::Candidate::LorentzVector& genDiTauP4, 
-			const reco::Candidate::LorentzVector& genLeg1P4, const reco::Candidate::LorentzVector& genLeg2P4, 
-			const reco::Candidate::LorentzVector& genMEtP4,
-			const NSVfitResonanceHypothesisBase* svFitResonanceHypothesis, double svFit_nll,
-			const reco::Candidate::LorentzVector& recLeg1P4, int recLeg1DecayMode,
-			const reco::Candidate::LorentzVector& recLeg2P4, int recLeg2DecayMode,
-			const reco::Candidate::LorentzVector& recMEtP4,
-			bool eventVertexIsValid, const AlgebraicVector3& eventVertexPos,
-			double evtWeight)
+    void fillHistograms(const fillInputType& input, double evtWeight)
     {
-      bool svFitIsValidSolution = svFitResonanceHypothesis->isValidSolution();
-      if ( isValidSolution_ < 0 &&  svFitIsValidSolution ) return;
-      if ( isValidSolution_ > 0 && !svFitIsValidSolution ) return;
-
-      double dPhi12 = TMath::ACos(TMath::Cos(recLeg1P4.phi() - recLeg2P4.phi()));
-      dPhi12 *= TMath::RadToDeg();
+      if ( isValidSolution_ < 0 &&  input.svFitIsValidSolution_ ) return;
+      if ( isValidSolution_ > 0 && !input.svFitIsValidSolution_ ) return;
 
-      double qT = genDiTauP4.pt();
-      
-      if ( (dPhi12 > minDPhi12_ || minDPhi12_ <= 0.) &&
-	   (dPhi12 < maxDPhi12_ || maxDPhi12_ <= 0.) &&
-	   (qT     > minQt_     || minQt_     <= 0.) &&
-	   (qT     < maxQt_     || maxQt_     <= 0.) ) {
+      if ( (input.dPhi12_ > minDPhi12_ || minDPhi12_ <= 0.) &&
+	   (input.dPhi12_ < maxDPhi12_ || maxDPhi12_ <= 0.) &&
+	   (input.qT_     > minQt_     || minQt_     <= 0.) &&
+	   (input.qT_     < maxQt_     || maxQt_     <= 0.) ) {
 	
-	leg1Pt_->Fill(recLeg1P4.pt(), evtWeight);
-	leg2Pt_->Fill(recLeg2P4.pt(), evtWeight);
-    	dPhi12_->Fill(dPhi12, evtWeight);
-	metPt_->Fill(recMEtP4.pt(), evtWeight);
-	double visMass = (recLeg1P4 + recLeg2P4).mass();
-	visMass_->Fill(visMass, evtWeight);
-	genMass_->Fill(genDiTauP4.mass(), evtWeight);
-	double genVisMass = (genLeg1P4 + genLeg2P4).mass();
-	genVisMass_->Fill(genVisMass, evtWeight);
-
-	//std::cout << "genDiTau: Pt = " << genDiTauP4.pt() << ", eta = " << genDiTauP4.eta() << ", phi = " << genDiTauP4.phi() << std::endl;
-	genDiTauPt_->Fill(genDiTauP4.pt(), evtWeight);
-	genDiTauEta_->Fill(genDiTauP4.eta(), evtWeight);
-	genDiTauPhi_->Fill(genDiTauP4.phi(), evtWeight);
-
-	bool svFitIsValidSolution = svFitResonanceHypothesis->isValidSolution();
-	svFitIsValidSolution_->Fill(svFitIsValidSolution, evtWeight);
-
-	double svFitMass      = svFitResonanceHypothesis->mass();
-	double svFitSigmaUp   = svFitResonanceHypothesis->massErrUp();
-	double svFitSigmaDown = svFitResonanceHypothesis->massErrDown();
-	double svFitSigma     = TMath::Sqrt(0.5*(svFitSigmaUp*svFitSigmaUp + svFitSigmaDown*svFitSigmaDown));
-
-	const NSVfitResonanceHypothesis* svFitResonanceHypothesis_nonbase = dynamic_cast<const NSVfitResonanceHypothesis*>(svFitResonanceHypothesis);
-	if ( svFitResonanceHypothesis_nonbase ) {
-	  if ( svFitResonanceHypothesis_nonbase->pt_isValid() && svFitResonanceHypothesis_nonbase->eta_isValid() && svFitResonanceHypothesis_nonbase->phi_isValid() ) {
-	    reco::Candidate::LorentzVector recDiTauP4 = svFitResonanceHypothesis_nonbase->p4_fitted(); 
-
-	    //std::cout << "recDiTau: Pt = " << recDiTauP4.pt() << ", eta = " << recDiTauP4.eta() << ", phi = " << recDiTauP4.phi() << std::endl;
-	    recDiTauPt_->Fill(recDiTauP4.pt(), evtWeight);
-	    recDiTauEta_->Fill(recDiTauP4.eta(), evtWeight);
-	    recDiTauPhi_->Fill(recDiTauP4.phi(), evtWeight);
-	    
-	    deltaDiTauPt_->Fill(recDiTauP4.pt() - genDiTauP4.pt(), evtWeight);
-	    deltaDiTauPx_->Fill(recDiTauP4.px() - genDiTauP4.px(), evtWeight);
-	    deltaDiTauPy_->Fill(recDiTauP4.py() - genDiTauP4.py(), evtWeight);
-	    deltaDiTauEta_->Fill(recDiTauP4.eta() - genDiTauP4.eta(), evtWeight);
-	    deltaDiTauPhi_->Fill(normalizedPhi(recDiTauP4.phi() - genDiTauP4.phi()), evtWeight);
-	    deltaDiTauMass_->Fill(recDiTauP4.mass() - genDiTauP4.mass(), evtWeight);
-	    
-	    if ( TMath::Abs(recDiTauP4.mass() - svFitMass) > (1.e-2*genDiTauP4.mass()) ) {
-	      std::cerr << "Problem with large rounding errors:" << std::endl;
-	      std::cerr << " svFitMass = " << svFitMass << std::endl;
-	      std::cerr << " recDiTauP4: E = " << recDiTauP4.E() << ", eta = " << recDiTauP4.eta() << ", phi = " << recDiTauP4.phi() << ", mass = " << recDiTauP4.mass() << std::endl;
-	    }
-	    
-	    reco::Candidate::LorentzVector recMEtBySVfitP4 = recDiTauP4 - (recLeg1P4 + recLeg2P4);
-	    deltaMEtBySVfitPt_->Fill(recMEtBySVfitP4.pt() - genMEtP4.pt(), evtWeight);
-	    deltaMEtBySVfitPx_->Fill(recMEtBySVfitP4.px() - genMEtP4.px(), evtWeight);
-	    deltaMEtBySVfitPy_->Fill(recMEtBySVfitP4.py() - genMEtP4.py(), evtWeight);
-	    deltaMEtBySVfitPhi_->Fill(normalizedPhi(recMEtBySVfitP4.phi() - genMEtP4.phi()), evtWeight);
-	  }
+	leg1Pt_->Fill(input.recLeg1Pt_, evtWeight);
+	leg2Pt_->Fill(input.recLeg2Pt_, evtWeight);
+    	dPhi12_->Fill(input.dPhi12_, evtWeight);
+	metPt_->Fill(input.recMEtPt_, evtWeight);
+	visMass_->Fill(input.visMass_, evtWeight);
+	genMass_->Fill(input.genMass_, evtWeight);
+	genVisMass_->Fill(input.genVisMass_, evtWeight);
+
+	genDiTauPt_->Fill(input.genDiTauPt_, evtWeight);
+	genDiTauEta_->Fill(input.genDiTauEta_, evtWeight);
+	genDiTauPhi_->Fill(input.genDiTauPhi_, evtWeight);
+
+	svFitIsValidSolution_->Fill(input.svFitIsValidSolution_, evtWeight);
+
+	if ( input.recDiTauP4isValid_ ) {
+	  recDiTauPt_->Fill(input.recDiTauPt_, evtWeight);
+	  recDiTauEta_->Fill(input.recDiTauEta_, evtWeight);
+	  recDiTauPhi_->Fill(input.recDiTauPhi_, evtWeight);
+	  
+	  deltaDiTauPt_->Fill(input.deltaDiTauPt_, evtWeight);
+	  deltaDiTauPx_->Fill(input.deltaDiTauPx_, evtWeight);
+	  deltaDiTauPy_->Fill(input.deltaDiTauPy_, evtWeight);
+	  deltaDiTauEta_->Fill(input.deltaDiTauEta_, evtWeight);
+	  deltaDiTauPhi_->Fill(input.deltaDiTauPhi_, evtWeight);
+	  deltaDiTauMass_->Fill(input.deltaDiTauMass_, evtWeight);
+
+	  deltaMEtBySVfitPt_->Fill(input.deltaMEtBySVfitPt_, evtWeight);
+	  deltaMEtBySVfitPx_->Fill(input.deltaMEtBySVfitPx_, evtWeight);
+	  deltaMEtBySVfitPy_->Fill(input.deltaMEtBySVfitPy_, evtWeight);
+	  deltaMEtBySVfitPhi_->Fill(input.deltaMEtBySVfitPhi_, evtWeight);
 	}
 
-	if ( eventVertexIsValid ) {
-	  const NSVfitTauDecayHypothesis* daughter1 = dynamic_cast<const NSVfitTauDecayHypothesis*>(svFitResonanceHypothesis->daughter(0));
-	  if ( daughter1 ) {
-	    MonitorElement* deltaDecayVertexPhi = 0;
-	    if ( daughter1->hasDecayVertexFit() ) deltaDecayVertexPhi = deltaLeg1DecayVertexPhi_3prong_;
-	    else if ( daughter1->leadTrackExtrapolationIsValid() ) deltaDecayVertexPhi = deltaLeg1DecayVertexPhi_1prong_;
-	    if ( deltaDecayVertexPhi ) deltaDecayVertexPhi->Fill(normalizedPhi(SVfit_namespace::phi(daughter1->reconstructedDecayVertexPos() - eventVertexPos) - genLeg1P4.phi()), evtWeight);
-	  }
-	  const NSVfitTauDecayHypothesis* daughter2 = dynamic_cast<const NSVfitTauDecayHypothesis*>(svFitResonanceHypothesis->daughter(1));
-	  if ( daughter2 ) {
-	    MonitorElement* deltaDecayVertexPhi = 0;
-	    if ( daughter2->hasDecayVertexFit() ) deltaDecayVertexPhi = deltaLeg2DecayVertexPhi_3prong_;
-	    else if ( daughter2->leadTrackExtrapolationIsValid() ) deltaDecayVertexPhi = deltaLeg2DecayVertexPhi_1prong_;
-	    if ( deltaDecayVertexPhi ) deltaDecayVertexPhi->Fill(normalizedPhi(SVfit_namespace::phi(daughter2->reconstructedDecayVertexPos() - eventVertexPos) - genLeg2P4.phi()), evtWeight);
-	  }
-	}
-
-	const NSVfitTauDecayHypothesis* daughter1 = dynamic_cast<const NSVfitTauDecayHypothesis*>(svFitResonanceHypothesis->daughter(0));
-	if ( daughter1 ) {
-	  if ( daughter1->pt_isValid()  ) deltaLeg1Pt_->Fill(daughter1->pt() - genLeg1P4.pt(), evtWeight);
-	  if ( daughter1->eta_isValid() ) deltaLeg1Eta_->Fill(daughter1->eta() - genLeg1P4.eta(), evtWeight);
-	  if ( daughter1->phi_isValid() ) deltaLeg1Phi_->Fill(daughter1->phi() - genLeg1P4.phi(), evtWeight);
-	}
-	const NSVfitTauDecayHypothesis* daughter2 = dynamic_cast<const NSVfitTauDecayHypothesis*>(svFitResonanceHypothesis->daughter(1));
-	if ( daughter2 ) {
-	  if ( daughter2->pt_isValid()  ) deltaLeg2Pt_->Fill(daughter2->pt() - genLeg2P4.pt(), evtWeight);
-	  if ( daughter2->eta_isValid() ) deltaLeg2Eta_->Fill(daughter2->eta() - genLeg2P4.eta(), evtWeight);
-	  if ( daughter2->phi_isValid() ) deltaLeg2Phi_->Fill(daughter2->phi() - genLeg2P4.phi(), evtWeight);
-	}
+	if ( input.leg1DecayVertexType_ == 1 ) deltaLeg1DecayVertexPhi_1prong_->Fill(input.deltaLeg1DecayVertexPhi_, evtWeight);
+	if ( input.leg1DecayVertexType_ == 3 ) deltaLeg1DecayVertexPhi_3prong_->Fill(input.deltaLeg1DecayVertexPhi_, evtWeight);
+	if ( input.leg2DecayVertexType_ == 1 ) deltaLeg2DecayVertexPhi_1prong_->Fill(input.deltaLeg2DecayVertexPhi_, evtWeight);
+	if ( input.leg2DecayVertexType_ == 3 ) deltaLeg2DecayVertexPhi_3prong_->Fill(input.deltaLeg2DecayVertexPhi_, evtWeight);
+
+	if ( input.deltaLeg1PtIsValid_  ) deltaLeg1Pt_->Fill(input.deltaLeg1Pt_, evtWeight);
+	if ( input.deltaLeg1EtaIsValid_ ) deltaLeg1Eta_->Fill(input.deltaLeg1Eta_, evtWeight);
+	if ( input.deltaLeg1PhiIsValid_ ) deltaLeg1Phi_->Fill(input.deltaLeg1Phi_, evtWeight);
+	if ( input.deltaLeg2PtIsValid_  ) deltaLeg2Pt_->Fill(input.deltaLeg2Pt_, evtWeight);
+	if ( input.deltaLeg2EtaIsValid_ ) deltaLeg2Eta_->Fill(input.deltaLeg2Eta_, evtWeight);
+	if ( input.deltaLeg2PhiIsValid_ ) deltaLeg2Phi_->Fill(input.deltaLeg2Phi_, evtWeight);
 	
-	reco::Candidate::LorentzVector recLeg12MEtP4 = recLeg1P4 + recLeg2P4 + recMEtP4;
-	//std::cout << "recLeg12MEt: Pt = " << recLeg12MEtP4.pt() << ", eta = " << recLeg12MEtP4.eta() << ", phi = " << recLeg12MEtP4.phi() << std::endl;
-	recLeg12MEtPt_->Fill(recLeg12MEtP4.pt(), evtWeight);
-	recLeg12MEtPhi_->Fill(recLeg12MEtP4.phi(), evtWeight);
+	recLeg12MEtPt_->Fill(input.recLeg12MEtPt_, evtWeight);
+	recLeg12MEtPhi_->Fill(input.recLeg12MEtPhi_, evtWeight);
 	
-	deltaLeg12MEtPt_->Fill(recLeg12MEtP4.pt() - genDiTauP4.pt(), evtWeight);
-	deltaLeg12MEtPx_->Fill(recLeg12MEtP4.px() - genDiTauP4.px(), evtWeight);
-	deltaLeg12MEtPy_->Fill(recLeg12MEtP4.py() - genDiTauP4.py(), evtWeight);
-	deltaLeg12MEtPhi_->Fill(normalizedPhi(recLeg12MEtP4.phi() - genDiTauP4.phi()), evtWeight);
+	deltaLeg12MEtPt_->Fill(input.deltaLeg12MEtPt_, evtWeight);
+	deltaLeg12MEtPx_->Fill(input.deltaLeg12MEtPx_, evtWeight);
+	deltaLeg12MEtPy_->Fill(input.deltaLeg12MEtPy_, evtWeight);
+	deltaLeg12MEtPhi_->Fill(input.deltaLeg12MEtPhi_, evtWeight);
 	
-	deltaMEtPt_->Fill(recMEtP4.pt() - genMEtP4.pt(), evtWeight);
-	deltaMEtPx_->Fill(recMEtP4.px() - genMEtP4.px(), evtWeight);
-	deltaMEtPy_->Fill(recMEtP4.py() - genMEtP4.py(), evtWeight);
-	deltaMEtPhi_->Fill(normalizedPhi(recMEtP4.phi() - genMEtP4.phi()), evtWeight);
+	deltaMEtPt_->Fill(input.deltaMEtPt_, evtWeight);
+	deltaMEtPx_->Fill(input.deltaMEtPx_, evtWeight);
+	deltaMEtPy_->Fill(input.deltaMEtPy_, evtWeight);
+	deltaMEtPhi_->Fill(input.deltaMEtPhi_, evtWeight);
 	
-	svFitMass_->Fill(svFitMass, evtWeight);
-	svFitSigma_->Fill(svFitSigma, evtWeight);
-	svFitMassVsSigma_->Fill(svFitSigma, svFitMass, evtWeight);
-
-	if ( dynamic_cast<const NSVfitResonanceHypothesisByIntegration*>(svFitResonanceHypothesis) ) {
-	  double svFitMass_mean        = (dynamic_cast<const NSVfitResonanceHypothesisByIntegration*>(svFitResonanceHypothesis))->mass_mean();
-	  double svFitMass_median      = (dynamic_cast<const NSVfitResonanceHypothesisByIntegration*>(svFitResonanceHypothesis))->mass_median();
-	  double svFitMass_maximum     = (dynamic_cast<const NSVfitResonanceHypothesisByIntegration*>(svFitResonanceHypothesis))->mass_maximum();
-	  double svFitMass_maxInterpol = (dynamic_cast<const NSVfitResonanceHypothesisByIntegration*>(svFitResonanceHypothesis))->mass_maxInterpol();
-
-	  svFitMassVsSigma_mean_->Fill(svFitSigma, svFitMass_mean, evtWeight);
-	  svFitMassVsSigma_median_->Fill(svFitSigma, svFitMass_median, evtWeight);
-	  svFitMassVsSigma_maximum_->Fill(svFitSigma, svFitMass_maximum, evtWeight);
-	  svFitMassVsSigma_maxInterpol_->Fill(svFitSigma, svFitMass_maxInterpol, evtWeight);
+	svFitMass_->Fill(input.svFitMass_, evtWeight);
+	svFitSigma_->Fill(input.svFitSigma_, evtWeight);
+	svFitMassVsSigma_->Fill(input.svFitSigma_, input.svFitMass_, evtWeight);
+
+	if ( input.isByIntegration_ ) {
+	  svFitMassVsSigma_mean_->Fill(input.svFitSigma_, input.svFitMass_mean_, evtWeight);
+	  svFitMassVsSigma_median_->Fill(input.svFitSigma_, input.svFitMass_median_, evtWeight);
+	  svFitMassVsSigma_maximum_->Fill(input.svFitSigma_, input.svFitMass_maximum_, evtWeight);
+	  svFitMassVsSigma_maxInterpol_->Fill(input.svFitSigma_, input.svFitMass_maxInterpol_, evtWeight);
 	}
 
-	svFitMassVsMEt_->Fill(recMEtP4.pt(), svFitMass, evtWeight);
-	svFitSigmaVsMEt_->Fill(recMEtP4.pt(), svFitSigma, evtWeight);
+	svFitMassVsMEt_->Fill(input.recMEtPt_, input.svFitMass_, evtWeight);
+	svFitSigmaVsMEt_->Fill(input.recMEtPt_, input.svFitSigma_, evtWeight);
 	
-	if ( recLeg2DecayMode == reco::PFTau::kOneProng0PiZero ) {
-	  svFitMass_oneProng0pi0_->Fill(svFitMass, evtWeight);
-	} else if ( recLeg2DecayMode == reco::PFTau::kOneProng1PiZero ) {	
-	  svFitMass_oneProng1pi0_->Fill(svFitMass, evtWeight);
-	} else if ( recLeg2DecayMode == reco::PFTau::kOneProng2PiZero ) {
-	  svFitMass_oneProng2pi0_->Fill(svFitMass, evtWeight);
-	} else if ( recLeg2DecayMode == reco::PFTau::kThreeProng0PiZero ) {	
-	  svFitMass_threeProng0pi0_->Fill(svFitMass, evtWeight);
+	if ( input.recLeg2DecayMode_ == reco::PFTau::kOneProng0PiZero ) {
+	  svFitMass_oneProng0pi0_->Fill(input.svFitMass_, evtWeight);
+	} else if ( input.recLeg2DecayMode_ == reco::PFTau::kOneProng1PiZero ) {	
+	  svFitMass_oneProng1pi0_->Fill(input.svFitMass_, evtWeight);
+	} else if ( input.recLeg2DecayMode_ == reco::PFTau::kOneProng2PiZero ) {
+	  svFitMass_oneProng2pi0_->Fill(input.svFitMass_, evtWeight);
+	} else if ( input.recLeg2DecayMode_ == reco::PFTau::kThreeProng0PiZero ) {	
+	  svFitMass_threeProng0pi0_->Fill(input.svFitMass_, evtWeight);
 	}
       }
     }
     void finalizeHistograms()
-    {}
+    {
+      for ( std::vector<std::pair<MonitorElement*, TH1*> >::iterator localHistogram = localHistograms_.begin();
+	    localHistogram != localHistograms_.end(); ++localHistogram ) {
+	localHistogram->first->getTH1()->Add(localHistogram->second);
+	delete localHistogram->second;
+      }
+      localHistograms_.clear();
+    }
 
     std::string dqmDirectory_;
 
@@ -355,86 +421,93 @@ class NSVfitEventHypothesisAnalyzerT : public edm::EDAnalyzer
     double svFitMassMax_;
     int numBinsSVfitSigma_;
     double svFitSigmaMax_;
+
+    bool fillLocalHistograms_;
     
-    MonitorElement* leg1Pt_;
-    MonitorElement* leg2Pt_;
-    MonitorElement* dPhi12_;
-    MonitorElement* metPt_;
-    MonitorElement* visMass_;
-    MonitorElement* genMass_;
-    MonitorElement* genVisMass_;
-
-    MonitorElement* genDiTauPt_;
-    MonitorElement* genDiTauEta_;
-    MonitorElement* genDiTauPhi_;
-
-    MonitorElement* recDiTauPt_;
-    MonitorElement* recDiTauEta_;
-    MonitorElement* recDiTauPhi_;
+    TH1* leg1Pt_;
+    TH1* leg2Pt_;
+    TH1* dPhi12_;
+    TH1* metPt_;
+    TH1* visMass_;
+    TH1* genMass_;
+    TH1* genVisMass_;
+
+    TH1* genDiTauPt_;
+    TH1* genDiTauEta_;
+    TH1* genDiTauPhi_;
+
+    TH1* recDiTauPt_;
+    TH1* recDiTauEta_;
+    TH1* recDiTauPhi_;
     
-    MonitorElement* recLeg12MEtPt_;
-    MonitorElement* recLeg12MEtPhi_;
+    TH1* recLeg12MEtPt_;
+    TH1* recLeg12MEtPhi_;
     
-    MonitorElement* deltaDiTauPt_;
-    MonitorElement* deltaDiTauPx_;
-    MonitorElement* deltaDiTauPy_;
-    MonitorElement* deltaDiTauEta_;
-    MonitorElement* deltaDiTauPhi_;
-    MonitorElement* deltaDiTauMass_;
+    TH1* deltaDiTauPt_;
+    TH1* deltaDiTauPx_;
+    TH1* deltaDiTauPy_;
+    TH1* deltaDiTauEta_;
+    TH1* deltaDiTauPhi_;
+    TH1* deltaDiTauMass_;
     
-    MonitorElement* deltaLeg12MEtPt_;
-    MonitorElement* deltaLeg12MEtPx_;
-    MonitorElement* deltaLeg12MEtPy_;
-    MonitorElement* deltaLeg12MEtPhi_;
+    TH1* deltaLeg12MEtPt_;
+    TH1* deltaLeg12MEtPx_;
+    TH1* deltaLeg12MEtPy_;
+    TH1* deltaLeg12MEtPhi_;
     
-    MonitorElement* deltaMEtPt_;
-    MonitorElement* deltaMEtPx_;
-    MonitorElement* deltaMEtPy_;
-    MonitorElement* deltaMEtPhi_;
-
-    MonitorElement* deltaMEtBySVfitPt_;
-    MonitorElement* deltaMEtBySVfitPx_;
-    MonitorElement* deltaMEtBySVfitPy_;
-    MonitorElement* deltaMEtBySVfitPhi_;
+    TH1* deltaMEtPt_;
+    TH1* deltaMEtPx_;
+    TH1* deltaMEtPy_;
+    TH1* deltaMEtPhi_;
+
+    TH1* deltaMEtBySVfitPt_;
+    TH1* deltaMEtBySVfitPx_;
+    TH1* deltaMEtBySVfitPy_;
+    TH1* deltaMEtBySVfitPhi_;
            
-    MonitorElement* deltaLeg1DecayVertexPhi_1prong_;
-    MonitorElement* deltaLeg1DecayVertexPhi_3prong_; 
-    MonitorElement* deltaLeg2DecayVertexPhi_1prong_;
-    MonitorElement* deltaLeg2DecayVertexPhi_3prong_; 
-
-    MonitorElement* deltaLeg1Pt_;
-    MonitorElement* deltaLeg1Eta_;
-    MonitorElement* deltaLeg1Phi_;
-    MonitorElement* deltaLeg2Pt_;
-    MonitorElement* deltaLeg2Eta_;
-    MonitorElement* deltaLeg2Phi_;
-
-    MonitorElement* svFitMass_;
-    MonitorElement* svFitSigma_;
-    MonitorElement* svFitIsValidSolution_;
-
-    MonitorElement* svFitMass_mean_;
-    MonitorElement* svFitMass_median_;
-    MonitorElement* svFitMass_maximum_;
-    MonitorElement* svFitMass_maxInterpol_;
-
-    MonitorElement* svFitMassVsSigma_;
-    MonitorElement* svFitMassVsSigma_mean_;
-    MonitorElement* svFitMassVsSigma_median_;
-    MonitorElement* svFitMassVsSigma_maximum_;
-    MonitorElement* svFitMassVsSigma_maxInterpol_;
-
-    MonitorElement* svFitMassVsMEt_;
-    MonitorElement* svFitSigmaVsMEt_;
-
-    MonitorElement* svFitMass_oneProng0pi0_;
-    MonitorElement* svFitMass_oneProng1pi0_;
-    MonitorElement* svFitMass_oneProng2pi0_;
-    MonitorElement* svFitMass_threeProng0pi0_;    
+    TH1* deltaLeg1DecayVertexPhi_1prong_;
+    TH1* deltaLeg1DecayVertexPhi_3prong_; 
+    TH1* deltaLeg2DecayVertexPhi_1prong_;
+    TH1* deltaLeg2DecayVertexPhi_3prong_; 
+
+    TH1* deltaLeg1Pt_;
+    TH1* deltaLeg1Eta_;
+    TH1* deltaLeg1Phi_;
+    TH1* deltaLeg2Pt_;
+    TH1* deltaLeg2Eta_;
+    TH1* deltaLeg2Phi_;
+
+    TH1* svFitMass_;
+    TH1* svFitSigma_;
+    TH1* svFitIsValidSolution_;
+
+    TH1* svFitMass_mean_;
+    TH1* svFitMass_median_;
+    TH1* svFitMass_maximum_;
+    TH1* svFitMass_maxInterpol_;
+
+    TH2* svFitMassVsSigma_;
+    TH2* svFitMassVsSigma_mean_;
+    TH2* svFitMassVsSigma_median_;
+    TH2* svFitMassVsSigma_maximum_;
+    TH2* svFitMassVsSigma_maxInterpol_;
+
+    TH2* svFitMassVsMEt_;
+    TH2* svFitSigmaVsMEt_;
+
+    TH1* svFitMass_oneProng0pi0_;
+    TH1* svFitMass_oneProng1pi0_;
+    TH1* svFitMass_oneProng2pi0_;
+    TH1* svFitMass_threeProng0pi0_;    
     
-    MonitorElement* svFitMassVsNLL_;
+    TH2* svFitMassVsNLL_;
+
+//--- local histograms filled in fillLocalHistograms mode,
+//    added to the histograms booked in DQMStore by finalizeHistograms
+    std::vector<std::pair<MonitorElement*, TH1*> > localHistograms_;
   };
 
+
   std::vector<plotEntryType*> plotEntries_;
   
   long numEvents_processed_;
@@ -71,6 +71,8 @@ void NSVfitEventLikelihoodMEt2::beginJob(NSVfitAlgorithmBase* algorithm)
   algorithm->requestFitParameter("allLeptons",   nSVfit_namespace::kLep_shiftEn,    pluginName_);
   algorithm->requestFitParameter("allNeutrinos", nSVfit_namespace::kNu_energy_lab,  pluginName_);
   algorithm->requestFitParameter("allNeutrinos", nSVfit_namespace::kNu_phi_lab,     pluginName_);
+
+  if ( pfMEtSign_ && algorithm->getPFMEtSignSharedEventData() ) pfMEtSign_->setSharedEventData(*algorithm->getPFMEtSignSharedEventData());
 }
 
 void NSVfitEventLikelihoodMEt2::beginEvent(const edm::Event& evt, const edm::EventSetup& es)
@@ -20,7 +20,9 @@ using namespace SVfit_namespace;
 NSVfitEventLikelihoodMEt3::NSVfitEventLikelihoodMEt3(const edm::ParameterSet& cfg)
   : NSVfitEventLikelihood(cfg),
     lut_(0),
-    pfMEtSign_(0)
+    pfMEtSign_(0),
+    algorithm_(0),
+    rnd_(pluginName_)
 {
   //std::cout << "<NSVfitEventLikelihoodMEt3::NSVfitEventLikelihoodMEt3>:" << std::endl;
   //std::cout << "cfg:" << std::endl;
@@ -61,6 +63,8 @@ NSVfitEventLikelihoodMEt3::~NSVfitEventLikelihoodMEt3()
 
 void NSVfitEventLikelihoodMEt3::beginJob(NSVfitAlgorithmBase* algorithm)
 {
+  algorithm_ = algorithm;
+
   algorithm->requestFitParameter("allTauDecays", nSVfit_namespace::kTau_visEnFracX, pluginName_);
   algorithm->requestFitParameter("allTauDecays", nSVfit_namespace::kTau_phi_lab,    pluginName_);
   algorithm->requestFitParameter("allLeptons",   nSVfit_namespace::kLep_shiftEn,    pluginName_);
@@ -258,6 +262,8 @@ void NSVfitEventLikelihoodMEt3::beginCandidate(const NSVfitEventHypothesis* hypo
     sumPy += objectPt*TMath::Sin(objectPhi);
   }
   
+//--- throw toys with random numbers depending on event and candidate only
+  algorithm_->initializeRandomGenerator(rnd_);
   for ( unsigned iToy = 0; iToy < numToys_; ++iToy ) {
     if ( verbosity_ >= 1 && (iToy % 100000) == 1 ) std::cout << "processing toy #" << iToy << std::endl;
     double sumPx_toy = 0.;
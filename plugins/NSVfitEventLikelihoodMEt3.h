@@ -29,12 +29,12 @@
 
 #include "TauAnalysis/CandidateTools/interface/NSVfitEventLikelihood.h"
 #include "TauAnalysis/CandidateTools/interface/PFMEtSignInterface.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
 
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitEventHypothesis.h"
 
 #include <TH2.h>
 #include <TAxis.h>
-#include <TRandom3.h>
 
 #include <string>
 #include <list>
@@ -78,7 +78,8 @@ class NSVfitEventLikelihoodMEt3 : public NSVfitEventLikelihood
 
   PFMEtSignInterfaceBase* pfMEtSign_;
 
-  mutable TRandom3 rnd_;
+  const NSVfitAlgorithmBase* algorithm_;
+  mutable NSVfitRandomGenerator rnd_;
 
   bool monitorMEtUncertainty_;
   std::string monitorFilePath_;
@@ -1,6 +1,8 @@
 #include "TauAnalysis/CandidateTools/plugins/NSVfitProducerT.h"
 
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "CommonTools/UtilAlgos/interface/TFileService.h"
 
 #include "DataFormats/Common/interface/Handle.h"
 #include "DataFormats/Common/interface/View.h"
@@ -13,6 +15,10 @@
 
 #include "TauAnalysis/CandidateTools/interface/IndepCombinatoricsGeneratorT.h"
 
+#include <TH1D.h>
+
+#include <map>
+
 template<typename T>
 unsigned NSVfitProducerT<T>::instanceCounter_ = 0;
 
@@ -22,7 +28,8 @@ NSVfitProducerT<T>::NSVfitProducerT(const edm::ParameterSet& cfg)
     algorithm_(0),
     numInputParticles_(0),
     timer_(0),
-    numSVfitCalls_(0)
+    numSVfitCalls_(0),
+    numSVfitCalls_budgetExhausted_(0)
 {
   edm::ParameterSet cfg_config = cfg.getParameter<edm::ParameterSet>("config");
   edm::ParameterSet cfg_event = cfg_config.getParameter<edm::ParameterSet>("event");
@@ -65,6 +72,11 @@ NSVfitProducerT<T>::NSVfitProducerT(const edm::ParameterSet& cfg)
   ++instanceCounter_;
 
   produces<NSVfitEventHypothesisCollection>(instanceLabel_);
+//--- flags indicating hypotheses for which the integration has been stopped
+//    because the time or integrand call budget got exhausted
+//   (one entry per hypothesis, in the same order as the NSVfitEventHypothesis collection)
+  budgetExhaustedInstanceLabel_ = instanceLabel_ + "BudgetExhausted";
+  produces<std::vector<int> >(budgetExhaustedInstanceLabel_);
 }
 
 template<typename T>
@@ -113,7 +125,9 @@ void NSVfitProducerT<T>::produce(edm::Event& evt, const edm::EventSetup& es)
       << " Found " << metCollection->size() << " MET objects in collection = " << srcMEt_ << ","
       << " --> NSVfitEventHypothesis collection will NOT be produced !!";
     std::auto_ptr<NSVfitEventHypothesisCollection> emptyNSVfitEventHypothesisCollection(new NSVfitEventHypothesisCollection());
-    evt.put(emptyNSVfitEventHypothesisCollection);
+    evt.put(emptyNSVfitEventHypothesisCollection, instanceLabel_);
+    std::auto_ptr<std::vector<int> > emptyBudgetExhaustedFlags(new std::vector<int>());
+    evt.put(emptyBudgetExhaustedFlags, budgetExhaustedInstanceLabel_);
     return;
   }
 
@@ -126,7 +140,19 @@ void NSVfitProducerT<T>::produce(edm::Event& evt, const edm::EventSetup& es)
 
   algorithm_->beginEvent(evt, es);
 
-  std::auto_ptr<NSVfitEventHypothesisCollection> nSVfitEventHypothesisCollection(new NSVfitEventHypothesisCollection());
+//--- find combinations of input particles to be fitted first;
+//    the inputParticleMap is created once and its entries are updated for each combination,
+//    the indices of accepted combinations are stored in one flat vector (numInputParticles_ entries per combination)
+  typedef edm::Ptr<reco::Candidate> CandidatePtr;
+  typedef std::map<std::string, CandidatePtr> inputParticleMap;
+  inputParticleMap inputParticles;
+  std::vector<CandidatePtr*> inputParticleSlots(numInputParticles_);
+  for ( unsigned iParticleType = 0; iParticleType < numInputParticles_; ++iParticleType ) {
+    inputParticleSlots[iParticleType] = &inputParticles[inputParticleNames_[iParticleType]];
+  }
+  inputParticles["met"] = metPtr;
+
+  std::vector<int> acceptedCombinations;
 
   IndepCombinatoricsGeneratorT<int> inputParticleCombination(numInputParticles_);
   for ( unsigned iParticleType = 0; iParticleType < numInputParticles_; ++iParticleType ) {
@@ -134,15 +160,6 @@ void NSVfitProducerT<T>::produce(edm::Event& evt, const edm::EventSetup& es)
   }
 
   while ( inputParticleCombination.isValid() ) {
-    typedef edm::Ptr<reco::Candidate> CandidatePtr;
-    typedef std::map<std::string, CandidatePtr> inputParticleMap;
-    inputParticleMap inputParticles;
-    for ( unsigned iParticleType = 0; iParticleType < numInputParticles_; ++iParticleType ) {
-      CandidatePtr inputParticlePtr = inputParticleCollections[iParticleType]->ptrAt(inputParticleCombination[iParticleType]);
-      inputParticles.insert(std::pair<std::string, CandidatePtr>(inputParticleNames_[iParticleType], inputParticlePtr));
-    }
-    inputParticles.insert(std::pair<std::string, CandidatePtr>("met", metPtr));
-
 //--- check if the same particle collection is used as input for daughters more than once;
 //    if so, skip combinations corresponding to inputParticleCombination[..i..j] with i >= j
 //    and i and j referring to the same particle collection 
@@ -156,33 +173,61 @@ void NSVfitProducerT<T>::produce(edm::Event& evt, const edm::EventSetup& es)
       }
     }
 
+    if ( !isCombinatorialDuplicate ) {
+      for ( unsigned iParticleType = 0; iParticleType < numInputParticles_; ++iParticleType ) {
+	*inputParticleSlots[iParticleType] = inputParticleCollections[iParticleType]->ptrAt(inputParticleCombination[iParticleType]);
+      }
+
 //--- check for overlaps between any pairs of input particles
-    bool isOverlap = false;
-    for ( inputParticleMap::const_iterator inputParticle1 = inputParticles.begin();
-	  inputParticle1 != inputParticles.end(); ++inputParticle1 ) {
-      inputParticleMap::const_iterator inputParticle2_begin = inputParticle1;
-      ++inputParticle2_begin;
-      for ( inputParticleMap::const_iterator inputParticle2 = inputParticle2_begin;
-	    inputParticle2 != inputParticles.end(); ++inputParticle2 ) {
-	if ( inputParticle2->first != "met" && deltaR(inputParticle1->second->p4(), inputParticle2->second->p4()) < dRmin_ )
-	  isOverlap = true;
+      bool isOverlap = false;
+      for ( inputParticleMap::const_iterator inputParticle1 = inputParticles.begin();
+	    inputParticle1 != inputParticles.end(); ++inputParticle1 ) {
+	inputParticleMap::const_iterator inputParticle2_begin = inputParticle1;
+	++inputParticle2_begin;
+	for ( inputParticleMap::const_iterator inputParticle2 = inputParticle2_begin;
+	      inputParticle2 != inputParticles.end(); ++inputParticle2 ) {
+	  if ( inputParticle2->first != "met" && deltaR(inputParticle1->second->p4(), inputParticle2->second->p4()) < dRmin_ )
+	    isOverlap = true;
+	}
       }
-    }
 
-    if ( !(isCombinatorialDuplicate || isOverlap) ) {
-      std::auto_ptr<T> hypothesis(dynamic_cast<T*>(algorithm_->fit(inputParticles, eventVertex)));      
-      assert(hypothesis.get());
-      //hypothesis->print(std::cout);
-      nSVfitEventHypothesisCollection->push_back(*hypothesis);
-      ++numSVfitCalls_;
+      if ( !isOverlap ) {
+	for ( unsigned iParticleType = 0; iParticleType < numInputParticles_; ++iParticleType ) {
+	  acceptedCombinations.push_back(inputParticleCombination[iParticleType]);
+	}
+      }
     }
 
     inputParticleCombination.next();
   }
 
+//--- reserve space for all hypotheses in output collection,
+//    in order to avoid copying the hypotheses (and their daughters) each time the collection grows
+  size_t numAcceptedCombinations = ( numInputParticles_ > 0 ) ? acceptedCombinations.size()/numInputParticles_ : 0;
+  std::auto_ptr<NSVfitEventHypothesisCollection> nSVfitEventHypothesisCollection(new NSVfitEventHypothesisCollection());
+  nSVfitEventHypothesisCollection->reserve(numAcceptedCombinations);
+  std::auto_ptr<std::vector<int> > budgetExhaustedFlags(new std::vector<int>());
+  budgetExhaustedFlags->reserve(numAcceptedCombinations);
+
+  for ( size_t iCombination = 0; iCombination < numAcceptedCombinations; ++iCombination ) {
+    for ( unsigned iParticleType = 0; iParticleType < numInputParticles_; ++iParticleType ) {
+      *inputParticleSlots[iParticleType] = 
+	inputParticleCollections[iParticleType]->ptrAt(acceptedCombinations[iCombination*numInputParticles_ + iParticleType]);
+    }
+
+    std::auto_ptr<T> hypothesis(dynamic_cast<T*>(algorithm_->fit(inputParticles, eventVertex)));      
+    assert(hypothesis.get());
+    //hypothesis->print(std::cout);
+    nSVfitEventHypothesisCollection->push_back(*hypothesis);
+    budgetExhaustedFlags->push_back(algorithm_->isBudgetExhausted());
+    ++numSVfitCalls_;
+    if ( algorithm_->isBudgetExhausted() ) ++numSVfitCalls_budgetExhausted_;
+  }
+
   timer_->Stop();
 
   evt.put(nSVfitEventHypothesisCollection, instanceLabel_);
+  evt.put(budgetExhaustedFlags, budgetExhaustedInstanceLabel_);
 }
 
 template<typename T>
@@ -194,10 +239,24 @@ void NSVfitProducerT<T>::endJob()
 	    << timer_->RealTime() << "/" 
 	    << timer_->CpuTime() << " seconds" << std::endl;
   std::cout << " SVfit calls = " << numSVfitCalls_ << std::endl;
+  if ( numSVfitCalls_budgetExhausted_ > 0 ) 
+    std::cout << " (stopped because time/integrand call budget was exhausted = " << numSVfitCalls_budgetExhausted_ << ")" << std::endl;
   std::cout << " real/CPU time per call = " 
 	    << timer_->RealTime()/(double)numSVfitCalls_ << "/" 
 	    << timer_->CpuTime()/(double)numSVfitCalls_ << " seconds" << std::endl;
+  algorithm_->printPluginTiming(std::cout);
   std::cout << std::endl;
+
+//--- store histograms of number of integrand calls and CPU cycles per fit
+//   (booked only in case 'monitorPluginTiming' is enabled)
+  const std::vector<TH1*>& pluginTimingHistograms = algorithm_->getPluginTimingHistograms();
+  if ( pluginTimingHistograms.size() > 0 && edm::Service<TFileService>().isAvailable() ) {
+    edm::Service<TFileService> fs;
+    for ( std::vector<TH1*>::const_iterator histogram = pluginTimingHistograms.begin();
+	  histogram != pluginTimingHistograms.end(); ++histogram ) {
+      fs->make<TH1D>(*dynamic_cast<TH1D*>(*histogram));
+    }
+  }
 }
 
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitEventHypothesis.h"
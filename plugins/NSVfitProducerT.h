@@ -44,6 +44,7 @@ class NSVfitProducerT : public edm::EDProducer
   std::string moduleLabel_;
 
   std::string instanceLabel_;
+  std::string budgetExhaustedInstanceLabel_;
 
   NSVfitAlgorithmBase* algorithm_;
   
@@ -62,6 +63,7 @@ class NSVfitProducerT : public edm::EDProducer
 
   TStopwatch* timer_;
   long numSVfitCalls_;
+  long numSVfitCalls_budgetExhausted_;
   unsigned instanceId_;
   static unsigned instanceCounter_;
 };
@@ -34,19 +34,45 @@ double NSVfitResonanceLikelihoodBreitWigner::operator()(const NSVfitResonanceHyp
 
   double mass = resonance->mass();
   if ( this->verbosity_ ) std::cout << " mass = " << mass << std::endl;
-  double mass2 = square(mass);
 
-  // normalized relativistic Breit-Wigner distribution
-  // taken from http://en.wikipedia.org/wiki/Relativistic_Breit–Wigner_distribution
-  double norm_factor = k_;
-  double prob = norm_factor/(square(mass2 - resonance_mass2_) + resonance_mass2_*resonance_width2_);
-  if ( prob > 0. && power_ != 1. ) prob = TMath::Power(prob, power_); 
+//--- evaluate likelihood as batch of one point,
+//    so that scalar and batch evaluation cannot give different results
+  batchInputType input;
+  input.numPoints_ = 1;
+  input.mass_ = &mass;
+  double prob;
+  evaluateBatch(input, polHandedness, &prob);
   
   //if ( this->verbosity_ ) std::cout << "--> prob = " << prob << std::endl;
   
   return prob;
 }
 
+void NSVfitResonanceLikelihoodBreitWigner::evaluateBatch(const batchInputType& input, int polHandedness, double* probs) const
+{
+  size_t numPoints = input.numPoints_;
+  const double* mass = input.mass_;
+
+//--- compute normalized relativistic Breit-Wigner distribution
+//    taken from http://en.wikipedia.org/wiki/Relativistic_Breit–Wigner_distribution
+//    in a loop without branches, so that it can be vectorized by the compiler;
+//    the exponentiation (if any) is applied in a second pass
+  double norm_factor = k_;
+  double resonance_mass2 = resonance_mass2_;
+  double resonance_mass2_times_width2 = resonance_mass2_*resonance_width2_;
+  for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+    double mass2 = mass[iPoint]*mass[iPoint];
+    double diff = mass2 - resonance_mass2;
+    probs[iPoint] = norm_factor/(diff*diff + resonance_mass2_times_width2);
+  }
+
+  if ( power_ != 1. ) {
+    for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+      if ( probs[iPoint] > 0. ) probs[iPoint] = TMath::Power(probs[iPoint], power_);
+    }
+  }
+}
+
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 DEFINE_EDM_PLUGIN(NSVfitResonanceLikelihoodPluginFactory, NSVfitResonanceLikelihoodBreitWigner, "NSVfitResonanceLikelihoodBreitWigner");
@@ -29,6 +29,9 @@ class NSVfitResonanceLikelihoodBreitWigner : public NSVfitResonanceLikelihood
 
   double operator()(const NSVfitResonanceHypothesis*, int) const;
 
+  bool supportsBatchEvaluation() const { return true; }
+  void evaluateBatch(const batchInputType&, int, double*) const;
+
  private:
 
   double resonance_mass_;
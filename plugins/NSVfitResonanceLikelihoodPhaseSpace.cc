@@ -23,15 +23,36 @@ double NSVfitResonanceLikelihoodPhaseSpace::operator()(const NSVfitResonanceHypo
   double prodAngle_rf = resonance->prod_angle_rf();
   //if ( this->verbosity_ ) std::cout << " prodAngle_rf = " << prodAngle_rf << std::endl;
 
-  double prob = 1.;
-  if ( applySinThetaFactor_ ) prob *= (0.5*TMath::Sin(prodAngle_rf)); // phase-space factor 
-				                                      // (to be used only in "fit", **not** in integration mode)
+//--- evaluate likelihood as batch of one point,
+//    so that scalar and batch evaluation cannot give different results
+  batchInputType input;
+  input.numPoints_ = 1;
+  input.prod_angle_rf_ = &prodAngle_rf;
+  double prob;
+  evaluateBatch(input, polHandedness, &prob);
   
   //if ( this->verbosity_ ) std::cout << "--> prob = " << prob << std::endl;
 
   return prob;
 }
 
+void NSVfitResonanceLikelihoodPhaseSpace::evaluateBatch(const batchInputType& input, int polHandedness, double* probs) const
+{
+  size_t numPoints = input.numPoints_;
+  if ( applySinThetaFactor_ ) {
+//--- phase-space factor 
+//   (to be used only in "fit", **not** in integration mode)
+    const double* prodAngle_rf = input.prod_angle_rf_;
+    for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+      probs[iPoint] = 0.5*TMath::Sin(prodAngle_rf[iPoint]);
+    }
+  } else {
+    for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+      probs[iPoint] = 1.;
+    }
+  }
+}
+
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 DEFINE_EDM_PLUGIN(NSVfitResonanceLikelihoodPluginFactory, NSVfitResonanceLikelihoodPhaseSpace, "NSVfitResonanceLikelihoodPhaseSpace");
@@ -30,6 +30,9 @@ class NSVfitResonanceLikelihoodPhaseSpace : public NSVfitResonanceLikelihood
 
   double operator()(const NSVfitResonanceHypothesis*, int) const;
 
+  bool supportsBatchEvaluation() const { return true; }
+  void evaluateBatch(const batchInputType&, int, double*) const;
+
  private:
 
   bool applySinThetaFactor_; 
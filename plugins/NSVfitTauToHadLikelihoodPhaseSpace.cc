@@ -70,12 +70,8 @@ double NSVfitTauToHadLikelihoodPhaseSpace::operator()(const NSVfitSingleParticle
   //if ( this->verbosity_ ) std::cout << " decayAngle = " << decayAngle << std::endl;  
   double visEnFracX = hypothesis_T->visEnFracX();
   double visMass = hypothesis_T->visMass();
-  if ( !applyVisMassFactor_ ) {
-    if ( visMass < chargedPionMass ) visMass = chargedPionMass;
-    if ( visMass > tauLeptonMass   ) visMass = tauLeptonMass;
-  }
-  double visMass2 = square(visMass);
   double Pvis_rf = hypothesis_T->p4vis_rf().P();
+  double pt_fitted = hypothesis_T->p4_fitted().pt();
 #ifdef SVFIT_DEBUG     
   if ( this->verbosity_ ) {
     std::cout << "<NSVfitTauToHadLikelihoodPhaseSpace::operator()>:" << std::endl;
@@ -84,41 +80,76 @@ double NSVfitTauToHadLikelihoodPhaseSpace::operator()(const NSVfitSingleParticle
     std::cout << " visMass = " << visMass << std::endl;
   }
 #endif
-  // CV: normalize likelihood function such that 
-  //               1
-  //       integral  prob dX = 1.
-  //               0
-  double prob = tauLeptonMass/(2.*Pvis_rf);
-  if ( visEnFracX < (visMass2/tauLeptonMass2) ) {
-    double visEnFracX_limit = visMass2/tauLeptonMass2;
-    prob /= (1. + 1.e+6*square(visEnFracX - visEnFracX_limit));
-  } else if ( visEnFracX > 1. ) {
-    double visEnFracX_limit = 1.;
-    prob /= (1. + 1.e+6*square(visEnFracX - visEnFracX_limit));
+
+//--- evaluate likelihood as batch of one point,
+//    so that scalar and batch evaluation cannot give different results
+  batchInputType input;
+  input.numPoints_ = 1;
+  input.visEnFracX_ = &visEnFracX;
+  input.decayAngle_ = &decayAngle;
+  input.visMass_ = &visMass;
+  input.pVis_rf_ = &Pvis_rf;
+  input.pt_fitted_ = &pt_fitted;
+  double prob;
+  evaluateBatch(input, polSign, &prob);
+#ifdef SVFIT_DEBUG       
+  if ( this->verbosity_ ) std::cout << "--> prob = " << prob << std::endl;
+#endif
+  return prob;
+}
+
+void NSVfitTauToHadLikelihoodPhaseSpace::evaluateBatch(const batchInputType& input, int polSign, double* probs) const
+{
+//--- computation organized in passes over all points, so that the main pass can be vectorized by the compiler;
+//    the lookup of the visible mass distribution is done in a separate (scalar) pass
+//
+//    NOTE: likelihood is normalized such that
+//               1
+//       integral  prob dX = 1.
+//               0
+  size_t numPoints = input.numPoints_;
+  const double* visEnFracX = input.visEnFracX_;
+  const double* visMass = input.visMass_;
+  const double* pVis_rf = input.pVis_rf_;
+
+  for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+    double visMass_i = visMass[iPoint];
+    if ( !applyVisMassFactor_ ) {
+      visMass_i = ( visMass_i < chargedPionMass ) ? chargedPionMass : visMass_i;
+      visMass_i = ( visMass_i > tauLeptonMass   ) ? tauLeptonMass   : visMass_i;
+    }
+    double visEnFracX_limit = visMass_i*visMass_i/tauLeptonMass2;
+    double x = visEnFracX[iPoint];
+    double diff = ( x < visEnFracX_limit ) ? (x - visEnFracX_limit) : ( x > 1. ? (x - 1.) : 0.);
+    probs[iPoint] = tauLeptonMass/(2.*pVis_rf[iPoint])/(1. + 1.e+6*diff*diff);
   }
-  if ( applySinThetaFactor_ ) prob *= (0.5*TMath::Sin(decayAngle));
 
-  if ( applyVisMassFactor_ ) {    
-    int bin = histogram_->FindBin(visMass);
-    if ( bin <= firstBin_ ) bin = firstBin_;
-    if ( bin >= lastBin_  ) bin = lastBin_;
-    prob *= histogram_->GetBinContent(bin);
+  if ( applySinThetaFactor_ ) {
+    const double* decayAngle = input.decayAngle_;
+    for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+      probs[iPoint] *= (0.5*TMath::Sin(decayAngle[iPoint]));
+    }
   }
-  
+
+  if ( applyVisMassFactor_ ) {
+    for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+      int bin = histogram_->FindBin(visMass[iPoint]);
+      if ( bin <= firstBin_ ) bin = firstBin_;
+      if ( bin >= lastBin_  ) bin = lastBin_;
+      probs[iPoint] *= histogram_->GetBinContent(bin);
+    }
+  }
+
   if ( applyVisPtCutCorrection_ ) {
-    double probCorr = 1.;
+    const double* pt_fitted = input.pt_fitted_;
     const double epsilon_regularization = 1.e-1;
-    if ( hypothesis_T->p4_fitted().pt() > visPtCutThreshold_ ) {     
-      double xCut = visPtCutThreshold_/hypothesis_T->p4_fitted().pt();      
-      probCorr = 1./((1. - xCut) + epsilon_regularization);
+    for ( size_t iPoint = 0; iPoint < numPoints; ++iPoint ) {
+      if ( pt_fitted[iPoint] > visPtCutThreshold_ ) {     
+	double xCut = visPtCutThreshold_/pt_fitted[iPoint];      
+	probs[iPoint] *= 1./((1. - xCut) + epsilon_regularization);
+      }
     }
-    //if ( this->verbosity_ ) std::cout << "probCorr (had) = " << probCorr << std::endl;
-    prob *= probCorr;
   }
-#ifdef SVFIT_DEBUG       
-  if ( this->verbosity_ ) std::cout << "--> prob = " << prob << std::endl;
-#endif
-  return prob;
 }
 
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -32,6 +32,9 @@ class NSVfitTauToHadLikelihoodPhaseSpace : public NSVfitSingleParticleLikelihood
 
   double operator()(const NSVfitSingleParticleHypothesis*, int) const;
 
+  bool supportsBatchEvaluation() const { return true; }
+  void evaluateBatch(const batchInputType&, int, double*) const;
+
  private:
   bool applySinThetaFactor_; 
 
@@ -33,6 +33,22 @@ allElecTauPairs = cms.EDProducer("PATElecTauPairProducer",
         dRoverlapPFCandidate = cms.double(0.1)
     ),
     doMtautauMin = cms.bool(True),                             
+    # cut applied before running the time consuming mTauTauMin and SVfit computations
+    # (empty string = run them for all pairs)
+    expensiveQuantitiesPreselection = cms.string(""),
+    # cache of SVfit results, used to skip the SVfit computation
+    # when reprocessing the same events with unchanged SVfit configuration
+    # (empty fileName = no cache)
+    nSVfitCache = cms.PSet(
+        fileName = cms.string(""),
+        readOnly = cms.bool(False),
+        momentumQuantum = cms.double(1.e-3), # GeV
+        positionQuantum = cms.double(1.e-4)  # cm
+    ),
+    # record SVfit input for replaying the SVfit computation without the framework
+    # (empty = no recording; cf. bin/replaySVfitInputs.cc);
+    # the module label gets inserted into the file name, before the extension
+    recordNSVfitInputFileName = cms.string(""),
     verbosity = cms.untracked.int32(0)
 )
 
@@ -33,6 +33,22 @@ allMuTauPairs = cms.EDProducer("PATMuTauPairProducer",
         dRoverlapPFCandidate = cms.double(0.1)
     ),
     doMtautauMin = cms.bool(True),                     
+    # cut applied before running the time consuming mTauTauMin and SVfit computations
+    # (empty string = run them for all pairs)
+    expensiveQuantitiesPreselection = cms.string(""),
+    # cache of SVfit results, used to skip the SVfit computation
+    # when reprocessing the same events with unchanged SVfit configuration
+    # (empty fileName = no cache)
+    nSVfitCache = cms.PSet(
+        fileName = cms.string(""),
+        readOnly = cms.bool(False),
+        momentumQuantum = cms.double(1.e-3), # GeV
+        positionQuantum = cms.double(1.e-4)  # cm
+    ),
+    # record SVfit input for replaying the SVfit computation without the framework
+    # (empty = no recording; cf. bin/replaySVfitInputs.cc);
+    # the module label gets inserted into the file name, before the extension
+    recordNSVfitInputFileName = cms.string(""),
     verbosity = cms.untracked.int32(0)
 )
 
@@ -98,6 +114,19 @@ allMuTauPairsPFtype1MET = copy.deepcopy(allMuTauPairs)
 allMuTauPairsPFtype1MET.srcMET = cms.InputTag('patPFtype1METs')
 produceMuTauPairs += allMuTauPairsPFtype1MET
 
+# example for deferred SVfit computation:
+# build muon + tau-jet pairs without running SVfit,
+# then run SVfit only on pairs passing the event selection
+# (NOTE: 'srcReRecoDiTauToMEtAssociations' must not be defined,
+#        so that the MET of the selected pairs is used and nSVfit solutions present already are reused)
+#
+#allMuTauPairsNoSVfit = allMuTauPairs.clone(
+#    doSVreco = cms.bool(False)
+#)
+#selectedMuTauPairsSVfit = allMuTauPairs.clone(
+#    srcReRecoDiTauObjects = cms.InputTag('selectedMuTauPairsPzetaDiffCumulative')
+#)
+
 # define additional collections of muon + tau-jet candidates
 # with loose track and ECAL isolation applied on muon leg
 # (NOTE: to be used for the purpose of factorizing efficiencies
@@ -265,7 +265,8 @@ nSVfitEventBuilder = cms.PSet(
     pluginType = cms.string("NSVfitEventBuilder"),
     srcBeamSpot = cms.InputTag('offlineBeamSpot'),
     algorithm = cms.string("AdaptiveVertexFitter"),
-    applyBeamSpotConstraint = cms.bool(False)
+    applyBeamSpotConstraint = cms.bool(False),
+    incrementalRefit = cms.bool(False)
 )
 
 nSVfitConfig_template = cms.PSet(
@@ -316,9 +317,32 @@ nSVfitProducerByIntegration = cms.EDProducer("NSVfitProducerByIntegration",
             numCallsIntEval = cms.uint32(10000),
             maxChi2 = cms.double(2.),
             maxIntEvalIter = cms.uint32(5),                                          
-            precision = cms.double(0.00001)
+            precision = cms.double(0.00001),
+            # limits on time (in seconds) and number of integrand evaluations per tau lepton pair
+            # (0 = unlimited); solutions for which mass hypotheses got skipped
+            # because the budget was exhausted are flagged as not valid.
+            # The limits are checked between mass hypotheses and VEGAS iterations only and may be exceeded
+            # by up to numCallsGridOpt + numCallsIntEval integrand evaluations
+            maxTime = cms.double(0.),
+            maxIntegrandCalls = cms.uint32(0)
+        ),
+        # integration algorithm: 'vegas' or 'qmc' (randomized quasi-Monte Carlo integration by scrambled Sobol sequence)
+        integrator = cms.string("vegas"),
+        qmcOptions = cms.PSet(
+            # number of points per replica (rounded up to next power of two)
+            # and number of independent replicas used to estimate the uncertainty of the integral
+            numPoints = cms.uint32(1024),
+            numReplicas = cms.uint32(4),
+            precision = cms.double(0.00001),
+            # limits on time (in seconds) and number of integrand evaluations per tau lepton pair
+            # (0 = unlimited); checked between mass hypotheses only,
+            # the limits may be exceeded by up to numPoints*numReplicas integrand evaluations
+            maxTime = cms.double(0.),
+            maxIntegrandCalls = cms.uint32(0)
         ),
         max_or_median = cms.string("max"),                                         
+        # count calls and CPU cycles spent in builder and likelihood plugins
+        monitorPluginTiming = cms.bool(False),
         verbosity = cms.int32(0)
     ),
     dRmin = cms.double(0.3),
@@ -347,9 +371,28 @@ nSVfitProducerByIntegration2 = cms.EDProducer("NSVfitProducerByIntegration2",
             numBatches = cms.uint32(1),
             L = cms.uint32(1),
             epsilon0 = cms.double(1.e-2),
-            nu = cms.double(0.71)
+            nu = cms.double(0.71),
+            # limits on time (in seconds) and number of integrand evaluations per tau lepton pair
+            # (0 = unlimited)
+            maxTime = cms.double(0.),
+            maxIntegrandCalls = cms.uint32(0)
         ),
         max_or_median = cms.string("max"),
+        # estimate mass, pt, eta and phi from histograms ("histogram")
+        # or by streaming P^2 quantile estimator ("P2"), which needs a small and fixed amount of memory
+        quantileEstimator = cms.string("histogram"),
+        quantileEstimatorGridPoints = cms.uint32(32),
+        # record moves of Markov Chain in ring-buffer and write them into binary file
+        # for events in which the integration fails, the acceptance rate is low
+        # or the reconstructed mass deviates from the value given by the collinear approximation
+        monitorMarkovChain = cms.bool(False),
+        monitorFilePath = cms.string(''),
+        monitorBufferSize = cms.uint32(10000),
+        monitorPrescale = cms.uint32(10),
+        monitorMinAcceptanceRate = cms.double(0.05),
+        monitorMaxMassDeviation = cms.double(0.5),
+        # count calls and CPU cycles spent in builder and likelihood plugins
+        monitorPluginTiming = cms.bool(False),
         verbosity = cms.int32(0)
     ),
     dRmin = cms.double(0.3),
@@ -367,6 +410,8 @@ nSVfitProducerByLikelihoodMaximization = cms.EDProducer("NSVfitProducer",
         pluginType = cms.string("NSVfitAlgorithmByLikelihoodMaximization"),
         minimizer  = cms.vstring("Minuit2", "Migrad"),
         maxObjFunctionCalls = cms.uint32(5000),
+        # count calls and CPU cycles spent in builder and likelihood plugins
+        monitorPluginTiming = cms.bool(False),
         verbosity = cms.int32(0)
     ),
     dRmin = cms.double(0.3),
@@ -17,12 +17,33 @@ from TauAnalysis.CandidateTools.tools.recursiveSetAttr import recursiveSetAttr
 
 class objProdConfigurator(cms._ParameterTypeBase):
 
-    def __init__(self, objProd, systematics = None, pyModuleName = None):
+    # NOTE: in case 'fanOut' is enabled, systematic shifts which only change
+    #       the leg1, leg2 and MET input collections are handled by the original module
+    #       (via its 'systematics' parameter, cf. CompositePtrCandidateT1T2MEtProducer),
+    #       which reuses results of nominal pairs that are not affected by a shift.
+    #       Shifted collections are then referred to as cms.InputTag(moduleName, sysName);
+    #       use getSysInputTags to configure downstream modules (e.g. objSelConfigurator 'systematics')
+    fanOutAttributes = [ "srcLeg1", "srcLeg2", "srcMET" ]
+
+    def __init__(self, objProd, systematics = None, pyModuleName = None, fanOut = False):
         self.objProd = objProd
         self.systematics = systematics
         self.pyModuleName = pyModuleName,
+        self.fanOut = fanOut
+        self.sysInputTags = {}
         self.sequence = cms.Sequence()
 
+    def _addFanOut(self, objProdItem, sysName, sysAttributes, pyNameSpace = None, process = None):
+        if not hasattr(objProdItem, "systematics"):
+            objProdItem.systematics = cms.PSet()
+        sysPSet = cms.PSet()
+        for sysAttrName, sysAttrValue in sysAttributes.items():
+            setattr(sysPSet, sysAttrName, sysAttrValue)
+        setattr(objProdItem.systematics, sysName, sysPSet)
+
+        # shifted collection is stored as additional product of original module
+        self.sysInputTags[sysName] = cms.InputTag(getInstanceName(objProdItem, pyNameSpace, process), sysName)
+
     def _addModule(self, objProdItem, sysName, sysAttributes, pyNameSpace = None, process = None):
         # create module
         moduleType = objProdItem.type_()
@@ -32,7 +53,7 @@ class objProdConfigurator(cms._ParameterTypeBase):
         # to default values
         for objProdAttrName in dir(objProdItem):
             objProdAttr = getattr(objProdItem, objProdAttrName)
-            if isinstance(objProdAttr, cms._ParameterTypeBase) and not objProdAttrName in [ "pluginName", "pluginType" ]:
+            if isinstance(objProdAttr, cms._ParameterTypeBase) and not objProdAttrName in [ "pluginName", "pluginType", "systematics" ]:
                 if isinstance(objProdAttr, cms.PSet):
                     # CV: need to clone configuration parameters of type cms.PSet,...
                     #     in order to avoid that recursiveSetAttr function
@@ -49,6 +70,7 @@ class objProdConfigurator(cms._ParameterTypeBase):
         moduleName = composeModuleName([ getInstanceName(objProdItem, pyNameSpace, process), sysName ])
         #print "moduleName = %s" % moduleName
         module.setLabel(moduleName)
+        self.sysInputTags[sysName] = cms.InputTag(moduleName)
 
         # if process object exists, attach module to process object;
         # else register module in global python name-space
@@ -74,7 +96,17 @@ class objProdConfigurator(cms._ParameterTypeBase):
         if self.systematics is not None:
             for sysName, sysAttributes in self.systematics.items():
                 #print "sysName = %s" % sysName
-                self._addModule(self.objProd, sysName = sysName, sysAttributes = sysAttributes,
-                                pyNameSpace = pyNameSpace, process = process)
+                if self.fanOut and len([ sysAttrName for sysAttrName in sysAttributes.keys() if sysAttrName not in self.fanOutAttributes ]) == 0:
+                    self._addFanOut(self.objProd, sysName = sysName, sysAttributes = sysAttributes,
+                                    pyNameSpace = pyNameSpace, process = process)
+                else:
+                    self._addModule(self.objProd, sysName = sysName, sysAttributes = sysAttributes,
+                                    pyNameSpace = pyNameSpace, process = process)
 
         return self.sequence
+
+    def getSysInputTags(self):
+        # return dictionary of input tags referring to collections produced for systematic shifts
+        # (key = name of systematic shift), to be passed to downstream modules;
+        # needs to be called after configure
+        return self.sysInputTags
@@ -28,14 +28,18 @@ MarkovChainIntegrator::MarkovChainIntegrator(const edm::ParameterSet& cfg)
     numIntegrationCalls_(0),
     numMovesTotal_accepted_(0),
     numMovesTotal_rejected_(0),
-    monitorFile_(0),
-    monitorTree_(0)
+    stepSize_(0.),
+    trace_(0),
+    traceEnabled_(false),
+    traceBufferSize_(0),
+    tracePrescale_(1)
 {
   //std::cout << "<MarkovChainIntegrator::MarkovChainIntegrator>:" << std::endl;
 
   if ( cfg.exists("name") ) 
     name_ = cfg.getParameter<std::string>("name");
   //std::cout << " name = " << name_ << std::endl;
+  rnd_.setComponent(name_);
 
   std::string moveMode_string = cfg.getParameter<std::string>("mode");
   if      ( moveMode_string == "Metropolis" ) moveMode_ = kMetropolis;
@@ -107,6 +111,27 @@ MarkovChainIntegrator::MarkovChainIntegrator(const edm::ParameterSet& cfg)
       << "Configuration Parameter 'epsilon0' undefined !!\n";
   nu_ = cfg.getParameter<double>("nu");
 
+//--- get parameters for automatic adaptation of step-size and mass matrix
+  adaptEpsilon_ = ( cfg.exists("adaptEpsilon") ) ?
+    cfg.getParameter<bool>("adaptEpsilon") : false;
+  adaptMassMatrix_ = ( cfg.exists("adaptMassMatrix") ) ?
+    cfg.getParameter<bool>("adaptMassMatrix") : false;
+  targetAcceptanceRate_ = ( cfg.exists("targetAcceptanceRate") ) ?
+    cfg.getParameter<double>("targetAcceptanceRate") : 0.65;
+  if ( !(targetAcceptanceRate_ > 0. && targetAcceptanceRate_ < 1.) )
+    throw cms::Exception("MarkovChainIntegrator")
+      << "Invalid Configuration Parameter 'targetAcceptanceRate' = " << targetAcceptanceRate_ << "," 
+      << " value within interval ]0..1[ expected !!\n";
+  epsilonScale_ = 1.;
+  acceptanceProb_ = 0.;
+
+//--- get parameters limiting time and number of integrand evaluations per integration
+  double maxTime = ( cfg.exists("maxTime") ) ?
+    cfg.getParameter<double>("maxTime") : 0.;
+  unsigned maxIntegrandCalls = ( cfg.exists("maxIntegrandCalls") ) ?
+    cfg.getParameter<unsigned>("maxIntegrandCalls") : 0;
+  budget_.setLimits(maxTime, maxIntegrandCalls);
+
   verbosity_ = ( cfg.exists("verbosity") ) ?
     cfg.getParameter<int>("verbosity") : 0;
   //std::cout << " verbosity = " << verbosity_ << std::endl;
@@ -126,8 +151,7 @@ MarkovChainIntegrator::~MarkovChainIntegrator()
 #endif
   delete [] x_;
 
-  delete monitorTree_;
-  delete monitorFile_;
+  delete trace_;
 }
 
 void MarkovChainIntegrator::setIntegrand(const ROOT::Math::Functor& integrand)
@@ -158,6 +182,10 @@ void MarkovChainIntegrator::setIntegrand(const ROOT::Math::Functor& integrand)
     }
   }
 
+  epsilonMass_.resize(numDimensions_);
+  qMean_.resize(numDimensions_);
+  qM2_.resize(numDimensions_);
+
   p_.resize(2*numDimensions_);   // first N entries = "significant" components, last N entries = "dummy" components
   q_.resize(numDimensions_);     // "potential energy" E(q) depends in the first N "significant" components only
   gradE_.resize(numDimensions_); 
@@ -168,10 +196,7 @@ void MarkovChainIntegrator::setIntegrand(const ROOT::Math::Functor& integrand)
   qProposal_.resize(numDimensions_);
 
   probSum_.resize(numChains_*numBatches_);  
-  for ( vdouble::iterator probSum_i = probSum_.begin();
-	probSum_i != probSum_.end(); ++probSum_i ) {
-    (*probSum_i) = 0.;
-  }
+  numMovesBatch_.resize(numChains_*numBatches_);  
   integral_.resize(numChains_*numBatches_);  
 }
 
@@ -187,12 +212,44 @@ void MarkovChainIntegrator::registerCallBackFunction(const ROOT::Math::Functor&
 
 void MarkovChainIntegrator::setF(const ROOT::Math::Functor& f, const std::string& branchName)
 {
-  extraMonitorBranches_.push_back(monitorElementType(&f, branchName));
+  extraValueFunctions_.push_back(&f);
+  extraValueNames_.push_back(branchName);
+  extraValues_.resize(extraValueFunctions_.size());
+//--- ring-buffer needs to be reallocated in case number of extra values changes
+  delete trace_;
+  trace_ = 0;
+}
+
+void MarkovChainIntegrator::enableTrace(unsigned bufferSize, unsigned prescale)
+{
+  if ( bufferSize != traceBufferSize_ || prescale != tracePrescale_ ) {
+    delete trace_;
+    trace_ = 0;
+  }
+  traceBufferSize_ = bufferSize;
+  tracePrescale_ = prescale;
+  traceEnabled_ = true;
+}
+
+void MarkovChainIntegrator::writeTrace(const std::string& fileName, const std::string& label) const
+{
+  if ( !trace_ ) {
+    edm::LogWarning ("MarkovChainIntegrator::writeTrace")
+      << "No moves recorded for integrator = " << name_ << " --> skipping !!";
+    return;
+  }
+  trace_->write(fileName, label, extraValueNames_);
+}
+
+double MarkovChainIntegrator::getAcceptanceRate() const
+{
+  long numMoves = numMoves_accepted_ + numMoves_rejected_;
+  return ( numMoves > 0 ) ? 
+    (double)numMoves_accepted_/numMoves : 0.;
 }
 
 void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std::vector<double>& xMax, 
-				      double& integral, double& integralErr, int& errorFlag,
-				      const std::string& monitorFileName)
+				      double& integral, double& integralErr, int& errorFlag)
 {
 #ifdef SVFIT_DEBUG 
   if ( verbosity_ >= 2 ) {
@@ -200,14 +257,16 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
     std::cout << " name = " << name_ << std::endl;
     std::cout << " numDimensions = " << numDimensions_ << std::endl;
   }
-#endif
-#ifdef SVFIT_DEBUG 
-  if ( monitorFileName != "" ) openMonitorFile(monitorFileName);
 #endif
   if ( !integrand_ )
     throw cms::Exception("MarkovChainIntegrator::integrate")
       << "No integrand function has been set yet !!\n";
 
+  if ( traceEnabled_ ) {
+    if ( !trace_ ) trace_ = new MarkovChainTrace(numDimensions_, extraValueFunctions_.size(), traceBufferSize_, tracePrescale_);
+    trace_->reset();
+  }
+
   if ( !(xMin.size() == numDimensions_ && xMax.size() == numDimensions_) )
     throw cms::Exception("MarkovChainIntegrator::integrate")
       << "Mismatch in dimensionality between integrand = " << numDimensions_
@@ -224,17 +283,26 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
   
 //--- CV: set random number generator used to initialize starting-position
 //        for each integration, in order to make integration results independent of processing history
-  rnd_.SetSeed(12345);
+  rnd_.reset();
+
+  budget_.start();
 
   numMoves_accepted_ = 0;
   numMoves_rejected_ = 0;
 
-  unsigned k = numChains_*numBatches_;  
+//--- restart sums of probabilities for each integration
+//   (the sums used to be reset in setIntegrand only,
+//    so that each integration returned the sum of the integrals computed since the integrand was set)
+  for ( unsigned idxBatch = 0; idxBatch < probSum_.size(); ++idxBatch ) {  
+    probSum_[idxBatch] = 0.;
+    numMovesBatch_[idxBatch] = 0;
+  }
+
   unsigned m = numIterSampling_/numBatches_;
 
   numChainsRun_ = 0; 
 
-  for ( unsigned iChain = 0; iChain < numChains_; ++iChain ) {
+  for ( unsigned iChain = 0; iChain < numChains_ && !budget_.isExhausted(); ++iChain ) {
     bool isValidStartPos = false;
     if ( initMode_ == kNone ) {
       prob_ = evalProb(q_);
@@ -256,7 +324,7 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
       }
     }    
     unsigned iTry = 0;
-    while ( !isValidStartPos && iTry < maxCallsStartingPos_ ) {
+    while ( !isValidStartPos && iTry < maxCallsStartingPos_ && !budget_.checkIsExhausted() ) {
       initializeStartPosition_and_Momentum();
 //--- CV: check if start-position is within "valid" (physically allowed) region 
       bool isWithinPhysicalRegion = true;
@@ -280,7 +348,9 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
     }
     if ( !isValidStartPos ) continue;
 
-    for ( unsigned iMove = 0; iMove < numIterBurnin_; ++iMove ) {
+    initializeAdaptation();
+
+    for ( unsigned iMove = 0; iMove < numIterBurnin_ && !budget_.checkIsExhausted(); ++iMove ) {
 //--- propose Markov Chain transition to new, randomly chosen, point
 #ifdef SVFIT_DEBUG 
       if ( verbosity_ >= 2 ) std::cout << "burn-in move #" << iMove << ":" << std::endl;
@@ -290,11 +360,17 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
       do {
 	makeStochasticMove(iMove, isAccepted, isValid);
       } while ( !isValid );
+      if ( traceEnabled_ && trace_->isToBeRecorded() ) fillTrace(iMove, iChain, isAccepted, true);
+      if ( iMove >= numIterSimAnnealingPhase1plus2_ ) updateAdaptation(iMove - numIterSimAnnealingPhase1plus2_);
     }
 
+    if ( budget_.isExhausted() ) break;
+
+    finalizeAdaptation();
+
     unsigned idxBatch = iChain*numBatches_;
 
-    for ( unsigned iMove = 0; iMove < numIterSampling_; ++iMove ) {
+    for ( unsigned iMove = 0; iMove < numIterSampling_ && !budget_.checkIsExhausted(); ++iMove ) {
 //--- propose Markov Chain transition to new, randomly chosen, point;
 //    evaluate "call-back" functions at this point
 #ifdef SVFIT_DEBUG 
@@ -319,16 +395,28 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
 
       if ( iMove > 0 && (iMove % m) == 0 ) ++idxBatch;
       probSum_[idxBatch] += prob_;
-#ifdef SVFIT_DEBUG 
-      if ( monitorFile_ ) updateMonitorFile();
-#endif
+      ++numMovesBatch_[idxBatch];
+
+      if ( traceEnabled_ && trace_->isToBeRecorded() ) fillTrace(numIterBurnin_ + iMove, iChain, isAccepted, false);
     }
 
-    ++numChainsRun_;
+    if ( numMovesBatch_[iChain*numBatches_] > 0 ) ++numChainsRun_;
   }
 
+//--- batches are partially filled in case the integration has been stopped because the budget is exhausted;
+//    batches are empty in case the budget got exhausted before the chain reached the sampling stage,
+//    or in case no valid start-position has been found for the chain.
+//    Empty batches do not enter the computation of integral value and uncertainty
+//   (chains without valid start-position used to enter the average with value zero,
+//    biasing the integral towards low values by the fraction of such chains)
+  unsigned k = 0;
   for ( unsigned idxBatch = 0; idxBatch < probSum_.size(); ++idxBatch ) {  
-    integral_[idxBatch] = probSum_[idxBatch]/m;
+    if ( numMovesBatch_[idxBatch] > 0 ) {
+      integral_[idxBatch] = probSum_[idxBatch]/numMovesBatch_[idxBatch];
+      ++k;
+    } else {
+      integral_[idxBatch] = 0.;
+    }
     //if ( verbosity_ >= 1 ) std::cout << "integral[" << idxBatch << "] = " << integral_[idxBatch] << std::endl;
   }
 
@@ -337,29 +425,39 @@ void MarkovChainIntegrator::integrate(const std::vector<double>& xMin, const std
 //--- compute integral value and uncertainty
 //   (eqs. (6.39) and (6.40) in [1])   
   integral = 0.;
-  for ( unsigned i = 0; i < k; ++i ) {    
-    integral += integral_[i];
+  for ( unsigned idxBatch = 0; idxBatch < probSum_.size(); ++idxBatch ) {    
+    if ( numMovesBatch_[idxBatch] > 0 ) integral += integral_[idxBatch];
   }
-  integral /= k;
+  if ( k >= 1 ) integral /= k;
 
   integralErr = 0.;
-  for ( unsigned i = 0; i < k; ++i ) {
-    integralErr += square(integral_[i] - integral);
+  for ( unsigned idxBatch = 0; idxBatch < probSum_.size(); ++idxBatch ) {
+    if ( numMovesBatch_[idxBatch] > 0 ) integralErr += square(integral_[idxBatch] - integral);
   }
   if ( k >= 2 ) integralErr /= (k*(k - 1));
   integralErr = TMath::Sqrt(integralErr);
 
   //if ( verbosity_ >= 1 ) std::cout << "--> returning integral = " << integral << " +/- " << integralErr << std::endl;
 
-  errorFlag = ( numChainsRun_ >= 0.5*numChains_ ) ?
-    0 : 1;
+  if ( budget_.isExhausted() ) {
+//--- return estimate obtained from moves made so far
+    errorFlag = ( numChainsRun_ >= 1 ) ?
+      0 : 1;
+#ifdef SVFIT_DEBUG 
+    if ( verbosity_ >= 1 ) {
+      std::cout << "<MarkovChainIntegrator::integrate (name = " << name_ << ")>:" << std::endl;
+      std::cout << "budget exhausted after " << budget_.numIntegrandCalls() << " integrand calls" 
+		<< " (chains run = " << numChainsRun_ << ")." << std::endl;
+    }
+#endif
+  } else {
+    errorFlag = ( numChainsRun_ >= 0.5*numChains_ ) ?
+      0 : 1;
+  }
 
   ++numIntegrationCalls_;
   numMovesTotal_accepted_ += numMoves_accepted_;
   numMovesTotal_rejected_ += numMoves_rejected_;
-#ifdef SVFIT_DEBUG 
-  if ( monitorFile_ ) closeMonitorFile();
-#endif
 }
 
 void MarkovChainIntegrator::print(std::ostream& stream) const
@@ -394,6 +492,114 @@ void MarkovChainIntegrator::print(std::ostream& stream) const
 //-------------------------------------------------------------------------------
 //
 
+namespace
+{
+  // parameters of "dual averaging" algorithm, taken from section 3.2.1 of [3]
+  const double dualAveragingGamma = 0.05;
+  const double dualAveragingT0    = 10.;
+  const double dualAveragingKappa = 0.75;
+
+  // minimum number of positions required to estimate mass matrix
+  const unsigned minSamplesMassMatrix = 10;
+}
+
+void MarkovChainIntegrator::initializeAdaptation()
+{
+//--- reset step-sizes to configured values at start of each Markov Chain
+  epsilonScale_ = 1.;
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+    epsilonMass_[iDimension] = epsilon0s_[iDimension];
+    qMean_[iDimension] = 0.;
+    qM2_[iDimension] = 0.;
+  }
+  numSamplesMassMatrix_ = 0;
+
+  dualAveragingMu_ = TMath::Log(10.*epsilonScale_);
+  dualAveragingHbar_ = 0.;
+  dualAveragingLogEpsilonBar_ = 0.;
+  dualAveragingIter_ = 0;
+}
+
+void MarkovChainIntegrator::updateAdaptation(unsigned idxAdaptationMove)
+{
+  if ( !(adaptEpsilon_ || adaptMassMatrix_) ) return;
+
+  unsigned numIterAdaptation = numIterBurnin_ - numIterSimAnnealingPhase1plus2_;
+  unsigned numIterMassMatrix = ( adaptMassMatrix_ ) ? numIterAdaptation/2 : 0;
+
+//--- accumulate mean and variance of positions visited in first half of adaptation stage
+//   (Welford's algorithm)
+  if ( idxAdaptationMove < numIterMassMatrix ) {
+    ++numSamplesMassMatrix_;
+    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+      double q_i = q_[iDimension];
+      double delta = q_i - qMean_[iDimension];
+      qMean_[iDimension] += delta/numSamplesMassMatrix_;
+      qM2_[iDimension] += delta*(q_i - qMean_[iDimension]);
+    }
+  }
+
+  if ( adaptEpsilon_ ) {
+//--- update step-size by "dual averaging" (eqs. (5) and (6) in [3])
+    ++dualAveragingIter_;
+    double m = dualAveragingIter_;
+    double w = 1./(m + dualAveragingT0);
+    dualAveragingHbar_ = (1. - w)*dualAveragingHbar_ + w*(targetAcceptanceRate_ - acceptanceProb_);
+    double logEpsilon = dualAveragingMu_ - TMath::Sqrt(m)/dualAveragingGamma*dualAveragingHbar_;
+//--- restrict step-size to size of integration region
+    double epsilonMass_max = 0.;
+    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+      if ( epsilonMass_[iDimension] > epsilonMass_max ) epsilonMass_max = epsilonMass_[iDimension];
+    }
+    if ( epsilonMass_max > 0. && logEpsilon > -TMath::Log(epsilonMass_max) ) logEpsilon = -TMath::Log(epsilonMass_max);
+    double eta = TMath::Power(m, -dualAveragingKappa);
+    dualAveragingLogEpsilonBar_ = eta*logEpsilon + (1. - eta)*dualAveragingLogEpsilonBar_;
+    epsilonScale_ = TMath::Exp(logEpsilon);
+  }
+
+//--- set diagonal mass matrix at end of first half of adaptation stage;
+//    regularize estimated variance towards small value in case few positions have been visited
+//   (following the implementation in Stan)
+//    and restart step-size adaptation, keeping the geometric mean of the per-dimension step-sizes unchanged
+  if ( adaptMassMatrix_ && (idxAdaptationMove + 1) == numIterMassMatrix && numSamplesMassMatrix_ >= minSamplesMassMatrix ) {
+    double n = numSamplesMassMatrix_;
+    double logEpsilonMassSum_old = 0.;
+    double logEpsilonMassSum_new = 0.;
+    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+      double var_i = qM2_[iDimension]/(n - 1.);
+      var_i = (n/(n + 5.))*var_i + 1.e-3*(5./(n + 5.));
+      logEpsilonMassSum_old += TMath::Log(epsilonMass_[iDimension]);
+      epsilonMass_[iDimension] = TMath::Sqrt(var_i);
+      logEpsilonMassSum_new += TMath::Log(epsilonMass_[iDimension]);
+    }
+    epsilonScale_ *= TMath::Exp((logEpsilonMassSum_old - logEpsilonMassSum_new)/numDimensions_);
+    dualAveragingMu_ = TMath::Log(10.*epsilonScale_);
+    dualAveragingHbar_ = 0.;
+    dualAveragingLogEpsilonBar_ = 0.;
+    dualAveragingIter_ = 0;
+#ifdef SVFIT_DEBUG 
+    if ( verbosity_ >= 1 ) {
+      std::cout << "<MarkovChainIntegrator::updateAdaptation>:" << std::endl;
+      std::cout << " epsilonMass = " << format_vdouble(epsilonMass_) << std::endl;
+    }
+#endif
+  }
+}
+
+void MarkovChainIntegrator::finalizeAdaptation()
+{
+//--- freeze step-size for sampling stage,
+//    in order for the Markov Chain to satisfy detailed balance
+  if ( adaptEpsilon_ && dualAveragingIter_ > 0 ) epsilonScale_ = TMath::Exp(dualAveragingLogEpsilonBar_);
+#ifdef SVFIT_DEBUG 
+  if ( verbosity_ >= 1 && (adaptEpsilon_ || adaptMassMatrix_) ) {
+    std::cout << "<MarkovChainIntegrator::finalizeAdaptation>:" << std::endl;
+    std::cout << " epsilonScale = " << epsilonScale_ << std::endl;
+    std::cout << " epsilonMass = " << format_vdouble(epsilonMass_) << std::endl;
+  }
+#endif
+}
+
 void MarkovChainIntegrator::initializeStartPosition_and_Momentum(const std::vector<double>& q)
 {
 //--- set start position of Markov Chain in N-dimensional space to given values
@@ -509,9 +715,10 @@ void MarkovChainIntegrator::makeStochasticMove(unsigned idxMove, bool& isAccepte
     double C = rnd_.BreitWigner(0., 1.);
     exp_nu_times_C = TMath::Exp(nu_*C);
   } while ( TMath::IsNaN(exp_nu_times_C) || !TMath::Finite(exp_nu_times_C) || exp_nu_times_C > 1.e+6 );
+  stepSize_ = epsilonScale_*exp_nu_times_C;
   vdouble epsilon(numDimensions_);
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-    epsilon[iDimension] = epsilon0s_[iDimension]*exp_nu_times_C;
+    epsilon[iDimension] = epsilonScale_*epsilonMass_[iDimension]*exp_nu_times_C;
   }
 #ifdef SVFIT_DEBUG 
   if ( verbosity_ >= 2 ) std::cout << "epsilon = " << format_vdouble(epsilon) << std::endl;
@@ -576,6 +783,7 @@ void MarkovChainIntegrator::makeStochasticMove(unsigned idxMove, bool& isAccepte
 #ifdef SVFIT_DEBUG 
   if ( verbosity_ >= 2 ) std::cout << " rho = " << rho << std::endl;
 #endif  
+  acceptanceProb_ = TMath::Min(rho, 1.);
   double u = rnd_.Uniform(0., 1.);
 #ifdef SVFIT_DEBUG 
   if ( verbosity_ >= 2 ) std::cout << "u = " << u << std::endl;
@@ -655,6 +863,7 @@ double MarkovChainIntegrator::evalProb(const std::vector<double>& q)
 {
   updateX(q);
   double prob = (*integrand_)(x_);
+  budget_.addIntegrandCalls(1);
   return prob;
 }
 
@@ -714,50 +923,13 @@ void MarkovChainIntegrator::updateGradE(std::vector<double>& q)
 //-------------------------------------------------------------------------------
 //
 
-void MarkovChainIntegrator::openMonitorFile(const std::string& monitorFileName)
+void MarkovChainIntegrator::fillTrace(unsigned idxMove, unsigned idxChain, bool isAccepted, bool isBurnin)
 {
-  monitorFile_ = new TFile(monitorFileName.data(), "RECREATE");
-
-  monitorTree_ = new TTree("monitorTree", "Markov Chain transitions");
-
-  branchValues_.resize(numDimensions_ + 1);
-
-  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-    std::string branchName = Form("x%u", iDimension);
-    std::string branchName_and_option = Form("%s/F", branchName.data());
-    monitorTree_->Branch(branchName.data(), &branchValues_[iDimension], branchName_and_option.data());
-  }
-  
-  for ( std::vector<monitorElementType>::iterator extraMonitorBranch = extraMonitorBranches_.begin();
-	extraMonitorBranch != extraMonitorBranches_.end(); ++extraMonitorBranch ) {
-    monitorTree_->Branch(extraMonitorBranch->branchName_.data(), &extraMonitorBranch->branchValue_, Form("%s/F", extraMonitorBranch->branchName_.data()));
+//--- evaluate extra functions in sampling stage only,
+//    as the functions may depend on the state of the integrand set by the "call-back" functions
+  for ( unsigned iValue = 0; iValue < extraValueFunctions_.size(); ++iValue ) {
+    extraValues_[iValue] = ( isBurnin ) ? 
+      0. : (*extraValueFunctions_[iValue])(x_);
   }
-}
-
-void MarkovChainIntegrator::updateMonitorFile()
-{
-  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-    double x_i = x_[iDimension];
-    branchValues_[iDimension] = x_i;
-  }
-  
-  for ( std::vector<monitorElementType>::iterator extraMonitorBranch = extraMonitorBranches_.begin();
-	extraMonitorBranch != extraMonitorBranches_.end(); ++extraMonitorBranch ) {
-    extraMonitorBranch->branchValue_ = (*extraMonitorBranch->f_)(x_);
-  }
-
-  monitorTree_->Fill();
-}
-
-void MarkovChainIntegrator::closeMonitorFile()
-{
-  monitorFile_->cd();
-
-  monitorTree_->Write();
-
-  delete monitorTree_;
-  monitorTree_ = 0;
-
-  delete monitorFile_;
-  monitorFile_ = 0;
+  trace_->fill(idxMove, idxChain, isAccepted, isBurnin, prob_, acceptanceProb_, stepSize_, q_, extraValues_);
 }
@@ -0,0 +1,115 @@
+#include "TauAnalysis/CandidateTools/interface/MarkovChainTrace.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <fstream>
+#include <assert.h>
+
+namespace
+{
+  const UInt_t traceFormatVersion = 1;
+
+  template <typename T>
+  void writeValue(std::ofstream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeString(std::ofstream& stream, const std::string& value)
+  {
+    writeValue(stream, (UInt_t)value.length());
+    stream.write(value.data(), value.length());
+  }
+}
+
+MarkovChainTrace::MarkovChainTrace(unsigned numDimensions, unsigned numExtraValues, unsigned bufferSize, unsigned prescale)
+  : numDimensions_(numDimensions),
+    numExtraValues_(numExtraValues),
+    bufferSize_(bufferSize),
+    prescale_(prescale)
+{
+  if ( bufferSize_ == 0 || prescale_ == 0 )
+    throw cms::Exception("MarkovChainTrace")
+      << "Invalid bufferSize = " << bufferSize_ << " and prescale = " << prescale_ << ","
+      << " values greater 0 expected !!\n";
+
+  entries_.resize(bufferSize_);
+  values_.resize(bufferSize_*(numDimensions_ + numExtraValues_));
+
+  reset();
+}
+
+void MarkovChainTrace::reset()
+{
+  prescaleCounter_ = prescale_ - 1; // always record first move
+  idxNext_ = 0;
+  numEntriesTotal_ = 0;
+}
+
+void MarkovChainTrace::fill(unsigned idxMove, unsigned idxChain, bool isAccepted, bool isBurnin,
+			    double prob, double acceptanceProb, double stepSize,
+			    const std::vector<double>& q, const std::vector<double>& extraValues)
+{
+  assert(q.size() >= numDimensions_ && extraValues.size() >= numExtraValues_);
+
+  entryType& entry = entries_[idxNext_];
+  entry.idxMove_ = idxMove;
+  entry.idxChain_ = idxChain;
+  entry.flags_ = 0;
+  if ( isAccepted ) entry.flags_ |= 0x1;
+  if ( isBurnin   ) entry.flags_ |= 0x2;
+  entry.prob_ = prob;
+  entry.acceptanceProb_ = acceptanceProb;
+  entry.stepSize_ = stepSize;
+
+  Float_t* values = &values_[idxNext_*(numDimensions_ + numExtraValues_)];
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+    values[iDimension] = q[iDimension];
+  }
+  for ( unsigned iValue = 0; iValue < numExtraValues_; ++iValue ) {
+    values[numDimensions_ + iValue] = extraValues[iValue];
+  }
+
+  ++idxNext_;
+  if ( idxNext_ == bufferSize_ ) idxNext_ = 0;
+  ++numEntriesTotal_;
+}
+
+void MarkovChainTrace::write(const std::string& fileName, const std::string& label, const std::vector<std::string>& extraValueNames) const
+{
+  std::ofstream stream(fileName.data(), std::ios::out | std::ios::binary | std::ios::app);
+  if ( !stream )
+    throw cms::Exception("MarkovChainTrace::write")
+      << "Failed to open file = " << fileName << " !!\n";
+
+  unsigned numEntries = ( numEntriesTotal_ < bufferSize_ ) ? numEntriesTotal_ : bufferSize_;
+  unsigned idxFirst = ( numEntriesTotal_ < bufferSize_ ) ? 0 : idxNext_;
+
+  stream.write("MCTR", 4);
+  writeValue(stream, traceFormatVersion);
+  writeValue(stream, (UInt_t)numDimensions_);
+  writeValue(stream, (UInt_t)numExtraValues_);
+  writeValue(stream, (UInt_t)numEntries);
+  writeValue(stream, (UInt_t)numEntriesTotal_);
+  writeString(stream, label);
+  for ( unsigned iValue = 0; iValue < numExtraValues_; ++iValue ) {
+    writeString(stream, ( iValue < extraValueNames.size() ) ? extraValueNames[iValue] : "");
+  }
+
+  unsigned numValuesPerEntry = numDimensions_ + numExtraValues_;
+  for ( unsigned iEntry = 0; iEntry < numEntries; ++iEntry ) {
+    unsigned idx = (idxFirst + iEntry) % bufferSize_;
+    const entryType& entry = entries_[idx];
+    writeValue(stream, entry.idxMove_);
+    writeValue(stream, entry.idxChain_);
+    writeValue(stream, entry.flags_);
+    writeValue(stream, entry.prob_);
+    writeValue(stream, entry.acceptanceProb_);
+    writeValue(stream, entry.stepSize_);
+    stream.write(reinterpret_cast<const char*>(&values_[idx*numValuesPerEntry]), numValuesPerEntry*sizeof(Float_t));
+  }
+
+  if ( !stream )
+    throw cms::Exception("MarkovChainTrace::write")
+      << "Failed to write trace to file = " << fileName << " !!\n";
+}
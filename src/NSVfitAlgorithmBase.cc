@@ -3,16 +3,29 @@
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/CandidateTools/interface/candidateAuxFunctions.h"
 
 #include <TMath.h>
+#include <TH1D.h>
+
+#include <iomanip>
 
 using namespace SVfit_namespace;
 
 const NSVfitAlgorithmBase* NSVfitAlgorithmBase::gNSVfitAlgorithm = 0;
 
 NSVfitAlgorithmBase::NSVfitAlgorithmBase(const edm::ParameterSet& cfg)
-  : currentEventHypothesis_(0),
-    fitParameterCounter_(0)
+  : currentRunNumber_(0),
+    currentLumiSectionNumber_(0),
+    currentEventNumber_(0),
+    currentCandidateKey_(0),
+    currentEventHypothesis_(0),
+    isBudgetExhausted_(false),
+    pfMEtSignSharedEventData_(0),
+    fitParameterCounter_(0),
+    fitTiming_(0),
+    histogramNumIntegrandCalls_(0),
+    histogramNumCycles_(0)
 {
   pluginName_ = cfg.getParameter<std::string>("pluginName");
   pluginType_ = cfg.getParameter<std::string>("pluginType");
@@ -20,6 +33,9 @@ NSVfitAlgorithmBase::NSVfitAlgorithmBase(const edm::ParameterSet& cfg)
   edm::ParameterSet cfgEvent = cfg.getParameter<edm::ParameterSet>("event");
   eventModel_ = new eventModelType(cfgEvent, allLikelihoods_);
 
+  monitorPluginTiming_ = cfg.exists("monitorPluginTiming") ?
+    cfg.getParameter<bool>("monitorPluginTiming") : false;
+
   verbosity_ = cfg.exists("verbosity") ?
     cfg.getParameter<int>("verbosity") : 0;
 }
@@ -27,6 +43,16 @@ NSVfitAlgorithmBase::NSVfitAlgorithmBase(const edm::ParameterSet& cfg)
 NSVfitAlgorithmBase::~NSVfitAlgorithmBase()
 {
   delete eventModel_;
+
+  for ( std::vector<NSVfitPluginTiming*>::iterator it = pluginTimings_.begin();
+	it != pluginTimings_.end(); ++it ) {
+    delete (*it);
+  }
+  delete fitTiming_;
+  for ( std::vector<TH1*>::iterator it = pluginTimingHistograms_.begin();
+	it != pluginTimingHistograms_.end(); ++it ) {
+    delete (*it);
+  }
 }
 
 void NSVfitAlgorithmBase::beginJob()
@@ -37,6 +63,64 @@ void NSVfitAlgorithmBase::beginJob()
   }
 
   eventModel_->builder_->beginJob(this);
+
+  if ( monitorPluginTiming_ ) {
+    eventModel_->builder_->setTiming(bookPluginTiming(eventModel_->builder_->pluginName(), eventModel_->builder_->pluginType()));
+    eventModel_->bookPluginTiming(this);
+    fitTiming_ = new NSVfitPluginTiming(pluginName_, pluginType_);
+//--- book histograms of number of integrand calls and CPU cycles per call of fit method
+//   (log10 scale)
+    histogramNumIntegrandCalls_ = new TH1D(std::string(pluginName_).append("_log10NumIntegrandCalls").data(), 
+					   "log_{10}(Number of integrand calls per fit)", 80, 0., 8.);
+    histogramNumIntegrandCalls_->SetDirectory(0);
+    pluginTimingHistograms_.push_back(histogramNumIntegrandCalls_);
+    histogramNumCycles_ = new TH1D(std::string(pluginName_).append("_log10NumCycles").data(), 
+				   "log_{10}(Number of CPU cycles per fit)", 80, 4., 12.);
+    histogramNumCycles_->SetDirectory(0);
+    pluginTimingHistograms_.push_back(histogramNumCycles_);
+  }
+}
+
+NSVfitPluginTiming* NSVfitAlgorithmBase::bookPluginTiming(const std::string& pluginName, const std::string& pluginType)
+{
+  if ( !monitorPluginTiming_ ) return 0;
+
+  for ( std::vector<NSVfitPluginTiming*>::iterator pluginTiming = pluginTimings_.begin();
+	pluginTiming != pluginTimings_.end(); ++pluginTiming ) {
+    if ( (*pluginTiming)->pluginName() == pluginName ) return (*pluginTiming);
+  }
+
+  NSVfitPluginTiming* pluginTiming = new NSVfitPluginTiming(pluginName, pluginType);
+  pluginTimings_.push_back(pluginTiming);
+  return pluginTiming;
+}
+
+void NSVfitAlgorithmBase::printPluginTiming(std::ostream& stream) const
+{
+  if ( !monitorPluginTiming_ ) return;
+
+  stream << "<NSVfitAlgorithmBase::printPluginTiming>:" << std::endl;
+  stream << " pluginName = " << pluginName_ << std::endl;
+  ULong64_t numFits = fitTiming_->numCalls();
+  stream << " fit calls = " << numFits << ", CPU cycles = " << fitTiming_->numCycles();
+  if ( numFits > 0 ) stream << " (" << (double)fitTiming_->numCycles()/numFits << " per call)";
+  stream << std::endl;
+  if ( histogramNumIntegrandCalls_->GetEntries() > 0 ) {
+    stream << " log10(integrand calls per fit): mean = " << histogramNumIntegrandCalls_->GetMean() 
+	   << ", RMS = " << histogramNumIntegrandCalls_->GetRMS() << std::endl;
+  }
+//--- NOTE: time measured for builder plugins includes the time spent in builder plugins of daughter particles
+  for ( std::vector<NSVfitPluginTiming*>::const_iterator pluginTiming = pluginTimings_.begin();
+	pluginTiming != pluginTimings_.end(); ++pluginTiming ) {
+    ULong64_t numCalls = (*pluginTiming)->numCalls();
+    ULong64_t numCycles = (*pluginTiming)->numCycles();
+    stream << " " << std::setw(40) << std::left << (*pluginTiming)->pluginName() 
+	   << " (" << (*pluginTiming)->pluginType() << "):" << std::right
+	   << " calls = " << numCalls << ", CPU cycles = " << numCycles;
+    if ( numCalls > 0 ) stream << " (" << (double)numCycles/numCalls << " per call)";
+    if ( fitTiming_->numCycles() > 0 ) stream << ", fraction = " << std::setprecision(3) << 100.*numCycles/fitTiming_->numCycles() << "%" << std::setprecision(6);
+    stream << std::endl;
+  }
 }
 
 void NSVfitAlgorithmBase::beginEvent(const edm::Event& evt, const edm::EventSetup& es)
@@ -49,6 +133,10 @@ void NSVfitAlgorithmBase::beginEvent(const edm::Event& evt, const edm::EventSetu
   eventModel_->builder_->beginEvent(evt, es);
 
   currentEventSetup_ = &es;
+
+  currentRunNumber_ = evt.id().run();
+  currentLumiSectionNumber_ = evt.luminosityBlock();
+  currentEventNumber_ = evt.id().event();
 }
 
 void NSVfitAlgorithmBase::requestFitParameter(const std::string& name, int type, const std::string& requester)
@@ -151,11 +239,26 @@ NSVfitEventHypothesisBase* NSVfitAlgorithmBase::fit(const inputParticleMap& inpu
   // beginEvent should always be called before fit(...)
   assert(currentEventSetup_);
 
+  ULong64_t numIntegrandCalls_start = 0;
+  if ( fitTiming_ ) {
+    fitTiming_->start();
+    numIntegrandCalls_start = eventModel_->builder_->timing()->numCalls();
+  }
+
   // Setup the track service
   reco::Candidate::Point eventVertexPosition(0,0,0);
   if ( eventVertex ) eventVertexPosition = eventVertex->position();
   trackService_->setup(*currentEventSetup_, eventVertexPosition);
 
+//--- compute key identifying the candidate from the input particles,
+//    used to initialize random number generators
+  currentCandidateKey_ = 0;
+  for ( inputParticleMap::const_iterator inputParticle = inputParticles.begin();
+	inputParticle != inputParticles.end(); ++inputParticle ) {
+    currentCandidateKey_ = NSVfitRandomGenerator::hashCombine(currentCandidateKey_, NSVfitRandomGenerator::hashString(inputParticle->first));
+    currentCandidateKey_ = hashPtr(currentCandidateKey_, inputParticle->second);
+  }
+
   currentEventHypothesis_ = eventModel_->builder_->build(inputParticles, eventVertex);
   currentEventHypothesis_->name_ = pluginName_;
   currentEventHypothesis_isValidSolution_ = true;
@@ -172,13 +275,30 @@ NSVfitEventHypothesisBase* NSVfitAlgorithmBase::fit(const inputParticleMap& inpu
     }
   }
 
+  isBudgetExhausted_ = false;
+
   fitImp();
   fittedEventHypothesis_->nll_ = fittedEventHypothesis_nll_;
   if ( verbosity_ >= 2 ) fittedEventHypothesis_->print(std::cout);
 
+  if ( fitTiming_ ) {
+    ULong64_t numCycles_start = fitTiming_->numCycles();
+    fitTiming_->stop();
+    ULong64_t numIntegrandCalls = eventModel_->builder_->timing()->numCalls() - numIntegrandCalls_start;
+    if ( numIntegrandCalls > 0 ) histogramNumIntegrandCalls_->Fill(TMath::Log10((double)numIntegrandCalls));
+    ULong64_t numCycles = fitTiming_->numCycles() - numCycles_start;
+    if ( numCycles > 0 ) histogramNumCycles_->Fill(TMath::Log10((double)numCycles));
+  }
+
   return fittedEventHypothesis_;
 }
 
+void NSVfitAlgorithmBase::initializeRandomGenerator(NSVfitRandomGenerator& rnd) const
+{
+  rnd.setEvent(currentRunNumber_, currentLumiSectionNumber_, currentEventNumber_);
+  rnd.setCandidate(currentCandidateKey_);
+}
+
 bool NSVfitAlgorithmBase::update(const double* x, const double* param) const
 {
   currentEventHypothesis_isValidSolution_ = eventModel_->builder_->applyFitParameter(currentEventHypothesis_, x);
@@ -11,6 +11,7 @@
 
 NSVfitDecayVertexFitter::NSVfitDecayVertexFitter(const edm::ParameterSet& cfg)
   : trackBuilder_(0),
+    trackServiceIsAvailable_(false),
     vertexFitAlgorithm_(0)
 {
   vertexFitAlgorithm_ = new KalmanVertexFitter(true);
@@ -33,6 +34,15 @@ void NSVfitDecayVertexFitter::beginEvent(const edm::Event& evt, const edm::Event
   if ( !trackBuilder_ ) 
     throw cms::Exception("NSVfitDecayVertexFitter::beginEvent")
       << " Failed to access TransientTrackBuilder !!\n";
+
+  trackServiceIsAvailable_ = trackService_.isAvailable();
+  if ( trackServiceIsAvailable_ ) trackService_->setup(es);
+}
+
+reco::TransientTrack NSVfitDecayVertexFitter::transientTrack(const reco::Track* track) const
+{
+  if ( trackServiceIsAvailable_ ) return trackService_->transientTrack(track);
+  else return trackBuilder_->build(track);
 }
 
 TransientVertex NSVfitDecayVertexFitter::fitSecondaryVertex(const std::vector<const reco::Track*>& tracks) const 
@@ -47,7 +57,7 @@ TransientVertex NSVfitDecayVertexFitter::fitSecondaryVertex(const std::vector<co
   std::vector<reco::TransientTrack> track_trajectories;
   for ( std::vector<const reco::Track*>::const_iterator track = tracks.begin();
 	track != tracks.end(); ++track ) {
-    track_trajectories.push_back(trackBuilder_->build(*track));
+    track_trajectories.push_back(transientTrack(*track));
   }
   
 //--- fit tau decay vertex
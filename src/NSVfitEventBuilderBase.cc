@@ -3,6 +3,7 @@
 #include "DataFormats/Common/interface/Handle.h"
 
 #include "TauAnalysis/CandidateTools/interface/NSVfitParameter.h"
+#include "TauAnalysis/CandidateTools/interface/NSVfitAlgorithmBase.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitTauDecayHypothesis.h"
@@ -50,6 +51,7 @@ void NSVfitEventBuilderBase::beginJob(NSVfitAlgorithmBase* algorithm)
   for ( std::vector<NSVfitResonanceBuilderBase*>::iterator resonanceBuilder = resonanceBuilders_.begin();
 	resonanceBuilder != resonanceBuilders_.end(); ++resonanceBuilder ) {
     (*resonanceBuilder)->beginJob(algorithm);
+    (*resonanceBuilder)->setTiming(algorithm->bookPluginTiming((*resonanceBuilder)->pluginName(), (*resonanceBuilder)->pluginType()));
   }
 
   idxFitParameter_pvShiftX_ = getFitParameterIdx(algorithm, "*", nSVfit_namespace::kPV_shiftX, true); // optional parameter
@@ -210,6 +212,8 @@ NSVfitEventHypothesis* NSVfitEventBuilderBase::build(const inputParticleMap& inp
 
 bool NSVfitEventBuilderBase::applyFitParameter(NSVfitEventHypothesis* event, const double* param) const
 {
+  if ( timing_ ) timing_->start();
+
   bool isValidSolution = true;
 
   if ( doFitParameter_pvShift_ ) {
@@ -222,13 +226,18 @@ bool NSVfitEventBuilderBase::applyFitParameter(NSVfitEventHypothesis* event, con
 
   for ( unsigned iResonanceBuilder = 0; iResonanceBuilder < numResonanceBuilders_; ++iResonanceBuilder ) {
     NSVfitResonanceHypothesis* resonance = event->resonance(iResonanceBuilder);
+    NSVfitPluginTiming* timing = resonanceBuilders_[iResonanceBuilder]->timing();
+    if ( timing ) timing->start();
     isValidSolution &= resonanceBuilders_[iResonanceBuilder]->applyFitParameter(resonance, param);
+    if ( timing ) timing->stop();
 
     dp4 += resonance->dp4_fitted();
   }
 
   event->dp4_ = dp4;
 
+  if ( timing_ ) timing_->stop();
+
   return isValidSolution;
 }
 
@@ -10,10 +10,13 @@
 
 #include <TMath.h>
 
+#include <algorithm>
+
 NSVfitEventVertexRefitter::NSVfitEventVertexRefitter(const edm::ParameterSet& cfg)
   : srcBeamSpot_(cfg.getParameter<edm::InputTag>("srcBeamSpot")),
     beamSpot_(0),
     trackBuilder_(0),
+    trackServiceIsAvailable_(false),
     vertexFitAlgorithm_(0)
 {
   std::string algorithm = cfg.getParameter<std::string>("algorithm");
@@ -27,6 +30,9 @@ NSVfitEventVertexRefitter::NSVfitEventVertexRefitter(const edm::ParameterSet& cf
 
   applyBeamSpotConstraint_ = cfg.getParameter<bool>("applyBeamSpotConstraint");
 
+  incrementalRefit_ = ( cfg.exists("incrementalRefit") ) ?
+    cfg.getParameter<bool>("incrementalRefit") : false;
+
   verbosity_ = cfg.exists("verbosity") ?
     cfg.getParameter<int>("verbosity") : 0;
 }
@@ -38,6 +44,9 @@ NSVfitEventVertexRefitter::~NSVfitEventVertexRefitter()
 
 void NSVfitEventVertexRefitter::beginEvent(const edm::Event& evt, const edm::EventSetup& es)
 {
+  eventVertexFits_.clear();
+  refittedVertices_.clear();
+
 //--- get beamspot
   edm::Handle<reco::BeamSpot> beamSpotHandle;
   evt.getByLabel(srcBeamSpot_, beamSpotHandle);
@@ -60,6 +69,15 @@ void NSVfitEventVertexRefitter::beginEvent(const edm::Event& evt, const edm::Eve
   if ( !trackBuilder_ ) 
     throw cms::Exception("NSVfitEventVertexRefitter::beginEvent")
       << " Failed to access TransientTrackBuilder !!\n";
+
+  trackServiceIsAvailable_ = trackService_.isAvailable();
+  if ( trackServiceIsAvailable_ ) trackService_->setup(es);
+}
+
+reco::TransientTrack NSVfitEventVertexRefitter::transientTrack(const reco::Track* track) const
+{
+  if ( trackServiceIsAvailable_ ) return trackService_->transientTrack(track);
+  else return trackBuilder_->build(track);
 }
 
 //-------------------------------------------------------------------------------
@@ -70,40 +88,82 @@ bool tracksMatchByDeltaR(const reco::Track* trk1, const reco::Track* trk2)
   else return false;
 }
 
-// auxiliary function to exclude tracks associated to tau lepton decay "leg"
-// from primary event vertex refit
-typedef std::map<const reco::Track*, reco::TransientTrack> TransientTrackMap;
-void removeTracks(TransientTrackMap& pvTracks_toRefit, const std::vector<const reco::Track*>& svTracks)
+// auxiliary function to determine which tracks of the primary event vertex are to be excluded from the refit
+// (returns sorted indices of tracks in pvTracks; the tracks are examined in the order given by pvTrackOrder)
+std::vector<unsigned> findTracksToRemove(const std::vector<const reco::Track*>& pvTracks, const std::vector<unsigned>& pvTrackOrder,
+					 const std::vector<const reco::Track*>& svTracks)
 {
+  std::vector<unsigned> pvTrackIndices_toRemove;
+  std::vector<bool> isRemoved(pvTracks.size(), false);
   for ( std::vector<const reco::Track*>::const_iterator svTrack = svTracks.begin();
 	svTrack != svTracks.end(); ++svTrack ) {
 
 //--- remove track from list of tracks included in primary event vertex refit
 //    if track matches by reference or in eta-phi
 //    any of the tracks associated to tau lepton decay "leg"
-    for ( TransientTrackMap::iterator pvTrack = pvTracks_toRefit.begin();
-	  pvTrack != pvTracks_toRefit.end(); ++pvTrack ) {
-      if ( tracksMatchByDeltaR(pvTrack->first, *svTrack) ) {
-	pvTracks_toRefit.erase(pvTrack);
+    for ( std::vector<unsigned>::const_iterator idx_ordered = pvTrackOrder.begin();
+	  idx_ordered != pvTrackOrder.end(); ++idx_ordered ) {
+      unsigned idx = (*idx_ordered);
+      if ( isRemoved[idx] ) continue;
+      if ( tracksMatchByDeltaR(pvTracks[idx], *svTrack) ) {
+	isRemoved[idx] = true;
+	pvTrackIndices_toRemove.push_back(idx);
 	break;
       }
     }
   }
+  std::sort(pvTrackIndices_toRemove.begin(), pvTrackIndices_toRemove.end());
+  return pvTrackIndices_toRemove;
 }
 //-------------------------------------------------------------------------------
 
-void printTracks(const TransientTrackMap& pvTrackMap)
+void printTracks(const std::vector<const reco::Track*>& pvTracks, const std::vector<unsigned>& pvTrackOrder,
+		 const std::vector<unsigned>& pvTrackIndices_toSkip)
 {
   int idx = 0;
-  for ( TransientTrackMap::const_iterator pvTrack = pvTrackMap.begin();
-	pvTrack != pvTrackMap.end(); ++pvTrack ) {
-    std::cout << "Track #" << idx << ": Pt = " << pvTrack->first->pt() << "," 
-	      << " eta = " << pvTrack->first->eta() << ", phi = " << pvTrack->first->phi() 
-	      << " (charge = " << pvTrack->first->charge() << ", chi2 = " << pvTrack->first->normalizedChi2() << ")" << std::endl;
+  for ( std::vector<unsigned>::const_iterator idx_ordered = pvTrackOrder.begin();
+	idx_ordered != pvTrackOrder.end(); ++idx_ordered ) {
+    unsigned iTrack = (*idx_ordered);
+    if ( std::binary_search(pvTrackIndices_toSkip.begin(), pvTrackIndices_toSkip.end(), iTrack) ) continue;
+    const reco::Track* pvTrack = pvTracks[iTrack];
+    std::cout << "Track #" << idx << ": Pt = " << pvTrack->pt() << "," 
+	      << " eta = " << pvTrack->eta() << ", phi = " << pvTrack->phi() 
+	      << " (charge = " << pvTrack->charge() << ", chi2 = " << pvTrack->normalizedChi2() << ")" << std::endl;
     ++idx;
   }
 }
 
+CachingVertex<5> NSVfitEventVertexRefitter::fitVertex(const std::vector<reco::TransientTrack>& tracks) const
+{
+  if ( applyBeamSpotConstraint_ && beamSpotIsValid_ ) return vertexFitAlgorithm_->vertex(tracks, *beamSpot_);
+  else return vertexFitAlgorithm_->vertex(tracks);
+}
+
+NSVfitEventVertexRefitter::eventVertexFitType& NSVfitEventVertexRefitter::getEventVertexFit(const reco::Vertex* eventVertex) const
+{
+  eventVertexFitType& eventVertexFit = eventVertexFits_[eventVertex];
+  if ( eventVertexFit.pvTracks_.empty() && eventVertex->tracksSize() > 0 ) {
+    for ( reco::Vertex::trackRef_iterator pvTrack = eventVertex->tracks_begin();
+	  pvTrack != eventVertex->tracks_end(); ++pvTrack ) {
+      eventVertexFit.pvTracks_.push_back(pvTrack->get());
+      eventVertexFit.pvTracks_transient_.push_back(transientTrack(pvTrack->get()));
+    }
+//--- order in which tracks are passed to the refit:
+//    sorted by address and without duplicates, as in previous versions,
+//    in which the tracks were kept in a std::map keyed by reco::Track pointer
+//   (the AdaptiveVertexFitter result depends on the order of the tracks)
+    std::map<const reco::Track*, unsigned> pvTrackOrder;
+    for ( unsigned idx = 0; idx < eventVertexFit.pvTracks_.size(); ++idx ) {
+      pvTrackOrder.insert(std::make_pair(eventVertexFit.pvTracks_[idx], idx));
+    }
+    for ( std::map<const reco::Track*, unsigned>::const_iterator pvTrack = pvTrackOrder.begin();
+	  pvTrack != pvTrackOrder.end(); ++pvTrack ) {
+      eventVertexFit.pvTrackOrder_.push_back(pvTrack->second);
+    }
+  }
+  return eventVertexFit;
+}
+
 TransientVertex NSVfitEventVertexRefitter::refit(const reco::Vertex* eventVertex, const std::vector<const reco::Track*>* svTracks) const
 {
 //--- return (invalid) dummy vertex in case primary event vertex cannot be refitted,
@@ -132,47 +192,80 @@ TransientVertex NSVfitEventVertexRefitter::refit(const reco::Vertex* eventVertex
   if ( !(eventVertex && beamSpot_) ) return TransientVertex();
   assert(trackBuilder_);
 
-  std::vector<reco::TransientTrack> pvTracks_original;
-  TransientTrackMap pvTrackMap_refit;
-  for ( reco::Vertex::trackRef_iterator pvTrack = eventVertex->tracks_begin();
-	pvTrack != eventVertex->tracks_end(); ++pvTrack ) {
-    reco::TransientTrack pvTrack_transient = trackBuilder_->build(pvTrack->get());
-    pvTracks_original.push_back(pvTrack_transient);
-    pvTrackMap_refit.insert(std::make_pair(pvTrack->get(), pvTrack_transient));
-  }
-  if ( verbosity_ >= 1 ) {
-    std::cout << "#pvTracks (before excl. leptons) = " << pvTrackMap_refit.size() << std::endl;
-    if ( verbosity_ >= 2 ) printTracks(pvTrackMap_refit);
-  }
+  eventVertexFitType& eventVertexFit = getEventVertexFit(eventVertex);
+  const std::vector<const reco::Track*>& pvTracks = eventVertexFit.pvTracks_;
+  const std::vector<unsigned>& pvTrackOrder = eventVertexFit.pvTrackOrder_;
 
 //--- exclude tracks associated to any one of the two tau lepton decay "legs"
 //    from the primary event vertex refit
-  if ( svTracks ) removeTracks(pvTrackMap_refit, *svTracks);
+  std::vector<unsigned> pvTrackIndices_toRemove;
+  if ( svTracks ) pvTrackIndices_toRemove = findTracksToRemove(pvTracks, pvTrackOrder, *svTracks);
   if ( verbosity_ >= 1 ) {
-    std::cout << "#pvTracks (after excl. leptons) = " << pvTrackMap_refit.size() << std::endl;
-    if ( verbosity_ >= 2 ) printTracks(pvTrackMap_refit);
+    std::cout << "#pvTracks (before excl. leptons) = " << pvTrackOrder.size() << std::endl;
+    if ( verbosity_ >= 2 ) printTracks(pvTracks, pvTrackOrder, std::vector<unsigned>());
+    std::cout << "#pvTracks (after excl. leptons) = " << (pvTrackOrder.size() - pvTrackIndices_toRemove.size()) << std::endl;
+    if ( verbosity_ >= 2 ) printTracks(pvTracks, pvTrackOrder, pvTrackIndices_toRemove);
   }
 
-  std::vector<reco::TransientTrack> pvTracks_refit;
-  for ( TransientTrackMap::iterator pvTrack = pvTrackMap_refit.begin();
-	pvTrack != pvTrackMap_refit.end(); ++pvTrack ) {
-    pvTracks_refit.push_back(pvTrack->second);
-  }
+//--- check if vertex has already been refitted without the same tracks
+//   (by another hypothesis sharing the same tau lepton decay "legs")
+  refitSignatureType refitSignature(eventVertex, pvTrackIndices_toRemove);
+  std::map<refitSignatureType, TransientVertex>::const_iterator refittedVertex = refittedVertices_.find(refitSignature);
+  if ( refittedVertex != refittedVertices_.end() ) return refittedVertex->second;
 
 //--- refit primary event vertex with "cleaned" track collection;
 //    in case there are not "enough" tracks left to do the refit
 //    after excluding the tracks associated to tau lepton decay "leg",
 //    refit the primary event vertex with all tracks used in the original primary event vertex fit
-  if ( pvTracks_refit.size() >= minNumTracksRefit_ ) {
-    if ( applyBeamSpotConstraint_ && beamSpotIsValid_ ) return vertexFitAlgorithm_->vertex(pvTracks_refit, *beamSpot_);
-    else return vertexFitAlgorithm_->vertex(pvTracks_refit);
-  } else {
+  bool useFullVertexFit = false;
+  if ( (pvTrackOrder.size() - pvTrackIndices_toRemove.size()) < minNumTracksRefit_ ) {
     edm::LogWarning ("NSVfitEventVertexRefitter::refit")
       << "Insufficient tracks remaining after excluding tracks associated to tau decay products"
       << " --> skipping primary event vertex refit !!";
     // CV: need to enlarge errors on reconstructed event vertex position
     //     in SVfitLikelihoodDiTauTrackInfo in this case <-- FIXME    
-    if ( applyBeamSpotConstraint_ && beamSpotIsValid_ ) return vertexFitAlgorithm_->vertex(pvTracks_original, *beamSpot_);
-    else return vertexFitAlgorithm_->vertex(pvTracks_original);
+    useFullVertexFit = true;
   }
+  if ( (useFullVertexFit || incrementalRefit_) && !eventVertexFit.isFitted_ ) {
+    eventVertexFit.fittedVertex_ = fitVertex(eventVertexFit.pvTracks_transient_);
+    eventVertexFit.isFitted_ = true;
+  }
+
+  TransientVertex eventVertex_refitted;
+  if ( useFullVertexFit ) {
+    eventVertex_refitted = eventVertexFit.fittedVertex_;
+  } else if ( incrementalRefit_ ) {
+//--- remove contributions of tracks associated to tau lepton decay "legs" 
+//    from vertex fitted with all tracks
+    CachingVertex<5> vertex = eventVertexFit.fittedVertex_;
+    if ( vertex.isValid() ) {
+      for ( std::vector<unsigned>::const_iterator idx = pvTrackIndices_toRemove.begin();
+	    idx != pvTrackIndices_toRemove.end(); ++idx ) {
+	const reco::TransientTrack& pvTrack_toRemove = eventVertexFit.pvTracks_transient_[*idx];
+	std::vector<CachingVertex<5>::RefCountedVertexTrack> vertexTracks = vertex.tracks();
+	for ( std::vector<CachingVertex<5>::RefCountedVertexTrack>::const_iterator vertexTrack = vertexTracks.begin();
+	      vertexTrack != vertexTracks.end(); ++vertexTrack ) {
+	  if ( (*vertexTrack)->linearizedTrack()->track() == pvTrack_toRemove ) {
+	    vertex = vertexUpdator_.remove(vertex, *vertexTrack);
+	    break;
+	  }
+	}
+	if ( !vertex.isValid() ) break;
+      }
+    }
+    eventVertex_refitted = vertex;
+  } else {
+    std::vector<reco::TransientTrack> pvTracks_refit;
+    for ( std::vector<unsigned>::const_iterator idx_ordered = pvTrackOrder.begin();
+	  idx_ordered != pvTrackOrder.end(); ++idx_ordered ) {
+      unsigned idx = (*idx_ordered);
+      if ( !std::binary_search(pvTrackIndices_toRemove.begin(), pvTrackIndices_toRemove.end(), idx) ) {
+	pvTracks_refit.push_back(eventVertexFit.pvTracks_transient_[idx]);
+      }
+    }
+    eventVertex_refitted = fitVertex(pvTracks_refit);
+  }
+
+  refittedVertices_.insert(std::make_pair(refitSignature, eventVertex_refitted));
+  return eventVertex_refitted;
 }
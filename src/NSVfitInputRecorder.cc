@@ -0,0 +1,284 @@
+#include "TauAnalysis/CandidateTools/interface/NSVfitInputRecorder.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/Candidate/interface/Candidate.h"
+#include "DataFormats/METReco/interface/MET.h"
+#include "DataFormats/VertexReco/interface/Vertex.h"
+#include "DataFormats/PatCandidates/interface/Electron.h"
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/Tau.h"
+#include "DataFormats/TrackReco/interface/Track.h"
+
+#include "TauAnalysis/CandidateTools/interface/NSVfitSingleParticleTrackExtractor.h"
+
+#include <string.h>
+
+namespace
+{
+  const UInt_t inputFormatVersion = 2;
+
+  template <typename T>
+  void writeValue(std::ofstream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeString(std::ofstream& stream, const std::string& value)
+  {
+    writeValue(stream, (UInt_t)value.length());
+    stream.write(value.data(), value.length());
+  }
+
+  template <typename T>
+  void readValue(std::ifstream& stream, T& value)
+  {
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  void readString(std::ifstream& stream, std::string& value)
+  {
+    UInt_t length = 0;
+    readValue(stream, length);
+    value.resize(length);
+    if ( length > 0 ) stream.read(&value[0], length);
+  }
+}
+
+void NSVfitInputRecord::clear()
+{
+  run_ = 0;
+  lumi_ = 0;
+  event_ = 0;
+  candidateKey_ = 0;
+  legs_.clear();
+  metPx_ = 0.;
+  metPy_ = 0.;
+  for ( unsigned iElement = 0; iElement < 4; ++iElement ) {
+    metCov_[iElement] = 0.;
+  }
+  hasPrimaryVertex_ = 0;
+  for ( unsigned iCoordinate = 0; iCoordinate < 3; ++iCoordinate ) {
+    primaryVertexPos_[iCoordinate] = 0.;
+  }
+  results_.clear();
+}
+
+void NSVfitInputRecord::addLeg(const reco::Candidate& leg)
+{
+  legType entry;
+  entry.pdgId_ = leg.pdgId();
+  const pat::Tau* tau = dynamic_cast<const pat::Tau*>(&leg);
+  entry.decayMode_ = ( tau ) ? tau->decayMode() : -1;
+  const reco::Candidate::LorentzVector& legP4 = leg.p4();
+  entry.px_ = legP4.px();
+  entry.py_ = legP4.py();
+  entry.pz_ = legP4.pz();
+  entry.energy_ = legP4.energy();
+  std::vector<const reco::Track*> tracks;
+  if ( tau ) {
+    tracks = NSVfitSingleParticleTrackExtractor<pat::Tau>()(*tau);
+  } else if ( const pat::Electron* electron = dynamic_cast<const pat::Electron*>(&leg) ) {
+    tracks = NSVfitSingleParticleTrackExtractor<pat::Electron>()(*electron);
+  } else if ( const pat::Muon* muon = dynamic_cast<const pat::Muon*>(&leg) ) {
+    tracks = NSVfitSingleParticleTrackExtractor<pat::Muon>()(*muon);
+  }
+  for ( std::vector<const reco::Track*>::const_iterator track = tracks.begin();
+	track != tracks.end(); ++track ) {
+    legType::trackType trackEntry;
+    trackEntry.charge_ = (*track)->charge();
+    trackEntry.referencePoint_[0] = (*track)->vx();
+    trackEntry.referencePoint_[1] = (*track)->vy();
+    trackEntry.referencePoint_[2] = (*track)->vz();
+    unsigned iElement = 0;
+    for ( unsigned iParameter = 0; iParameter < 5; ++iParameter ) {
+      trackEntry.parameters_[iParameter] = (*track)->parameter(iParameter);
+      for ( unsigned jParameter = iParameter; jParameter < 5; ++jParameter ) {
+	trackEntry.covariance_[iElement] = (*track)->covariance(iParameter, jParameter);
+	++iElement;
+      }
+    }
+    entry.tracks_.push_back(trackEntry);
+  }
+  legs_.push_back(entry);
+}
+
+void NSVfitInputRecord::setMEt(const reco::MET& met, const TMatrixD& metCov)
+{
+  metPx_ = met.px();
+  metPy_ = met.py();
+  if ( metCov.GetNrows() == 2 && metCov.GetNcols() == 2 ) {
+    metCov_[0] = metCov(0, 0);
+    metCov_[1] = metCov(0, 1);
+    metCov_[2] = metCov(1, 0);
+    metCov_[3] = metCov(1, 1);
+  }
+}
+
+void NSVfitInputRecord::setPrimaryVertex(const reco::Vertex* pv)
+{
+  if ( pv ) {
+    hasPrimaryVertex_ = 1;
+    primaryVertexPos_[0] = pv->x();
+    primaryVertexPos_[1] = pv->y();
+    primaryVertexPos_[2] = pv->z();
+  }
+}
+
+//
+//-------------------------------------------------------------------------------
+//
+
+std::string NSVfitInputRecorder::makeFileName(const std::string& fileName, const std::string& moduleLabel)
+{
+  if ( moduleLabel == "" ) return fileName;
+  size_t posExtension = fileName.find_last_of('.');
+  size_t posDirectory = fileName.find_last_of('/');
+  if ( posExtension == std::string::npos || (posDirectory != std::string::npos && posExtension < posDirectory) ) 
+    return fileName + "_" + moduleLabel;
+  return std::string(fileName, 0, posExtension) + "_" + moduleLabel + std::string(fileName, posExtension);
+}
+
+NSVfitInputRecorder::NSVfitInputRecorder(const std::string& fileName)
+  : fileName_(fileName),
+    stream_(fileName.data(), std::ios::out | std::ios::binary | std::ios::trunc),
+    numRecords_(0)
+{
+  if ( !stream_ )
+    throw cms::Exception("NSVfitInputRecorder")
+      << "Failed to open file = " << fileName_ << " !!\n";
+
+  stream_.write("SVFI", 4);
+  writeValue(stream_, inputFormatVersion);
+}
+
+void NSVfitInputRecorder::write(const NSVfitInputRecord& record)
+{
+  writeValue(stream_, record.run_);
+  writeValue(stream_, record.lumi_);
+  writeValue(stream_, record.event_);
+  writeValue(stream_, record.candidateKey_);
+  writeValue(stream_, (UInt_t)record.legs_.size());
+  for ( std::vector<NSVfitInputRecord::legType>::const_iterator leg = record.legs_.begin();
+	leg != record.legs_.end(); ++leg ) {
+    writeValue(stream_, leg->pdgId_);
+    writeValue(stream_, leg->decayMode_);
+    writeValue(stream_, leg->px_);
+    writeValue(stream_, leg->py_);
+    writeValue(stream_, leg->pz_);
+    writeValue(stream_, leg->energy_);
+    writeValue(stream_, (UInt_t)leg->tracks_.size());
+    for ( std::vector<NSVfitInputRecord::legType::trackType>::const_iterator track = leg->tracks_.begin();
+	  track != leg->tracks_.end(); ++track ) {
+      writeValue(stream_, track->charge_);
+      stream_.write(reinterpret_cast<const char*>(track->referencePoint_), 3*sizeof(Float_t));
+      stream_.write(reinterpret_cast<const char*>(track->parameters_), 5*sizeof(Float_t));
+      stream_.write(reinterpret_cast<const char*>(track->covariance_), 15*sizeof(Float_t));
+    }
+  }
+  writeValue(stream_, record.metPx_);
+  writeValue(stream_, record.metPy_);
+  stream_.write(reinterpret_cast<const char*>(record.metCov_), 4*sizeof(Float_t));
+  writeValue(stream_, record.hasPrimaryVertex_);
+  stream_.write(reinterpret_cast<const char*>(record.primaryVertexPos_), 3*sizeof(Float_t));
+  writeValue(stream_, (UInt_t)record.results_.size());
+  for ( std::vector<NSVfitInputRecord::resultType>::const_iterator result = record.results_.begin();
+	result != record.results_.end(); ++result ) {
+    writeString(stream_, result->label_);
+    writeValue(stream_, result->isValidSolution_);
+    writeValue(stream_, result->mass_);
+    writeValue(stream_, result->massErrUp_);
+    writeValue(stream_, result->massErrDown_);
+    writeValue(stream_, result->time_);
+  }
+
+  if ( !stream_ )
+    throw cms::Exception("NSVfitInputRecorder::write")
+      << "Failed to write record to file = " << fileName_ << " !!\n";
+
+  ++numRecords_;
+}
+
+//
+//-------------------------------------------------------------------------------
+//
+
+NSVfitInputReader::NSVfitInputReader(const std::string& fileName)
+  : fileName_(fileName),
+    stream_(fileName.data(), std::ios::in | std::ios::binary),
+    formatVersion_(0)
+{
+  if ( !stream_ )
+    throw cms::Exception("NSVfitInputReader")
+      << "Failed to open file = " << fileName_ << " !!\n";
+
+  char magicWord[4];
+  stream_.read(magicWord, 4);
+  readValue(stream_, formatVersion_);
+  if ( !stream_ || strncmp(magicWord, "SVFI", 4) != 0 )
+    throw cms::Exception("NSVfitInputReader")
+      << "File = " << fileName_ << " is not an nSVfit input file !!\n";
+  if ( formatVersion_ < 1 || formatVersion_ > inputFormatVersion )
+    throw cms::Exception("NSVfitInputReader")
+      << "File = " << fileName_ << " has format version = " << formatVersion_ << ","
+      << " expected version <= " << inputFormatVersion << " !!\n";
+}
+
+bool NSVfitInputReader::read(NSVfitInputRecord& record)
+{
+  record.clear();
+
+  readValue(stream_, record.run_);
+  if ( stream_.eof() ) return false;
+  readValue(stream_, record.lumi_);
+  readValue(stream_, record.event_);
+  readValue(stream_, record.candidateKey_);
+  UInt_t numLegs = 0;
+  readValue(stream_, numLegs);
+  record.legs_.resize(numLegs);
+  for ( std::vector<NSVfitInputRecord::legType>::iterator leg = record.legs_.begin();
+	leg != record.legs_.end(); ++leg ) {
+    readValue(stream_, leg->pdgId_);
+    readValue(stream_, leg->decayMode_);
+    readValue(stream_, leg->px_);
+    readValue(stream_, leg->py_);
+    readValue(stream_, leg->pz_);
+    readValue(stream_, leg->energy_);
+//--- tracks are recorded since format version 2
+    if ( formatVersion_ >= 2 ) {
+      UInt_t numTracks = 0;
+      readValue(stream_, numTracks);
+      leg->tracks_.resize(numTracks);
+      for ( std::vector<NSVfitInputRecord::legType::trackType>::iterator track = leg->tracks_.begin();
+	    track != leg->tracks_.end(); ++track ) {
+	readValue(stream_, track->charge_);
+	stream_.read(reinterpret_cast<char*>(track->referencePoint_), 3*sizeof(Float_t));
+	stream_.read(reinterpret_cast<char*>(track->parameters_), 5*sizeof(Float_t));
+	stream_.read(reinterpret_cast<char*>(track->covariance_), 15*sizeof(Float_t));
+      }
+    }
+  }
+  readValue(stream_, record.metPx_);
+  readValue(stream_, record.metPy_);
+  stream_.read(reinterpret_cast<char*>(record.metCov_), 4*sizeof(Float_t));
+  readValue(stream_, record.hasPrimaryVertex_);
+  stream_.read(reinterpret_cast<char*>(record.primaryVertexPos_), 3*sizeof(Float_t));
+  UInt_t numResults = 0;
+  readValue(stream_, numResults);
+  record.results_.resize(numResults);
+  for ( std::vector<NSVfitInputRecord::resultType>::iterator result = record.results_.begin();
+	result != record.results_.end(); ++result ) {
+    readString(stream_, result->label_);
+    readValue(stream_, result->isValidSolution_);
+    readValue(stream_, result->mass_);
+    readValue(stream_, result->massErrUp_);
+    readValue(stream_, result->massErrDown_);
+    readValue(stream_, result->time_);
+  }
+
+  if ( !stream_ )
+    throw cms::Exception("NSVfitInputReader::read")
+      << "Failed to read record from file = " << fileName_ << " (file truncated ?) !!\n";
+
+  return true;
+}
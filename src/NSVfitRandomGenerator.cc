@@ -0,0 +1,163 @@
+#include "TauAnalysis/CandidateTools/interface/NSVfitRandomGenerator.h"
+
+#include <TMath.h>
+
+namespace
+{
+  // constants of Philox4x32 algorithm
+  const UInt_t philoxM0 = 0xD2511F53;
+  const UInt_t philoxM1 = 0xCD9E8D57;
+  const UInt_t philoxW0 = 0x9E3779B9;
+  const UInt_t philoxW1 = 0xBB67AE85;
+  const unsigned philoxNumRounds = 10;
+
+  inline void mulhilo(UInt_t a, UInt_t b, UInt_t& hi, UInt_t& lo)
+  {
+    ULong64_t product = (ULong64_t)a*(ULong64_t)b;
+    hi = (UInt_t)(product >> 32);
+    lo = (UInt_t)product;
+  }
+
+  const double twoToMinus32 = 1./4294967296.;
+}
+
+NSVfitRandomGenerator::NSVfitRandomGenerator(const std::string& component, UInt_t stream)
+  : componentHash_(hashString(component)),
+    stream_(stream),
+    run_(0),
+    lumi_(0),
+    event_(0),
+    candidate_(0)
+{
+  updateKey();
+  reset();
+}
+
+void NSVfitRandomGenerator::setComponent(const std::string& component)
+{
+  componentHash_ = hashString(component);
+  updateKey();
+  reset();
+}
+
+void NSVfitRandomGenerator::setEvent(UInt_t run, UInt_t lumi, UInt_t event)
+{
+  run_ = run;
+  lumi_ = lumi;
+  event_ = event;
+  updateKey();
+  reset();
+}
+
+void NSVfitRandomGenerator::setCandidate(UInt_t candidate)
+{
+  candidate_ = candidate;
+  reset();
+}
+
+void NSVfitRandomGenerator::setStream(UInt_t stream)
+{
+  stream_ = stream;
+  updateKey();
+  reset();
+}
+
+void NSVfitRandomGenerator::updateKey()
+{
+  key_[0] = run_;
+  key_[1] = hashCombine(componentHash_, stream_);
+}
+
+void NSVfitRandomGenerator::reset()
+{
+//--- counter = (index of block of four random numbers, candidate, event, luminosity section)
+  counter_[0] = 0;
+  counter_[1] = candidate_;
+  counter_[2] = event_;
+  counter_[3] = lumi_;
+  idxBlock_ = 4;
+}
+
+void NSVfitRandomGenerator::philox4x32(const UInt_t* counter, const UInt_t* key_initial, UInt_t* result)
+{
+  UInt_t ctr[4] = { counter[0], counter[1], counter[2], counter[3] };
+  UInt_t key[2] = { key_initial[0], key_initial[1] };
+  for ( unsigned iRound = 0; iRound < philoxNumRounds; ++iRound ) {
+    UInt_t hi0, lo0, hi1, lo1;
+    mulhilo(philoxM0, ctr[0], hi0, lo0);
+    mulhilo(philoxM1, ctr[2], hi1, lo1);
+    UInt_t ctr0 = hi1^ctr[1]^key[0];
+    UInt_t ctr2 = hi0^ctr[3]^key[1];
+    ctr[0] = ctr0;
+    ctr[1] = lo1;
+    ctr[2] = ctr2;
+    ctr[3] = lo0;
+    key[0] += philoxW0;
+    key[1] += philoxW1;
+  }
+  for ( unsigned i = 0; i < 4; ++i ) {
+    result[i] = ctr[i];
+  }
+}
+
+void NSVfitRandomGenerator::generateBlock()
+{
+  philox4x32(counter_, key_, block_);
+  ++counter_[0];
+  idxBlock_ = 0;
+}
+
+UInt_t NSVfitRandomGenerator::Integer32()
+{
+  if ( idxBlock_ >= 4 ) generateBlock();
+  return block_[idxBlock_++];
+}
+
+Double_t NSVfitRandomGenerator::Rndm()
+{
+  return (Integer32() + 0.5)*twoToMinus32;
+}
+
+Double_t NSVfitRandomGenerator::Uniform(Double_t x1, Double_t x2)
+{
+  return x1 + (x2 - x1)*Rndm();
+}
+
+Double_t NSVfitRandomGenerator::Gaus(Double_t mean, Double_t sigma)
+{
+//--- Box-Muller transformation;
+//    the second random number is not cached,
+//    so that the number of values drawn per call does not depend on the call history
+  Double_t u1 = Rndm();
+  Double_t u2 = Rndm();
+  return mean + sigma*TMath::Sqrt(-2.*TMath::Log(u1))*TMath::Cos(2.*TMath::Pi()*u2);
+}
+
+Double_t NSVfitRandomGenerator::BreitWigner(Double_t mean, Double_t gamma)
+{
+  return mean + 0.5*gamma*TMath::Tan(TMath::Pi()*(Rndm() - 0.5));
+}
+
+UInt_t NSVfitRandomGenerator::hashString(const std::string& s)
+{
+//--- FNV-1a hash
+  UInt_t hash = 2166136261U;
+  for ( std::string::const_iterator c = s.begin(); c != s.end(); ++c ) {
+    hash ^= (unsigned char)(*c);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+UInt_t NSVfitRandomGenerator::hashCombine(UInt_t hash, UInt_t value)
+{
+//--- combine hash with value and apply finalization step of MurmurHash3,
+//    in order for small changes of input values to affect all bits of the result
+  UInt_t h = hash^(value + philoxW0 + (hash << 6) + (hash >> 2));
+  h ^= h >> 16;
+  h *= 0x85EBCA6B;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35;
+  h ^= h >> 16;
+  return h;
+}
@@ -3,6 +3,7 @@
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitResonanceHypothesis.h"
 #include "AnalysisDataFormats/TauAnalysis/interface/NSVfitSingleParticleHypothesis.h"
 
+#include "TauAnalysis/CandidateTools/interface/NSVfitAlgorithmBase.h"
 #include "TauAnalysis/CandidateTools/interface/svFitAuxFunctions.h"
 
 NSVfitResonanceBuilderBase::NSVfitResonanceBuilderBase(const edm::ParameterSet& cfg)
@@ -26,6 +27,7 @@ void NSVfitResonanceBuilderBase::beginJob(NSVfitAlgorithmBase* algorithm)
   for ( std::vector<NSVfitSingleParticleBuilderBase*>::iterator daughterBuilder = daughterBuilders_.begin();
 	daughterBuilder != daughterBuilders_.end(); ++daughterBuilder ) {
     (*daughterBuilder)->beginJob(algorithm);
+    (*daughterBuilder)->setTiming(algorithm->bookPluginTiming((*daughterBuilder)->pluginName(), (*daughterBuilder)->pluginType()));
   }
 }
 
@@ -88,7 +90,10 @@ bool NSVfitResonanceBuilderBase::applyFitParameter(NSVfitResonanceHypothesis* re
   bool isValidSolution = true;
 
   for ( unsigned iDaughterBuilder = 0; iDaughterBuilder < numDaughterBuilders_; ++iDaughterBuilder ) {
+    NSVfitPluginTiming* timing = daughterBuilders_[iDaughterBuilder]->timing();
+    if ( timing ) timing->start();
     isValidSolution &= daughterBuilders_[iDaughterBuilder]->applyFitParameter(resonance->daughter(iDaughterBuilder), params);
+    if ( timing ) timing->stop();
   }
 
   reco::Candidate::LorentzVector dp4(0,0,0,0);
@@ -0,0 +1,244 @@
+#include "TauAnalysis/CandidateTools/interface/NSVfitResultCache.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+  const UInt_t cacheFormatVersion = 1;
+  const size_t headerSize = 4 + sizeof(UInt_t);
+  const size_t recordHeaderSize = 2*sizeof(UInt_t);
+
+  template <typename T>
+  void appendValue(std::string& data, const T& value)
+  {
+    data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  T readValue(const char* data)
+  {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+//--- close file (releasing the lock) when leaving scope, also in case of exceptions
+  struct fileLockGuard
+  {
+    fileLockGuard(int fd) : fd_(fd) {}
+    ~fileLockGuard() { close(fd_); }
+    int fd_;
+  };
+}
+
+NSVfitResultCache::NSVfitResultCache(const std::string& fileName, bool isReadOnly)
+  : fileName_(fileName),
+    isReadOnly_(isReadOnly),
+    fileData_(0),
+    fileSize_(0),
+    mappedSize_(0),
+    numEntriesWritten_(0),
+    numHits_(0),
+    numMisses_(0)
+{
+  int fd = open(fileName_.data(), O_RDONLY);
+  if ( fd < 0 ) {
+    edm::LogInfo("NSVfitResultCache")
+      << "Cache file = " << fileName_ << " does not exist, starting with empty cache.";
+    return;
+  }
+
+  struct stat fileStatus;
+  if ( fstat(fd, &fileStatus) != 0 ) {
+    close(fd);
+    throw cms::Exception("NSVfitResultCache")
+      << "Failed to get size of cache file = " << fileName_ << " !!\n";
+  }
+  size_t mappedSize = fileStatus.st_size;
+  if ( mappedSize == 0 ) {
+    close(fd);
+    return;
+  }
+
+  void* mappedData = mmap(0, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if ( mappedData == MAP_FAILED )
+    throw cms::Exception("NSVfitResultCache")
+      << "Failed to map cache file = " << fileName_ << " into memory !!\n";
+  fileData_ = static_cast<const char*>(mappedData);
+  fileSize_ = mappedSize;
+  mappedSize_ = mappedSize;
+
+  if ( fileSize_ < headerSize || strncmp(fileData_, "SVFC", 4) != 0 )
+    throw cms::Exception("NSVfitResultCache")
+      << "File = " << fileName_ << " is not an nSVfit cache file !!\n";
+  UInt_t formatVersion = readValue<UInt_t>(fileData_ + 4);
+  if ( formatVersion != cacheFormatVersion )
+    throw cms::Exception("NSVfitResultCache")
+      << "Cache file = " << fileName_ << " has format version = " << formatVersion << ","
+      << " expected version = " << cacheFormatVersion << " !!\n";
+
+//--- build index of records
+  size_t position = headerSize;
+  while ( position < mappedSize ) {
+    if ( (mappedSize - position) < recordHeaderSize ) break;
+    UInt_t keyLength = readValue<UInt_t>(fileData_ + position);
+    UInt_t valueLength = readValue<UInt_t>(fileData_ + position + sizeof(UInt_t));
+    size_t recordSize = recordHeaderSize + (size_t)keyLength + (size_t)valueLength;
+    if ( (mappedSize - position) < recordSize ) break;
+    std::string key(fileData_ + position + recordHeaderSize, keyLength);
+    index_.insert(std::pair<ULong64_t, size_t>(hash(key), position));
+    position += recordSize;
+  }
+
+//--- ignore truncated record at end of file
+//   (in case the job writing the cache file has crashed)
+  if ( position < mappedSize ) {
+    edm::LogWarning("NSVfitResultCache")
+      << "Cache file = " << fileName_ << " ends with truncated record, " << (mappedSize - position) << " bytes ignored.";
+  }
+  fileSize_ = position;
+}
+
+NSVfitResultCache::~NSVfitResultCache()
+{
+  if ( fileData_ ) munmap(const_cast<char*>(fileData_), mappedSize_);
+}
+
+void NSVfitResultCache::write()
+{
+  if ( isReadOnly_ || numEntriesWritten_ == newEntries_.size() ) return;
+
+//--- lock cache file, in order to prevent other jobs or modules writing to the same cache file
+//    from removing the records appended by this one (and vice versa)
+  int fd = open(fileName_.data(), O_RDWR | O_CREAT, 0644);
+  if ( fd < 0 )
+    throw cms::Exception("NSVfitResultCache::write")
+      << "Failed to open cache file = " << fileName_ << " !!\n";
+  fileLockGuard fileLock(fd);
+  if ( flock(fd, LOCK_EX) != 0 )
+    throw cms::Exception("NSVfitResultCache::write")
+      << "Failed to lock cache file = " << fileName_ << " !!\n";
+
+  struct stat fileStatus;
+  if ( fstat(fd, &fileStatus) != 0 )
+    throw cms::Exception("NSVfitResultCache::write")
+      << "Failed to get size of cache file = " << fileName_ << " !!\n";
+  size_t currentSize = fileStatus.st_size;
+
+  std::string data;
+  size_t position = 0;
+  if ( currentSize == 0 ) {
+    data.append("SVFC", 4);
+    appendValue(data, cacheFormatVersion);
+  } else {
+    if ( currentSize < headerSize )
+      throw cms::Exception("NSVfitResultCache::write")
+	<< "File = " << fileName_ << " is not an nSVfit cache file !!\n";
+//--- find end of last complete record;
+//    the file may have been extended by other jobs or modules since it has been mapped into memory,
+//    but record boundaries found before stay valid, as records are only ever appended
+    position = ( fileSize_ >= headerSize && fileSize_ <= currentSize ) ? fileSize_ : headerSize;
+    while ( position < currentSize ) {
+      if ( (currentSize - position) < recordHeaderSize ) break;
+      char recordHeader[recordHeaderSize];
+      if ( pread(fd, recordHeader, recordHeaderSize, position) != (ssize_t)recordHeaderSize )
+	throw cms::Exception("NSVfitResultCache::write")
+	  << "Failed to read cache file = " << fileName_ << " !!\n";
+      size_t recordSize = recordHeaderSize 
+	+ (size_t)readValue<UInt_t>(recordHeader) + (size_t)readValue<UInt_t>(recordHeader + sizeof(UInt_t));
+      if ( (currentSize - position) < recordSize ) break;
+      position += recordSize;
+    }
+//--- remove truncated record at end of file before appending new entries
+    if ( position < currentSize ) {
+      if ( ftruncate(fd, position) != 0 )
+	throw cms::Exception("NSVfitResultCache::write")
+	  << "Failed to truncate cache file = " << fileName_ << " !!\n";
+    }
+  }
+
+  for ( unsigned iEntry = numEntriesWritten_; iEntry < newEntries_.size(); ++iEntry ) {
+    const std::string& key = newEntries_[iEntry].first;
+    const std::string& value = newEntries_[iEntry].second;
+    appendValue(data, (UInt_t)key.length());
+    appendValue(data, (UInt_t)value.length());
+    data.append(key);
+    data.append(value);
+  }
+
+  size_t numBytesWritten = 0;
+  while ( numBytesWritten < data.length() ) {
+    ssize_t numBytes = pwrite(fd, data.data() + numBytesWritten, data.length() - numBytesWritten, position + numBytesWritten);
+    if ( numBytes <= 0 )
+      throw cms::Exception("NSVfitResultCache::write")
+	<< "Failed to write entries to cache file = " << fileName_ << " !!\n";
+    numBytesWritten += numBytes;
+  }
+
+  numEntriesWritten_ = newEntries_.size();
+}
+
+bool NSVfitResultCache::find(const std::string& key, const char*& valueData, UInt_t& valueLength) const
+{
+  ULong64_t keyHash = hash(key);
+
+  typedef std::multimap<ULong64_t, size_t>::const_iterator indexIterator;
+  std::pair<indexIterator, indexIterator> records = index_.equal_range(keyHash);
+  for ( indexIterator record = records.first; record != records.second; ++record ) {
+    const char* recordData = fileData_ + record->second;
+    UInt_t keyLength = readValue<UInt_t>(recordData);
+    if ( keyLength != key.length() || memcmp(recordData + recordHeaderSize, key.data(), keyLength) != 0 ) continue;
+    valueData = recordData + recordHeaderSize + keyLength;
+    valueLength = readValue<UInt_t>(recordData + sizeof(UInt_t));
+    ++numHits_;
+    return true;
+  }
+
+  typedef std::multimap<ULong64_t, unsigned>::const_iterator newEntryIndexIterator;
+  std::pair<newEntryIndexIterator, newEntryIndexIterator> newEntries = newEntryIndex_.equal_range(keyHash);
+  for ( newEntryIndexIterator newEntry = newEntries.first; newEntry != newEntries.second; ++newEntry ) {
+    const std::pair<std::string, std::string>& entry = newEntries_[newEntry->second];
+    if ( entry.first != key ) continue;
+    valueData = entry.second.data();
+    valueLength = entry.second.length();
+    ++numHits_;
+    return true;
+  }
+
+  ++numMisses_;
+  return false;
+}
+
+void NSVfitResultCache::insert(const std::string& key, const std::string& value)
+{
+  newEntryIndex_.insert(std::pair<ULong64_t, unsigned>(hash(key), newEntries_.size()));
+  newEntries_.push_back(std::pair<std::string, std::string>(key, value));
+}
+
+ULong64_t NSVfitResultCache::hash(const std::string& key)
+{
+//--- 64-bit FNV-1a hash
+  ULong64_t hash = 14695981039346656037ULL;
+  for ( std::string::const_iterator c = key.begin(); c != key.end(); ++c ) {
+    hash ^= (unsigned char)(*c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void NSVfitResultCache::print(std::ostream& stream) const
+{
+  stream << "<NSVfitResultCache::print>:" << std::endl;
+  stream << " fileName = " << fileName_ << " (readOnly = " << isReadOnly_ << ")" << std::endl;
+  stream << " numEntries = " << numEntries() << " (new = " << newEntries_.size() << ")" << std::endl;
+  stream << " numHits = " << numHits_ << ", numMisses = " << numMisses_ << std::endl;
+}
@@ -42,6 +42,10 @@ NSVfitStandaloneAlgorithm::NSVfitStandaloneAlgorithm(std::vector<NSVfitStandalon
   fitStatus_(-1), 
   verbosity_(verbosity), 
   maxObjFunctionCalls_(5000),
+  fallbackToFit_(false),
+  isBudgetExhausted_(false),
+  isFallbackToFit_(false),
+  numIntegrandCalls_(0),
   mcObjectiveFunctionAdapter_(0),
   mcPtEtaPhiMassAdapter_(0),
   integrator2_(0),
@@ -231,7 +235,8 @@ NSVfitStandaloneAlgorithm::integrateVEGAS()
 
   // integrator instance
   //ROOT::Math::IntegratorMultiDim ig2(ROOT::Math::IntegrationMultiDim::kVEGAS, 1.e-12, 1.e-5);
-  ROOT::Math::GSLMCIntegrator ig2("vegas", 1.e-12, 1.e-5, 2000);
+  const unsigned numCallsPerMassPoint = 2000;
+  ROOT::Math::GSLMCIntegrator ig2("vegas", 1.e-12, 1.e-5, numCallsPerMassPoint);
   ROOT::Math::Functor toIntegrate(&standaloneObjectiveFunctionAdapter_, &ObjectiveFunctionAdapter::Eval, par); 
   standaloneObjectiveFunctionAdapter_.SetPar(par);
   ig2.SetFunction(toIntegrate);
@@ -242,7 +247,15 @@ NSVfitStandaloneAlgorithm::integrateVEGAS()
   double pMax = 0.;
   double mtest = measuredDiTauSystem().mass();
   bool skiphighmasstail = false;
+  massScan_.clear();
+  massScanLikelihood_.clear();
+  budget_.start();
+  isFallbackToFit_ = false;
   for(int i=0; i<100 && (!skiphighmasstail); ++i){
+    // stop scan in case time or number of likelihood evaluations exceed the budget
+    if(budget_.checkIsExhausted()){
+      break;
+    }
     standaloneObjectiveFunctionAdapter_.SetM(mtest);
     double p = -1.;
     if(par == 4){
@@ -255,6 +268,9 @@ NSVfitStandaloneAlgorithm::integrateVEGAS()
       std::cout << " >> ERROR : the nubmer of measured leptons must be 2" << std::endl;
       assert(0);
     }
+    budget_.addIntegrandCalls(numCallsPerMassPoint);
+    massScan_.push_back(mtest);
+    massScanLikelihood_.push_back(p);
     if(verbosity_>1){
       std::cout << "--> scan idx = " << i << "  mtest = " << mtest << "  p = " << p << "  pmax = " << pMax << std::endl;
     }
@@ -281,6 +297,205 @@ NSVfitStandaloneAlgorithm::integrateVEGAS()
     std::cout << "--> pmax  = " << pMax   << std::endl;
     std::cout << "--> count = " << count  << std::endl;
   }
+  isBudgetExhausted_ = budget_.isExhausted();
+  numIntegrandCalls_ = budget_.numIntegrandCalls();
+  if(isBudgetExhausted_){
+    if(verbosity_>0){
+      std::cout << "--> budget exhausted after " << budget_.numIntegrandCalls() << " likelihood evaluations" << std::endl;
+    }
+    applyFallbackToFit();
+  }
+}
+
+void
+NSVfitStandaloneAlgorithm::integrateVEGASMultiMass()
+{
+  if(verbosity_>0){
+    std::cout << "<NSVfitStandaloneAlgorithm::integrateVEGASMultiMass()>:" << std::endl;
+  }
+  // integrator instances
+  // NOTE: the likelihood is evaluated for all mass hypotheses at each point sampled by VEGAS, 
+  //       the number of likelihood evaluations is counted per mass hypothesis (as in integrateVEGAS).
+  //       The coarse integrator is used to find the mass range in which the likelihood is not negligible,
+  //       the mass hypotheses within this range are then integrated with the same number of points per mass hypothesis 
+  //       as used in integrateVEGAS. Mass hypotheses for which the likelihood is negligible compared to the most likely 
+  //       mass hypothesis are no longer evaluated (same threshold as used for skipping the high mass tail in integrateVEGAS)
+  edm::ParameterSet cfgCoarse;
+  cfgCoarse.addParameter<std::string>("name", "NSVfitStandaloneAlgorithm_coarse");
+  cfgCoarse.addParameter<unsigned>("numCallsGridOpt", 200);
+  cfgCoarse.addParameter<unsigned>("numIterGridOpt", 1);
+  cfgCoarse.addParameter<unsigned>("numCallsIntEval", 200);
+  cfgCoarse.addParameter<unsigned>("numIterIntEval", 1);
+  cfgCoarse.addParameter<int>("verbosity", ( verbosity_ > 1 ) ? 1 : 0);
+  VegasIntegrator coarseIntegrator(cfgCoarse);
+  edm::ParameterSet cfg;
+  cfg.addParameter<std::string>("name", "NSVfitStandaloneAlgorithm");
+  cfg.addParameter<double>("pruneThreshold", 1.e-3);
+  cfg.addParameter<unsigned>("numCallsGridOpt", 500);
+  cfg.addParameter<unsigned>("numIterGridOpt", 2);
+  cfg.addParameter<unsigned>("numCallsIntEval", 500);
+  cfg.addParameter<unsigned>("numIterIntEval", 2);
+  cfg.addParameter<int>("verbosity", ( verbosity_ > 1 ) ? 1 : 0);
+  VegasIntegrator integrator(cfg);
+  integrateMultiMass(coarseIntegrator, integrator);
+}
+
+void
+NSVfitStandaloneAlgorithm::integrateQMC()
+{
+  if(verbosity_>0){
+    std::cout << "<NSVfitStandaloneAlgorithm::integrateQMC()>:" << std::endl;
+  }
+  // integrator instances
+  // NOTE: same counting of likelihood evaluations, determination of mass range 
+  //       and threshold for dropping mass hypotheses as in integrateVEGASMultiMass.
+  //       Mass hypotheses are dropped once the first pair of replicas provides an uncertainty estimate;
+  //       with 4 replicas of 256 points, the number of likelihood evaluations per mass hypothesis 
+  //       is about half the number used by integrateVEGAS and integrateVEGASMultiMass
+  edm::ParameterSet cfgCoarse;
+  cfgCoarse.addParameter<std::string>("name", "NSVfitStandaloneAlgorithm_coarse");
+  cfgCoarse.addParameter<unsigned>("numPoints", 64);
+  cfgCoarse.addParameter<unsigned>("numReplicas", 2);
+  cfgCoarse.addParameter<int>("verbosity", ( verbosity_ > 1 ) ? 1 : 0);
+  QuasiMonteCarloIntegrator coarseIntegrator(cfgCoarse);
+  edm::ParameterSet cfg;
+  cfg.addParameter<std::string>("name", "NSVfitStandaloneAlgorithm");
+  cfg.addParameter<double>("pruneThreshold", 1.e-3);
+  cfg.addParameter<unsigned>("numPoints", 256);
+  cfg.addParameter<unsigned>("numReplicas", 4);
+  cfg.addParameter<int>("verbosity", ( verbosity_ > 1 ) ? 1 : 0);
+  QuasiMonteCarloIntegrator integrator(cfg);
+  integrateMultiMass(coarseIntegrator, integrator);
+}
+
+template <typename T>
+void
+NSVfitStandaloneAlgorithm::integrateMultiMass(T& coarseIntegrator, T& integrator)
+{
+  using namespace NSVfitStandalone;
+  
+  double pi = 3.14159265;
+  // number of hadrponic decays
+  int khad = 0;
+  for(unsigned int idx=0; idx<nll_->measuredTauLeptons().size(); ++idx){
+    if(nll_->measuredTauLeptons()[idx].decayType() == kHadDecay){ 
+      khad++; 
+    }
+  }
+  // number of parameters for fit
+  int par = nll_->measuredTauLeptons().size()*NSVfitStandalone::kMaxFitParams - (khad + 1);
+  // lower and upper bounds for integration, same as in integrateVEGAS
+  std::vector<double> xl;
+  std::vector<double> xu;
+  if(par == 4){
+    double xl4[4] = { 0.0, 0.0, -pi, -pi };
+    double xu4[4] = { 1.0, SVfit_namespace::tauLeptonMass, pi, pi };
+    xl.assign(xl4, xl4 + 4);
+    xu.assign(xu4, xu4 + 4);
+  } else if(par == 5){
+    double xl5[5] = { 0.0, 0.0, -pi, 0.0, -pi };
+    double xu5[5] = { 1.0, SVfit_namespace::tauLeptonMass, pi, SVfit_namespace::tauLeptonMass, pi };
+    xl.assign(xl5, xl5 + 5);
+    xu.assign(xu5, xu5 + 5);
+  } else if(par == 3){
+    double xl3[3] = { 0.0, -pi, -pi };
+    double xu3[3] = { 1.0,  pi,  pi };
+    xl.assign(xl3, xl3 + 3);
+    xu.assign(xu3, xu3 + 3);
+  } else{
+    std::cout << " >> ERROR : the nubmer of measured leptons must be 2" << std::endl;
+    assert(0);
+  }
+  // mass hypotheses, same as scanned in integrateVEGAS
+  std::vector<double> mtest;
+  double m = measuredDiTauSystem().mass();
+  for(int i=0; i<100; ++i){
+    mtest.push_back(m);
+    m += TMath::Max(2.5, 0.025*m);
+  }
+
+  nll_->addDelta(true);
+  nll_->addSinTheta(false);
+  nll_->addPhiPenalty(false);
+  isFallbackToFit_ = false;
+  budget_.start();
+  standaloneMultiMassObjectiveFunctionAdapter_.SetPar(par);
+
+  // coarse pass: integrate every 4th mass hypothesis with few points, in order to find the mass hypothesis 
+  // above the most likely one at which the likelihood becomes negligible (same threshold as in integrateVEGAS);
+  // the high mass tail beyond this mass hypothesis is not integrated in the second pass
+  const unsigned coarseMassStep = 4;
+  std::vector<double> mtestCoarse;
+  for(unsigned int i=0; i<mtest.size(); i+=coarseMassStep){
+    mtestCoarse.push_back(mtest[i]);
+  }
+  standaloneMultiMassObjectiveFunctionAdapter_.SetM(mtestCoarse);
+  coarseIntegrator.setIntegrand(standaloneMultiMassObjectiveFunctionAdapter_, mtestCoarse.size());
+  coarseIntegrator.setBudget(budget_.maxTime(), budget_.maxIntegrandCalls());
+  std::vector<double> p;
+  std::vector<double> pErr;
+  int errorFlag = 0;
+  coarseIntegrator.integrate(xl, xu, p, pErr, errorFlag);
+  budget_.addIntegrandCalls(coarseIntegrator.numIntegrandCalls());
+  if(errorFlag == 0){
+    unsigned int idxMax = 0;
+    for(unsigned int i=1; i<p.size(); ++i){
+      if(p[i]>p[idxMax]){
+	idxMax = i;
+      }
+    }
+    for(unsigned int i=idxMax+1; i<p.size(); ++i){
+      if((p[i] + 3.*pErr[i])<(1.e-3*p[idxMax])){
+	mtest.resize(i*coarseMassStep + 1);
+	break;
+      }
+    }
+  }
+  if(verbosity_>1){
+    std::cout << "--> coarse pass: " << coarseIntegrator.numIntegrandCalls() << " likelihood evaluations," 
+	      << " integrating " << mtest.size() << " mass hypotheses up to mtest = " << mtest.back() << std::endl;
+  }
+
+  // second pass: integrate mass hypotheses within range, using the remaining budget
+  if(!budget_.checkIsExhausted()){
+    double maxTime = ( budget_.maxTime() > 0. ) ? 
+      TMath::Max(budget_.maxTime() - budget_.elapsedTime(), 1.e-6) : 0.;
+    unsigned long maxIntegrandCalls = ( budget_.maxIntegrandCalls() > 0 ) ? 
+      budget_.maxIntegrandCalls() - budget_.numIntegrandCalls() : 0;
+    standaloneMultiMassObjectiveFunctionAdapter_.SetM(mtest);
+    integrator.setIntegrand(standaloneMultiMassObjectiveFunctionAdapter_, mtest.size());
+    integrator.setBudget(maxTime, maxIntegrandCalls);
+    integrator.integrate(xl, xu, p, pErr, errorFlag);
+    budget_.addIntegrandCalls(integrator.numIntegrandCalls());
+  } else{
+    // budget exhausted in coarse pass, keep result of coarse pass
+    mtest = mtestCoarse;
+  }
+  massScan_ = mtest;
+  massScanLikelihood_ = p;
+  double pMax = 0.;
+  for(unsigned int i=0; i<mtest.size(); ++i){
+    if(verbosity_>1){
+      std::cout << "--> scan idx = " << i << "  mtest = " << mtest[i] << "  p = " << p[i] << " +/- " << pErr[i] << std::endl;
+    }
+    if(p[i]>pMax){
+      mass_ = mtest[i];
+      pMax  = p[i];
+    }
+  }
+  if ( verbosity_ > 0 ) {
+    std::cout << "--> mass  = " << mass_  << std::endl;
+    std::cout << "--> pmax  = " << pMax   << std::endl;
+    std::cout << "--> likelihood evaluations = " << budget_.numIntegrandCalls() << std::endl;
+  }
+  isBudgetExhausted_ = ( budget_.isExhausted() || integrator.isBudgetExhausted() );
+  numIntegrandCalls_ = budget_.numIntegrandCalls();
+  if(isBudgetExhausted_){
+    if(verbosity_>0){
+      std::cout << "--> budget exhausted" << std::endl;
+    }
+    applyFallbackToFit();
+  }
 }
 
 void
@@ -400,8 +615,11 @@ NSVfitStandaloneAlgorithm::integrateMarkovChain()
   double integral = 0.;
   double integralErr = 0.;
   int errorFlag = 0;
-  //integrator2_->integrate(xl, xu, integral, integralErr, errorFlag, "/data1/veelken/tmp/svFitStudies/svFitStandalone/debugMarkovChain.root");
+  isFallbackToFit_ = false;
+  integrator2_->setBudget(budget_.maxTime(), budget_.maxIntegrandCalls());
   integrator2_->integrate(xl, xu, integral, integralErr, errorFlag);
+  isBudgetExhausted_ = integrator2_->isBudgetExhausted();
+  numIntegrandCalls_ = integrator2_->numIntegrandCalls();
   fitStatus_ = errorFlag;
   pt_ = mcPtEtaPhiMassAdapter_->getPt();
   ptUncert_ = mcPtEtaPhiMassAdapter_->getPtUncert();
@@ -415,4 +633,32 @@ NSVfitStandaloneAlgorithm::integrateMarkovChain()
   if(verbosity_ > 0){
     std::cout << "--> Pt = " << pt_ << ", eta = " << eta_ << ", phi = " << phi_ << ", mass  = " << mass_  << std::endl;
   }
+  if(isBudgetExhausted_){
+    if(verbosity_>0){
+      std::cout << "--> budget exhausted (errorFlag = " << errorFlag << ")" << std::endl;
+    }
+    applyFallbackToFit();
+  }
+}
+
+void
+NSVfitStandaloneAlgorithm::applyFallbackToFit()
+{
+  if(!fallbackToFit_){
+    return;
+  }
+  if(verbosity_>0){
+    std::cout << "<NSVfitStandaloneAlgorithm::applyFallbackToFit()>:" << std::endl;
+  }
+  // restore default settings of likelihood, modified by integration modes
+  nll_->addPhiPenalty(true);
+  fit();
+  // pt, eta and phi of di-tau system are taken from fit, without uncertainties
+  pt_ = fittedDiTauSystem_.pt();
+  ptUncert_ = 0.;
+  eta_ = fittedDiTauSystem_.eta();
+  etaUncert_ = 0.;
+  phi_ = fittedDiTauSystem_.phi();
+  phiUncert_ = 0.;
+  isFallbackToFit_ = true;
 }
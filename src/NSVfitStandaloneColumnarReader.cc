@@ -0,0 +1,298 @@
+#include "TauAnalysis/CandidateTools/interface/NSVfitStandaloneColumnarReader.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <TBranch.h>
+#include <TLeaf.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+  const char cacheMagic[8] = { 'S', 'V', 'F', 'I', 'T', 'C', 'O', 'L' };
+  const UInt_t cacheVersion = 2;
+
+  struct cacheHeaderType
+  {
+    char magic_[8];
+    UInt_t version_;
+    UInt_t numColumns_;
+    ULong64_t numEntries_;
+    ULong64_t dataOffset_;
+    ULong64_t inputFileSize_;
+    Long64_t inputFileModTime_;
+    ULong64_t inputFileNameSize_; // including terminating '\0'
+  };
+
+  size_t padTo8(size_t size) { return (size + 7) & ~size_t(7); }
+
+//--- absolute path of file, with symbolic links resolved
+//   (file name as given in case the file does not exist)
+  std::string getAbsolutePath(const std::string& fileName)
+  {
+    char absolutePath[PATH_MAX];
+    if ( realpath(fileName.data(), absolutePath) ) return std::string(absolutePath);
+    return fileName;
+  }
+
+//--- 64-bit FNV-1a hash
+  ULong64_t hashString64(const std::string& value)
+  {
+    ULong64_t hash = 14695981039346656037ULL;
+    for ( std::string::const_iterator c = value.begin(); c != value.end(); ++c ) {
+      hash ^= (unsigned char)(*c);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  size_t compColumnNamesSize(const std::vector<std::string>& columnNames)
+  {
+    size_t size = 0;
+    for ( std::vector<std::string>::const_iterator columnName = columnNames.begin();
+	  columnName != columnNames.end(); ++columnName ) {
+      size += columnName->size() + 1;
+    }
+    return padTo8(size);
+  }
+}
+
+NSVfitStandaloneColumnarReader::NSVfitStandaloneColumnarReader(const std::vector<std::string>& columnNames)
+  : columnNames_(columnNames),
+    numEntries_(0),
+    mappedFile_(0),
+    mappedFileSize_(0),
+    data_(0)
+{
+  if ( columnNames_.empty() )
+    throw cms::Exception("NSVfitStandaloneColumnarReader")
+      << "No columns defined !!\n";
+}
+
+NSVfitStandaloneColumnarReader::~NSVfitStandaloneColumnarReader()
+{
+  clear();
+}
+
+void NSVfitStandaloneColumnarReader::clear()
+{
+  if ( mappedFile_ ) munmap(mappedFile_, mappedFileSize_);
+  mappedFile_ = 0;
+  mappedFileSize_ = 0;
+  buffer_.clear();
+  data_ = 0;
+  numEntries_ = 0;
+}
+
+size_t NSVfitStandaloneColumnarReader::columnIndex(const std::string& columnName) const
+{
+  for ( size_t idx = 0; idx < columnNames_.size(); ++idx ) {
+    if ( columnNames_[idx] == columnName ) return idx;
+  }
+  throw cms::Exception("NSVfitStandaloneColumnarReader")
+    << "No column of name = " << columnName << " defined !!\n";
+}
+
+void NSVfitStandaloneColumnarReader::readTree(TTree* tree, Long64_t maxEntries)
+{
+  if ( !tree )
+    throw cms::Exception("NSVfitStandaloneColumnarReader")
+      << "Invalid TTree pointer !!\n";
+
+  clear();
+
+  Long64_t numEntries = tree->GetEntries();
+  if ( maxEntries >= 0 && maxEntries < numEntries ) numEntries = maxEntries;
+  numEntries_ = numEntries;
+
+  std::vector<TBranch*> branches;
+  std::vector<TLeaf*> leafs;
+  for ( std::vector<std::string>::const_iterator columnName = columnNames_.begin();
+	columnName != columnNames_.end(); ++columnName ) {
+    TBranch* branch = tree->GetBranch(columnName->data());
+    TLeaf* leaf = ( branch ) ? dynamic_cast<TLeaf*>(branch->GetListOfLeaves()->At(0)) : 0;
+    if ( !leaf )
+      throw cms::Exception("NSVfitStandaloneColumnarReader")
+	<< "No branch of name = " << (*columnName) << " found in TTree = " << tree->GetName() << " !!\n";
+    branches.push_back(branch);
+    leafs.push_back(leaf);
+  }
+
+//--- disable all branches not needed, in order to avoid decompressing them
+  tree->SetBranchStatus("*", 0);
+  for ( std::vector<std::string>::const_iterator columnName = columnNames_.begin();
+	columnName != columnNames_.end(); ++columnName ) {
+    tree->SetBranchStatus(columnName->data(), 1);
+  }
+
+//--- read each branch separately, so that baskets are decompressed sequentially
+//    and values are written into contiguous memory
+  buffer_.resize(columnNames_.size()*numEntries_);
+  for ( size_t idx = 0; idx < branches.size(); ++idx ) {
+    Float_t* column = &buffer_[idx*numEntries_];
+    for ( size_t iEntry = 0; iEntry < numEntries_; ++iEntry ) {
+      branches[idx]->GetEntry(tree->LoadTree(iEntry));
+      column[iEntry] = leafs[idx]->GetValue();
+    }
+  }
+  data_ = ( numEntries_ > 0 ) ? &buffer_[0] : 0;
+}
+
+bool NSVfitStandaloneColumnarReader::openCache(const std::string& cacheFileName, const std::string& inputFileName)
+{
+  clear();
+
+  struct stat cacheFileStat;
+  if ( stat(cacheFileName.data(), &cacheFileStat) != 0 ) return false;
+
+  size_t fileSize = cacheFileStat.st_size;
+  if ( fileSize < sizeof(cacheHeaderType) ) return false;
+
+  int fd = open(cacheFileName.data(), O_RDONLY);
+  if ( fd < 0 ) return false;
+  void* mappedFile = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if ( mappedFile == MAP_FAILED ) return false;
+
+  const char* fileContent = static_cast<const char*>(mappedFile);
+  const cacheHeaderType* header = reinterpret_cast<const cacheHeaderType*>(fileContent);
+
+  bool isValid = true;
+  if ( memcmp(header->magic_, cacheMagic, sizeof(cacheMagic)) != 0 ||
+       header->version_ != cacheVersion ||
+       header->numColumns_ != columnNames_.size() ) isValid = false;
+  if ( isValid && header->dataOffset_ + header->numColumns_*header->numEntries_*sizeof(Float_t) != fileSize ) isValid = false;
+  const char* columnNames_begin = fileContent + sizeof(cacheHeaderType) + padTo8(header->inputFileNameSize_);
+  const char* columnNames_end = fileContent + header->dataOffset_;
+  if ( isValid && (header->inputFileNameSize_ < 1 || columnNames_begin > columnNames_end) ) isValid = false;
+  if ( !isValid ) {
+    std::cout << "<NSVfitStandaloneColumnarReader::openCache>: cache file = " << cacheFileName
+	      << " has invalid format or is incompatible with requested columns --> ignoring it." << std::endl;
+    munmap(mappedFile, fileSize);
+    return false;
+  }
+
+//--- check that cache file has been written for the same input file
+  if ( inputFileName != "" ) {
+    const char* cachedInputFileName = fileContent + sizeof(cacheHeaderType);
+    std::string inputFileName_absolute = getAbsolutePath(inputFileName);
+    struct stat inputFileStat;
+    if ( stat(inputFileName.data(), &inputFileStat) != 0 ||
+	 cachedInputFileName[header->inputFileNameSize_ - 1] != '\0' ||
+	 inputFileName_absolute != cachedInputFileName ||
+	 header->inputFileSize_ != (ULong64_t)inputFileStat.st_size ||
+	 header->inputFileModTime_ != (Long64_t)inputFileStat.st_mtime ) {
+      std::cout << "<NSVfitStandaloneColumnarReader::openCache>: cache file = " << cacheFileName
+		<< " has not been written for the current version of input file = " << inputFileName_absolute << " --> ignoring it." << std::endl;
+      munmap(mappedFile, fileSize);
+      return false;
+    }
+  }
+
+  if ( isValid ) {
+    const char* columnName = columnNames_begin;
+    for ( size_t idx = 0; idx < columnNames_.size() && isValid; ++idx ) {
+      size_t length = columnNames_[idx].size();
+      if ( columnName + length >= columnNames_end || columnNames_[idx].compare(0, length, columnName, length) != 0 || columnName[length] != '\0' ) isValid = false;
+      columnName += length + 1;
+    }
+  }
+  if ( !isValid ) {
+    std::cout << "<NSVfitStandaloneColumnarReader::openCache>: cache file = " << cacheFileName
+	      << " is incompatible with requested columns --> ignoring it." << std::endl;
+    munmap(mappedFile, fileSize);
+    return false;
+  }
+
+  mappedFile_ = mappedFile;
+  mappedFileSize_ = fileSize;
+  numEntries_ = header->numEntries_;
+  data_ = reinterpret_cast<const Float_t*>(fileContent + header->dataOffset_);
+  return true;
+}
+
+void NSVfitStandaloneColumnarReader::writeCache(const std::string& cacheFileName, const std::string& inputFileName) const
+{
+  std::string inputFileName_absolute;
+  ULong64_t inputFileSize = 0;
+  Long64_t inputFileModTime = 0;
+  if ( inputFileName != "" ) {
+    struct stat inputFileStat;
+    if ( stat(inputFileName.data(), &inputFileStat) != 0 )
+      throw cms::Exception("NSVfitStandaloneColumnarReader")
+	<< "Failed to access input file = " << inputFileName << " !!\n";
+    inputFileName_absolute = getAbsolutePath(inputFileName);
+    inputFileSize = inputFileStat.st_size;
+    inputFileModTime = inputFileStat.st_mtime;
+  }
+
+//--- write to temporary file first and rename it at the end,
+//    so that concurrent jobs never see a partially written cache file
+  std::string tmpFileName = cacheFileName + ".tmp";
+  std::ofstream cacheFile(tmpFileName.data(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if ( !cacheFile )
+    throw cms::Exception("NSVfitStandaloneColumnarReader")
+      << "Failed to open cache file = " << tmpFileName << " for writing !!\n";
+
+  cacheHeaderType header;
+  memcpy(header.magic_, cacheMagic, sizeof(cacheMagic));
+  header.version_ = cacheVersion;
+  header.numColumns_ = columnNames_.size();
+  header.numEntries_ = numEntries_;
+  header.inputFileSize_ = inputFileSize;
+  header.inputFileModTime_ = inputFileModTime;
+  header.inputFileNameSize_ = inputFileName_absolute.size() + 1;
+  header.dataOffset_ = sizeof(cacheHeaderType) + padTo8(header.inputFileNameSize_) + compColumnNamesSize(columnNames_);
+  cacheFile.write(reinterpret_cast<const char*>(&header), sizeof(cacheHeaderType));
+
+  const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  cacheFile.write(inputFileName_absolute.data(), header.inputFileNameSize_); // include terminating '\0'
+  cacheFile.write(padding, padTo8(header.inputFileNameSize_) - header.inputFileNameSize_);
+
+  size_t numBytes_columnNames = 0;
+  for ( std::vector<std::string>::const_iterator columnName = columnNames_.begin();
+	columnName != columnNames_.end(); ++columnName ) {
+    cacheFile.write(columnName->data(), columnName->size() + 1); // include terminating '\0'
+    numBytes_columnNames += columnName->size() + 1;
+  }
+  cacheFile.write(padding, padTo8(numBytes_columnNames) - numBytes_columnNames);
+
+  if ( numEntries_ > 0 ) cacheFile.write(reinterpret_cast<const char*>(data_), columnNames_.size()*numEntries_*sizeof(Float_t));
+  cacheFile.close();
+  if ( !cacheFile || rename(tmpFileName.data(), cacheFileName.data()) != 0 )
+    throw cms::Exception("NSVfitStandaloneColumnarReader")
+      << "Failed to write cache file = " << cacheFileName << " !!\n";
+}
+
+void NSVfitStandaloneColumnarReader::read(TTree* tree, const std::string& inputFileName, const std::string& cacheFileName)
+{
+  if ( cacheFileName != "" && openCache(cacheFileName, inputFileName) ) return;
+  readTree(tree);
+  if ( cacheFileName != "" ) writeCache(cacheFileName, inputFileName);
+}
+
+std::string NSVfitStandaloneColumnarReader::makeCacheFileName(const std::string& directory, const std::string& inputFileName, const std::string& treeName)
+{
+//--- include hash of absolute path, so that input files of the same name in different directories
+//    are mapped to different cache files
+  std::string inputFileName_base = inputFileName;
+  size_t idx = inputFileName_base.find_last_of('/');
+  if ( idx != std::string::npos ) inputFileName_base = inputFileName_base.substr(idx + 1);
+  std::ostringstream cacheFileName;
+  if ( directory != "" ) cacheFileName << directory << "/";
+  cacheFileName << inputFileName_base << "_" << std::hex << std::setw(16) << std::setfill('0') << hashString64(getAbsolutePath(inputFileName))
+		<< std::dec << "_" << treeName << ".svfitcol";
+  return cacheFileName.str();
+}
@@ -113,29 +113,7 @@ NSVfitStandaloneLikelihood::transformint(double* xPrime, const double* x, const
       }
       ++ip;
     }
-    double labframeVisMom = measuredTauLeptons_[ idx ].momentum(); // visible momentum in lab-frame
-    double labframeVisEn  = measuredTauLeptons_[ idx ].energy();   // visible energy in lab-frame
-    double visMass        = measuredTauLeptons_[ idx ].mass();     // vis mass
-    // add protection against zero mass for visMass. If visMass is lower than the electron mass, set it
-    // to the electron mass
-    if(visMass<5.1e-4){ 
-      visMass=5.1e-4; 
-    }    
-    // momentum of visible decay products in tau lepton restframe
-    double restframeVisMom     = SVfit_namespace::pVisRestFrame(visMass, nunuMass, SVfit_namespace::tauLeptonMass);
-    // tau lepton decay angle in tau lepton restframe (as function of the energy ratio of visible decay products/tau lepton energy)
-    double restframeDecayAngle = SVfit_namespace::gjAngleFromX(labframeXFrac, visMass, restframeVisMom, labframeVisEn, SVfit_namespace::tauLeptonMass);
-    // tau lepton decay angle in labframe
-    double labframeDecayAngle  = SVfit_namespace::gjAngleToLabFrame(restframeVisMom, restframeDecayAngle, labframeVisMom);
-    // tau lepton momentum in labframe
-    double labframeTauMom      = SVfit_namespace::motherMomentumLabFrame(visMass, restframeVisMom, restframeDecayAngle, labframeVisMom, SVfit_namespace::tauLeptonMass);
-    Vector labframeTauDir      = SVfit_namespace::motherDirection(measuredTauLeptons_[idx].direction(), labframeDecayAngle, labframePhi).unit();
-    // tau lepton four vector in labframe
-    fittedDiTauSystem += SVfit_namespace::motherP4(labframeTauDir, labframeTauMom, SVfit_namespace::tauLeptonMass);
-    // fill branch-wise nll parameters
-    xPrime[ idx == 0 ? kNuNuMass1   : kNuNuMass2   ] = nunuMass;
-    xPrime[ idx == 0 ? kVisMass1    : kVisMass2    ] = visMass;
-    xPrime[ idx == 0 ? kDecayAngle1 : kDecayAngle2 ] = restframeDecayAngle;
+    fittedDiTauSystem += transformintLeg(xPrime, idx, labframeXFrac, nunuMass, labframePhi);
   }
   /*
     I believe that the following line contains a sign bug in the official version of SVfit:
@@ -180,6 +158,34 @@ NSVfitStandaloneLikelihood::transformint(double* xPrime, const double* x, const
   return xPrime;
 }
 
+LorentzVector
+NSVfitStandaloneLikelihood::transformintLeg(double* xPrime, unsigned int idx, double labframeXFrac, double nunuMass, double labframePhi) const
+{
+  double labframeVisMom = measuredTauLeptons_[ idx ].momentum(); // visible momentum in lab-frame
+  double labframeVisEn  = measuredTauLeptons_[ idx ].energy();   // visible energy in lab-frame
+  double visMass        = measuredTauLeptons_[ idx ].mass();     // vis mass
+  // add protection against zero mass for visMass. If visMass is lower than the electron mass, set it
+  // to the electron mass
+  if(visMass<5.1e-4){ 
+    visMass=5.1e-4; 
+  }    
+  // momentum of visible decay products in tau lepton restframe
+  double restframeVisMom     = SVfit_namespace::pVisRestFrame(visMass, nunuMass, SVfit_namespace::tauLeptonMass);
+  // tau lepton decay angle in tau lepton restframe (as function of the energy ratio of visible decay products/tau lepton energy)
+  double restframeDecayAngle = SVfit_namespace::gjAngleFromX(labframeXFrac, visMass, restframeVisMom, labframeVisEn, SVfit_namespace::tauLeptonMass);
+  // tau lepton decay angle in labframe
+  double labframeDecayAngle  = SVfit_namespace::gjAngleToLabFrame(restframeVisMom, restframeDecayAngle, labframeVisMom);
+  // tau lepton momentum in labframe
+  double labframeTauMom      = SVfit_namespace::motherMomentumLabFrame(visMass, restframeVisMom, restframeDecayAngle, labframeVisMom, SVfit_namespace::tauLeptonMass);
+  Vector labframeTauDir      = SVfit_namespace::motherDirection(measuredTauLeptons_[idx].direction(), labframeDecayAngle, labframePhi).unit();
+  // fill branch-wise nll parameters
+  xPrime[ idx == 0 ? kNuNuMass1   : kNuNuMass2   ] = nunuMass;
+  xPrime[ idx == 0 ? kVisMass1    : kVisMass2    ] = visMass;
+  xPrime[ idx == 0 ? kDecayAngle1 : kDecayAngle2 ] = restframeDecayAngle;
+  // tau lepton four vector in labframe
+  return SVfit_namespace::motherP4(labframeTauDir, labframeTauMom, SVfit_namespace::tauLeptonMass);
+}
+
 double
 NSVfitStandaloneLikelihood::probint(const double* x, const double mtest, const int par) const 
 {
@@ -196,6 +202,69 @@ NSVfitStandaloneLikelihood::probint(const double* x, const double mtest, const i
   }
 }
 
+void
+NSVfitStandaloneLikelihood::probint(const double* x, const std::vector<double>& mtest, const int par, double* probs, const std::vector<bool>* isActive) const 
+{
+  for(unsigned int idxMass=0; idxMass<mtest.size(); ++idxMass){
+    probs[idxMass] = 0.;
+  }
+  // in case of initialization errors don't start to do anything
+  if(error()){ return; }
+  // decode integration parameters for both decay branches (same mapping as in transformint)
+  double nunuMass[2];
+  double labframePhi[2];
+  int ip = 1;
+  for(unsigned int idx=0; idx<measuredTauLeptons_.size(); ++idx){
+    if((par == 5 || par == 4) && measuredTauLeptons_[idx].decayType() == kLepDecay){
+      nunuMass[idx] = x[ip++];
+    }
+    else{
+      nunuMass[idx] = 0.;
+    }
+    labframePhi[idx] = x[ip++];
+  }
+  double xPrime[kMaxNLLParams+2];
+  // the kinematics and the likelihood of the first decay branch do not depend on the mass hypothesis, 
+  // compute them only once
+  double labframeXFrac1 = x[0];
+  xPrime[kMaxNLLParams] = labframeXFrac1;
+  LorentzVector fittedTauLepton1 = transformintLeg(xPrime, 0, labframeXFrac1, nunuMass[0], labframePhi[0]);
+  double probTauDecay1 = probTauDecay(0, xPrime);
+  if(!(probTauDecay1 > 0.)){ return; }
+  double vmm = (measuredTauLeptons_[0].p4() + measuredTauLeptons_[1].p4()).mass();
+  Vector measuredVisP = measuredTauLeptons_[0].p() + measuredTauLeptons_[1].p();
+  for(unsigned int idxMass=0; idxMass<mtest.size(); ++idxMass){
+    if(isActive && !(*isActive)[idxMass]){
+      continue;
+    }
+    double labframeXFrac2 = pow(vmm/mtest[idxMass], 2)/labframeXFrac1;
+    if(labframeXFrac2>1.){
+      continue;
+    }
+    xPrime[kMaxNLLParams+1] = labframeXFrac2;
+    LorentzVector fittedDiTauSystem = fittedTauLepton1 + transformintLeg(xPrime, 1, labframeXFrac2, nunuMass[1], labframePhi[1]);
+    Vector fittedMET = fittedDiTauSystem.Vect() - measuredVisP; 
+    xPrime[ kDMETx   ] = measuredMET_.x() - fittedMET.x(); 
+    xPrime[ kDMETy   ] = measuredMET_.y() - fittedMET.y();
+    xPrime[ kMTauTau ] = mtest[idxMass];
+    // same terms as in prob(const double*, double), with phiPenalty = 0
+    double prob = probMET(xPrime[kDMETx], xPrime[kDMETy], covDet_, invCovMET_, metPower_, false);
+    prob *= probTauDecay1;
+    prob *= probTauDecay(1, xPrime);
+    if(addLogM_ && xPrime[kMTauTau]>0.){
+      prob *= (1.0/xPrime[kMTauTau]);
+    }
+    if(addDelta_){
+      prob *= (2.0*xPrime[kMaxNLLParams]/xPrime[kMTauTau]);
+    }
+    if(TMath::IsNaN(prob)){
+      prob = 0.;
+    }
+    probs[idxMass] = prob;
+  }
+  FIRST=false;
+}
+
 const double*
 NSVfitStandaloneLikelihood::transform(double* xPrime, const double* x) const
 {
@@ -317,19 +386,9 @@ NSVfitStandaloneLikelihood::prob(const double* xPrime, double phiPenalty) const
   }
   // add likelihoods for the decay branches
   for(unsigned int idx=0; idx<measuredTauLeptons_.size(); ++idx){
-    switch(measuredTauLeptons_[idx].decayType()){
-    case kHadDecay :
-      prob *= probTauToHadPhaseSpace(xPrime[idx==0 ? kDecayAngle1 : kDecayAngle2], xPrime[idx==0 ? kNuNuMass1 : kNuNuMass2], xPrime[idx==0 ? kVisMass1 : kVisMass2], xPrime[idx==0 ? kMaxNLLParams : (kMaxNLLParams+1)], addSinTheta_, (verbose_&& FIRST));
-      if(verbose_ && FIRST){
-	std::cout << " *probTauToHad  = " << prob << std::endl;
-      }
-      break;
-    case kLepDecay :
-      prob *= probTauToLepPhaseSpace(xPrime[idx==0 ? kDecayAngle1 : kDecayAngle2], xPrime[idx==0 ? kNuNuMass1 : kNuNuMass2], xPrime[idx==0 ? kVisMass1 : kVisMass2], xPrime[idx==0 ? kMaxNLLParams : (kMaxNLLParams+1)], addSinTheta_, (verbose_&& FIRST));
-      if(verbose_ && FIRST){
-	std::cout << " *probTauToLep  = " << prob << std::endl;
-      }
-      break;
+    prob *= probTauDecay(idx, xPrime);
+    if(verbose_ && FIRST){
+      std::cout << ( measuredTauLeptons_[idx].decayType() == kHadDecay ? " *probTauToHad  = " : " *probTauToLep  = " ) << prob << std::endl;
     }
   }
   // add additional logM term if configured such 
@@ -358,6 +417,18 @@ NSVfitStandaloneLikelihood::prob(const double* xPrime, double phiPenalty) const
   return prob;
 }
 
+double
+NSVfitStandaloneLikelihood::probTauDecay(unsigned int idx, const double* xPrime) const
+{
+  switch(measuredTauLeptons_[idx].decayType()){
+  case kHadDecay :
+    return probTauToHadPhaseSpace(xPrime[idx==0 ? kDecayAngle1 : kDecayAngle2], xPrime[idx==0 ? kNuNuMass1 : kNuNuMass2], xPrime[idx==0 ? kVisMass1 : kVisMass2], xPrime[idx==0 ? kMaxNLLParams : (kMaxNLLParams+1)], addSinTheta_, (verbose_&& FIRST));
+  case kLepDecay :
+    return probTauToLepPhaseSpace(xPrime[idx==0 ? kDecayAngle1 : kDecayAngle2], xPrime[idx==0 ? kNuNuMass1 : kNuNuMass2], xPrime[idx==0 ? kVisMass1 : kVisMass2], xPrime[idx==0 ? kMaxNLLParams : (kMaxNLLParams+1)], addSinTheta_, (verbose_&& FIRST));
+  }
+  return 0.;
+}
+
 void
 NSVfitStandaloneLikelihood::results(std::vector<LorentzVector>& fittedTauLeptons, const double* x) const
 {
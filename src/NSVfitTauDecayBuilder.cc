@@ -181,7 +181,7 @@ void NSVfitTauDecayBuilder::initialize(NSVfitTauDecayHypothesis* hypothesis, con
 
   for ( std::vector<const reco::Track*>::const_iterator track = hypothesis->selTracks_.begin();
 	track != hypothesis->selTracks_.end(); ++track ) {
-    reco::TransientTrack trajectory = trackBuilder_->build(*track);
+    reco::TransientTrack trajectory = trackService_->transientTrack(*track);
     hypothesis->selTrackTrajectories_.push_back(trajectory);
   }
 
@@ -3,10 +3,39 @@
 #include "FWCore/ServiceRegistry/interface/ActivityRegistry.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
+namespace
+{
+  size_t hashTrackPtr(const reco::Track* track)
+  {
+    // lowest bits of pointer are always zero due to alignment;
+    // mix high bits into low bits, as the table index is taken from the latter
+    size_t key = reinterpret_cast<size_t>(track) >> 3;
+    key *= static_cast<size_t>(11400714819323198485ull);
+    return key ^ (key >> 29);
+  }
+
+  // Entry published for slots in which building the TransientTrack failed
+  // (never dereferenced, only compared against)
+  const char buildFailedMarker = 0;
+  const reco::TransientTrack* const buildFailed = reinterpret_cast<const reco::TransientTrack*>(&buildFailedMarker);
+}
+
 NSVfitTrackService::NSVfitTrackService(const edm::ParameterSet& pset, edm::ActivityRegistry& reg)
-  : builder_(NULL) 
+  : builder_(NULL),
+    numArenaEntries_(0),
+    numSlotsUsed_(0)
 {
   isValid_ = false;
+  hasRefPoint_ = false;
+  // Capacity of TransientTrack cache (rounded up to power of two);
+  // the number of slots is twice the capacity, to keep probe sequences short
+  unsigned cacheCapacity = ( pset.exists("cacheCapacity") ) ? 
+    pset.getParameter<unsigned>("cacheCapacity") : 2048;
+  size_t numSlots = 2;
+  while ( numSlots < 2*cacheCapacity ) numSlots *= 2;
+  cacheTransientTrack_.resize(numSlots);
+  cacheMask_ = numSlots - 1;
+  arenaTransientTrack_.resize(numSlots);
   // Register the reset() function to be called after all modules have
   // processed the event.  This make sure the state is always consistent for
   // caller.
@@ -33,22 +62,70 @@ const SVfit::track::TrackExtrapolation& NSVfitTrackService::linearizedTrack(cons
 */
 
 void NSVfitTrackService::setup(const edm::EventSetup& es, const reco::Candidate::Point& refPoint) 
+{
+  setup(es);
+  if ( !hasRefPoint_ ) {
+    refPoint_ = AlgebraicVector3(refPoint.x(), refPoint.y(), refPoint.z());
+    hasRefPoint_ = true;
+  }
+}
+
+void NSVfitTrackService::setup(const edm::EventSetup& es) 
 {
   if ( !isValid_ ) {
     es.get<TransientTrackRecord>().get("TransientTrackBuilder", builder_);
     isValid_ = true;
-    refPoint_ = AlgebraicVector3(refPoint.x(), refPoint.y(), refPoint.z());
   }
 }
 
+const reco::TransientTrack*
+NSVfitTrackService::findOrInsertTransientTrack(const reco::Track* track) const
+{
+  size_t numSlots = cacheTransientTrack_.size();
+  size_t idx = hashTrackPtr(track) & cacheMask_;
+  for ( size_t iProbe = 0; iProbe < numSlots; ++iProbe ) {
+    TransTrackCacheSlot& slot = cacheTransientTrack_[idx];
+    const reco::Track* key = slot.key_;
+    if ( key == 0 ) {
+      // Keep load factor of hash table below 1/2
+      if ( 2*numSlotsUsed_ >= numSlots ) return 0;
+      // Try to claim the empty slot; if another thread was faster,
+      // re-examine the same slot, as it may have been claimed for the same track
+      key = __sync_val_compare_and_swap(&slot.key_, static_cast<const reco::Track*>(0), track);
+      if ( key == 0 ) {
+	__sync_fetch_and_add(&numSlotsUsed_, 1);
+	// Every claimed slot owns exactly one arena entry,
+	// so the arena (of size numSlots) can never overflow
+	size_t iEntry = __sync_fetch_and_add(&numArenaEntries_, 1);
+	try {
+	  arenaTransientTrack_[iEntry] = builder_->build(track);
+	} catch ( ... ) {
+	  // Release threads waiting for the entry, then pass the exception on;
+	  // the waiting threads build the TransientTrack without caching it
+	  __sync_synchronize();
+	  slot.entry_ = buildFailed;
+	  throw;
+	}
+	__sync_synchronize(); // make TransientTrack visible before publishing it
+	slot.entry_ = &arenaTransientTrack_[iEntry];
+	return slot.entry_;
+      }
+    }
+    if ( key == track ) {
+      // Wait for the thread that claimed the slot to publish the entry
+      const reco::TransientTrack* entry = slot.entry_;
+      while ( entry == 0 ) entry = slot.entry_;
+      return ( entry != buildFailed ) ? entry : 0;
+    }
+    idx = (idx + 1) & cacheMask_;
+  }
+  return 0;
+}
+
 reco::TransientTrack
 NSVfitTrackService::transientTrack(const reco::Track* track) const 
 {
-  // Check if we've already made it.
-  TransTrackCache::const_iterator lookup = cacheTransientTrack_.find(track);
-  if ( lookup != cacheTransientTrack_.end() ) return lookup->second;
-
-  // Build the transient track
+  // Check that the service has been set up for the current event
   if ( !isValid_ || !builder_.isValid() ) {
     throw cms::Exception("NoTransTrackBuilder")
       << "<NSVfitTrackService> The handle to the transient track builder is"
@@ -56,16 +133,31 @@ NSVfitTrackService::transientTrack(const reco::Track* track) const
       << " and that setEventSetup(es) has been called on the track service"
       << " before use.";
   }
-  reco::TransientTrack result = builder_->build(track);
-  std::pair<TransTrackCache::const_iterator, bool> insertResult =
-    cacheTransientTrack_.insert(std::make_pair(track, result));
-  assert(insertResult.second);
-  return insertResult.first->second;
+
+  // Check if we've already made it, else build it and add it to the cache
+  const reco::TransientTrack* cached = findOrInsertTransientTrack(track);
+  if ( cached ) return (*cached);
+  
+  // Cache full (or building the cached TransientTrack failed in another thread)
+  return builder_->build(track);
 }
 
 void NSVfitTrackService::reset(const edm::Event& evt, const edm::EventSetup&) 
 {
-  cacheTransientTrack_.clear();
+  size_t numEntries = numArenaEntries_;
+  for ( size_t iEntry = 0; iEntry < numEntries; ++iEntry ) {
+    arenaTransientTrack_[iEntry] = reco::TransientTrack();
+  }
+  numArenaEntries_ = 0;
+  if ( numSlotsUsed_ > 0 ) {
+    for ( std::vector<TransTrackCacheSlot>::iterator slot = cacheTransientTrack_.begin();
+	  slot != cacheTransientTrack_.end(); ++slot ) {
+      slot->key_ = 0;
+      slot->entry_ = 0;
+    }
+  }
+  numSlotsUsed_ = 0;
   cacheTrackExtrapolations_.clear();
   isValid_ = false;
+  hasRefPoint_ = false;
 }
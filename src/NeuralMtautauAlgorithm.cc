@@ -13,23 +13,43 @@
 #include <TMath.h>
 
 NeuralMtautauAlgorithm::NeuralMtautauAlgorithm(const edm::ParameterSet& cfg)
-  : mva_(0)
+  : mva_(0),
+    mlp_(0)
 {
   edm::FileInPath inputFileName = cfg.getParameter<edm::FileInPath>("inputFileName");
   if ( !inputFileName.isLocal()) throw cms::Exception("NeuralMtautauAlgorithm") 
     << " Failed to find File = " << inputFileName << " !!\n";
+
+  bool useCompiledMLP = ( cfg.exists("useCompiledMLP") ) ?
+    cfg.getParameter<bool>("useCompiledMLP") : false;
   
-  initialize(inputFileName.fullPath());
+  initialize(inputFileName.fullPath(), useCompiledMLP);
 }
 
-NeuralMtautauAlgorithm::NeuralMtautauAlgorithm(const std::string& inputFileName)
-  : mva_(0)
+NeuralMtautauAlgorithm::NeuralMtautauAlgorithm(const std::string& inputFileName, bool useCompiledMLP)
+  : mva_(0),
+    mlp_(0)
 {
-  initialize(inputFileName);
+  initialize(inputFileName, useCompiledMLP);
 }
 
-void NeuralMtautauAlgorithm::initialize(const std::string& inputFileName)
+void NeuralMtautauAlgorithm::initialize(const std::string& inputFileName, bool useCompiledMLP)
 {
+//--- read network either from TMVA weights file (XML format) 
+//    or from file written by bin/exportNeuralMtautau.cc
+  if ( useCompiledMLP ) {
+    mlp_ = new NeuralMtautauMLP();
+    if ( inputFileName.size() >= 4 && inputFileName.compare(inputFileName.size() - 4, 4, ".xml") == 0 ) 
+      mlp_->readTMVAWeightsFile(inputFileName);
+    else 
+      mlp_->readFile(inputFileName);
+    if ( mlp_->numInputs() != kNumInputs )
+      throw cms::Exception("NeuralMtautauAlgorithm") 
+	<< " Neural net read from File = " << inputFileName << " has " << mlp_->numInputs() << " inputs," 
+	<< " expected " << kNumInputs << " !!\n";
+    return;
+  }
+
   TMVA::Tools::Instance();
   
   mva_ = new TMVA::Reader("!Color:!Silent");   
@@ -52,10 +72,44 @@ void NeuralMtautauAlgorithm::initialize(const std::string& inputFileName)
 NeuralMtautauAlgorithm::~NeuralMtautauAlgorithm()
 {
   delete mva_;
+  delete mlp_;
 }
 
 double NeuralMtautauAlgorithm::operator()(const reco::Candidate::LorentzVector& leg1P4, const reco::Candidate::LorentzVector& leg2P4, 
 					  double metPx, double metPy, const TMatrixD& metCov)
+{
+  Float_t inputs[kNumInputs];
+  compInputVariables(leg1P4, leg2P4, metPx, metPy, metCov, inputs);
+
+//--- compute & return neural net output
+  if ( mlp_ ) return mlp_->evaluate(inputs);
+
+//--- set neural net input variables
+  recLeg1Px_    = inputs[0];
+  recLeg1Py_    = inputs[1];
+  recLeg1Pz_    = inputs[2];
+  recLeg2Px_    = inputs[3];
+  recLeg2Py_    = inputs[4];
+  recLeg2Pz_    = inputs[5];
+  recMEtPx_     = inputs[6];
+  recMEtPy_     = inputs[7];
+  recMEtSigmaX_ = inputs[8];
+  recMEtSigmaY_ = inputs[9];
+  recMEtCorrXY_ = inputs[10];
+
+  return mva_->EvaluateRegression("trainNeuralMtautau")[0];
+}
+
+void NeuralMtautauAlgorithm::evaluate(const Float_t* inputs, size_t numCandidates, Float_t* outputs) const
+{
+  if ( !mlp_ )
+    throw cms::Exception("NeuralMtautauAlgorithm::evaluate") 
+      << "Batch evaluation requires 'useCompiledMLP' mode !!\n";
+  mlp_->evaluate(inputs, numCandidates, outputs);
+}
+
+void NeuralMtautauAlgorithm::compInputVariables(const reco::Candidate::LorentzVector& leg1P4, const reco::Candidate::LorentzVector& leg2P4, 
+						double metPx, double metPy, const TMatrixD& metCov, Float_t* inputs)
 {
 //--- compute axis 'zeta' bisecting angle between visible decay products of the two tau leptons
   double zetaPhi = compZetaPhi(leg1P4, leg2P4);
@@ -76,19 +130,17 @@ double NeuralMtautauAlgorithm::operator()(const reco::Candidate::LorentzVector&
     covInZetaFrame(0,1)/(sigmaXinZetaFrame*sigmaYinZetaFrame) : 0.;		
 
 //--- set neural net input variables
-  recLeg1Px_    = leg1P4.px();
-  recLeg1Py_    = leg1P4.py();
-  recLeg1Pz_    = leg1P4.pz();
-  recLeg2Px_    = leg2P4.px();
-  recLeg2Py_    = leg2P4.py();
-  recLeg2Pz_    = leg2P4.pz();
-  recMEtPx_     = metPx;
-  recMEtPy_     = metPy; 
-  recMEtSigmaX_ = sigmaXinZetaFrame;
-  recMEtSigmaY_ = sigmaYinZetaFrame;
-  recMEtCorrXY_ = corrXYinZetaFrame;
-
-//--- compute & return neural net output
-  return mva_->EvaluateRegression("trainNeuralMtautau")[0];
+//    (order needs to match order of variables in initialize)
+  inputs[0]  = leg1P4.px();
+  inputs[1]  = leg1P4.py();
+  inputs[2]  = leg1P4.pz();
+  inputs[3]  = leg2P4.px();
+  inputs[4]  = leg2P4.py();
+  inputs[5]  = leg2P4.pz();
+  inputs[6]  = metPx;
+  inputs[7]  = metPy; 
+  inputs[8]  = sigmaXinZetaFrame;
+  inputs[9]  = sigmaYinZetaFrame;
+  inputs[10] = corrXYinZetaFrame;
 }
 
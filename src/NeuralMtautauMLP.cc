@@ -0,0 +1,443 @@
+#include "TauAnalysis/CandidateTools/interface/NeuralMtautauMLP.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <TXMLEngine.h>
+#include <TMath.h>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+  // number of events for which the network is evaluated simultaneously by the batch evaluation;
+  // the activations of all events in a block are stored next to each other,
+  // so that the innermost loop runs over events and can be vectorized by the compiler
+  const size_t blockSize = 16;
+
+//-------------------------------------------------------------------------------
+// auxiliary functions for accessing the XML elements of TMVA weights files,
+// read by the same XML engine (TXMLEngine) as used by TMVA itself
+//-------------------------------------------------------------------------------
+
+  XMLNodePointer_t findChild(TXMLEngine& xml, XMLNodePointer_t node, const std::string& name)
+  {
+    for ( XMLNodePointer_t child = xml.GetChild(node); child; child = xml.GetNext(child) ) {
+      if ( name == xml.GetNodeName(child) ) return child;
+    }
+    return 0;
+  }
+
+  XMLNodePointer_t getChild(TXMLEngine& xml, XMLNodePointer_t node, const std::string& name)
+  {
+    XMLNodePointer_t retVal = findChild(xml, node, name);
+    if ( !retVal )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "No element <" << name << "> found in element <" << xml.GetNodeName(node) << "> !!\n";
+    return retVal;
+  }
+
+  std::vector<XMLNodePointer_t> getChildren(TXMLEngine& xml, XMLNodePointer_t node, const std::string& name)
+  {
+    std::vector<XMLNodePointer_t> retVal;
+    for ( XMLNodePointer_t child = xml.GetChild(node); child; child = xml.GetNext(child) ) {
+      if ( name == xml.GetNodeName(child) ) retVal.push_back(child);
+    }
+    return retVal;
+  }
+
+  std::string getAttribute(TXMLEngine& xml, XMLNodePointer_t node, const std::string& name)
+  {
+    const char* retVal = xml.GetAttr(node, name.data());
+    if ( !retVal )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "No attribute '" << name << "' found in element <" << xml.GetNodeName(node) << "> !!\n";
+    return retVal;
+  }
+
+  std::string getContent(TXMLEngine& xml, XMLNodePointer_t node)
+  {
+    const char* retVal = xml.GetNodeContent(node);
+    return ( retVal ) ? retVal : "";
+  }
+
+//--- release XML document in case an exception is thrown while reading it
+  struct xmlDocumentGuard
+  {
+    xmlDocumentGuard(TXMLEngine& xml, XMLDocPointer_t document)
+      : xml_(xml),
+	document_(document)
+    {}
+    ~xmlDocumentGuard() { xml_.FreeDoc(document_); }
+    TXMLEngine& xml_;
+    XMLDocPointer_t document_;
+  };
+
+  template <typename T>
+  T convert(const std::string& value)
+  {
+    std::istringstream stream(value);
+    T retVal;
+    stream >> retVal;
+    if ( stream.fail() )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "Failed to convert '" << value << "' to number !!\n";
+    return retVal;
+  }
+
+  bool isSpace(char c) { return (c == ' ' || c == '\t' || c == '\n' || c == '\r'); }
+
+  std::string trim(const std::string& value)
+  {
+    size_t first = 0;
+    while ( first < value.size() && isSpace(value[first]) ) ++first;
+    size_t last = value.size();
+    while ( last > first && isSpace(value[last - 1]) ) --last;
+    return value.substr(first, last - first);
+  }
+
+  std::string getOption(TXMLEngine& xml, XMLNodePointer_t methodSetup, const std::string& name, const std::string& defaultValue)
+  {
+    XMLNodePointer_t options = findChild(xml, methodSetup, "Options");
+    if ( options ) {
+      std::vector<XMLNodePointer_t> optionList = getChildren(xml, options, "Option");
+      for ( std::vector<XMLNodePointer_t>::const_iterator option = optionList.begin();
+	    option != optionList.end(); ++option ) {
+	if ( xml.HasAttr(*option, "name") && getAttribute(xml, *option, "name") == name ) return trim(getContent(xml, *option));
+      }
+    }
+    return defaultValue;
+  }
+
+  int getActivation(const std::string& neuronType)
+  {
+    if      ( neuronType == "linear"  ) return NeuralMtautauMLP::kLinear;
+    else if ( neuronType == "tanh"    ) return NeuralMtautauMLP::kTanh;
+    else if ( neuronType == "sigmoid" ) return NeuralMtautauMLP::kSigmoid;
+    else if ( neuronType == "radial"  ) return NeuralMtautauMLP::kRadial;
+    else throw cms::Exception("NeuralMtautauMLP")
+      << "Neuron type = " << neuronType << " not supported !!\n";
+  }
+
+  inline double activate(int activation, double x)
+  {
+    switch ( activation ) {
+    case NeuralMtautauMLP::kTanh:
+      return TMath::TanH(x);
+    case NeuralMtautauMLP::kSigmoid:
+      return 1./(1. + TMath::Exp(-x));
+    case NeuralMtautauMLP::kRadial:
+      return TMath::Exp(-0.5*x*x);
+    default:
+      return x;
+    }
+  }
+
+//--- variable transformation performed in single precision, as done by TMVA
+  inline Float_t normalize(Float_t value, Float_t min, Float_t max)
+  {
+    Float_t offset = min;
+    Float_t scale = 1.0/(max - min);
+    return (value - offset)*scale*2 - 1;
+  }
+
+  inline Float_t denormalize(Float_t value, Float_t min, Float_t max)
+  {
+    Float_t offset = min;
+    Float_t scale = 1.0/(max - min);
+    return offset + ((value + 1)/(scale*2));
+  }
+}
+
+NeuralMtautauMLP::NeuralMtautauMLP()
+  : numInputs_(0),
+    hasNormalization_(false),
+    targetMin_(0.),
+    targetMax_(0.),
+    maxNumNeurons_(0)
+{}
+
+NeuralMtautauMLP::~NeuralMtautauMLP()
+{
+// nothing to be done yet...
+}
+
+void NeuralMtautauMLP::readTMVAWeightsFile(const std::string& inputFileName)
+{
+  TXMLEngine xml;
+  XMLDocPointer_t document = xml.ParseFile(inputFileName.data());
+  if ( !document )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Failed to parse file = " << inputFileName << " !!\n";
+  xmlDocumentGuard documentGuard(xml, document);
+  XMLNodePointer_t methodSetup = xml.DocGetRootElement(document);
+  if ( !methodSetup || std::string(xml.GetNodeName(methodSetup)) != "MethodSetup" ||
+       getAttribute(xml, methodSetup, "Method").find("MLP") != 0 )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "File = " << inputFileName << " does not contain weights of TMVA MLP !!\n";
+
+  if ( getOption(xml, methodSetup, "NeuronInputType", "sum") != "sum" )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Neuron input type = " << getOption(xml, methodSetup, "NeuronInputType", "sum") << " not supported !!\n";
+  int hiddenActivation = getActivation(getOption(xml, methodSetup, "NeuronType", "sigmoid"));
+  int outputActivation = ( getOption(xml, methodSetup, "EstimatorType", "MSE") == "CE" ) ? kSigmoid : kLinear;
+
+  XMLNodePointer_t variables = getChild(xml, methodSetup, "Variables");
+  unsigned numVariables = convert<unsigned>(getAttribute(xml, variables, "NVar"));
+  unsigned numTargets = convert<unsigned>(getAttribute(xml, getChild(xml, methodSetup, "Targets"), "NTrgt"));
+  if ( numTargets != 1 )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Regression with " << numTargets << " targets not supported !!\n";
+  numInputs_ = numVariables;
+
+//--- read expressions of input variables, in the order expected by the network
+  inputExpressions_.clear();
+  std::vector<XMLNodePointer_t> variableList = getChildren(xml, variables, "Variable");
+  if ( variableList.size() != numVariables )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Number of variables = " << variableList.size() << " does not match NVar = " << numVariables << " !!\n";
+  for ( std::vector<XMLNodePointer_t>::const_iterator variable = variableList.begin();
+	variable != variableList.end(); ++variable ) {
+    inputExpressions_.push_back(getAttribute(xml, *variable, "Expression"));
+  }
+
+//--- read variable transformation
+  hasNormalization_ = false;
+  inputMin_.clear();
+  inputMax_.clear();
+  XMLNodePointer_t transformations = findChild(xml, methodSetup, "Transformations");
+  std::vector<XMLNodePointer_t> transformList;
+  if ( transformations ) transformList = getChildren(xml, transformations, "Transform");
+  if ( transformList.size() > 1 )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "More than one variable transformation not supported !!\n";
+  if ( transformList.size() == 1 ) {
+    XMLNodePointer_t transform = transformList.front();
+    if ( getAttribute(xml, transform, "Name") != "Normalize" )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "Variable transformation = " << getAttribute(xml, transform, "Name") << " not supported !!\n";
+    XMLNodePointer_t selection = findChild(xml, transform, "Selection");
+    if ( selection ) {
+      std::vector<XMLNodePointer_t> inputs = getChildren(xml, getChild(xml, selection, "Input"), "Input");
+      bool isValid = (inputs.size() == (numVariables + numTargets));
+      for ( unsigned idx = 0; idx < inputs.size() && isValid; ++idx ) {
+	if ( getAttribute(xml, inputs[idx], "Type") != (( idx < numVariables ) ? "Variable" : "Target") ) isValid = false;
+      }
+      if ( !isValid )
+	throw cms::Exception("NeuralMtautauMLP")
+	  << "Variable transformation needs to be applied to all variables and targets !!\n";
+    }
+//--- use ranges computed for all classes, which are stored last
+    std::vector<XMLNodePointer_t> classes = getChildren(xml, transform, "Class");
+    if ( classes.empty() )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "No ranges defined for variable transformation !!\n";
+    std::vector<XMLNodePointer_t> ranges = getChildren(xml, getChild(xml, classes.back(), "Ranges"), "Range");
+    if ( ranges.size() != (numVariables + numTargets) )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "Number of ranges = " << ranges.size() << " does not match number of variables and targets !!\n";
+    inputMin_.resize(numVariables);
+    inputMax_.resize(numVariables);
+    for ( std::vector<XMLNodePointer_t>::const_iterator range = ranges.begin();
+	  range != ranges.end(); ++range ) {
+      unsigned idx = convert<unsigned>(getAttribute(xml, *range, "Index"));
+      Float_t min = convert<Float_t>(getAttribute(xml, *range, "Min"));
+      Float_t max = convert<Float_t>(getAttribute(xml, *range, "Max"));
+      if ( idx < numVariables ) {
+	inputMin_[idx] = min;
+	inputMax_[idx] = max;
+      } else if ( idx == numVariables ) {
+	targetMin_ = min;
+	targetMax_ = max;
+      } else {
+	throw cms::Exception("NeuralMtautauMLP")
+	  << "Invalid range index = " << idx << " !!\n";
+      }
+    }
+    hasNormalization_ = true;
+  }
+
+//--- read network weights;
+//    TMVA stores for each neuron the weights of synapses to the neurons in the next layer,
+//    with the bias neuron stored last in each layer but the output layer
+  std::vector<XMLNodePointer_t> layers = getChildren(xml, getChild(xml, getChild(xml, methodSetup, "Weights"), "Layout"), "Layer");
+  if ( layers.size() < 2 )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Network needs to have at least two layers !!\n";
+  layers_.clear();
+  maxNumNeurons_ = 0;
+  for ( unsigned iLayer = 0; iLayer < (layers.size() - 1); ++iLayer ) {
+    std::vector<XMLNodePointer_t> neurons = getChildren(xml, layers[iLayer], "Neuron");
+    unsigned numNeurons_next = convert<unsigned>(getAttribute(xml, layers[iLayer + 1], "NNeurons"));
+    bool isOutputLayer = (iLayer == (layers.size() - 2));
+    layerType layer;
+    layer.numInputs_ = neurons.size() - 1;
+    layer.numOutputs_ = ( isOutputLayer ) ? numNeurons_next : numNeurons_next - 1;
+    layer.activation_ = ( isOutputLayer ) ? outputActivation : hiddenActivation;
+    if ( iLayer == 0 && layer.numInputs_ != numInputs_ )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "Number of input neurons = " << layer.numInputs_ << " does not match number of variables = " << numInputs_ << " !!\n";
+    if ( isOutputLayer && layer.numOutputs_ != 1 )
+      throw cms::Exception("NeuralMtautauMLP")
+	<< "Number of output neurons = " << layer.numOutputs_ << " not supported !!\n";
+    layer.weights_.resize(layer.numOutputs_*(layer.numInputs_ + 1));
+    for ( unsigned iNeuron = 0; iNeuron < neurons.size(); ++iNeuron ) {
+      std::istringstream weights(getContent(xml, neurons[iNeuron]));
+      for ( unsigned iSynapse = 0; iSynapse < layer.numOutputs_; ++iSynapse ) {
+	double weight;
+	weights >> weight;
+	if ( weights.fail() )
+	  throw cms::Exception("NeuralMtautauMLP")
+	    << "Failed to read weights of neuron #" << iNeuron << " in layer #" << iLayer << " !!\n";
+	layer.weights_[iSynapse*(layer.numInputs_ + 1) + iNeuron] = weight;
+      }
+    }
+    if ( layer.numInputs_ > maxNumNeurons_ ) maxNumNeurons_ = layer.numInputs_;
+    if ( layer.numOutputs_ > maxNumNeurons_ ) maxNumNeurons_ = layer.numOutputs_;
+    layers_.push_back(layer);
+  }
+}
+
+void NeuralMtautauMLP::readFile(const std::string& inputFileName)
+{
+  std::ifstream inputFile(inputFileName.data());
+  if ( !inputFile )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Failed to open file = " << inputFileName << " !!\n";
+
+  std::string keyword;
+  unsigned version = 0;
+  inputFile >> keyword >> version;
+  if ( keyword != "NeuralMtautauMLP" || version != 1 )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "File = " << inputFileName << " is not in NeuralMtautauMLP format !!\n";
+
+  unsigned numLayers = 0;
+  inputFile >> keyword >> numInputs_ >> hasNormalization_ >> numLayers;
+  inputMin_.resize(numInputs_);
+  inputMax_.resize(numInputs_);
+  if ( hasNormalization_ ) {
+    for ( unsigned idx = 0; idx < numInputs_; ++idx ) {
+      inputFile >> inputMin_[idx] >> inputMax_[idx];
+    }
+    inputFile >> targetMin_ >> targetMax_;
+  }
+  layers_.resize(numLayers);
+  maxNumNeurons_ = 0;
+  for ( unsigned iLayer = 0; iLayer < numLayers; ++iLayer ) {
+    layerType& layer = layers_[iLayer];
+    inputFile >> keyword >> layer.numInputs_ >> layer.numOutputs_ >> layer.activation_;
+    layer.weights_.resize(layer.numOutputs_*(layer.numInputs_ + 1));
+    for ( std::vector<double>::iterator weight = layer.weights_.begin();
+	  weight != layer.weights_.end(); ++weight ) {
+      inputFile >> (*weight);
+    }
+    if ( layer.numInputs_ > maxNumNeurons_ ) maxNumNeurons_ = layer.numInputs_;
+    if ( layer.numOutputs_ > maxNumNeurons_ ) maxNumNeurons_ = layer.numOutputs_;
+  }
+  if ( inputFile.fail() || numLayers == 0 || layers_.front().numInputs_ != numInputs_ || layers_.back().numOutputs_ != 1 )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Failed to read network from file = " << inputFileName << " !!\n";
+}
+
+void NeuralMtautauMLP::writeFile(const std::string& outputFileName) const
+{
+  std::ofstream outputFile(outputFileName.data());
+  if ( !outputFile )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Failed to open file = " << outputFileName << " for writing !!\n";
+
+//--- write numbers with sufficient precision to restore them exactly
+  outputFile << "NeuralMtautauMLP 1" << std::endl;
+  outputFile << "network " << numInputs_ << " " << hasNormalization_ << " " << layers_.size() << std::endl;
+  if ( hasNormalization_ ) {
+    outputFile << std::setprecision(9);
+    for ( unsigned idx = 0; idx < numInputs_; ++idx ) {
+      outputFile << inputMin_[idx] << " " << inputMax_[idx] << std::endl;
+    }
+    outputFile << targetMin_ << " " << targetMax_ << std::endl;
+  }
+  outputFile << std::setprecision(17);
+  for ( std::vector<layerType>::const_iterator layer = layers_.begin();
+	layer != layers_.end(); ++layer ) {
+    outputFile << "layer " << layer->numInputs_ << " " << layer->numOutputs_ << " " << layer->activation_ << std::endl;
+    for ( unsigned iOutput = 0; iOutput < layer->numOutputs_; ++iOutput ) {
+      for ( unsigned iInput = 0; iInput <= layer->numInputs_; ++iInput ) {
+	outputFile << " " << layer->weights_[iOutput*(layer->numInputs_ + 1) + iInput];
+      }
+      outputFile << std::endl;
+    }
+  }
+  if ( !outputFile )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Failed to write network to file = " << outputFileName << " !!\n";
+}
+
+void NeuralMtautauMLP::evaluateBlock(const Float_t* inputs, size_t numEvents, Float_t* outputs,
+				     std::vector<double>& current, std::vector<double>& next) const
+{
+//--- activations are stored as (neuron, event) matrix, with the bias neuron (value 1) stored last
+  for ( unsigned iInput = 0; iInput < numInputs_; ++iInput ) {
+    double* current_row = &current[iInput*blockSize];
+    for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+      Float_t value = inputs[iEvent*numInputs_ + iInput];
+      if ( hasNormalization_ ) value = normalize(value, inputMin_[iInput], inputMax_[iInput]);
+      current_row[iEvent] = value;
+    }
+  }
+  for ( std::vector<layerType>::const_iterator layer = layers_.begin();
+	layer != layers_.end(); ++layer ) {
+    double* bias_row = &current[layer->numInputs_*blockSize];
+    for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+      bias_row[iEvent] = 1.;
+    }
+    for ( unsigned iOutput = 0; iOutput < layer->numOutputs_; ++iOutput ) {
+      const double* weights = &layer->weights_[iOutput*(layer->numInputs_ + 1)];
+      double* next_row = &next[iOutput*blockSize];
+      for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+	next_row[iEvent] = 0.;
+      }
+      for ( unsigned iInput = 0; iInput <= layer->numInputs_; ++iInput ) {
+	double weight = weights[iInput];
+	const double* current_row = &current[iInput*blockSize];
+	for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+	  next_row[iEvent] += weight*current_row[iEvent];
+	}
+      }
+      if ( layer->activation_ != kLinear ) {
+	for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+	  next_row[iEvent] = activate(layer->activation_, next_row[iEvent]);
+	}
+      }
+    }
+    current.swap(next);
+  }
+  for ( size_t iEvent = 0; iEvent < numEvents; ++iEvent ) {
+    Float_t value = current[iEvent];
+    if ( hasNormalization_ ) value = denormalize(value, targetMin_, targetMax_);
+    outputs[iEvent] = value;
+  }
+}
+
+Float_t NeuralMtautauMLP::evaluate(const Float_t* inputs) const
+{
+  Float_t output;
+  evaluate(inputs, 1, &output);
+  return output;
+}
+
+void NeuralMtautauMLP::evaluate(const Float_t* inputs, size_t numEvents, Float_t* outputs) const
+{
+  if ( layers_.empty() )
+    throw cms::Exception("NeuralMtautauMLP")
+      << "Network not initialized !!\n";
+
+//--- buffers are allocated per call, in order to keep the evaluation reentrant
+  std::vector<double> current((maxNumNeurons_ + 1)*blockSize);
+  std::vector<double> next((maxNumNeurons_ + 1)*blockSize);
+  for ( size_t iEvent = 0; iEvent < numEvents; iEvent += blockSize ) {
+    size_t numEvents_block = TMath::Min(blockSize, numEvents - iEvent);
+    evaluateBlock(inputs + iEvent*numInputs_, numEvents_block, outputs + iEvent, current, next);
+  }
+}
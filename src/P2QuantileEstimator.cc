@@ -0,0 +1,201 @@
+#include "TauAnalysis/CandidateTools/interface/P2QuantileEstimator.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <TMath.h>
+
+#include <algorithm>
+
+namespace
+{
+  void addProbability(std::vector<double>& probabilities, double probability)
+  {
+    for ( std::vector<double>::const_iterator it = probabilities.begin();
+	  it != probabilities.end(); ++it ) {
+      if ( TMath::Abs((*it) - probability) < 1.e-6 ) return;
+    }
+    probabilities.push_back(probability);
+  }
+
+  double interpolateParabolic(double x1, double y1, double x2, double y2, double x3, double y3)
+  {
+//--- compute position of extremum of parabola through three points;
+//    (x2, y2) is expected to be the point with the highest y
+    double xMinus = x1 - x2;
+    double yMinus = y1 - y2;
+    double xPlus  = x3 - x2;
+    double yPlus  = y3 - y2;
+    double denominator = yPlus*xMinus - yMinus*xPlus;
+    if ( denominator == 0. ) return x2;
+    return x2 + 0.5*(yPlus*xMinus*xMinus - yMinus*xPlus*xPlus)/denominator;
+  }
+}
+
+P2QuantileEstimator::P2QuantileEstimator(const std::vector<double>& probabilities, unsigned numGridPoints)
+{
+  std::vector<double> quantiles;
+  for ( std::vector<double>::const_iterator probability = probabilities.begin();
+	probability != probabilities.end(); ++probability ) {
+    if ( !((*probability) > 0. && (*probability) < 1.) )
+      throw cms::Exception("P2QuantileEstimator")
+	<< "Invalid probability = " << (*probability) << ", values within interval ]0..1[ expected !!\n";
+    addProbability(quantiles, *probability);
+  }
+  std::sort(quantiles.begin(), quantiles.end());
+
+//--- place markers at minimum, maximum, each quantile and in between neighbouring quantiles
+  addProbability(probabilities_, 0.);
+  addProbability(probabilities_, 1.);
+  double previousQuantile = 0.;
+  for ( std::vector<double>::const_iterator quantile = quantiles.begin();
+	quantile != quantiles.end(); ++quantile ) {
+    addProbability(probabilities_, 0.5*(previousQuantile + (*quantile)));
+    addProbability(probabilities_, *quantile);
+    previousQuantile = (*quantile);
+  }
+  addProbability(probabilities_, 0.5*(previousQuantile + 1.));
+
+//--- add markers at equidistant probabilities
+  for ( unsigned iGridPoint = 1; iGridPoint <= numGridPoints; ++iGridPoint ) {
+    addProbability(probabilities_, iGridPoint/(numGridPoints + 1.));
+  }
+
+  std::sort(probabilities_.begin(), probabilities_.end());
+  numMarkers_ = probabilities_.size();
+
+  heights_.resize(numMarkers_);
+  positions_.resize(numMarkers_);
+  desiredPositions_.resize(numMarkers_);
+
+  reset();
+}
+
+void P2QuantileEstimator::reset()
+{
+  numEntries_ = 0;
+  sum_ = 0.;
+}
+
+void P2QuantileEstimator::fill(double x)
+{
+  sum_ += x;
+
+//--- collect first numMarkers values
+  if ( numEntries_ < numMarkers_ ) {
+    heights_[numEntries_] = x;
+    ++numEntries_;
+    if ( numEntries_ == numMarkers_ ) {
+      std::sort(heights_.begin(), heights_.end());
+      for ( unsigned iMarker = 0; iMarker < numMarkers_; ++iMarker ) {
+	positions_[iMarker] = iMarker;
+	desiredPositions_[iMarker] = probabilities_[iMarker]*(numMarkers_ - 1);
+      }
+    }
+    return;
+  }
+
+//--- find cell containing new value, update minimum and maximum
+  unsigned idxCell;
+  if ( x < heights_[0] ) {
+    heights_[0] = x;
+    idxCell = 0;
+  } else if ( x >= heights_[numMarkers_ - 1] ) {
+    heights_[numMarkers_ - 1] = x;
+    idxCell = numMarkers_ - 2;
+  } else {
+    idxCell = std::upper_bound(heights_.begin(), heights_.end(), x) - heights_.begin() - 1;
+  }
+  ++numEntries_;
+
+//--- shift positions of markers above new value
+  for ( unsigned iMarker = idxCell + 1; iMarker < numMarkers_; ++iMarker ) {
+    positions_[iMarker] += 1.;
+  }
+  for ( unsigned iMarker = 0; iMarker < numMarkers_; ++iMarker ) {
+    desiredPositions_[iMarker] += probabilities_[iMarker];
+  }
+
+//--- adjust heights of markers that deviate from their desired positions,
+//    using piecewise parabolic interpolation (linear interpolation if parabolic prediction is not monotonic)
+  for ( unsigned iMarker = 1; iMarker < (numMarkers_ - 1); ++iMarker ) {
+    double d = desiredPositions_[iMarker] - positions_[iMarker];
+    double dPositionPlus  = positions_[iMarker + 1] - positions_[iMarker];
+    double dPositionMinus = positions_[iMarker - 1] - positions_[iMarker];
+    if ( (d >= 1. && dPositionPlus > 1.) || (d <= -1. && dPositionMinus < -1.) ) {
+      double s = ( d >= 0. ) ? +1. : -1.;
+      double height = heights_[iMarker];
+      double heightPlus = heights_[iMarker + 1];
+      double heightMinus = heights_[iMarker - 1];
+      double heightParabolic = height
+	+ s/(dPositionPlus - dPositionMinus)*((s - dPositionMinus)*(heightPlus - height)/dPositionPlus
+					      + (dPositionPlus - s)*(height - heightMinus)/(-dPositionMinus));
+      if ( heightParabolic > heightMinus && heightParabolic < heightPlus ) {
+	heights_[iMarker] = heightParabolic;
+      } else if ( s > 0. ) {
+	heights_[iMarker] = height + (heightPlus - height)/dPositionPlus;
+      } else {
+	heights_[iMarker] = height - (heightMinus - height)/dPositionMinus;
+      }
+      positions_[iMarker] += s;
+    }
+  }
+}
+
+double P2QuantileEstimator::quantile(double probability) const
+{
+  if ( numEntries_ == 0 ) return 0.;
+
+//--- compute quantile from stored values, in case less than numMarkers values have been filled
+  if ( numEntries_ < numMarkers_ ) {
+    std::vector<double> values(heights_.begin(), heights_.begin() + numEntries_);
+    std::sort(values.begin(), values.end());
+    double idx = probability*(numEntries_ - 1);
+    unsigned idxLow = TMath::FloorNint(idx);
+    if ( idxLow >= (numEntries_ - 1) ) return values.back();
+    return values[idxLow] + (idx - idxLow)*(values[idxLow + 1] - values[idxLow]);
+  }
+
+  if ( probability <= 0. ) return heights_.front();
+  if ( probability >= 1. ) return heights_.back();
+  unsigned idxUp = std::lower_bound(probabilities_.begin(), probabilities_.end(), probability) - probabilities_.begin();
+  if ( TMath::Abs(probabilities_[idxUp] - probability) < 1.e-6 ) return heights_[idxUp];
+  unsigned idxLow = idxUp - 1;
+  return heights_[idxLow]
+    + (probability - probabilities_[idxLow])/(probabilities_[idxUp] - probabilities_[idxLow])*(heights_[idxUp] - heights_[idxLow]);
+}
+
+double P2QuantileEstimator::mode() const
+{
+  if ( numEntries_ < numMarkers_ ) return quantile(0.5);
+
+//--- compute density in windows of neighbouring markers, each window covering a probability of at least modeWindow;
+//    the density is computed for windows instead of single cells between neighbouring markers,
+//    as the latter fluctuate strongly in case the number of markers is large
+  const double modeWindow = 0.10;
+  std::vector<double> windowCenters;
+  std::vector<double> windowDensities;
+  unsigned idxMaximum = 0;
+  unsigned idxUp = 1;
+  for ( unsigned idxLow = 0; idxLow < (numMarkers_ - 1); ++idxLow ) {
+    if ( idxUp <= idxLow ) idxUp = idxLow + 1;
+    while ( idxUp < (numMarkers_ - 1) && (probabilities_[idxUp] - probabilities_[idxLow]) < (modeWindow - 1.e-6) ) ++idxUp;
+    if ( (probabilities_[idxUp] - probabilities_[idxLow]) < (modeWindow - 1.e-6) ) break;
+    double width = heights_[idxUp] - heights_[idxLow];
+    double center = 0.5*(heights_[idxLow] + heights_[idxUp]);
+//--- window of zero width contains a "peak" in the distribution
+    if ( !(width > 0.) ) return center;
+    windowCenters.push_back(center);
+    windowDensities.push_back((probabilities_[idxUp] - probabilities_[idxLow])/width);
+    if ( windowDensities.back() > windowDensities[idxMaximum] ) idxMaximum = windowDensities.size() - 1;
+  }
+  if ( windowDensities.size() == 0 ) return quantile(0.5);
+
+  if ( idxMaximum > 0 && idxMaximum < (windowDensities.size() - 1) ) {
+    double xMaximum_interpol = interpolateParabolic(
+      windowCenters[idxMaximum - 1], windowDensities[idxMaximum - 1],
+      windowCenters[idxMaximum],     windowDensities[idxMaximum],
+      windowCenters[idxMaximum + 1], windowDensities[idxMaximum + 1]);
+    if ( xMaximum_interpol > windowCenters[idxMaximum - 1] && xMaximum_interpol < windowCenters[idxMaximum + 1] ) return xMaximum_interpol;
+  }
+  return windowCenters[idxMaximum];
+}
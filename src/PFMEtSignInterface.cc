@@ -10,10 +10,28 @@
 #include <TMath.h>
 #include <TVectorD.h>
 
+#include <sstream>
+
 using namespace SVfit_namespace;
 
+PFMEtSignSharedEventData::~PFMEtSignSharedEventData()
+{
+  for ( std::map<std::string, PFMEtSignEventData*>::iterator it = eventData_.begin();
+	it != eventData_.end(); ++it ) {
+    delete it->second;
+  }
+}
+
+PFMEtSignEventData* PFMEtSignSharedEventData::getEventData(const std::string& key)
+{
+  PFMEtSignEventData*& eventData = eventData_[key];
+  if ( !eventData ) eventData = new PFMEtSignEventData();
+  return eventData;
+}
+
 PFMEtSignInterface::PFMEtSignInterface(const edm::ParameterSet& cfg)
-  : PFMEtSignInterfaceBase(cfg.getParameter<edm::ParameterSet>("resolution"))
+  : PFMEtSignInterfaceBase(cfg.getParameter<edm::ParameterSet>("resolution")),
+    eventData_(&ownEventData_)
 {
   srcPFJets_ = cfg.getParameter<edm::InputTag>("srcPFJets");
   srcPFCandidates_ = cfg.getParameter<edm::InputTag>("srcPFCandidates");
@@ -23,6 +41,15 @@ PFMEtSignInterface::PFMEtSignInterface(const edm::ParameterSet& cfg)
 
   verbosity_ = cfg.exists("verbosity") ?
     cfg.getParameter<int>("verbosity") : 0;
+
+//--- instances with identical input collections, overlap removal and resolution parameters
+//    compute identical covariance matrices and can hence share per-event data
+  std::ostringstream sharedEventDataKey;
+  sharedEventDataKey.precision(17);
+  sharedEventDataKey << srcPFJets_.encode() << ";" << srcPFCandidates_.encode() << ";"
+		     << dRoverlapPFJet_ << ";" << dRoverlapPFCandidate_ << ";"
+		     << cfg.getParameter<edm::ParameterSet>("resolution").toString();
+  sharedEventDataKey_ = sharedEventDataKey.str();
 }
 
 PFMEtSignInterface::~PFMEtSignInterface()
@@ -30,6 +57,11 @@ PFMEtSignInterface::~PFMEtSignInterface()
 // nothing to be done yet...
 }
 
+void PFMEtSignInterface::setSharedEventData(PFMEtSignSharedEventData& sharedEventData)
+{
+  eventData_ = sharedEventData.getEventData(sharedEventDataKey_);
+}
+
 namespace
 {
   template <typename T>
@@ -65,17 +97,27 @@ namespace
 
 void PFMEtSignInterface::beginEvent(const edm::Event& evt, const edm::EventSetup& es)
 {
+  edm::Handle<reco::PFCandidateCollection> pfCandidates;
+  evt.getByLabel(srcPFCandidates_, pfCandidates);
+
+//--- check if event data has already been filled by another instance
+  if ( eventData_->eventId_ == evt.id() && eventData_->pfCandidates_ == pfCandidates.product() ) return;
+
+  eventData_->eventId_ = evt.id();
+  eventData_->pfCandidates_ = pfCandidates.product();
+  eventData_->covMatrixCache_.clear();
+
   edm::Handle<reco::PFJetCollection> pfJets;
   evt.getByLabel(srcPFJets_, pfJets);
-  pfJetList_ = makeList<reco::PFJet>(*pfJets);  
+  std::list<const reco::PFJet*>& pfJetList = eventData_->pfJetList_;
+  pfJetList = makeList<reco::PFJet>(*pfJets);  
 
-  edm::Handle<reco::PFCandidateCollection> pfCandidates;
-  evt.getByLabel(srcPFCandidates_, pfCandidates);
-  pfCandidateList_ = makeList<reco::PFCandidate>(*pfCandidates); 
+  std::list<const reco::PFCandidate*>& pfCandidateList = eventData_->pfCandidateList_;
+  pfCandidateList = makeList<reco::PFCandidate>(*pfCandidates); 
 
   std::list<const reco::PFCandidate*> pfJetConstituentList;
-  for ( std::list<const reco::PFJet*>::const_iterator pfJet = pfJetList_.begin();
-	pfJet != pfJetList_.end(); ++pfJet ) {
+  for ( std::list<const reco::PFJet*>::const_iterator pfJet = pfJetList.begin();
+	pfJet != pfJetList.end(); ++pfJet ) {
     const std::vector<reco::PFCandidatePtr> pfJetConstituents = (*pfJet)->getPFConstituents();
     for ( std::vector<reco::PFCandidatePtr>::const_iterator pfJetConstituent = pfJetConstituents.begin();
 	  pfJetConstituent != pfJetConstituents.end(); ++pfJetConstituent ) {
@@ -83,7 +125,7 @@ void PFMEtSignInterface::beginEvent(const edm::Event& evt, const edm::EventSetup
     }
   }
 
-  removePFCandidateOverlaps(pfCandidateList_, pfJetConstituentList, dRoverlapPFCandidate_);
+  removePFCandidateOverlaps(pfCandidateList, pfJetConstituentList, dRoverlapPFCandidate_);
 }
 
 namespace
@@ -117,17 +159,33 @@ namespace
 
 TMatrixD PFMEtSignInterface::operator()(const std::list<const reco::Candidate*>& patLeptonList) const
 {
+//--- the order of leptons is kept in the key,
+//    in order to reproduce the result of the computation exactly
+  std::vector<const reco::Candidate*> key(patLeptonList.begin(), patLeptonList.end());
+  PFMEtSignEventData::covMatrixCacheType::const_iterator cachedCovMatrix = eventData_->covMatrixCache_.find(key);
+  if ( cachedCovMatrix != eventData_->covMatrixCache_.end() ) return cachedCovMatrix->second;
+
+  TMatrixD covMatrix = compCovMatrix(patLeptonList);
+  eventData_->covMatrixCache_.insert(std::make_pair(key, covMatrix));
+  return covMatrix;
+}
+
+TMatrixD PFMEtSignInterface::compCovMatrix(const std::list<const reco::Candidate*>& patLeptonList) const
+{
+  const std::list<const reco::PFJet*>& pfJetList = eventData_->pfJetList_;
+  const std::list<const reco::PFCandidate*>& pfCandidateList = eventData_->pfCandidateList_;
+
   if ( this->verbosity_ ) {
-    std::cout << "<PFMEtSignInterface::operator()>:" << std::endl;
+    std::cout << "<PFMEtSignInterface::compCovMatrix>:" << std::endl;
     std::cout << " patLeptonList: #entries = " << patLeptonList.size() << std::endl;
-    std::cout << " pfJetList: #entries = " << pfJetList_.size() << std::endl;
-    std::cout << " pfCandidateList: #entries = " << pfCandidateList_.size() << std::endl;
+    std::cout << " pfJetList: #entries = " << pfJetList.size() << std::endl;
+    std::cout << " pfCandidateList: #entries = " << pfCandidateList.size() << std::endl;
   }
 
-  std::list<const reco::PFJet*> pfJetList_hypothesis = pfJetList_;
+  std::list<const reco::PFJet*> pfJetList_hypothesis = pfJetList;
   removePFJetOverlaps(pfJetList_hypothesis, patLeptonList, dRoverlapPFJet_, dRoverlapPFCandidate_);  
 
-  std::list<const reco::PFCandidate*> pfCandidateList_hypothesis = pfCandidateList_;
+  std::list<const reco::PFCandidate*> pfCandidateList_hypothesis = pfCandidateList;
   removePFCandidateOverlaps(pfCandidateList_hypothesis, patLeptonList, dRoverlapPFCandidate_);
 
   std::vector<metsig::SigInputObj> pfMEtSignObjects;
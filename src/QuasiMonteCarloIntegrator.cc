@@ -0,0 +1,345 @@
+#include "TauAnalysis/CandidateTools/interface/QuasiMonteCarloIntegrator.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <TMath.h>
+
+namespace
+{
+  const unsigned numBits = 32;
+
+//--- primitive polynomials and initial direction numbers of dimensions 2..21,
+//    taken from the file new-joe-kuo-6.21201 provided by the authors of [2]
+//   (s = degree of polynomial, a = coefficients of polynomial, m = initial direction numbers)
+  struct sobolDirectionNumbersType
+  {
+    unsigned s_;
+    unsigned a_;
+    unsigned m_[7];
+  };
+
+  const sobolDirectionNumbersType sobolDirectionNumbers[QuasiMonteCarloIntegrator::maxDimensions - 1] = {
+    { 1,  0, { 1                    } },
+    { 2,  1, { 1, 3                 } },
+    { 3,  1, { 1, 3, 1              } },
+    { 3,  2, { 1, 1, 1              } },
+    { 4,  1, { 1, 1, 3,  3          } },
+    { 4,  4, { 1, 3, 5, 13          } },
+    { 5,  2, { 1, 1, 5,  5, 17      } },
+    { 5,  4, { 1, 1, 5,  5,  5      } },
+    { 5,  7, { 1, 1, 7, 11, 19      } },
+    { 5, 11, { 1, 1, 5,  1,  1      } },
+    { 5, 13, { 1, 1, 1,  3, 11      } },
+    { 5, 14, { 1, 3, 5,  5, 31      } },
+    { 6,  1, { 1, 3, 3,  9,  7, 49  } },
+    { 6, 13, { 1, 1, 1, 15, 21, 21  } },
+    { 6, 16, { 1, 3, 1, 13, 27, 49  } },
+    { 6, 19, { 1, 1, 1, 15,  7,  5  } },
+    { 6, 22, { 1, 3, 1, 15, 13, 25  } },
+    { 6, 25, { 1, 1, 5,  5, 19, 61  } },
+    { 7,  1, { 1, 3, 7, 11, 23, 15, 103 } },
+    { 7,  4, { 1, 3, 7, 13, 13, 15,  69 } }
+  };
+
+  UInt_t parity(UInt_t value)
+  {
+    value ^= (value >> 16);
+    value ^= (value >>  8);
+    value ^= (value >>  4);
+    value ^= (value >>  2);
+    value ^= (value >>  1);
+    return (value & 1);
+  }
+
+  unsigned numTrailingZeros(unsigned value)
+  {
+    unsigned retVal = 0;
+    while ( (value & 1) == 0 ) {
+      value >>= 1;
+      ++retVal;
+    }
+    return retVal;
+  }
+}
+
+const unsigned QuasiMonteCarloIntegrator::maxDimensions;
+
+QuasiMonteCarloIntegrator::QuasiMonteCarloIntegrator(const edm::ParameterSet& cfg)
+  : name_(""),
+    integrand_(0),
+    numIntegrals_(0),
+    numDimensions_(0),
+    numReplicasDone_(0),
+    numActive_(0)
+{
+  if ( cfg.exists("name") )
+    name_ = cfg.getParameter<std::string>("name");
+  rnd_.setComponent(name_);
+
+//--- get number of points per replica, rounded up to next power of two,
+//    and number of replicas
+  unsigned numPoints = cfg.getParameter<unsigned>("numPoints");
+  if ( !(numPoints >= 1 && numPoints <= (1U << 30)) )
+    throw cms::Exception("QuasiMonteCarloIntegrator")
+      << "Invalid Configuration Parameter 'numPoints' = " << numPoints << " !!\n";
+  numPoints_ = 1;
+  while ( numPoints_ < numPoints ) numPoints_ <<= 1;
+  numReplicas_ = ( cfg.exists("numReplicas") ) ?
+    cfg.getParameter<unsigned>("numReplicas") : 8;
+  if ( !(numReplicas_ >= 2) )
+    throw cms::Exception("QuasiMonteCarloIntegrator")
+      << "Invalid Configuration Parameter 'numReplicas' = " << numReplicas_ << ","
+      << " at least two replicas are needed to estimate the uncertainties !!\n";
+
+//--- get threshold for dropping functions with negligible integral
+  pruneThreshold_ = ( cfg.exists("pruneThreshold") ) ?
+    cfg.getParameter<double>("pruneThreshold") : 0.;
+
+//--- get parameters limiting time and number of integrand evaluations per integration
+  double maxTime = ( cfg.exists("maxTime") ) ?
+    cfg.getParameter<double>("maxTime") : 0.;
+  unsigned maxIntegrandCalls = ( cfg.exists("maxIntegrandCalls") ) ?
+    cfg.getParameter<unsigned>("maxIntegrandCalls") : 0;
+  budget_.setLimits(maxTime, maxIntegrandCalls);
+
+  verbosity_ = ( cfg.exists("verbosity") ) ?
+    cfg.getParameter<int>("verbosity") : 0;
+}
+
+void QuasiMonteCarloIntegrator::setIntegrand(const Integrand& integrand, unsigned numIntegrals)
+{
+  integrand_ = &integrand;
+  numIntegrals_ = numIntegrals;
+}
+
+void QuasiMonteCarloIntegrator::integrate(const std::vector<double>& xMin, const std::vector<double>& xMax,
+					  std::vector<double>& integral, std::vector<double>& integralErr, int& errorFlag)
+{
+  if ( !integrand_ )
+    throw cms::Exception("QuasiMonteCarloIntegrator::integrate")
+      << "No integrand function has been set yet !!\n";
+
+  if ( xMin.size() != xMax.size() )
+    throw cms::Exception("QuasiMonteCarloIntegrator::integrate")
+      << "Mismatch in dimensionality of lower and upper boundaries of integration region !!\n";
+
+  if ( !(xMin.size() >= 1 && xMin.size() <= maxDimensions) )
+    throw cms::Exception("QuasiMonteCarloIntegrator::integrate")
+      << "Integration in " << xMin.size() << " dimensions not supported,"
+      << " direction numbers of Sobol sequence available for up to " << maxDimensions << " dimensions only !!\n";
+
+  if ( xMin.size() != numDimensions_ ) {
+    numDimensions_ = xMin.size();
+    initializeDirections();
+  }
+  xMin_ = xMin;
+  xMax_ = xMax;
+
+  y_.resize(numDimensions_);
+  x_.resize(numDimensions_);
+  f_.resize(numIntegrals_);
+  sumF_.resize(numIntegrals_);
+  sumIntegrals_.assign(numIntegrals_, 0.);
+  sumIntegrals2_.assign(numIntegrals_, 0.);
+  numReplicasDone_ = 0;
+  isActive_.assign(numIntegrals_, true);
+  numActive_ = numIntegrals_;
+  prunedIntegrals_.assign(numIntegrals_, 0.);
+  prunedIntegralErrs_.assign(numIntegrals_, 0.);
+
+  rnd_.reset();
+
+  double volume = 1.;
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+    volume *= (xMax_[iDimension] - xMin_[iDimension]);
+  }
+
+  budget_.start();
+
+  unsigned numPointsDone = 0;
+  for ( unsigned iReplica = 0; iReplica < numReplicas_ && !budget_.isExhausted(); ++iReplica ) {
+    scrambleDirections();
+    numPointsDone = runReplica();
+    if ( numPointsDone < numPoints_ ) break;
+    for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+      if ( !isActive_[iIntegral] ) continue;
+      double integral_i = volume*sumF_[iIntegral]/numPoints_;
+      sumIntegrals_[iIntegral] += integral_i;
+      sumIntegrals2_[iIntegral] += integral_i*integral_i;
+    }
+    ++numReplicasDone_;
+    if ( pruneThreshold_ > 0. && numReplicasDone_ >= 2 ) pruneIntegrals();
+  }
+
+//--- compute average and spread of integrals computed in different replicas
+  integral.resize(numIntegrals_);
+  integralErr.resize(numIntegrals_);
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) {
+      integral[iIntegral] = prunedIntegrals_[iIntegral];
+      integralErr[iIntegral] = prunedIntegralErrs_[iIntegral];
+    } else if ( numReplicasDone_ >= 1 ) {
+      integral[iIntegral] = sumIntegrals_[iIntegral]/numReplicasDone_;
+      if ( numReplicasDone_ >= 2 ) {
+	double integralVar = (sumIntegrals2_[iIntegral]/numReplicasDone_ - integral[iIntegral]*integral[iIntegral])/(numReplicasDone_ - 1);
+	integralErr[iIntegral] = TMath::Sqrt(TMath::Max(0., integralVar));
+      } else {
+	integralErr[iIntegral] = 0.;
+      }
+//--- in case the budget got exhausted before the first replica has been completed,
+//    compute integrals from the points of the incomplete replica (no uncertainty available)
+    } else if ( numPointsDone > 0 ) {
+      integral[iIntegral] = volume*sumF_[iIntegral]/numPointsDone;
+      integralErr[iIntegral] = 0.;
+    } else {
+      integral[iIntegral] = 0.;
+      integralErr[iIntegral] = 0.;
+    }
+  }
+
+  errorFlag = ( numReplicasDone_ > 0 ) ? 0 : 1;
+
+  if ( verbosity_ >= 1 ) print(std::cout);
+}
+
+void QuasiMonteCarloIntegrator::initializeDirections()
+{
+//--- compute direction numbers of Sobol sequence (eqs. (2.2) and (2.3) in [2]),
+//    scaled such that the most significant bit corresponds to 1/2
+  directions_.resize(numDimensions_*numBits);
+  for ( unsigned iBit = 0; iBit < numBits; ++iBit ) {
+    directions_[iBit] = (1U << (numBits - 1 - iBit));
+  }
+  for ( unsigned iDimension = 1; iDimension < numDimensions_; ++iDimension ) {
+    const sobolDirectionNumbersType& sobol = sobolDirectionNumbers[iDimension - 1];
+    UInt_t* v = &directions_[iDimension*numBits];
+    for ( unsigned iBit = 0; iBit < numBits; ++iBit ) {
+      if ( iBit < sobol.s_ ) {
+	v[iBit] = (sobol.m_[iBit] << (numBits - 1 - iBit));
+      } else {
+	v[iBit] = v[iBit - sobol.s_] ^ (v[iBit - sobol.s_] >> sobol.s_);
+	for ( unsigned k = 1; k < sobol.s_; ++k ) {
+	  if ( (sobol.a_ >> (sobol.s_ - 1 - k)) & 1 ) v[iBit] ^= v[iBit - k];
+	}
+      }
+    }
+  }
+  scrambledDirections_.resize(numDimensions_*numBits);
+  digitalShifts_.resize(numDimensions_);
+}
+
+void QuasiMonteCarloIntegrator::scrambleDirections()
+{
+//--- multiply direction numbers by random lower triangular binary matrix with unit diagonal
+//   (bit k of scrambled direction number = parity of the bits of the original direction number selected by row k of the matrix)
+//    and draw random digital shift, independently for each dimension [3]
+  std::vector<UInt_t> matrixRows(numBits);
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+    for ( unsigned iRow = 0; iRow < numBits; ++iRow ) {
+      UInt_t diagonal = (1U << (numBits - 1 - iRow));
+      UInt_t moreSignificantBits = ~((diagonal << 1) - 1);
+      matrixRows[iRow] = diagonal | (rnd_.Integer32() & moreSignificantBits);
+    }
+    const UInt_t* v = &directions_[iDimension*numBits];
+    UInt_t* vScrambled = &scrambledDirections_[iDimension*numBits];
+    for ( unsigned iBit = 0; iBit < numBits; ++iBit ) {
+      UInt_t value = 0;
+      for ( unsigned iRow = 0; iRow < numBits; ++iRow ) {
+	if ( parity(v[iBit] & matrixRows[iRow]) ) value |= (1U << (numBits - 1 - iRow));
+      }
+      vScrambled[iBit] = value;
+    }
+    digitalShifts_[iDimension] = rnd_.Integer32();
+  }
+}
+
+void QuasiMonteCarloIntegrator::pruneIntegrals()
+{
+  std::vector<double> integrals(numIntegrals_);
+  std::vector<double> integralErrs(numIntegrals_);
+  double maxIntegral = 0.;
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) continue;
+    integrals[iIntegral] = sumIntegrals_[iIntegral]/numReplicasDone_;
+    double integralVar = (sumIntegrals2_[iIntegral]/numReplicasDone_ - integrals[iIntegral]*integrals[iIntegral])/(numReplicasDone_ - 1);
+    integralErrs[iIntegral] = TMath::Sqrt(TMath::Max(0., integralVar));
+    if ( integrals[iIntegral] > maxIntegral ) maxIntegral = integrals[iIntegral];
+  }
+  if ( !(maxIntegral > 0.) ) return;
+
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) continue;
+    if ( (integrals[iIntegral] + 3.*integralErrs[iIntegral]) < (pruneThreshold_*maxIntegral) ) {
+      prunedIntegrals_[iIntegral] = integrals[iIntegral];
+      prunedIntegralErrs_[iIntegral] = integralErrs[iIntegral];
+      isActive_[iIntegral] = false;
+      --numActive_;
+    }
+  }
+}
+
+unsigned QuasiMonteCarloIntegrator::runReplica()
+{
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    sumF_[iIntegral] = 0.;
+  }
+
+//--- generate points of the Sobol sequence in Gray code order (cf. [2]),
+//    starting from the digital shift
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+    y_[iDimension] = digitalShifts_[iDimension];
+  }
+
+  const double scale = 1./4294967296.; // 2^-32
+  unsigned numPointsDone = 0;
+  while ( numPointsDone < numPoints_ && !budget_.checkIsExhausted() ) {
+    if ( numPointsDone > 0 ) {
+      unsigned iBit = numTrailingZeros(numPointsDone);
+      for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+	y_[iDimension] ^= scrambledDirections_[iDimension*numBits + iBit];
+      }
+    }
+//--- shift points by half of the resolution, in order to avoid evaluating the integrand on the boundaries
+    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+      double u = (y_[iDimension] + 0.5)*scale;
+      x_[iDimension] = xMin_[iDimension] + u*(xMax_[iDimension] - xMin_[iDimension]);
+    }
+
+    if ( numActive_ < numIntegrals_ ) integrand_->evaluate(&x_[0], isActive_, &f_[0]);
+    else (*integrand_)(&x_[0], &f_[0]);
+    budget_.addIntegrandCalls(numActive_);
+    ++numPointsDone;
+
+    for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+      if ( isActive_[iIntegral] && !TMath::IsNaN(f_[iIntegral]) ) sumF_[iIntegral] += f_[iIntegral];
+    }
+  }
+
+  return numPointsDone;
+}
+
+void QuasiMonteCarloIntegrator::print(std::ostream& stream) const
+{
+  stream << "<QuasiMonteCarloIntegrator::print>:" << std::endl;
+  stream << " name = " << name_ << std::endl;
+  stream << " numDimensions = " << numDimensions_ << ", numIntegrals = " << numIntegrals_ << std::endl;
+  stream << " numPoints per replica = " << numPoints_ << ", replicas completed = " << numReplicasDone_ << std::endl;
+  stream << " functions evaluated in last replica = " << numActive_ << std::endl;
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_ && numReplicasDone_ >= 1; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) {
+      stream << " integral #" << iIntegral << " = " << prunedIntegrals_[iIntegral] << " +/- " << prunedIntegralErrs_[iIntegral] 
+	     << " (dropped)" << std::endl;
+      continue;
+    }
+    double integral = sumIntegrals_[iIntegral]/numReplicasDone_;
+    stream << " integral #" << iIntegral << " = " << integral;
+    if ( numReplicasDone_ >= 2 ) {
+      double integralVar = (sumIntegrals2_[iIntegral]/numReplicasDone_ - integral*integral)/(numReplicasDone_ - 1);
+      stream << " +/- " << TMath::Sqrt(TMath::Max(0., integralVar));
+    }
+    stream << std::endl;
+  }
+  if ( budget_.isExhausted() ) {
+    stream << " budget exhausted after " << budget_.numIntegrandCalls() << " integrand calls" << std::endl;
+  }
+}
@@ -1,67 +1,102 @@
 #include "TauAnalysis/CandidateTools/interface/RooSmearedIsotropicDecayPdf.h"
 #include <cmath>
+#include <cassert>
 #include "TMath.h"
 
 namespace {
 
-#define E (TMath::E())
-#define Pi (TMath::Pi())
-#define Power(x, n) (std::pow((x), (n)))
-#define Sqrt(x) (TMath::Sqrt((x)))
-#define Erf(x) (TMath::Erf((x)))
+const Double_t sqrt2    = TMath::Sqrt(2.);
+const Double_t sqrt2Pi  = TMath::Sqrt(2.*TMath::Pi());
+const Double_t sqrtPiBy2 = TMath::Sqrt(0.5*TMath::Pi());
 
-// Copied from Mathematic CForm[...] output
-inline Double_t smearedIsoDecayImpl(Double_t x, Double_t a, Double_t s) {
-  return (-(s*(2*Power(E,(a*x)/Power(s,2))*s*(8*Power(a,2) + 4*a*(Power(a,2) + 2*Power(s,2) + a*x + Power(x,2)) +
-            3*(Power(a,4) + 8*Power(s,4) + Power(a,3)*x + Power(a,2)*Power(x,2) + a*Power(x,3) +
-              Power(x,4) + Power(s,2)*(4*Power(a,2) + 7*a*x + 9*Power(x,2)))) -
-          Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2)))*Sqrt(2*Pi)*x*
-          (8*Power(a,2) + 4*a*(3*Power(s,2) + Power(x,2)) +
-           3*(15*Power(s,4) + 10*Power(s,2)*Power(x,2) + Power(x,4)))*Erf((a - x)/(Sqrt(2)*s))))/
-      (2.*Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2)))) +
-      (s*(2*s*(8*Power(a,2) + 4*a*(2*Power(s,2) + Power(x,2)) +
-               3*(8*Power(s,4) + 9*Power(s,2)*Power(x,2) + Power(x,4))) +
-          Power(E,Power(x,2)/(2.*Power(s,2)))*Sqrt(2*Pi)*x*
-          (8*Power(a,2) + 4*a*(3*Power(s,2) + Power(x,2)) +
-           3*(15*Power(s,4) + 10*Power(s,2)*Power(x,2) + Power(x,4)))*Erf(x/(Sqrt(2)*s))))/
-      (2.*Power(E,Power(x,2)/(2.*Power(s,2)))))/(8.*Power(a,2.5)*Sqrt(2*Pi)*s);
+// Coefficients of the polynomials in x entering the PDF,
+// which depend on location a and smearing s only.
+// The expressions are obtained from the Mathematica CForm[...] output
+// by cancelling the exponential factors, which avoids overflows of exp(x^2/(2 s^2))
+// for large x/s, and expanding the polynomials in powers of x.
+struct smearedIsoDecayCoeffType
+{
+  smearedIsoDecayCoeffType(Double_t a, Double_t s)
+    : a_(a),
+      s_(s)
+  {
+    Double_t a2 = a*a;
+    Double_t a3 = a2*a;
+    Double_t a4 = a2*a2;
+    Double_t s2 = s*s;
+    Double_t s4 = s2*s2;
+    p1_[0] = 8*a2 + 4*a3 + 3*a4 + 8*a*s2 + 12*a2*s2 + 24*s4;
+    p1_[1] = 4*a2 + 3*a3 + 21*a*s2;
+    p1_[2] = 4*a + 3*a2 + 27*s2;
+    p1_[3] = 3*a;
+    p2_[0] = 8*a2 + 8*a*s2 + 24*s4;
+    p2_[2] = 4*a + 27*s2;
+    q_[0]  = 8*a2 + 12*a*s2 + 45*s4;
+    q_[2]  = 4*a + 30*s2;
+    minusOneOver2s2_ = -0.5/s2;
+    oneOverSqrt2s_ = 1./(sqrt2*s);
+    norm_ = 1./(8*a2*TMath::Sqrt(a)*sqrt2Pi);
+  }
+  Double_t a_;
+  Double_t s_;
+  Double_t p1_[4]; // coefficient of x^4 is 3
+  Double_t p2_[3]; // only even powers, coefficient of x^4 is 3
+  Double_t q_[3];  // only even powers, coefficient of x^4 is 3
+  Double_t minusOneOver2s2_;
+  Double_t oneOverSqrt2s_;
+  Double_t norm_;
+};
+
+inline Double_t smearedIsoDecayImpl(Double_t x, const smearedIsoDecayCoeffType& coeff) 
+{
+  Double_t x2 = x*x;
+  Double_t d = coeff.a_ - x;
+  Double_t p1 = (((3*x + coeff.p1_[3])*x + coeff.p1_[2])*x + coeff.p1_[1])*x + coeff.p1_[0];
+  Double_t p2 = (3*x2 + coeff.p2_[2])*x2 + coeff.p2_[0];
+  Double_t q  = (3*x2 + coeff.q_[2])*x2 + coeff.q_[0];
+  Double_t g0 = TMath::Exp(x2*coeff.minusOneOver2s2_);
+  Double_t g1 = TMath::Exp(d*d*coeff.minusOneOver2s2_);
+  Double_t erf0 = TMath::Erf(x*coeff.oneOverSqrt2s_);
+  Double_t erf1 = TMath::Erf(d*coeff.oneOverSqrt2s_);
+  return (coeff.s_*(p2*g0 - p1*g1) + 0.5*sqrt2Pi*x*q*(erf1 + erf0))*coeff.norm_;
 }
 
-// Inline this so the compiler can optimize it.
-inline Double_t smearedIsoDecayCDFXImpl(Double_t x, Double_t a, Double_t s) {
-  return ((s*((s*x*(8*Power(a,2) + 10*a*Power(s,2) + 33*Power(s,4) + 2*(a + 7*Power(s,2))*Power(x,2) + Power(x,4)))/
-       Power(E,Power(x,2)/(2.*Power(s,2))) +
-       Sqrt(Pi/2.)*(15*Power(s,6) + 45*Power(s,4)*Power(x,2) + 15*Power(s,2)*Power(x,4) + Power(x,6) +
-         8*Power(a,2)*(Power(s,2) + Power(x,2)) +
-         2*a*(3*Power(s,4) + 6*Power(s,2)*Power(x,2) + Power(x,4)))*Erf(x/(Sqrt(2)*s))))/2. -
-   (s*((-2*Power(s,2)*(-(a*s*(8*a + 12*Power(a,2) + 69*Power(s,2))) -
-                       Power(E,Power(a,2)/(2.*Power(s,2)))*Sqrt(2*Pi)*
-                       (4*Power(a,3) + 6*Power(a,4) + 2*a*Power(s,2) + 39*Power(a,2)*Power(s,2) + 18*Power(s,4))*
-                       Erf(a/(Sqrt(2)*s))))/Power(E,Power(a,2)/(2.*Power(s,2))) -
-       (2*a*s*(2*Power(a,3) + Power(a,4) + 22*a*Power(s,2) + 153*Power(s,4) +
-               Power(a,2)*(8 + 29*Power(s,2))) +
-        Power(E,Power(a,2)/(2.*Power(s,2)))*Sqrt(2*Pi)*
-        (2*Power(a,5) + Power(a,6) + 16*Power(a,3)*Power(s,2) + 2*a*Power(s,4) + 57*Power(s,6) +
-         8*Power(a,4)*(1 + 3*Power(s,2)) + 4*Power(a,2)*Power(s,2)*(-2 + 39*Power(s,2)))*
-        Erf(a/(Sqrt(2)*s)))/(2.*Power(E,Power(a,2)/(2.*Power(s,2)))) +
-       (2*Power(s,2)*(-(Power(E,(a*x)/Power(s,2))*s*
-                        (12*Power(a,3) + Power(a,2)*(8 + 9*x) + 3*x*(12*Power(s,2) + Power(x,2)) +
-                         a*(69*Power(s,2) + 2*x*(2 + 3*x)))) +
-                      Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2)))*Sqrt(2*Pi)*
-                      (4*Power(a,3) + 6*Power(a,4) + 2*a*Power(s,2) + 39*Power(a,2)*Power(s,2) + 18*Power(s,4))*
-                      Erf((-a + x)/(Sqrt(2)*s))))/Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2))) +
-       (2*Power(E,(a*x)/Power(s,2))*s*(Power(a,5) + 105*Power(s,4)*x + 20*Power(s,2)*Power(x,3) +
-                                       Power(x,5) + Power(a,4)*(2 + x) + Power(a,3)*(8 + 29*Power(s,2) + 2*x + Power(x,2)) +
-                                       a*(153*Power(s,4) + Power(x,3)*(2 + x) + 6*Power(s,2)*x*(3 + 4*x)) +
-                                       Power(a,2)*(Power(s,2)*(22 + 27*x) + x*(8 + 2*x + Power(x,2)))) -
-        Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2)))*Sqrt(2*Pi)*Power(x,2)*
-        (8*Power(a,2) + 45*Power(s,4) + 15*Power(s,2)*Power(x,2) + Power(x,4) +
-         2*a*(6*Power(s,2) + Power(x,2)))*Erf((a - x)/(Sqrt(2)*s)) -
-        Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2)))*Sqrt(2*Pi)*
-        (2*Power(a,5) + Power(a,6) + 16*Power(a,3)*Power(s,2) + 2*a*Power(s,4) + 57*Power(s,6) +
-         8*Power(a,4)*(1 + 3*Power(s,2)) + 4*Power(a,2)*Power(s,2)*(-2 + 39*Power(s,2)))*
-        Erf((-a + x)/(Sqrt(2)*s)))/(2.*Power(E,(Power(a,2) + Power(x,2))/(2.*Power(s,2))))))/2.)/
-        (8.*Power(a,2.5)*Sqrt(2*Pi)*s);
+inline Double_t smearedIsoDecayImpl(Double_t x, Double_t a, Double_t s) 
+{
+  return smearedIsoDecayImpl(x, smearedIsoDecayCoeffType(a, s));
+}
+
+// Integral of PDF from 0 to x
+// (Mathematica CForm[...] output, simplified in the same way as the PDF)
+inline Double_t smearedIsoDecayCDFXImpl(Double_t x, Double_t a, Double_t s) 
+{
+  Double_t a2 = a*a;
+  Double_t a3 = a2*a;
+  Double_t a4 = a2*a2;
+  Double_t s2 = s*s;
+  Double_t s4 = s2*s2;
+  Double_t s6 = s4*s2;
+  Double_t x2 = x*x;
+  Double_t x4 = x2*x2;
+  Double_t d = a - x;
+  Double_t g0 = TMath::Exp(-x2/(2*s2));
+  Double_t g1 = TMath::Exp(-d*d/(2*s2));
+  Double_t gA = TMath::Exp(-a2/(2*s2));
+  Double_t erf0 = TMath::Erf(x/(sqrt2*s));
+  Double_t erf1 = TMath::Erf(d/(sqrt2*s));
+  Double_t erfA = TMath::Erf(a/(sqrt2*s));
+  Double_t A = s*x*(8*a2 + 10*a*s2 + 33*s4 + 2*(a + 7*s2)*x2 + x4);
+  Double_t B = 15*s6 + 45*s4*x2 + 15*s2*x4 + x4*x2 + 8*a2*(s2 + x2) + 2*a*(3*s4 + 6*s2*x2 + x4);
+  Double_t R = 4*a3 + 6*a4 + 2*a*s2 + 39*a2*s2 + 18*s4;
+  Double_t T = 2*a3 + a4 + 22*a*s2 + 153*s4 + a2*(8 + 29*s2);
+  Double_t U = 2*a4*a + a4*a2 + 16*a3*s2 + 2*a*s4 + 57*s6 + 8*a4*(1 + 3*s2) + 4*a2*s2*(-2 + 39*s2);
+  Double_t V = 12*a3 + a2*(8 + 9*x) + 3*x*(12*s2 + x2) + a*(69*s2 + 2*x*(2 + 3*x));
+  Double_t W = a4*a + 105*s4*x + 20*s2*x2*x + x4*x + a4*(2 + x) + a3*(8 + 29*s2 + 2*x + x2) 
+              + a*(153*s4 + x2*x*(2 + x) + 6*s2*x*(3 + 4*x)) + a2*(s2*(22 + 27*x) + x*(8 + 2*x + x2));
+  Double_t Y = 8*a2 + 45*s4 + 15*s2*x2 + x4 + 2*a*(6*s2 + x2);
+  Double_t termA = 2*s2*(a*s*(8*a + 12*a2 + 69*s2)*gA + sqrt2Pi*R*erfA) - a*s*T*gA - 0.5*sqrt2Pi*U*erfA;
+  Double_t termX = -2*s2*(s*V*g1 + sqrt2Pi*R*erf1) + s*W*g1 - 0.5*sqrt2Pi*(x2*Y - U)*erf1;
+  return ((A*g0 + sqrtPiBy2*B*erf0) - (termA + termX))/(16*a2*TMath::Sqrt(a)*sqrt2Pi);
 }
 } // end anonymous namespace
 
@@ -71,7 +106,15 @@ RooSmearedIsotropicDecayPdf::RooSmearedIsotropicDecayPdf(
   RooAbsPdf(name, title),
   x("x", "Observable", this, _x),
   smear("smear", "Smear", this, _smear),
-  location("location", "Location", this, _location)
+  location("location", "Location", this, _location),
+  tableNumPointsX_(0),
+  tableMaxX_(0.),
+  tableNumPointsLocation_(0),
+  tableMinLocation_(0.),
+  tableMaxLocation_(0.),
+  tableNumPointsSmear_(0),
+  tableMinSmear_(0.),
+  tableMaxSmear_(0.)
 {}
 
 // Copy constructor
@@ -80,7 +123,16 @@ RooSmearedIsotropicDecayPdf::RooSmearedIsotropicDecayPdf(
   RooAbsPdf(other, name),
   x("x", this, other.x),
   smear("smear", this, other.smear),
-  location("location", this, other.location) {}
+  location("location", this, other.location),
+  table_(other.table_),
+  tableNumPointsX_(other.tableNumPointsX_),
+  tableMaxX_(other.tableMaxX_),
+  tableNumPointsLocation_(other.tableNumPointsLocation_),
+  tableMinLocation_(other.tableMinLocation_),
+  tableMaxLocation_(other.tableMaxLocation_),
+  tableNumPointsSmear_(other.tableNumPointsSmear_),
+  tableMinSmear_(other.tableMinSmear_),
+  tableMaxSmear_(other.tableMaxSmear_) {}
 
 Double_t RooSmearedIsotropicDecayPdf::evaluate() const {
   Double_t s = smear;
@@ -88,9 +140,83 @@ Double_t RooSmearedIsotropicDecayPdf::evaluate() const {
   Double_t a = location;
   if (x < 0)
     return 0;
+  if (!table_.empty())
+    return evaluateTable(xVal, a, s);
   return smearedIsoDecayImpl(xVal, a, s);
 }
 
+Double_t RooSmearedIsotropicDecayPdf::evaluate(Double_t x, Double_t location, Double_t smear) {
+  if (x < 0)
+    return 0;
+  return smearedIsoDecayImpl(x, location, smear);
+}
+
+void RooSmearedIsotropicDecayPdf::evaluateBatch(const Double_t* x, Double_t* pdf, size_t n,
+    Double_t location, Double_t smear) {
+  smearedIsoDecayCoeffType coeff(location, smear);
+  for (size_t i = 0; i < n; ++i) {
+    pdf[i] = ( x[i] < 0 ) ? 0. : smearedIsoDecayImpl(x[i], coeff);
+  }
+}
+
+void RooSmearedIsotropicDecayPdf::tabulate(unsigned numBinsX, Double_t xMax,
+    unsigned numBinsLocation, Double_t locationMin, Double_t locationMax,
+    unsigned numBinsSmear, Double_t smearMin, Double_t smearMax) {
+  assert(numBinsX >= 1 && numBinsLocation >= 1 && numBinsSmear >= 1);
+  assert(xMax > 0. && locationMin > 0. && locationMax > locationMin && smearMin > 0. && smearMax > smearMin);
+  tableNumPointsX_ = numBinsX + 1;
+  tableMaxX_ = xMax;
+  tableNumPointsLocation_ = numBinsLocation + 1;
+  tableMinLocation_ = locationMin;
+  tableMaxLocation_ = locationMax;
+  tableNumPointsSmear_ = numBinsSmear + 1;
+  tableMinSmear_ = smearMin;
+  tableMaxSmear_ = smearMax;
+  // x is the fastest running index, so that each (location, smearing) row is
+  // filled by one batch evaluation
+  table_.resize(tableNumPointsX_*tableNumPointsLocation_*tableNumPointsSmear_);
+  std::vector<Double_t> xValues(tableNumPointsX_);
+  for (unsigned iX = 0; iX < tableNumPointsX_; ++iX) {
+    xValues[iX] = iX*(xMax/numBinsX);
+  }
+  for (unsigned iSmear = 0; iSmear < tableNumPointsSmear_; ++iSmear) {
+    Double_t smearValue = smearMin + iSmear*((smearMax - smearMin)/numBinsSmear);
+    for (unsigned iLocation = 0; iLocation < tableNumPointsLocation_; ++iLocation) {
+      Double_t locationValue = locationMin + iLocation*((locationMax - locationMin)/numBinsLocation);
+      Double_t* row = &table_[(iSmear*tableNumPointsLocation_ + iLocation)*tableNumPointsX_];
+      evaluateBatch(&xValues[0], row, tableNumPointsX_, locationValue, smearValue);
+    }
+  }
+}
+
+Double_t RooSmearedIsotropicDecayPdf::evaluateTable(Double_t xVal, Double_t a, Double_t s) const {
+  if (xVal > tableMaxX_ ||
+      a < tableMinLocation_ || a > tableMaxLocation_ ||
+      s < tableMinSmear_ || s > tableMaxSmear_)
+    return smearedIsoDecayImpl(xVal, a, s);
+  // position on grid
+  Double_t uX = xVal/tableMaxX_*(tableNumPointsX_ - 1);
+  Double_t uA = (a - tableMinLocation_)/(tableMaxLocation_ - tableMinLocation_)*(tableNumPointsLocation_ - 1);
+  Double_t uS = (s - tableMinSmear_)/(tableMaxSmear_ - tableMinSmear_)*(tableNumPointsSmear_ - 1);
+  unsigned iX = TMath::Min((unsigned)uX, tableNumPointsX_ - 2);
+  unsigned iA = TMath::Min((unsigned)uA, tableNumPointsLocation_ - 2);
+  unsigned iS = TMath::Min((unsigned)uS, tableNumPointsSmear_ - 2);
+  Double_t fX = uX - iX;
+  Double_t fA = uA - iA;
+  Double_t fS = uS - iS;
+  const Double_t* row00 = &table_[(iS*tableNumPointsLocation_ + iA)*tableNumPointsX_ + iX];
+  const Double_t* row01 = row00 + tableNumPointsX_;                           // iA + 1
+  const Double_t* row10 = row00 + tableNumPointsLocation_*tableNumPointsX_;   // iS + 1
+  const Double_t* row11 = row10 + tableNumPointsX_;                           // iS + 1, iA + 1
+  Double_t v00 = row00[0] + fX*(row00[1] - row00[0]);
+  Double_t v01 = row01[0] + fX*(row01[1] - row01[0]);
+  Double_t v10 = row10[0] + fX*(row10[1] - row10[0]);
+  Double_t v11 = row11[0] + fX*(row11[1] - row11[0]);
+  Double_t v0 = v00 + fA*(v01 - v00);
+  Double_t v1 = v10 + fA*(v11 - v10);
+  return v0 + fS*(v1 - v0);
+}
+
 Int_t RooSmearedIsotropicDecayPdf::getAnalyticalIntegral(
     RooArgSet& allVars, RooArgSet& analVars, const char *rangeName) const {
   if (matchArgs(allVars, analVars, x)) {
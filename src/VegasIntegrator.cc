@@ -0,0 +1,332 @@
+#include "TauAnalysis/CandidateTools/interface/VegasIntegrator.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <TMath.h>
+
+#include <algorithm>
+#include <assert.h>
+
+VegasIntegrator::VegasIntegrator(const edm::ParameterSet& cfg)
+  : name_(""),
+    integrand_(0),
+    numIntegrals_(0),
+    numDimensions_(0),
+    numIterIntEvalDone_(0),
+    numActive_(0)
+{
+  if ( cfg.exists("name") )
+    name_ = cfg.getParameter<std::string>("name");
+  rnd_.setComponent(name_);
+
+//--- get parameters defining number of iterations and integrand evaluations per iteration
+  numCallsGridOpt_ = cfg.getParameter<unsigned>("numCallsGridOpt");
+  numIterGridOpt_ = ( cfg.exists("numIterGridOpt") ) ?
+    cfg.getParameter<unsigned>("numIterGridOpt") : 5;
+  numCallsIntEval_ = cfg.getParameter<unsigned>("numCallsIntEval");
+  numIterIntEval_ = ( cfg.exists("numIterIntEval") ) ?
+    cfg.getParameter<unsigned>("numIterIntEval") : 5;
+  if ( !(numIterIntEval_ >= 1 && numCallsIntEval_ >= 2) )
+    throw cms::Exception("VegasIntegrator")
+      << "Invalid Configuration Parameters 'numIterIntEval' = " << numIterIntEval_ << ","
+      << " 'numCallsIntEval' = " << numCallsIntEval_ << " !!\n";
+
+//--- get parameters of adaptive grid
+  numBins_ = ( cfg.exists("numBins") ) ?
+    cfg.getParameter<unsigned>("numBins") : 50;
+  if ( !(numBins_ >= 2) )
+    throw cms::Exception("VegasIntegrator")
+      << "Invalid Configuration Parameter 'numBins' = " << numBins_ << ", value >= 2 expected !!\n";
+  alpha_ = ( cfg.exists("alpha") ) ?
+    cfg.getParameter<double>("alpha") : 1.5;
+
+//--- get threshold for dropping functions with negligible integral
+  pruneThreshold_ = ( cfg.exists("pruneThreshold") ) ?
+    cfg.getParameter<double>("pruneThreshold") : 0.;
+
+//--- get parameters limiting time and number of integrand evaluations per integration
+  double maxTime = ( cfg.exists("maxTime") ) ?
+    cfg.getParameter<double>("maxTime") : 0.;
+  unsigned maxIntegrandCalls = ( cfg.exists("maxIntegrandCalls") ) ?
+    cfg.getParameter<unsigned>("maxIntegrandCalls") : 0;
+  budget_.setLimits(maxTime, maxIntegrandCalls);
+
+  verbosity_ = ( cfg.exists("verbosity") ) ?
+    cfg.getParameter<int>("verbosity") : 0;
+}
+
+void VegasIntegrator::setIntegrand(const Integrand& integrand, unsigned numIntegrals)
+{
+  integrand_ = &integrand;
+  numIntegrals_ = numIntegrals;
+}
+
+void VegasIntegrator::integrate(const std::vector<double>& xMin, const std::vector<double>& xMax,
+				std::vector<double>& integral, std::vector<double>& integralErr, int& errorFlag)
+{
+  if ( !integrand_ )
+    throw cms::Exception("VegasIntegrator::integrate")
+      << "No integrand function has been set yet !!\n";
+
+  if ( xMin.size() != xMax.size() )
+    throw cms::Exception("VegasIntegrator::integrate")
+      << "Mismatch in dimensionality of lower and upper boundaries of integration region !!\n";
+
+  xMin_ = xMin;
+  xMax_ = xMax;
+  numDimensions_ = xMin.size();
+
+  x_.resize(numDimensions_);
+  idxBins_.resize(numDimensions_);
+  f_.resize(numIntegrals_);
+  sumF_.resize(numIntegrals_);
+  sumF2_.resize(numIntegrals_);
+  sumWeightedIntegrals_.assign(numIntegrals_, 0.);
+  sumWeightedIntegrals2_.assign(numIntegrals_, 0.);
+  sumWeights_.assign(numIntegrals_, 0.);
+  numIterIntEvalDone_ = 0;
+  isActive_.assign(numIntegrals_, true);
+  numActive_ = numIntegrals_;
+  prunedIntegrals_.assign(numIntegrals_, 0.);
+  prunedIntegralErrs_.assign(numIntegrals_, 0.);
+  iterIntegrals_.resize(numIntegrals_);
+  iterIntegralErrs_.resize(numIntegrals_);
+
+  initializeGrid();
+
+  rnd_.reset();
+
+  budget_.start();
+
+//--- grid optimization stage
+  for ( unsigned iIter = 0; iIter < numIterGridOpt_ && !budget_.isExhausted(); ++iIter ) {
+    runIteration(numCallsGridOpt_, false);
+  }
+
+//--- integral evaluation stage
+  for ( unsigned iIter = 0; iIter < numIterIntEval_ && !budget_.isExhausted(); ++iIter ) {
+    runIteration(numCallsIntEval_, true);
+  }
+
+//--- compute weighted average of integrals computed in all iterations (eqs. (5) and (6) in [1])
+  integral.resize(numIntegrals_);
+  integralErr.resize(numIntegrals_);
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) {
+      integral[iIntegral] = prunedIntegrals_[iIntegral];
+      integralErr[iIntegral] = prunedIntegralErrs_[iIntegral];
+    } else if ( sumWeights_[iIntegral] > 0. ) {
+      integral[iIntegral] = sumWeightedIntegrals_[iIntegral]/sumWeights_[iIntegral];
+      integralErr[iIntegral] = 1./TMath::Sqrt(sumWeights_[iIntegral]);
+    } else {
+      integral[iIntegral] = 0.;
+      integralErr[iIntegral] = 0.;
+    }
+  }
+
+  errorFlag = ( numIterIntEvalDone_ > 0 ) ? 0 : 1;
+
+  if ( verbosity_ >= 1 ) print(std::cout);
+}
+
+void VegasIntegrator::initializeGrid()
+{
+  gridEdges_.resize(numDimensions_*(numBins_ + 1));
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+    for ( unsigned iEdge = 0; iEdge <= numBins_; ++iEdge ) {
+      gridEdges_[iDimension*(numBins_ + 1) + iEdge] = (double)iEdge/numBins_;
+    }
+  }
+  gridWeights_.resize(numIntegrals_*numDimensions_*numBins_);
+}
+
+unsigned VegasIntegrator::runIteration(unsigned numCalls, bool isIntEval)
+{
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    sumF_[iIntegral] = 0.;
+    sumF2_[iIntegral] = 0.;
+  }
+  std::fill(gridWeights_.begin(), gridWeights_.end(), 0.);
+
+  unsigned numCallsDone = 0;
+  while ( numCallsDone < numCalls && !budget_.checkIsExhausted() ) {
+//--- sample point according to grid:
+//    each bin is chosen with equal probability, the position within the bin is uniformly distributed
+    double jacobian = 1.;
+    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+      double y = rnd_.Rndm()*numBins_;
+      unsigned idxBin = TMath::Min((unsigned)y, numBins_ - 1);
+      const double* edges = &gridEdges_[iDimension*(numBins_ + 1)];
+      double binWidth = edges[idxBin + 1] - edges[idxBin];
+      double u = edges[idxBin] + (y - idxBin)*binWidth;
+      double range = xMax_[iDimension] - xMin_[iDimension];
+      x_[iDimension] = xMin_[iDimension] + u*range;
+      jacobian *= (binWidth*numBins_*range);
+      idxBins_[iDimension] = idxBin;
+    }
+
+    if ( numActive_ < numIntegrals_ ) integrand_->evaluate(&x_[0], isActive_, &f_[0]);
+    else (*integrand_)(&x_[0], &f_[0]);
+    budget_.addIntegrandCalls(numActive_);
+    ++numCallsDone;
+
+    for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+      if ( !isActive_[iIntegral] ) continue;
+      double value = f_[iIntegral]*jacobian;
+      if ( TMath::IsNaN(value) ) value = 0.;
+      if ( value == 0. ) continue;
+      double value2 = value*value;
+      sumF_[iIntegral] += value;
+      sumF2_[iIntegral] += value2;
+      double* weights = &gridWeights_[iIntegral*numDimensions_*numBins_];
+      for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+	weights[iDimension*numBins_ + idxBins_[iDimension]] += value2;
+      }
+    }
+  }
+
+//--- at least two points are needed to estimate the uncertainty
+  if ( numCallsDone < 2 ) return numCallsDone;
+
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) continue;
+    double integral_i = sumF_[iIntegral]/numCallsDone;
+    double integralVar_i = (sumF2_[iIntegral]/numCallsDone - integral_i*integral_i)/(numCallsDone - 1);
+    iterIntegrals_[iIntegral] = integral_i;
+    iterIntegralErrs_[iIntegral] = TMath::Sqrt(TMath::Max(0., integralVar_i));
+//--- skip iterations in which the function was zero at all sampled points,
+//    as these cannot be used for computing the weighted average
+    if ( !isIntEval || !(integralVar_i > 0.) ) continue;
+    double weight = 1./integralVar_i;
+    sumWeightedIntegrals_[iIntegral] += weight*integral_i;
+    sumWeightedIntegrals2_[iIntegral] += weight*integral_i*integral_i;
+    sumWeights_[iIntegral] += weight;
+  }
+  if ( isIntEval ) ++numIterIntEvalDone_;
+
+  if ( pruneThreshold_ > 0. ) pruneIntegrals();
+
+  refineGrid();
+
+  return numCallsDone;
+}
+
+void VegasIntegrator::pruneIntegrals()
+{
+  double maxIntegral = 0.;
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( isActive_[iIntegral] && iterIntegrals_[iIntegral] > maxIntegral ) maxIntegral = iterIntegrals_[iIntegral];
+  }
+  if ( !(maxIntegral > 0.) ) return;
+
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) continue;
+    if ( (iterIntegrals_[iIntegral] + 3.*iterIntegralErrs_[iIntegral]) < (pruneThreshold_*maxIntegral) ) {
+//--- keep estimate of integral computed so far
+      if ( sumWeights_[iIntegral] > 0. ) {
+	prunedIntegrals_[iIntegral] = sumWeightedIntegrals_[iIntegral]/sumWeights_[iIntegral];
+	prunedIntegralErrs_[iIntegral] = 1./TMath::Sqrt(sumWeights_[iIntegral]);
+      } else {
+	prunedIntegrals_[iIntegral] = iterIntegrals_[iIntegral];
+	prunedIntegralErrs_[iIntegral] = iterIntegralErrs_[iIntegral];
+      }
+      isActive_[iIntegral] = false;
+      --numActive_;
+    }
+  }
+}
+
+void VegasIntegrator::refineGrid()
+{
+  std::vector<double> d(numBins_);
+  std::vector<double> dSmoothed(numBins_);
+  std::vector<double> r(numBins_);
+  std::vector<double> newEdges(numBins_ + 1);
+  for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+//--- sum contributions of all functions, each normalized to one
+    std::fill(d.begin(), d.end(), 0.);
+    for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+      const double* weights = &gridWeights_[(iIntegral*numDimensions_ + iDimension)*numBins_];
+      double sumWeights = 0.;
+      for ( unsigned iBin = 0; iBin < numBins_; ++iBin ) {
+	sumWeights += weights[iBin];
+      }
+      if ( !(sumWeights > 0.) ) continue;
+      for ( unsigned iBin = 0; iBin < numBins_; ++iBin ) {
+	d[iBin] += weights[iBin]/sumWeights;
+      }
+    }
+
+//--- smooth contributions of neighbouring bins
+    dSmoothed[0] = 0.5*(d[0] + d[1]);
+    for ( unsigned iBin = 1; iBin < (numBins_ - 1); ++iBin ) {
+      dSmoothed[iBin] = (d[iBin - 1] + d[iBin] + d[iBin + 1])/3.;
+    }
+    dSmoothed[numBins_ - 1] = 0.5*(d[numBins_ - 2] + d[numBins_ - 1]);
+    double sumD = 0.;
+    for ( unsigned iBin = 0; iBin < numBins_; ++iBin ) {
+      sumD += dSmoothed[iBin];
+    }
+    if ( !(sumD > 0.) ) continue;
+
+//--- compute number of subdivisions of each bin, damped by parameter alpha (eq. (17) in [1])
+    double sumR = 0.;
+    for ( unsigned iBin = 0; iBin < numBins_; ++iBin ) {
+      double ratio = dSmoothed[iBin]/sumD;
+      if      ( ratio <= 0. ) r[iBin] = 0.;
+      else if ( ratio >= 1. ) r[iBin] = 1.;
+      else                    r[iBin] = TMath::Power((1. - ratio)/(-TMath::Log(ratio)), alpha_);
+      sumR += r[iBin];
+    }
+    if ( !(sumR > 0.) ) continue;
+
+//--- move bin boundaries, such that each new bin contains the same fraction of sum(r)
+    double* edges = &gridEdges_[iDimension*(numBins_ + 1)];
+    double rPerBin = sumR/numBins_;
+    double rAccumulated = 0.;
+    unsigned idxNewEdge = 1;
+    newEdges[0] = 0.;
+    for ( unsigned iBin = 0; iBin < numBins_ && idxNewEdge < numBins_; ++iBin ) {
+      rAccumulated += r[iBin];
+      while ( rAccumulated > rPerBin && idxNewEdge < numBins_ ) {
+	rAccumulated -= rPerBin;
+	double binWidth = edges[iBin + 1] - edges[iBin];
+	newEdges[idxNewEdge] = edges[iBin + 1] - binWidth*rAccumulated/r[iBin];
+	++idxNewEdge;
+      }
+    }
+    for ( ; idxNewEdge <= numBins_; ++idxNewEdge ) {
+      newEdges[idxNewEdge] = 1.;
+    }
+    for ( unsigned iEdge = 0; iEdge <= numBins_; ++iEdge ) {
+      edges[iEdge] = newEdges[iEdge];
+    }
+  }
+}
+
+void VegasIntegrator::print(std::ostream& stream) const
+{
+  stream << "<VegasIntegrator::print>:" << std::endl;
+  stream << " name = " << name_ << std::endl;
+  stream << " numDimensions = " << numDimensions_ << ", numIntegrals = " << numIntegrals_ << std::endl;
+  stream << " iterations of integral evaluation stage = " << numIterIntEvalDone_ << std::endl;
+  stream << " functions evaluated in last iteration = " << numActive_ << std::endl;
+  for ( unsigned iIntegral = 0; iIntegral < numIntegrals_; ++iIntegral ) {
+    if ( !isActive_[iIntegral] ) {
+      stream << " integral #" << iIntegral << " = " << prunedIntegrals_[iIntegral] << " +/- " << prunedIntegralErrs_[iIntegral] 
+	     << " (dropped)" << std::endl;
+      continue;
+    }
+    if ( !(sumWeights_[iIntegral] > 0.) ) continue;
+    double integral = sumWeightedIntegrals_[iIntegral]/sumWeights_[iIntegral];
+    double integralErr = 1./TMath::Sqrt(sumWeights_[iIntegral]);
+//--- compute chi^2 per degree of freedom of integrals computed in different iterations (eq. (7) in [1])
+    double chi2 = sumWeightedIntegrals2_[iIntegral] - integral*integral*sumWeights_[iIntegral];
+    stream << " integral #" << iIntegral << " = " << integral << " +/- " << integralErr;
+    if ( numIterIntEvalDone_ >= 2 ) stream << " (chi^2/DoF = " << chi2/(numIterIntEvalDone_ - 1) << ")";
+    stream << std::endl;
+  }
+  if ( budget_.isExhausted() ) {
+    stream << " budget exhausted after " << budget_.numIntegrandCalls() << " integrand calls" << std::endl;
+  }
+}
@@ -1,6 +1,5 @@
 #include "TauAnalysis/CandidateTools/interface/mTauTauMinAlgo.h"
 
-#include "CLHEP/Random/RandFlat.h"
 
 #include <cmath>
 
@@ -147,7 +146,8 @@ double mTauTauAtFixedKxKy(const double kx, const double ky,
 double mTauTauMin(const double se, const double sx, const double sy, const double sz,
 		  const double te, const double tx, const double ty, const double tz,
 		  const double pmissx, const double pmissy,
-		  const double mtau) 
+		  const double mtau,
+		  NSVfitRandomGenerator& rnd) 
 {
   double kxStart = 0;
   double kyStart = 0;
@@ -161,9 +161,9 @@ double mTauTauMin(const double se, const double sx, const double sy, const doubl
   const double distFromWall = 2; // scan size = order of magnitude spread over which cauchy vals will be distributed.
     
   for ( int i=0; i < 10000; ++i ) {
-    const double theta = (CLHEP::RandFlat::shoot()-0.5)*3.14159;
+    const double theta = (rnd.Rndm()-0.5)*3.14159;
     const double distToStep = distFromWall*tan(theta); 
-    const double angToStep = CLHEP::RandFlat::shoot()*3.14159*2.0;
+    const double angToStep = rnd.Rndm()*3.14159*2.0;
     const double kx = distToStep * cos(angToStep);
     const double ky = distToStep * sin(angToStep);
     bool wasSilly;
@@ -206,9 +206,9 @@ double mTauTauMin(const double se, const double sx, const double sy, const doubl
     const double growthFactor = 2.0;
     
     while ( typicalStepSize > 1.e-6 ) {
-      const double theta = (CLHEP::RandFlat::shoot()-0.5)*3.14159;
+      const double theta = (rnd.Rndm()-0.5)*3.14159;
       const double distToStep = typicalStepSize*tan(theta); 
-      const double angToStep = CLHEP::RandFlat::shoot()*3.14159*2.0001;
+      const double angToStep = rnd.Rndm()*3.14159*2.0001;
       const double newkx = kxOld + distToStep * cos(angToStep);
       const double newky = kyOld + distToStep * sin(angToStep);
       bool wasSilly;
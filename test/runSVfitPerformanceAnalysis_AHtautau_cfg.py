@@ -743,7 +743,8 @@ for idxSVfitOption1 in range(16):                       # determines likelihood
             numBinsSVfitSigma = cms.int32(numBinsSVfitSigma),
             svFitSigmaMax = cms.double(svFitSigmaMax),
             dqmDirectory = cms.string("%s/%s/%s/nSVfitAnalyzerOption%i%s" % \
-              (sample, channel, metResolution_label, idxSVfitOption1, idxSVfitOption2))
+              (sample, channel, metResolution_label, idxSVfitOption1, idxSVfitOption2)),
+            fillLocalHistograms = cms.bool(True)
         )                                    
         nSVfitAnalyzerName = "nSVfitAnalyzer%i%s" % (idxSVfitOption1, idxSVfitOption2)
         setattr(process, nSVfitAnalyzerName, nSVfitAnalyzer)
@@ -49,6 +49,9 @@ process.testNeuralMtautau = cms.PSet(
     #NNconfigFileName = cms.string('/data1/veelken/tmp/neuralMtautau/weights/trainNeuralMtautau_trainNeuralMtautau_MLP.weights.xml'),
     NNconfigFileName = cms.string('/data1/veelken/tmp/neuralMtautau/weights/trainNeuralMtautau_trainNeuralMtautau_kNN.weights.xml'),
     ##NNconfigFileName = cms.string('/afs/cern.ch/user/v/veelken/scratch0/CMSSW_4_2_4_patch1/src/TauAnalysis/CandidateTools/test/weights/trainNeuralMtautau_trainNeuralMtautau_MLP.weights.xml'),
+    # evaluate network by NeuralMtautauMLP instead of TMVA::Reader
+    # (supported for MLP weights files only; validate weights file by exportNeuralMtautau before enabling)
+    useCompiledMLP = cms.bool(False),
     treeName = cms.string("neuralMtautauNtupleProducer/neuralMtautauNtuple"),
     ##treeName = cms.string("tree"),
     inputBranchNames = cms.vstring(
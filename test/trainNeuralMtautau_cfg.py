@@ -75,33 +75,47 @@ mvaTrainingOptions_kNN = [
 mvaTrainingOptions_kNN_string = ":".join(mvaTrainingOptions_kNN)
 #print "mvaTrainingOptions_kNN_string = %s" % mvaTrainingOptions_kNN_string
 
+inputBranchNames = [
+    "recLeg1Px",
+    "recLeg1Py",
+    "recLeg1Pz",
+    "recLeg2Px",
+    "recLeg2Py",
+    "recLeg2Pz",
+    "recLeg2M",
+    "recMEtPx",
+    "recMEtPy",
+    "TMath::Min(recMEtSigmaX, 1.e+2)",
+    "TMath::Min(recMEtSigmaY, 1.e+2)",
+    "recMEtCorrXY",
+    ##"recDPhi12",
+    ##"recDAlpha12",
+    ##"recSVfitMtautau",
+    ##"recSigmaSVfit",
+    ##"recVisMass"
+]
+targetBranchName = "genMtautau"
+#targetBranchName = "genM"
+
+# configuration of bin/prepareNeuralMtautauTrainingData.cc
+process.prepareNeuralMtautauTrainingData = cms.PSet(
+    treeName = cms.string("neuralMtautauNtupleProducer/neuralMtautauNtuple"),
+    inputBranchNames = cms.vstring(inputBranchNames),
+    targetBranchName = cms.string(targetBranchName),
+    eventBranchName = cms.string("event"),
+    testFraction = cms.double(0.5),
+    numWorkers = cms.uint32(8),
+    outputFileName = cms.string('trainNeuralMtautau_prepared.root')
+)
+
 process.trainNeuralMtautau = cms.PSet(
     mvaType = cms.string(mvaType_kNN),
     mvaName = cms.string(mvaName_kNN),
     mvaTrainingOptions = cms.string(mvaTrainingOptions_kNN_string),
     treeName = cms.string("neuralMtautauNtupleProducer/neuralMtautauNtuple"),
     #treeName = cms.string("tree"),
-    inputBranchNames = cms.vstring(
-        "recLeg1Px",
-        "recLeg1Py",
-        "recLeg1Pz",
-        "recLeg2Px",
-        "recLeg2Py",
-        "recLeg2Pz",
-        "recLeg2M",
-        "recMEtPx",
-        "recMEtPy",
-        "TMath::Min(recMEtSigmaX, 1.e+2)",
-        "TMath::Min(recMEtSigmaY, 1.e+2)",
-        "recMEtCorrXY",
-        ##"recDPhi12",
-        ##"recDAlpha12",
-        ##"recSVfitMtautau",
-        ##"recSigmaSVfit",
-        ##"recVisMass"
-    ),
-    targetBranchName = cms.string(
-        "genMtautau"
-        #"genM"
-    )
+    inputBranchNames = cms.vstring(inputBranchNames),
+    targetBranchName = cms.string(targetBranchName),
+    # uncomment to train on samples prepared by bin/prepareNeuralMtautauTrainingData.cc
+    ##preparedInputFileName = cms.string('trainNeuralMtautau_prepared.root')
 )